@@ -0,0 +1,92 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/apply_batch.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct Key { int code; };
+struct Click { int x, y; };
+struct Scroll { double delta; };
+struct Resize { int width, height; };
+
+using event = eggs::variant<Key, Click, Scroll, Resize>;
+
+struct Handler
+{
+    double total = 0;
+
+    void operator()(Key const& e) { total += e.code; }
+    void operator()(Click const& e) { total += e.x * e.y; }
+    void operator()(Scroll const& e) { total -= e.delta; }
+    void operator()(Resize const& e) { total += e.width + e.height; }
+};
+
+void bench(char const* name, std::vector<event> const& es)
+{
+    std::string prefix = name;
+
+    benchmark::run((prefix + " apply loop").c_str(), es.size(), [&]
+    {
+        Handler h;
+        for (event const& e : es)
+            eggs::variants::apply(h, e);
+        benchmark::do_not_optimize(h.total);
+    });
+
+    benchmark::run((prefix + " apply_batch unordered").c_str(), es.size(), [&]
+    {
+        Handler h;
+        eggs::variants::apply_batch(h, es.begin(), es.end());
+        benchmark::do_not_optimize(h.total);
+    });
+
+    benchmark::run((prefix + " apply_batch ordered").c_str(), es.size(), [&]
+    {
+        Handler h;
+        eggs::variants::apply_batch(
+            eggs::variants::ordered, h, es.begin(), es.end());
+        benchmark::do_not_optimize(h.total);
+    });
+}
+
+event make_event(std::size_t which, std::mt19937& gen)
+{
+    int const x = static_cast<int>(gen() % 1000);
+    switch (which)
+    {
+    case 0: return Key{x};
+    case 1: return Click{x, x + 1};
+    case 2: return Scroll{x * 0.5};
+    default: return Resize{x, x * 2};
+    }
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    std::vector<event> random;
+    for (std::size_t i = 0; i < n; ++i)
+        random.push_back(make_event(gen() % 4, gen));
+    bench("random", random);
+
+    std::vector<event> bursty;
+    while (bursty.size() < n)
+    {
+        std::size_t const which = gen() % 4;
+        for (std::size_t i = gen() % 64; i > 0 && bursty.size() < n; --i)
+            bursty.push_back(make_event(which, gen));
+    }
+    bench("bursty", bursty);
+}
@@ -0,0 +1,149 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/atomic_variant.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct Idle {};
+struct Running { std::uint32_t step; };
+struct Failed { std::int32_t code; };
+
+using state = eggs::variant<Idle, Running, Failed>;
+
+struct Progress { std::uint32_t done, total, seq; };
+
+class locked_state
+{
+public:
+    explicit locked_state(state const& s) : _state(s) {}
+
+    state load() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _state;
+    }
+
+    void store(state const& s)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _state = s;
+    }
+
+private:
+    mutable std::mutex _mutex;
+    state _state;
+};
+
+// Runs `threads` threads, each calling `f(thread, i)` for `ops` iterations.
+template <typename F>
+void contend(std::size_t threads, std::size_t ops, F const& f)
+{
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&f, t, ops]
+        {
+            for (std::size_t i = 0; i < ops; ++i)
+                f(t, i);
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+int main()
+{
+    std::size_t const ops = 1 << 18;
+
+    eggs::variants::atomic_variant<Idle, Running, Failed> atomic(Idle{});
+    eggs::variants::atomic_variant<Idle, Progress, Failed> atomic16(Idle{});
+    locked_state locked(Idle{});
+
+    std::printf("8 byte word lock-free: %d, 16 byte word lock-free: %d\n",
+        int(atomic.is_lock_free()), int(atomic16.is_lock_free()));
+
+    // powers of two up to the number of hardware threads, and that number
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    for (std::size_t threads : counts)
+    {
+        char name[64];
+
+        // one writer per eight operations, the rest are readers
+        std::snprintf(name, sizeof(name),
+            "mutex, %u threads", unsigned(threads));
+        benchmark::run(name, ops * threads, [&]
+        {
+            contend(threads, ops, [&](std::size_t, std::size_t i)
+            {
+                if (i % 8 == 0)
+                    locked.store(Running{std::uint32_t(i)});
+                else
+                    benchmark::do_not_optimize(locked.load().which());
+            });
+        });
+
+        std::snprintf(name, sizeof(name),
+            "atomic_variant (8 bytes), %u threads", unsigned(threads));
+        benchmark::run(name, ops * threads, [&]
+        {
+            contend(threads, ops, [&](std::size_t, std::size_t i)
+            {
+                if (i % 8 == 0)
+                    atomic.store(Running{std::uint32_t(i)});
+                else
+                    benchmark::do_not_optimize(atomic.load().which());
+            });
+        });
+
+        std::snprintf(name, sizeof(name),
+            "atomic_variant (16 bytes), %u threads", unsigned(threads));
+        benchmark::run(name, ops * threads, [&]
+        {
+            contend(threads, ops, [&](std::size_t t, std::size_t i)
+            {
+                if (i % 8 == 0)
+                    atomic16.store(Progress{
+                        std::uint32_t(i), std::uint32_t(ops), std::uint32_t(t)});
+                else
+                    benchmark::do_not_optimize(atomic16.load().which());
+            });
+        });
+
+        // every operation is a compare exchange increment
+        std::snprintf(name, sizeof(name),
+            "atomic_variant CAS loop, %u threads", unsigned(threads));
+        benchmark::run(name, ops * threads, [&]
+        {
+            contend(threads, ops, [&](std::size_t, std::size_t)
+            {
+                state expected = atomic.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Running const* r = expected.target<Running>();
+                    Running const next = {r != nullptr ? r->step + 1 : 0};
+                    if (atomic.compare_exchange_weak(expected, next))
+                        break;
+                }
+            });
+        });
+    }
+}
@@ -0,0 +1,57 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_BENCHMARK_BENCHMARK_HPP
+#define EGGS_VARIANT_BENCHMARK_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+
+namespace benchmark
+{
+    ///////////////////////////////////////////////////////////////////////////
+    template <typename T>
+    inline void do_not_optimize(T const& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r"(&value) : "memory");
+#else
+        static void const* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Runs `f` `repetitions` times and reports the best time per operation,
+    // where `ops` is the number of operations performed by a single run.
+    template <typename F>
+    double run(char const* name, std::size_t ops, F&& f,
+        std::size_t repetitions = 5)
+    {
+        typedef std::chrono::steady_clock clock;
+
+        double best = 0.0;
+        for (std::size_t i = 0; i < repetitions; ++i)
+        {
+            clock::time_point const start = clock::now();
+            f();
+            clock::time_point const stop = clock::now();
+
+            double const ns = std::chrono::duration<double, std::nano>(
+                stop - start).count() / double(ops);
+            if (i == 0 || ns < best)
+                best = ns;
+        }
+
+        std::printf("%-48s %10.2f ns/op\n", name, best);
+        return best;
+    }
+}
+
+#endif /*EGGS_VARIANT_BENCHMARK_BENCHMARK_HPP*/
@@ -0,0 +1,153 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/conflating_mailbox.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct quote
+{
+    double bid;
+    double ask;
+
+    quote(double bid, double ask) : bid(bid), ask(ask) {}
+};
+
+struct trade
+{
+    double price;
+    int size;
+
+    trade(double price, int size) : price(price), size(size) {}
+};
+
+struct status { int code; explicit status(int code) : code(code) {} };
+
+using market_data = eggs::variant<quote, trade, status>;
+
+// a reader that does a fixed amount of work per value, so that it falls
+// behind a burst of updates
+struct handler
+{
+    double sum;
+
+    void work(double v)
+    {
+        for (int i = 0; i < 16; ++i)
+            v = v * 0.5 + 1.0;
+        sum += v;
+    }
+
+    void operator()(quote const& q) { work(q.bid + q.ask); }
+    void operator()(trade const& t) { work(t.price * t.size); }
+    void operator()(status const& s) { work(s.code); }
+};
+
+class locked_queue
+{
+public:
+    void post(std::size_t i)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (i % 8 == 7)
+            _messages.push_back(market_data(trade(double(i), 100)));
+        else
+            _messages.push_back(market_data(quote(double(i), double(i + 1))));
+        if (_messages.size() > _peak)
+            _peak = _messages.size();
+    }
+
+    void drain(handler& h)
+    {
+        std::deque<market_data> messages;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            messages.swap(_messages);
+        }
+        for (market_data& m : messages)
+            eggs::variants::apply(h, m);
+    }
+
+    std::size_t peak() const { return _peak; }
+
+private:
+    std::mutex _mutex;
+    std::deque<market_data> _messages;
+    std::size_t _peak = 0;
+};
+
+class mailbox
+{
+public:
+    void post(std::size_t i)
+    {
+        if (i % 8 == 7)
+            _mailbox.emplace<trade>(double(i), 100);
+        else
+            _mailbox.emplace<quote>(double(i), double(i + 1));
+    }
+
+    void drain(handler& h)
+    {
+        _mailbox.try_drain(h);
+    }
+
+    std::size_t peak() const { return 3; }
+
+private:
+    eggs::variants::conflating_mailbox<market_data> _mailbox;
+};
+
+// Times a writer posting a burst of updates, until a reader draining
+// concurrently has caught up with the last of them.
+template <typename Box>
+void measure(char const* kind)
+{
+    std::size_t const ops = 1 << 20;
+    std::size_t peak = 0;
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s, burst", kind);
+    benchmark::run(name, ops, [&]
+    {
+        Box box;
+        std::atomic<bool> done(false);
+        std::thread writer([&]
+        {
+            for (std::size_t i = 0; i < ops; ++i)
+                box.post(i);
+            done.store(true);
+        });
+
+        handler h = {0.0};
+        while (!done.load())
+        {
+            box.drain(h);
+            std::this_thread::yield();
+        }
+        box.drain(h);
+        benchmark::do_not_optimize(h.sum);
+
+        writer.join();
+        peak = box.peak();
+    }, 3);
+    std::printf("%-48s %10u values\n", "  peak backlog", unsigned(peak));
+}
+
+int main()
+{
+    measure<locked_queue>("mutex + deque");
+    measure<mailbox>("conflating_mailbox");
+}
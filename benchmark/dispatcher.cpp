@@ -0,0 +1,132 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/dispatcher.hpp>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct order { int id; int quantity; };
+struct cancel { int id; };
+struct fill { int id; double price; };
+struct heartbeat {};
+
+using message = eggs::variant<order, cancel, fill, heartbeat>;
+
+static std::vector<message> make_messages(std::size_t n)
+{
+    std::vector<message> messages;
+    messages.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        int const id = int(i);
+        switch (i * 7 % 4)
+        {
+        case 0: messages.push_back(order{id, 10}); break;
+        case 1: messages.push_back(cancel{id}); break;
+        case 2: messages.push_back(fill{id, 1.5}); break;
+        default: messages.push_back(heartbeat{}); break;
+        }
+    }
+    return messages;
+}
+
+// the baseline: handlers looked up by `target_type()`, wrapped in
+// `std::function` taking the address of the active member
+class map_dispatcher
+{
+public:
+    template <typename T, typename F>
+    void subscribe(F f)
+    {
+        _handlers[std::type_index(typeid(T))].push_back(
+            [f](void const* ptr) { f(*static_cast<T const*>(ptr)); });
+    }
+
+    void dispatch(message const& m) const
+    {
+        auto const it = _handlers.find(std::type_index(m.target_type()));
+        if (it == _handlers.end())
+            return;
+        for (std::function<void(void const*)> const& handler : it->second)
+            handler(m.target());
+    }
+
+private:
+    std::map<
+        std::type_index, std::vector<std::function<void(void const*)>>
+    > _handlers;
+};
+
+struct totals
+{
+    long quantity;
+    long cancels;
+    double notional;
+
+    void operator()(order const& o) { quantity += o.quantity; }
+    void operator()(cancel const&) { ++cancels; }
+    void operator()(fill const& f) { notional += f.price; }
+    void operator()(heartbeat const&) {}
+};
+
+template <typename Dispatcher>
+void subscribe(Dispatcher& d, totals& t)
+{
+    d.template subscribe<order>([&t](order const& o) { t(o); });
+    d.template subscribe<order>(
+        [&t](order const& o) { t.quantity -= o.id & 1; });
+    d.template subscribe<cancel>([&t](cancel const& c) { t(c); });
+    d.template subscribe<fill>([&t](fill const& f) { t(f); });
+}
+
+int main()
+{
+    std::size_t const n = 1 << 16;
+    std::vector<message> const messages = make_messages(n);
+
+    {
+        totals t = {0, 0, 0.0};
+        map_dispatcher d;
+        subscribe(d, t);
+        benchmark::run("std::map<std::type_index, std::function>", n, [&]
+        {
+            for (message const& m : messages)
+                d.dispatch(m);
+            benchmark::do_not_optimize(t);
+        });
+    }
+
+    {
+        totals t = {0, 0, 0.0};
+        eggs::variants::dispatcher<message> d;
+        subscribe(d, t);
+        benchmark::run("dispatcher", n, [&]
+        {
+            for (message const& m : messages)
+                d.dispatch(m);
+            benchmark::do_not_optimize(t);
+        });
+    }
+
+    {
+        totals t = {0, 0, 0.0};
+        eggs::variants::dispatcher<message> d;
+        benchmark::run("dispatcher, static handler", n, [&]
+        {
+            for (message const& m : messages)
+                d.dispatch(m, t);
+            benchmark::do_not_optimize(t);
+        });
+    }
+}
@@ -0,0 +1,98 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/flat_hash_map.hpp>
+#include <eggs/variant/hashed_variant.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using Key = eggs::variant<int, std::string>;
+using HKey = eggs::variants::hashed_variant<int, std::string>;
+
+template <typename K>
+std::vector<K> make_keys(std::size_t n, unsigned seed = 42)
+{
+    std::mt19937 gen(seed);
+    std::vector<K> keys;
+    keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        int const x = static_cast<int>(gen());
+        if (i % 4 == 0)
+            keys.push_back(K(std::to_string(x)));
+        else
+            keys.push_back(K(x));
+    }
+    return keys;
+}
+
+template <typename Map, typename K>
+void bench(char const* name, std::vector<K> const& keys)
+{
+    std::size_t const n = keys.size();
+    std::string prefix = name;
+
+    benchmark::run((prefix + " insert").c_str(), n, [&]
+    {
+        Map m;
+        for (std::size_t i = 0; i < n; ++i)
+            m[keys[i]] = i;
+        benchmark::do_not_optimize(m);
+    });
+
+    Map m;
+    for (std::size_t i = 0; i < n; ++i)
+        m[keys[i]] = i;
+
+    benchmark::run((prefix + " find (hit)").c_str(), n, [&]
+    {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            sum += m.find(keys[i])->second;
+        benchmark::do_not_optimize(sum);
+    });
+
+    std::vector<K> const misses = make_keys<K>(n / 2, 43);
+    benchmark::run((prefix + " find (miss)").c_str(), misses.size(), [&]
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < misses.size(); ++i)
+            count += m.count(misses[i]);
+        benchmark::do_not_optimize(count);
+    });
+
+    benchmark::run((prefix + " iterate").c_str(), m.size(), [&]
+    {
+        std::size_t sum = 0;
+        for (auto const& kv : m)
+            sum += kv.second;
+        benchmark::do_not_optimize(sum);
+    });
+}
+
+int main()
+{
+    std::size_t const n = 1 << 18;
+
+    std::vector<Key> const keys = make_keys<Key>(n);
+    bench<std::unordered_map<Key, std::size_t>>(
+        "unordered_map<variant>", keys);
+    bench<eggs::variants::flat_hash_map<Key, std::size_t>>(
+        "flat_hash_map<variant>", keys);
+
+    std::vector<HKey> const hkeys = make_keys<HKey>(n);
+    bench<std::unordered_map<HKey, std::size_t>>(
+        "unordered_map<hashed_variant>", hkeys);
+    bench<eggs::variants::flat_hash_map<HKey, std::size_t>>(
+        "flat_hash_map<hashed_variant>", hkeys);
+}
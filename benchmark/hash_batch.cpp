@@ -0,0 +1,60 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/hash_batch.hpp>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using variant = eggs::variant<int, long long, double>;
+
+void bench(char const* name, std::vector<variant> const& vs)
+{
+    std::vector<std::size_t> hs(vs.size());
+    std::string prefix = name;
+
+    benchmark::run((prefix + " std::hash").c_str(), vs.size(), [&]
+    {
+        for (std::size_t i = 0; i < vs.size(); ++i)
+            hs[i] = std::hash<variant>{}(vs[i]);
+        benchmark::do_not_optimize(hs);
+    });
+
+    benchmark::run((prefix + " hash_batch").c_str(), vs.size(), [&]
+    {
+        eggs::variants::hash_batch(vs.begin(), vs.end(), hs.begin());
+        benchmark::do_not_optimize(hs);
+    });
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    std::vector<variant> uniform(n);
+    for (std::size_t i = 0; i < n; ++i)
+        uniform[i] = static_cast<int>(gen());
+    bench("uniform", uniform);
+
+    std::vector<variant> mixed(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        switch (gen() % 3)
+        {
+        case 0: mixed[i] = static_cast<int>(gen()); break;
+        case 1: mixed[i] = static_cast<long long>(gen()); break;
+        case 2: mixed[i] = static_cast<double>(gen()); break;
+        }
+    }
+    bench("mixed", mixed);
+}
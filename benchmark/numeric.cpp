@@ -0,0 +1,95 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/numeric.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using number = eggs::variant<std::int32_t, std::int64_t, float, double>;
+
+struct to_double
+{
+    template <typename T>
+    double operator()(T x) const { return static_cast<double>(x); }
+};
+
+void bench(char const* name, std::vector<number> const& ns)
+{
+    std::string prefix = name;
+
+    benchmark::run((prefix + " apply sum").c_str(), ns.size(), [&]
+    {
+        double sum = 0;
+        for (number const& n : ns)
+            sum += eggs::variants::apply<double>(to_double{}, n);
+        benchmark::do_not_optimize(sum);
+    });
+
+    benchmark::run((prefix + " numeric::sum").c_str(), ns.size(), [&]
+    {
+        double sum = eggs::variants::numeric::sum(ns.begin(), ns.end());
+        benchmark::do_not_optimize(sum);
+    });
+
+    benchmark::run((prefix + " numeric::max").c_str(), ns.size(), [&]
+    {
+        double max = eggs::variants::numeric::max(ns.begin(), ns.end());
+        benchmark::do_not_optimize(max);
+    });
+
+    std::vector<double> ds(ns.size());
+    benchmark::run((prefix + " apply convert").c_str(), ns.size(), [&]
+    {
+        for (std::size_t i = 0; i < ns.size(); ++i)
+            ds[i] = eggs::variants::apply<double>(to_double{}, ns[i]);
+        benchmark::do_not_optimize(ds);
+    });
+
+    benchmark::run((prefix + " numeric::convert_to").c_str(), ns.size(), [&]
+    {
+        eggs::variants::numeric::convert_to<double>(
+            ns.begin(), ns.end(), ds.begin());
+        benchmark::do_not_optimize(ds);
+    });
+}
+
+number make_number(unsigned k, std::size_t i)
+{
+    switch (k % 4)
+    {
+    case 0: return std::int32_t(i);
+    case 1: return std::int64_t(i);
+    case 2: return float(i);
+    default: return double(i);
+    }
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    std::vector<number> bursty;
+    while (bursty.size() < n)
+    {
+        unsigned const k = gen();
+        for (std::size_t i = 0; i < 256 && bursty.size() < n; ++i)
+            bursty.push_back(make_number(k, bursty.size()));
+    }
+    bench("bursty", bursty);
+
+    std::vector<number> random;
+    for (std::size_t i = 0; i < n; ++i)
+        random.push_back(make_number(gen(), i));
+    bench("random", random);
+}
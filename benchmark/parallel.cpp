@@ -0,0 +1,94 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/parallel.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using number = eggs::variant<std::int32_t, std::int64_t, double>;
+
+struct accumulate
+{
+    double operator()(double acc, std::int32_t i) const { return acc + i; }
+    double operator()(double acc, std::int64_t i) const { return acc + double(i); }
+    double operator()(double acc, double d) const { return acc + d; }
+};
+
+struct plus
+{
+    double operator()(double a, double b) const { return a + b; }
+};
+
+struct negate
+{
+    template <typename T>
+    void operator()(T& x) const { x = -x; }
+};
+
+int main()
+{
+    std::size_t const n = 1 << 22;
+    std::mt19937 gen(42);
+
+    std::vector<number> ns;
+    ns.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        switch (gen() % 3)
+        {
+        case 0: ns.push_back(std::int32_t(i)); break;
+        case 1: ns.push_back(std::int64_t(i)); break;
+        case 2: ns.push_back(double(i) * 0.5); break;
+        }
+    }
+
+    benchmark::run("serial loop with apply", n, [&]
+    {
+        double sum = 0;
+        for (number const& v : ns)
+            sum = eggs::variants::apply(
+                [sum](double x) { return sum + x; }, v);
+        benchmark::do_not_optimize(sum);
+    });
+
+    // powers of two up to the number of hardware threads, and that number
+    std::size_t const max_threads =
+        eggs::variants::thread_pool::default_concurrency();
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    for (std::size_t threads : counts)
+    {
+        eggs::variants::thread_pool pool(threads);
+        char name[64];
+
+        std::snprintf(name, sizeof(name),
+            "parallel_reduce, %u threads", unsigned(threads));
+        benchmark::run(name, n, [&]
+        {
+            double const sum = eggs::variants::parallel_reduce(
+                pool, ns.begin(), ns.end(), 0.0, accumulate{}, plus{});
+            benchmark::do_not_optimize(sum);
+        });
+
+        std::snprintf(name, sizeof(name),
+            "parallel_apply, %u threads", unsigned(threads));
+        benchmark::run(name, n, [&]
+        {
+            eggs::variants::parallel_apply(
+                pool, ns.begin(), ns.end(), negate{});
+        });
+    }
+}
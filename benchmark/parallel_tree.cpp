@@ -0,0 +1,111 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/parallel_tree.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct node;
+
+struct Add { std::unique_ptr<node> lhs, rhs; };
+struct Mul { std::unique_ptr<node> lhs, rhs; };
+
+using expr = eggs::variant<double, Add, Mul>;
+
+struct node { expr e; };
+
+static std::unique_ptr<node> make_tree(std::size_t size, std::size_t seed)
+{
+    if (size == 1)
+        return std::unique_ptr<node>(new node{expr(double(seed % 7) + 0.5)});
+
+    std::unique_ptr<node> lhs = make_tree(size / 2, seed * 3 + 1);
+    std::unique_ptr<node> rhs = make_tree(size - size / 2, seed * 5 + 2);
+    if (seed % 4 == 0)
+        return std::unique_ptr<node>(
+            new node{expr(Mul{std::move(lhs), std::move(rhs)})});
+    return std::unique_ptr<node>(
+        new node{expr(Add{std::move(lhs), std::move(rhs)})});
+}
+
+struct sequential
+{
+    double operator()(double v) const { return v; }
+
+    double operator()(Add const& a) const
+    {
+        return eggs::variants::apply<double>(*this, a.lhs->e)
+             + eggs::variants::apply<double>(*this, a.rhs->e);
+    }
+
+    double operator()(Mul const& m) const
+    {
+        return eggs::variants::apply<double>(*this, m.lhs->e)
+             * eggs::variants::apply<double>(*this, m.rhs->e);
+    }
+};
+
+struct parallel
+{
+    template <typename Eval>
+    double operator()(double v, Eval const&) const { return v; }
+
+    template <typename Eval>
+    double operator()(Add const& a, Eval const& eval) const
+    {
+        std::array<double, 2> const r = eval.fork(a.lhs->e, a.rhs->e);
+        return r[0] + r[1];
+    }
+
+    template <typename Eval>
+    double operator()(Mul const& m, Eval const& eval) const
+    {
+        std::array<double, 2> const r = eval.fork(m.lhs->e, m.rhs->e);
+        return r[0] * r[1];
+    }
+};
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::unique_ptr<node> const tree = make_tree(n, 0);
+
+    benchmark::run("apply recursion", n, [&]
+    {
+        double const r = eggs::variants::apply<double>(sequential{}, tree->e);
+        benchmark::do_not_optimize(r);
+    });
+
+    // powers of two up to the number of hardware threads, and that number
+    std::size_t const max_threads =
+        eggs::variants::thread_pool::default_concurrency();
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    for (std::size_t threads : counts)
+    {
+        eggs::variants::thread_pool pool(threads);
+        char name[64];
+
+        std::snprintf(name, sizeof(name),
+            "parallel_evaluate, %u threads", unsigned(threads));
+        benchmark::run(name, n, [&]
+        {
+            double const r = eggs::variants::parallel_evaluate<double>(
+                pool, tree->e, parallel{});
+            benchmark::do_not_optimize(r);
+        });
+    }
+}
@@ -0,0 +1,199 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/pipeline.hpp>
+#include <eggs/variant/variant_queue.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#include "benchmark.hpp"
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+struct tick { std::uint32_t instrument; double price; };
+struct trade { std::uint32_t instrument; double price; std::uint32_t size; };
+struct heartbeat { std::uint64_t sequence; };
+
+using message = eggs::variant<tick, trade, heartbeat>;
+
+static message make_message(std::uint32_t i)
+{
+    switch (i % 4)
+    {
+    case 0: case 1: return tick{i, 1.0 + i % 7};
+    case 2: return trade{i, 1.25, i % 100};
+    default: return heartbeat{i};
+    }
+}
+
+// keeps ticks of even instruments, everything else passes
+struct even_ticks
+{
+    bool operator()(tick& t) const { return t.instrument % 2 == 0; }
+};
+
+// scales trades in place, everything else passes untouched
+struct scale_trades
+{
+    void operator()(trade& t) const { t.price *= 2.0; }
+};
+
+struct totals
+{
+    double* sum;
+
+    void operator()(tick& t) const { *sum += t.price; }
+    void operator()(trade& t) const { *sum += t.price * t.size; }
+    void operator()(heartbeat&) const { *sum += 1.0; }
+};
+
+using queue = eggs::variants::spsc_queue<tick, trade, heartbeat>;
+
+static std::uint64_t const end_of_stream = ~std::uint64_t(0);
+
+// the stage between two queues, filtering and transforming as it forwards
+struct forward_stage
+{
+    queue* out;
+
+    void operator()(tick&& t) const
+    {
+        if (even_ticks()(t))
+            push(message(t));
+    }
+    void operator()(trade&& t) const
+    {
+        scale_trades()(t);
+        push(message(t));
+    }
+    void operator()(heartbeat&& h) const
+    {
+        push(message(h));
+    }
+
+    void push(message&& m) const
+    {
+        while (!out->try_push(std::move(m)))
+            std::this_thread::yield();
+    }
+};
+
+struct queue_sink
+{
+    double* sum;
+    bool* done;
+
+    void operator()(tick&& t) const { *sum += t.price; }
+    void operator()(trade&& t) const { *sum += t.price * t.size; }
+    void operator()(heartbeat&& h) const
+    {
+        if (h.sequence == end_of_stream)
+            *done = true;
+        else
+            *sum += 1.0;
+    }
+};
+
+#if EGGS_CXX20_HAS_COROUTINES
+static eggs::variants::generator<message> messages(std::uint32_t n)
+{
+    for (std::uint32_t i = 0; i < n; ++i)
+        co_yield make_message(i);
+}
+#endif
+
+int main()
+{
+    std::uint32_t const n = 1 << 20;
+
+    // the baseline: every stage fused by hand into a single loop
+    {
+        double sum = 0.0;
+        totals const sink = {&sum};
+        benchmark::run("hand-fused loop", n, [&]
+        {
+            for (std::uint32_t i = 0; i < n; ++i)
+            {
+                message m = make_message(i);
+                if (tick* t = m.target<tick>())
+                {
+                    if (!even_ticks()(*t))
+                        continue;
+                }
+                if (trade* t = m.target<trade>())
+                    scale_trades()(*t);
+                eggs::variants::apply(sink, m);
+            }
+            benchmark::do_not_optimize(sum);
+        });
+    }
+
+#if EGGS_CXX20_HAS_COROUTINES
+    {
+        using eggs::variants::filter_stage;
+        using eggs::variants::sink;
+        using eggs::variants::transform_stage;
+
+        double sum = 0.0;
+        benchmark::run("coroutine stages", n, [&]
+        {
+            messages(n)
+              | filter_stage(even_ticks())
+              | transform_stage(scale_trades())
+              | sink(totals{&sum});
+            benchmark::do_not_optimize(sum);
+        });
+    }
+#endif
+
+    // the status quo: a thread per stage, connected by queues
+    {
+        double sum = 0.0;
+        benchmark::run("thread per stage, spsc_queue", n, [&]
+        {
+            queue first(1024);
+            queue second(1024);
+
+            std::thread source([&first, n]
+            {
+                for (std::uint32_t i = 0; i < n; ++i)
+                {
+                    while (!first.try_push(make_message(i)))
+                        std::this_thread::yield();
+                }
+            });
+
+            std::thread stage([&first, &second, n]
+            {
+                forward_stage const f = {&second};
+                std::uint32_t seen = 0;
+                while (seen < n)
+                {
+                    std::size_t const count = first.consume(f, 256);
+                    if (count == 0)
+                        std::this_thread::yield();
+                    seen += std::uint32_t(count);
+                }
+                f.push(message(heartbeat{end_of_stream}));
+            });
+
+            bool done = false;
+            queue_sink const t = {&sum, &done};
+            while (!done)
+            {
+                if (second.consume(t, 256) == 0)
+                    std::this_thread::yield();
+            }
+            source.join();
+            stage.join();
+            benchmark::do_not_optimize(sum);
+        }, 3);
+    }
+}
@@ -0,0 +1,166 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/rcu_variant.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct rule { int priority; std::string pattern; };
+
+using config = eggs::variant<std::string, std::vector<rule>>;
+
+static config make_config(int version)
+{
+    std::vector<rule> rules;
+    for (int i = 0; i < 16; ++i)
+        rules.push_back(rule{version + i, "pattern"});
+    return config(std::move(rules));
+}
+
+static int first_priority(config const& c)
+{
+    std::vector<rule> const* rules = c.target<std::vector<rule>>();
+    return rules != nullptr ? rules->front().priority : 0;
+}
+
+class locked_config
+{
+public:
+    explicit locked_config(config c) : _value(std::move(c)) {}
+
+    int read() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return first_priority(_value);
+    }
+
+    void store(config c)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _value = std::move(c);
+    }
+
+private:
+    mutable std::mutex _mutex;
+    config _value;
+};
+
+class shared_config
+{
+public:
+    explicit shared_config(config c)
+      : _value(std::make_shared<config>(std::move(c)))
+    {}
+
+    int read() const
+    {
+        std::shared_ptr<config const> const value = std::atomic_load(&_value);
+        return first_priority(*value);
+    }
+
+    void store(config c)
+    {
+        std::shared_ptr<config const> next =
+            std::make_shared<config>(std::move(c));
+        std::atomic_store(&_value, std::move(next));
+    }
+
+private:
+    std::shared_ptr<config const> _value;
+};
+
+class rcu_config
+{
+public:
+    explicit rcu_config(config c) : _value(std::move(c)) {}
+
+    int read() const
+    {
+        eggs::variants::rcu_variant<std::string, std::vector<rule>>::read_guard
+            const guard = _value.read();
+        return first_priority(*guard);
+    }
+
+    void store(config c)
+    {
+        _value.store(std::move(c));
+    }
+
+private:
+    eggs::variants::rcu_variant<std::string, std::vector<rule>> _value;
+};
+
+// Times reads on `readers` threads while a writer publishes a new config
+// every millisecond.
+template <typename Cell>
+void measure(char const* kind, std::size_t readers)
+{
+    std::size_t const ops = 1 << 18;
+    Cell cell(make_config(0));
+
+    char name[64];
+    std::snprintf(name, sizeof(name),
+        "%s, %u readers", kind, unsigned(readers));
+    benchmark::run(name, ops * readers, [&]
+    {
+        std::atomic<bool> done(false);
+        std::thread writer([&]
+        {
+            for (int version = 1; !done.load(); ++version)
+            {
+                cell.store(make_config(version));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        std::vector<std::thread> threads;
+        for (std::size_t r = 0; r < readers; ++r)
+        {
+            threads.emplace_back([&]
+            {
+                int sum = 0;
+                for (std::size_t i = 0; i < ops; ++i)
+                    sum += cell.read();
+                benchmark::do_not_optimize(sum);
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        done.store(true);
+        writer.join();
+    }, 3);
+}
+
+int main()
+{
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    // powers of two up to the number of hardware threads, and that number
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    for (std::size_t readers : counts)
+    {
+        measure<locked_config>("mutex", readers);
+        measure<shared_config>("atomic shared_ptr", readers);
+        measure<rcu_config>("rcu_variant", readers);
+    }
+}
@@ -0,0 +1,134 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/seqlock_variant.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct Halted { int reason; };
+struct Book
+{
+    std::uint64_t seq;
+    double bid[10];
+    double ask[10];
+};
+
+using snapshot = eggs::variant<Halted, Book>;
+
+class locked_snapshot
+{
+public:
+    snapshot load() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _value;
+    }
+
+    void store(snapshot const& v)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _value = v;
+    }
+
+private:
+    mutable std::mutex _mutex;
+    snapshot _value;
+};
+
+// Times loads and stores of `cell` while `readers` background threads keep
+// loading and, if `writer` is set, a background thread keeps storing.
+template <typename Cell>
+void measure(char const* kind, Cell& cell, std::size_t readers, bool writer)
+{
+    std::size_t const ops = 1 << 16;
+
+    Book book = {};
+    cell.store(book);
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (std::size_t r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&]
+        {
+            while (!done.load(std::memory_order_relaxed))
+                benchmark::do_not_optimize(cell.load().which());
+        });
+    }
+    if (writer)
+    {
+        threads.emplace_back([&]
+        {
+            Book b = {};
+            while (!done.load(std::memory_order_relaxed))
+            {
+                ++b.seq;
+                cell.store(b);
+            }
+        });
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s load, %u readers%s",
+        kind, unsigned(readers), writer ? " + writer" : "");
+    benchmark::run(name, ops, [&]
+    {
+        for (std::size_t i = 0; i < ops; ++i)
+            benchmark::do_not_optimize(cell.load().which());
+    });
+
+    if (!writer)
+    {
+        std::snprintf(name, sizeof(name), "%s store, %u readers",
+            kind, unsigned(readers));
+        benchmark::run(name, ops, [&]
+        {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                ++book.seq;
+                cell.store(book);
+            }
+        });
+    }
+
+    done.store(true);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+int main()
+{
+    eggs::variants::seqlock_variant<Halted, Book> seqlock;
+    locked_snapshot locked;
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    // 0, 1, 3, 7, ... background readers, leaving a thread for the writer
+    std::vector<std::size_t> counts;
+    for (std::size_t readers = 1; readers < max_threads; readers *= 2)
+        counts.push_back(readers - 1);
+    if (counts.empty())
+        counts.push_back(0);
+
+    for (std::size_t readers : counts)
+    {
+        measure("mutex", locked, readers, false);
+        measure("seqlock_variant", seqlock, readers, false);
+        measure("mutex", locked, readers, true);
+        measure("seqlock_variant", seqlock, readers, true);
+    }
+}
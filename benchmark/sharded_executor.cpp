@@ -0,0 +1,113 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/sharded_executor.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+template <std::size_t K>
+struct update { std::uint32_t key; std::uint32_t value; };
+
+using message = eggs::variant<
+    update<0>, update<1>, update<2>, update<3>,
+    update<4>, update<5>, update<6>, update<7>>;
+
+// a handler with a 256KiB table per alternative, which stays in the cache
+// of a worker only if that worker sees few alternatives
+struct handler
+{
+    static std::size_t const table_size = 1 << 16;
+
+    std::vector<std::uint32_t> tables[8];
+
+    handler()
+    {
+        for (std::vector<std::uint32_t>& table : tables)
+            table.assign(table_size, 0);
+    }
+
+    template <std::size_t K>
+    void operator()(update<K> const& u)
+    {
+        std::vector<std::uint32_t>& table = tables[K];
+        std::uint32_t h = u.key;
+        for (int i = 0; i < 4; ++i)
+        {
+            h = h * 2654435761u + u.value;
+            table[h % table_size] += u.value;
+        }
+    }
+};
+
+template <std::size_t K>
+static void push(std::vector<message>& messages, std::uint32_t i)
+{
+    messages.push_back(update<K>{i * 7919u, i});
+}
+
+static std::vector<message> make_messages(std::size_t n)
+{
+    std::vector<message> messages;
+    messages.reserve(n);
+    for (std::uint32_t i = 0; i < n; ++i)
+    {
+        switch (i * 5 % 8)
+        {
+        case 0: push<0>(messages, i); break;
+        case 1: push<1>(messages, i); break;
+        case 2: push<2>(messages, i); break;
+        case 3: push<3>(messages, i); break;
+        case 4: push<4>(messages, i); break;
+        case 5: push<5>(messages, i); break;
+        case 6: push<6>(messages, i); break;
+        default: push<7>(messages, i); break;
+        }
+    }
+    return messages;
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::vector<message> const messages = make_messages(n);
+
+    std::size_t shards = std::thread::hardware_concurrency();
+    if (shards == 0)
+        shards = 1;
+
+    using executor = eggs::variants::sharded_executor<message, handler>;
+    executor e(handler(), shards);
+
+    char name[64];
+    std::snprintf(name, sizeof(name),
+        "round-robin, %u shards", unsigned(shards));
+    benchmark::run(name, n, [&]
+    {
+        std::size_t shard = 0;
+        for (message const& m : messages)
+        {
+            e.submit_to(shard, m);
+            shard = shard + 1 != shards ? shard + 1 : 0;
+        }
+        e.flush();
+    }, 3);
+
+    std::snprintf(name, sizeof(name),
+        "by alternative, %u shards", unsigned(shards));
+    benchmark::run(name, n, [&]
+    {
+        for (message const& m : messages)
+            e.submit(m);
+        e.flush();
+    }, 3);
+}
@@ -0,0 +1,159 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/shm_channel.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "benchmark.hpp"
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_POSIX_HAS_SHARED_MEMORY
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#if EGGS_POSIX_HAS_SHARED_MEMORY
+struct quote { std::uint32_t instrument; double bid; double ask; };
+struct trade { std::uint32_t instrument; double price; std::uint32_t size; };
+struct heartbeat { std::uint64_t sequence; };
+
+using message = eggs::variant<quote, trade, heartbeat>;
+using channel = eggs::variants::shm_channel<quote, trade, heartbeat>;
+
+static message make_message(std::uint32_t i)
+{
+    switch (i % 4)
+    {
+    case 0: case 1: return quote{i, 1.0, 1.5};
+    case 2: return trade{i, 1.25, i};
+    default: return heartbeat{i};
+    }
+}
+
+struct totals
+{
+    std::uint64_t sum;
+
+    void operator()(quote const& q) { sum += q.instrument; }
+    void operator()(trade const& t) { sum += t.size; }
+    void operator()(heartbeat const& h) { sum += h.sequence; }
+};
+
+static void wait_child(::pid_t pid)
+{
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        std::fprintf(stderr, "sender process failed\n");
+}
+
+// the baseline: each message written to a pipe as its object
+// representation, and read back into a local variant
+static void run_pipe(std::size_t n, totals& t)
+{
+    int fds[2];
+    if (::pipe(fds) != 0)
+        return;
+
+    ::pid_t const pid = ::fork();
+    if (pid == 0)
+    {
+        ::close(fds[0]);
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            message const m = make_message(i);
+            if (::write(fds[1], &m, sizeof(m)) != sizeof(m))
+                ::_exit(1);
+        }
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+
+    message m;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        char* bytes = reinterpret_cast<char*>(&m);
+        std::size_t read = 0;
+        while (read < sizeof(m))
+        {
+            ::ssize_t const r = ::read(fds[0], bytes + read, sizeof(m) - read);
+            if (r <= 0)
+                break;
+            read += std::size_t(r);
+        }
+        eggs::variants::apply<void>(t, m);
+    }
+    ::close(fds[0]);
+    wait_child(pid);
+}
+
+static void run_channel(
+    char const* name, std::size_t n, std::size_t batch, totals& t)
+{
+    channel receiver = channel::create(name, 1024);
+
+    ::pid_t const pid = ::fork();
+    if (pid == 0)
+    {
+        channel sender = channel::open(name);
+        for (std::uint32_t i = 0; i < n; ++i)
+            sender.send(make_message(i));
+        ::_exit(0);
+    }
+
+    std::size_t consumed = 0;
+    while (consumed < n)
+    {
+        receiver.wait();
+        consumed += receiver.consume(t, batch);
+    }
+    wait_child(pid);
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+
+    char name[64];
+    std::snprintf(name, sizeof(name),
+        "/eggs_variant_benchmark_%ld", static_cast<long>(::getpid()));
+
+    {
+        totals t = {0};
+        benchmark::run("pipe, write/read per message", n, [&]
+        {
+            run_pipe(n, t);
+            benchmark::do_not_optimize(t);
+        }, 3);
+    }
+
+    {
+        totals t = {0};
+        benchmark::run("shm_channel, consume one", n, [&]
+        {
+            run_channel(name, n, 1, t);
+            benchmark::do_not_optimize(t);
+        }, 3);
+    }
+
+    {
+        totals t = {0};
+        benchmark::run("shm_channel, consume batch", n, [&]
+        {
+            run_channel(name, n, 256, t);
+            benchmark::do_not_optimize(t);
+        }, 3);
+    }
+}
+#else
+int main() {}
+#endif
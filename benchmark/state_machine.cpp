@@ -0,0 +1,195 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/state_machine.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+struct closed
+{
+    std::uint32_t restarts;
+    explicit closed(std::uint32_t restarts = 0) : restarts(restarts) {}
+};
+
+struct opening
+{
+    std::uint32_t session;
+    std::uint32_t attempts;
+    opening(std::uint32_t session, std::uint32_t attempts)
+      : session(session), attempts(attempts) {}
+};
+
+struct streaming
+{
+    std::uint32_t session;
+    std::uint64_t bytes;
+    streaming(std::uint32_t session, std::uint64_t bytes)
+      : session(session), bytes(bytes) {}
+};
+
+struct draining
+{
+    std::uint32_t session;
+    std::uint64_t pending;
+    draining(std::uint32_t session, std::uint64_t pending)
+      : session(session), pending(pending) {}
+};
+
+struct start { std::uint32_t session; };
+struct timeout {};
+struct ack {};
+struct data { std::uint32_t size; };
+struct finish {};
+
+using states = eggs::variant<closed, opening, streaming, draining>;
+using events = eggs::variant<start, timeout, ack, data, finish>;
+
+static std::vector<events> make_events(std::size_t n)
+{
+    // a session is opened, retried, fed and drained, with a few events
+    // that are not handled in the state they arrive in
+    static events const cycle[] = {
+        start{1}, data{0}, timeout{}, timeout{}, ack{},
+        data{64}, data{128}, start{2}, data{256},
+        finish{}, data{32}, ack{}, timeout{}};
+    std::size_t const length = sizeof(cycle) / sizeof(cycle[0]);
+
+    std::vector<events> result;
+    result.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        result.push_back(cycle[i % length]);
+    return result;
+}
+
+// the baseline: a visit of the state and the event returns the next state
+// as a temporary variant, which is then move assigned to the current one
+struct next_state
+{
+    states operator()(closed&, start const& e) const
+    {
+        return opening(e.session, 0);
+    }
+    states operator()(opening& s, timeout const&) const
+    {
+        ++s.attempts;
+        return s;
+    }
+    states operator()(opening& s, ack const&) const
+    {
+        return streaming(s.session, 0);
+    }
+    states operator()(streaming& s, data const& e) const
+    {
+        s.bytes += e.size;
+        return s;
+    }
+    states operator()(streaming& s, finish const&) const
+    {
+        return draining(s.session, s.bytes);
+    }
+    states operator()(draining& s, data const& e) const
+    {
+        s.pending -= e.size < s.pending ? e.size : s.pending;
+        return s;
+    }
+    states operator()(draining& s, ack const&) const
+    {
+        return closed(s.session);
+    }
+
+    // everything else stays where it is
+    template <typename S, typename E>
+    states operator()(S& s, E const&) const
+    {
+        return s;
+    }
+};
+
+using eggs::variants::transition;
+using eggs::variants::transition_to;
+
+struct protocol
+{
+    transition<opening, std::uint32_t, std::uint32_t>
+    operator()(closed&, start const& e) const
+    {
+        return transition_to<opening>(e.session, 0u);
+    }
+    void operator()(opening& s, timeout const&) const
+    {
+        ++s.attempts;
+    }
+    transition<streaming, std::uint32_t, std::uint64_t>
+    operator()(opening& s, ack const&) const
+    {
+        return transition_to<streaming>(s.session, std::uint64_t(0));
+    }
+    void operator()(streaming& s, data const& e) const
+    {
+        s.bytes += e.size;
+    }
+    transition<draining, std::uint32_t, std::uint64_t>
+    operator()(streaming& s, finish const&) const
+    {
+        return transition_to<draining>(s.session, s.bytes);
+    }
+    void operator()(draining& s, data const& e) const
+    {
+        s.pending -= e.size < s.pending ? e.size : s.pending;
+    }
+    transition<closed, std::uint32_t>
+    operator()(draining& s, ack const&) const
+    {
+        return transition_to<closed>(s.session);
+    }
+};
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::vector<events> const input = make_events(n);
+
+    {
+        std::uint64_t sum = 0;
+        benchmark::run("apply, move assign next state", n, [&]
+        {
+            states current(closed(0));
+            for (events const& e : input)
+            {
+                states next = eggs::variants::apply<states>(
+                    next_state(), current, e);
+                current = std::move(next);
+                sum += current.which();
+            }
+            benchmark::do_not_optimize(sum);
+        });
+    }
+
+    {
+        using machine =
+            eggs::variants::state_machine<states, events, protocol>;
+
+        std::uint64_t sum = 0;
+        benchmark::run("state_machine, process(variant)", n, [&]
+        {
+            machine m;
+            for (events const& e : input)
+            {
+                sum += m.process(e);
+                sum += m.state().which();
+            }
+            benchmark::do_not_optimize(sum);
+        });
+    }
+}
@@ -0,0 +1,90 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/tag_scan.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using variant = eggs::variant<int, double, std::string>;
+using column = eggs::variants::variant_column<int, double, std::string>;
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    column c;
+    c.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        switch (gen() % 3)
+        {
+        case 0: c.push_back(variant(int(i))); break;
+        case 1: c.push_back(variant(double(i))); break;
+        case 2: c.push_back(variant(std::string())); break;
+        }
+    }
+    column::tag_type const* const tags = c.tags();
+
+    benchmark::run("scalar histogram", n, [&]
+    {
+        std::array<std::size_t, 4> counts = {{0, 0, 0, 0}};
+        for (std::size_t i = 0; i < n; ++i)
+            ++counts[tags[i]];
+        benchmark::do_not_optimize(counts);
+    });
+
+    benchmark::run("count_by_alternative", n, [&]
+    {
+        std::array<std::size_t, 3> counts =
+            eggs::variants::count_by_alternative(c);
+        benchmark::do_not_optimize(counts);
+    });
+
+    std::vector<std::uint64_t> words((n + 63) / 64);
+    benchmark::run("scalar mask", n, [&]
+    {
+        for (std::size_t w = 0; w < words.size(); ++w)
+        {
+            std::uint64_t word = 0;
+            for (std::size_t i = 0; i < 64; ++i)
+                word |= std::uint64_t(tags[w * 64 + i] == 2) << i;
+            words[w] = word;
+        }
+        benchmark::do_not_optimize(words);
+    });
+
+    benchmark::run("mask_of<double>", n, [&]
+    {
+        eggs::variants::mask_of<double>(c, words.data());
+        benchmark::do_not_optimize(words);
+    });
+
+    std::vector<std::uint32_t> indices(n);
+    benchmark::run("scalar compress", n, [&]
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            if (tags[i] == 2)
+                indices[count++] = static_cast<std::uint32_t>(i);
+        benchmark::do_not_optimize(count);
+    });
+
+    benchmark::run("compress_indices<double>", n, [&]
+    {
+        std::size_t count =
+            eggs::variants::compress_indices<double>(c, indices.data());
+        benchmark::do_not_optimize(count);
+    });
+}
@@ -0,0 +1,82 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/transform_runs.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct Key { int code; };
+struct Click { int x, y; };
+struct Scroll { double delta; };
+struct Resize { int width, height; };
+
+using event = eggs::variant<Key, Click, Scroll, Resize>;
+
+struct Weight
+{
+    double operator()(Key const& e) const { return e.code; }
+    double operator()(Click const& e) const { return e.x * e.y; }
+    double operator()(Scroll const& e) const { return -e.delta; }
+    double operator()(Resize const& e) const { return e.width + e.height; }
+};
+
+event make_event(unsigned k, int i)
+{
+    switch (k % 4)
+    {
+    case 0: return Key{i};
+    case 1: return Click{i, 2};
+    case 2: return Scroll{i * 0.5};
+    default: return Resize{i, i};
+    }
+}
+
+void bench(char const* name, std::vector<event> const& es)
+{
+    std::string prefix = name;
+    std::vector<double> out(es.size());
+
+    benchmark::run((prefix + " apply loop").c_str(), es.size(), [&]
+    {
+        for (std::size_t i = 0; i < es.size(); ++i)
+            out[i] = eggs::variants::apply<double>(Weight{}, es[i]);
+        benchmark::do_not_optimize(out);
+    });
+
+    benchmark::run((prefix + " transform_runs").c_str(), es.size(), [&]
+    {
+        eggs::variants::transform_runs(
+            es.begin(), es.end(), out.begin(), Weight{});
+        benchmark::do_not_optimize(out);
+    });
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    std::vector<event> bursty;
+    while (bursty.size() < n)
+    {
+        unsigned const k = gen();
+        std::size_t const burst = 16 + gen() % 240;
+        for (std::size_t i = 0; i < burst && bursty.size() < n; ++i)
+            bursty.push_back(make_event(k, int(bursty.size())));
+    }
+    bench("bursty", bursty);
+
+    std::vector<event> random;
+    for (std::size_t i = 0; i < n; ++i)
+        random.push_back(make_event(gen(), int(i)));
+    bench("random", random);
+}
@@ -0,0 +1,67 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_column.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+using variant = eggs::variant<int, double, std::string>;
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    std::vector<variant> vs;
+    eggs::variants::variant_column<int, double, std::string> column;
+    column.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        switch (gen() % 3)
+        {
+        case 0: vs.push_back(int(i)); break;
+        case 1: vs.push_back(double(i)); break;
+        case 2: vs.push_back(std::string(8, 'x')); break;
+        }
+        column.push_back(vs.back());
+    }
+
+    benchmark::run("vector<variant> count which() == 1", n, [&]
+    {
+        std::size_t count = 0;
+        for (variant const& v : vs)
+            count += v.which() == 1;
+        benchmark::do_not_optimize(count);
+    });
+
+    benchmark::run("variant_column count<double>()", n, [&]
+    {
+        std::size_t count = column.count<double>();
+        benchmark::do_not_optimize(count);
+    });
+
+    benchmark::run("vector<variant> sum of doubles", n, [&]
+    {
+        double sum = 0;
+        for (variant const& v : vs)
+            if (double const* d = v.target<double>())
+                sum += *d;
+        benchmark::do_not_optimize(sum);
+    });
+
+    benchmark::run("variant_column for_each<double>", n, [&]
+    {
+        double sum = 0;
+        column.for_each<double>([&sum](double d) { sum += d; });
+        benchmark::do_not_optimize(sum);
+    });
+}
@@ -0,0 +1,167 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_queue.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct order
+{
+    std::size_t id;
+    double price;
+    int quantity;
+
+    order(std::size_t id, double price, int quantity)
+      : id(id), price(price), quantity(quantity)
+    {}
+};
+
+struct cancel
+{
+    std::size_t id;
+
+    explicit cancel(std::size_t id) : id(id) {}
+};
+
+struct heartbeat {};
+
+using message = eggs::variant<order, cancel, heartbeat>;
+
+struct handler
+{
+    std::size_t sum;
+
+    void operator()(order const& o) { sum += o.id + std::size_t(o.quantity); }
+    void operator()(cancel const& c) { sum -= c.id; }
+    void operator()(heartbeat const&) { ++sum; }
+};
+
+class locked_queue
+{
+public:
+    explicit locked_queue(std::size_t /*capacity*/) {}
+
+    void send(std::size_t i)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (i % 4 == 3)
+            _messages.push_back(message(cancel(i)));
+        else
+            _messages.push_back(message(order(i, 1.5, 10)));
+    }
+
+    std::size_t receive(handler& h)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::size_t const count = _messages.size();
+        for (message& m : _messages)
+            eggs::variants::apply(h, m);
+        _messages.clear();
+        return count;
+    }
+
+private:
+    std::mutex _mutex;
+    std::deque<message> _messages;
+};
+
+template <template <typename...> class Queue>
+class lockfree_queue
+{
+public:
+    explicit lockfree_queue(std::size_t capacity) : _queue(capacity) {}
+
+    void send(std::size_t i)
+    {
+        bool sent;
+        do {
+            sent = i % 4 == 3
+              ? _queue.template try_emplace<cancel>(i)
+              : _queue.template try_emplace<order>(i, 1.5, 10);
+            if (!sent)
+                std::this_thread::yield();
+        } while (!sent);
+    }
+
+    std::size_t receive(handler& h)
+    {
+        return _queue.consume_all(h);
+    }
+
+private:
+    Queue<order, cancel, heartbeat> _queue;
+};
+
+// Times `producers` threads sending messages to a single consumer that
+// drains the queue in batches.
+template <typename Queue>
+void measure(char const* kind, std::size_t producers)
+{
+    std::size_t const ops = 1 << 18;
+
+    char name[64];
+    std::snprintf(name, sizeof(name),
+        "%s, %u producers", kind, unsigned(producers));
+    benchmark::run(name, ops * producers, [&]
+    {
+        Queue queue(1024);
+
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&queue, p, ops]
+            {
+                for (std::size_t i = 0; i < ops; ++i)
+                    queue.send(p * ops + i);
+            });
+        }
+
+        handler h = {0};
+        std::size_t received = 0;
+        while (received < ops * producers)
+        {
+            std::size_t const count = queue.receive(h);
+            if (count == 0)
+                std::this_thread::yield();
+            received += count;
+        }
+        benchmark::do_not_optimize(h.sum);
+
+        for (std::thread& thread : threads)
+            thread.join();
+    }, 3);
+}
+
+int main()
+{
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    measure<locked_queue>("mutex + deque", 1);
+    measure<lockfree_queue<eggs::variants::spsc_queue>>("spsc_queue", 1);
+
+    // powers of two up to the number of hardware threads, and that number
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    for (std::size_t producers : counts)
+    {
+        measure<locked_queue>("mutex + deque", producers);
+        measure<lockfree_queue<eggs::variants::mpsc_queue>>(
+            "mpsc_queue", producers);
+    }
+}
@@ -0,0 +1,75 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_sort.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+template <typename Variant>
+void bench(char const* name, std::vector<Variant> const& input)
+{
+    std::string prefix = name;
+    std::vector<Variant> vs;
+
+    benchmark::run((prefix + " std::sort").c_str(), input.size(), [&]
+    {
+        vs = input;
+        std::sort(vs.begin(), vs.end());
+        benchmark::do_not_optimize(vs);
+    });
+
+    benchmark::run((prefix + " variant_sort").c_str(), input.size(), [&]
+    {
+        vs = input;
+        eggs::variants::variant_sort(vs.begin(), vs.end());
+        benchmark::do_not_optimize(vs);
+    });
+
+    benchmark::run((prefix + " copy only").c_str(), input.size(), [&]
+    {
+        vs = input;
+        benchmark::do_not_optimize(vs);
+    });
+}
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    using number = eggs::variant<std::int32_t, std::int64_t, double>;
+    std::vector<number> numbers;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::uint32_t const x = gen();
+        switch (x % 3)
+        {
+        case 0: numbers.push_back(std::int32_t(gen())); break;
+        case 1: numbers.push_back(std::int64_t(gen()) << 16); break;
+        case 2: numbers.push_back(double(gen()) * 0.25); break;
+        }
+    }
+    bench("numbers", numbers);
+
+    using mixed = eggs::variant<int, std::string>;
+    std::vector<mixed> strings;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (gen() % 2 == 0)
+            strings.push_back(int(gen()));
+        else
+            strings.push_back(std::to_string(gen()));
+    }
+    bench("int/string", strings);
+}
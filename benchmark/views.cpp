@@ -0,0 +1,55 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/views.hpp>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+struct Quote { double bid, ask; };
+struct Trade { double price; int size; };
+struct Status { int code; };
+
+using message = eggs::variant<Quote, Trade, Status>;
+
+int main()
+{
+    std::size_t const n = 1 << 20;
+    std::mt19937 gen(42);
+
+    std::vector<message> ms;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        switch (gen() % 3)
+        {
+        case 0: ms.push_back(Quote{double(i), double(i) + 1}); break;
+        case 1: ms.push_back(Trade{double(i), int(i)}); break;
+        case 2: ms.push_back(Status{int(i)}); break;
+        }
+    }
+
+    benchmark::run("target<Quote>() loop", n, [&]
+    {
+        double spread = 0;
+        for (message const& m : ms)
+            if (Quote const* q = m.target<Quote>())
+                spread += q->ask - q->bid;
+        benchmark::do_not_optimize(spread);
+    });
+
+    benchmark::run("only<Quote>() view", n, [&]
+    {
+        double spread = 0;
+        for (Quote const& q : ms | eggs::variants::only<Quote>())
+            spread += q.ask - q.bid;
+        benchmark::do_not_optimize(spread);
+    });
+}
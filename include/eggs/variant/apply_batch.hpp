@@ -0,0 +1,169 @@
+//! \file eggs/variant/apply_batch.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_APPLY_BATCH_HPP
+#define EGGS_VARIANT_APPLY_BATCH_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! struct ordered_t {};
+    //! struct unordered_t {};
+    //!
+    //! The structs `ordered_t` and `unordered_t` are empty structure types
+    //! used to select whether a batch operation over a range of variants
+    //! preserves the order of the elements.
+    struct ordered_t {};
+    struct unordered_t {};
+
+    //! constexpr ordered_t ordered{};
+    EGGS_CXX11_CONSTEXPR ordered_t const ordered = {};
+
+    //! constexpr unordered_t unordered{};
+    EGGS_CXX11_CONSTEXPR unordered_t const unordered = {};
+
+    namespace detail
+    {
+        template <typename F, typename V>
+        void _apply_one(F& /*f*/, V&& /*v*/, index<0>)
+        {
+            throw_bad_variant_access<void>();
+        }
+
+        template <typename F, typename V, std::size_t I>
+        void _apply_one(F& f, V&& v, index<I>)
+        {
+            detail::_invoke(f, access::get(v, index<I - 1>{}));
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        template <typename RandomIt, typename F>
+        struct _apply_batch
+        {
+            EGGS_CXX11_STATIC_CONSTEXPR std::size_t prefetch_distance = 8;
+
+            template <typename I>
+            static void call(
+                RandomIt const& block, std::uint16_t const* indices,
+                std::size_t count, std::size_t /*offset*/, F& f)
+            {
+                if (indices == nullptr)
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                        _apply_one(f, block[i], I{});
+                } else {
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        if (i + prefetch_distance < count)
+                        {
+                            detail::prefetch(std::addressof(
+                                block[indices[i + prefetch_distance]]));
+                        }
+                        _apply_one(f, block[indices[i]], I{});
+                    }
+                }
+            }
+        };
+
+        template <typename RandomIt, typename F>
+        struct _apply_run
+        {
+            template <typename I>
+            static void call(
+                RandomIt const& run, std::size_t count,
+                std::size_t /*offset*/, F& f)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                    _apply_one(f, run[i], I{});
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class F, class RandomIt>
+    //! void apply_batch(unordered_t, F&& f, RandomIt first, RandomIt last);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>`. `INVOKE(f,
+    //!  get<I>(*it))` shall be a valid expression for every iterator `it` in
+    //!  `[first, last)` and every `I` in the range `[0u, sizeof...(Ts))`.
+    //!
+    //! \effects Evaluates `INVOKE(f, get<I>(*it))` exactly once for every `it`
+    //!  in `[first, last)`, where `I` is `it->which()`, in an unspecified
+    //!  order.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, in which case `f` may have been invoked on an
+    //!  unspecified subset of the elements.
+    //!
+    //! \remarks The range is processed in blocks, each of which is partitioned
+    //!  by `which()` with a counting pass. Then a loop specialized for each
+    //!  alternative present in the block invokes `f` on all of its elements,
+    //!  prefetching ahead, so that there is a single indirect dispatch per
+    //!  alternative per block instead of one per element.
+    template <typename F, typename RandomIt>
+    void apply_batch(unordered_t, F&& f, RandomIt first, RandomIt last)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        detail::batch_dispatch<detail::_apply_batch<RandomIt, fun>>(
+            first, last, f);
+    }
+
+    //! template <class F, class RandomIt>
+    //! void apply_batch(ordered_t, F&& f, RandomIt first, RandomIt last);
+    //!
+    //! \requires The same as for `apply_batch(unordered, f, first, last)`.
+    //!
+    //! \effects Evaluates `INVOKE(f, get<I>(*it))` for every `it` in `[first,
+    //!  last)` in order, where `I` is `it->which()`.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, in which case `f` has been invoked on all the
+    //!  elements that precede it.
+    //!
+    //! \remarks There is a single indirect dispatch per maximal run of
+    //!  consecutive elements holding the same alternative. This mode is best
+    //!  suited to ranges where alternatives come in bursts; for finely mixed
+    //!  ranges the unordered mode avoids more mispredicted branches.
+    template <typename F, typename RandomIt>
+    void apply_batch(ordered_t, F&& f, RandomIt first, RandomIt last)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        detail::for_each_run<detail::_apply_run<RandomIt, fun>>(
+            first, last, f);
+    }
+
+    //! template <class F, class RandomIt>
+    //! void apply_batch(F&& f, RandomIt first, RandomIt last);
+    //!
+    //! \effects Equivalent to `apply_batch(unordered, std::forward<F>(f),
+    //!  first, last)`.
+    template <typename F, typename RandomIt>
+    void apply_batch(F&& f, RandomIt first, RandomIt last)
+    {
+        apply_batch(unordered, std::forward<F>(f), first, last);
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_APPLY_BATCH_HPP*/
@@ -0,0 +1,549 @@
+//! \file eggs/variant/atomic_variant.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_ATOMIC_VARIANT_HPP
+#define EGGS_VARIANT_ATOMIC_VARIANT_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/in_place.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/visitor.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        ///////////////////////////////////////////////////////////////////////
+        inline std::memory_order _cas_failure_order(
+            std::memory_order order) EGGS_CXX11_NOEXCEPT
+        {
+            return order == std::memory_order_acq_rel
+              ? std::memory_order_acquire
+              : order == std::memory_order_release
+              ? std::memory_order_relaxed
+              : order;
+        }
+
+        // An 8 byte word, over a native 64-bit atomic.
+        class _atomic_word8
+        {
+        public:
+            struct value_type
+            {
+                std::uint64_t bits;
+            };
+
+            explicit _atomic_word8(value_type w) EGGS_CXX11_NOEXCEPT
+              : _word(w.bits)
+            {}
+
+            bool is_lock_free() const EGGS_CXX11_NOEXCEPT
+            {
+                return _word.is_lock_free();
+            }
+
+            value_type load(std::memory_order order) const EGGS_CXX11_NOEXCEPT
+            {
+                value_type const w = {_word.load(order)};
+                return w;
+            }
+
+            void store(value_type w, std::memory_order order) EGGS_CXX11_NOEXCEPT
+            {
+                _word.store(w.bits, order);
+            }
+
+            value_type exchange(
+                value_type w, std::memory_order order) EGGS_CXX11_NOEXCEPT
+            {
+                value_type const old = {_word.exchange(w.bits, order)};
+                return old;
+            }
+
+            bool compare_exchange(
+                value_type& expected, value_type desired, bool weak,
+                std::memory_order success,
+                std::memory_order failure) EGGS_CXX11_NOEXCEPT
+            {
+                return weak
+                  ? _word.compare_exchange_weak(
+                        expected.bits, desired.bits, success, failure)
+                  : _word.compare_exchange_strong(
+                        expected.bits, desired.bits, success, failure);
+            }
+
+        private:
+            std::atomic<std::uint64_t> _word;
+        };
+
+#if EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+        __extension__ typedef unsigned __int128 _uint128;
+
+        inline bool _has_cmpxchg16b() EGGS_CXX11_NOEXCEPT
+        {
+            static bool const has_cmpxchg16b =
+                (__builtin_cpu_init(),
+                 __builtin_cpu_supports("cmpxchg16b") != 0);
+            return has_cmpxchg16b;
+        }
+
+        // `lock cmpxchg16b` is a full barrier, whatever the memory order
+        __attribute__((target("cx16")))
+        inline _uint128 _cas16(
+            _uint128* word,
+            _uint128 expected,
+            _uint128 desired) EGGS_CXX11_NOEXCEPT
+        {
+            return __sync_val_compare_and_swap(word, expected, desired);
+        }
+#endif
+
+        // A 16 byte word, over `cmpxchg16b` where the processor supports
+        // it, or over a spin lock otherwise.
+        class _atomic_word16
+        {
+        public:
+            struct value_type
+            {
+                std::uint64_t bits[2];
+            };
+
+            explicit _atomic_word16(value_type w) EGGS_CXX11_NOEXCEPT
+            {
+                std::memcpy(&_word, &w, sizeof(w));
+                _lock.clear();
+            }
+
+            bool is_lock_free() const EGGS_CXX11_NOEXCEPT
+            {
+#if EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+                return _has_cmpxchg16b();
+#else
+                return false;
+#endif
+            }
+
+            value_type load(std::memory_order /*order*/) const EGGS_CXX11_NOEXCEPT
+            {
+                value_type w;
+#if EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+                if (_has_cmpxchg16b())
+                {
+                    // swaps zero for zero, so the value is left unchanged
+                    _uint128 const bits = _cas16(&_word, 0, 0);
+                    std::memcpy(&w, &bits, sizeof(w));
+                    return w;
+                }
+#endif
+                _acquire();
+                std::memcpy(&w, &_word, sizeof(w));
+                _release();
+                return w;
+            }
+
+            void store(value_type w, std::memory_order order) EGGS_CXX11_NOEXCEPT
+            {
+                exchange(w, order);
+            }
+
+            value_type exchange(
+                value_type w, std::memory_order /*order*/) EGGS_CXX11_NOEXCEPT
+            {
+                value_type old;
+#if EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+                if (_has_cmpxchg16b())
+                {
+                    _uint128 desired;
+                    std::memcpy(&desired, &w, sizeof(w));
+                    _uint128 expected = 0;
+                    for (;;)
+                    {
+                        _uint128 const seen =
+                            _cas16(&_word, expected, desired);
+                        if (seen == expected)
+                            break;
+                        expected = seen;
+                    }
+                    std::memcpy(&old, &expected, sizeof(old));
+                    return old;
+                }
+#endif
+                _acquire();
+                std::memcpy(&old, &_word, sizeof(old));
+                std::memcpy(&_word, &w, sizeof(w));
+                _release();
+                return old;
+            }
+
+            bool compare_exchange(
+                value_type& expected, value_type desired, bool /*weak*/,
+                std::memory_order /*success*/,
+                std::memory_order /*failure*/) EGGS_CXX11_NOEXCEPT
+            {
+#if EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+                if (_has_cmpxchg16b())
+                {
+                    _uint128 e, d;
+                    std::memcpy(&e, &expected, sizeof(e));
+                    std::memcpy(&d, &desired, sizeof(d));
+                    _uint128 const seen = _cas16(&_word, e, d);
+                    std::memcpy(&expected, &seen, sizeof(expected));
+                    return seen == e;
+                }
+#endif
+                _acquire();
+                bool const equal =
+                    std::memcmp(&_word, &expected, sizeof(expected)) == 0;
+                if (equal)
+                    std::memcpy(&_word, &desired, sizeof(desired));
+                else
+                    std::memcpy(&expected, &_word, sizeof(expected));
+                _release();
+                return equal;
+            }
+
+        private:
+            void _acquire() const EGGS_CXX11_NOEXCEPT
+            {
+                while (_lock.test_and_set(std::memory_order_acquire))
+                    ;
+            }
+
+            void _release() const EGGS_CXX11_NOEXCEPT
+            {
+                _lock.clear(std::memory_order_release);
+            }
+
+        private:
+#if EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+            // loads are done with `cmpxchg16b` too, which needs to write
+            alignas(16) mutable _uint128 _word;
+#else
+            value_type _word;
+#endif
+            mutable std::atomic_flag _lock;
+        };
+
+        ///////////////////////////////////////////////////////////////////////
+        template <typename ...Ts>
+        struct _atomic_unpack
+        {
+            template <typename I>
+            static variant<Ts...> call(unsigned char const* bytes)
+            {
+                using T = typename at_index<I::value, pack<Ts...>>::type;
+
+                alignas(T) unsigned char buffer[sizeof(T)] = {};
+                std::memcpy(buffer, bytes, sizeof(T));
+                return variant<Ts...>(in_place<I::value>,
+                    *reinterpret_cast<T const*>(buffer));
+            }
+        };
+
+        template <std::size_t ...Vs>
+        struct _max_of;
+
+        template <>
+        struct _max_of<>
+          : std::integral_constant<std::size_t, 0>
+        {};
+
+        template <std::size_t V, std::size_t ...Vs>
+        struct _max_of<V, Vs...>
+          : std::integral_constant<std::size_t,
+                (V > _max_of<Vs...>::value ? V : _max_of<Vs...>::value)>
+        {};
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class atomic_variant;
+    //!
+    //! An `atomic_variant<Ts...>` holds a `variant<Ts...>` that can be
+    //! loaded, stored and exchanged concurrently without data races. The
+    //! value is kept packed into a single word: the active member followed
+    //! by a one byte discriminator, padded with zero bytes. The word is 8
+    //! bytes when `max(sizeof(Ts)...) < 8`, and 16 bytes otherwise.
+    //!
+    //! 8 byte words use a native 64-bit atomic. 16 byte words use
+    //! `cmpxchg16b` on x86-64 processors that support it, detected at run
+    //! time, and a spin lock elsewhere; `is_lock_free()` tells which.
+    //!
+    //! \requires Every type in `Ts...` shall be trivially copyable, and
+    //!  `max(sizeof(Ts)...) < 16` shall be `true`.
+    //!
+    //! \remarks Comparisons made by `compare_exchange_weak` and
+    //!  `compare_exchange_strong` are on the packed representation; i.e.,
+    //!  on the discriminator and the object representation of the active
+    //!  member. Types with padding bits may then compare unequal despite
+    //!  holding equal values.
+    template <typename ...Ts>
+    class atomic_variant
+    {
+#if EGGS_CXX11_STD_HAS_IS_TRIVIALLY_COPYABLE
+        static_assert(
+            detail::all_of<detail::pack<
+                std::is_trivially_copyable<Ts>...
+            >>::value,
+            "atomic_variant requires trivially copyable alternatives");
+#endif
+        static_assert(sizeof...(Ts) < 255,
+            "atomic_variant supports up to 254 alternatives");
+
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _payload_size =
+            detail::_max_of<sizeof(Ts)...>::value;
+
+        static_assert(_payload_size < 16,
+            "atomic_variant requires alternatives smaller than 16 bytes");
+
+        using _word_type = typename std::conditional<
+            _payload_size < 8,
+            detail::_atomic_word8, detail::_atomic_word16
+        >::type;
+        using _word = typename _word_type::value_type;
+
+    public:
+        using value_type = variant<Ts...>;
+
+        //! static constexpr bool is_always_lock_free;
+        //!
+        //! `true` if the packed word is 8 bytes and 64-bit atomics are always
+        //! lock-free; otherwise, `false`.
+        EGGS_CXX11_STATIC_CONSTEXPR bool is_always_lock_free =
+            _payload_size < 8 && ATOMIC_LLONG_LOCK_FREE == 2;
+
+    public:
+        //! atomic_variant() noexcept;
+        //!
+        //! \postconditions `load().which() == npos`.
+        atomic_variant() EGGS_CXX11_NOEXCEPT
+          : _storage(_pack(value_type()))
+        {}
+
+        //! atomic_variant(variant<Ts...> const& v) noexcept;
+        //!
+        //! \effects Initializes the stored value to `v`. Initialization is
+        //!  not an atomic operation.
+        atomic_variant(value_type const& v) EGGS_CXX11_NOEXCEPT
+          : _storage(_pack(v))
+        {}
+
+        atomic_variant(atomic_variant const&) = delete;
+        atomic_variant& operator=(atomic_variant const&) = delete;
+
+        //! variant<Ts...> operator=(variant<Ts...> const& v) noexcept;
+        //!
+        //! \effects Equivalent to `store(v)`.
+        //!
+        //! \returns `v`.
+        value_type operator=(value_type const& v) EGGS_CXX11_NOEXCEPT
+        {
+            store(v);
+            return v;
+        }
+
+        //! operator variant<Ts...>() const noexcept;
+        //!
+        //! \returns `load()`.
+        operator value_type() const EGGS_CXX11_NOEXCEPT
+        {
+            return load();
+        }
+
+        //! bool is_lock_free() const noexcept;
+        //!
+        //! \returns `true` if the operations on `*this` are lock-free.
+        bool is_lock_free() const EGGS_CXX11_NOEXCEPT
+        {
+            return _storage.is_lock_free();
+        }
+
+        //! void store(
+        //!     variant<Ts...> const& v,
+        //!     std::memory_order order = std::memory_order_seq_cst) noexcept;
+        //!
+        //! \requires `order` shall not be `std::memory_order_consume`,
+        //!  `std::memory_order_acquire` nor `std::memory_order_acq_rel`.
+        //!
+        //! \effects Atomically replaces the stored value with `v`. Memory is
+        //!  affected according to `order`.
+        void store(value_type const& v,
+            std::memory_order order = std::memory_order_seq_cst
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            _storage.store(_pack(v), order);
+        }
+
+        //! variant<Ts...> load(
+        //!     std::memory_order order = std::memory_order_seq_cst) const noexcept;
+        //!
+        //! \requires `order` shall not be `std::memory_order_release` nor
+        //!  `std::memory_order_acq_rel`.
+        //!
+        //! \returns Atomically the stored value. Memory is affected according
+        //!  to `order`.
+        value_type load(
+            std::memory_order order = std::memory_order_seq_cst
+        ) const EGGS_CXX11_NOEXCEPT
+        {
+            return _unpack(_storage.load(order));
+        }
+
+        //! variant<Ts...> exchange(
+        //!     variant<Ts...> const& v,
+        //!     std::memory_order order = std::memory_order_seq_cst) noexcept;
+        //!
+        //! \effects Atomically replaces the stored value with `v`. Memory is
+        //!  affected according to `order`. This is a read-modify-write
+        //!  operation.
+        //!
+        //! \returns The stored value immediately before the effects.
+        value_type exchange(value_type const& v,
+            std::memory_order order = std::memory_order_seq_cst
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            return _unpack(_storage.exchange(_pack(v), order));
+        }
+
+        //! bool compare_exchange_weak(
+        //!     variant<Ts...>& expected, variant<Ts...> const& desired,
+        //!     std::memory_order success,
+        //!     std::memory_order failure) noexcept;
+        //!
+        //! bool compare_exchange_strong(
+        //!     variant<Ts...>& expected, variant<Ts...> const& desired,
+        //!     std::memory_order success,
+        //!     std::memory_order failure) noexcept;
+        //!
+        //! \requires `failure` shall not be `std::memory_order_release` nor
+        //!  `std::memory_order_acq_rel`.
+        //!
+        //! \effects Atomically compares the packed representation of the
+        //!  stored value with that of `expected`. If equal, replaces the
+        //!  stored value with `desired`, affecting memory according to
+        //!  `success`; otherwise, assigns the stored value to `expected`,
+        //!  affecting memory according to `failure`. The weak form may fail
+        //!  spuriously.
+        //!
+        //! \returns The result of the comparison.
+        bool compare_exchange_weak(
+            value_type& expected, value_type const& desired,
+            std::memory_order success, std::memory_order failure
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            return _compare_exchange(
+                expected, desired, true, success, failure);
+        }
+
+        bool compare_exchange_strong(
+            value_type& expected, value_type const& desired,
+            std::memory_order success, std::memory_order failure
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            return _compare_exchange(
+                expected, desired, false, success, failure);
+        }
+
+        //! bool compare_exchange_weak(
+        //!     variant<Ts...>& expected, variant<Ts...> const& desired,
+        //!     std::memory_order order = std::memory_order_seq_cst) noexcept;
+        //!
+        //! bool compare_exchange_strong(
+        //!     variant<Ts...>& expected, variant<Ts...> const& desired,
+        //!     std::memory_order order = std::memory_order_seq_cst) noexcept;
+        //!
+        //! \effects Equivalent to the forms above, where `failure` is
+        //!  `order`, except that `std::memory_order_acq_rel` becomes
+        //!  `std::memory_order_acquire` and `std::memory_order_release`
+        //!  becomes `std::memory_order_relaxed`.
+        bool compare_exchange_weak(
+            value_type& expected, value_type const& desired,
+            std::memory_order order = std::memory_order_seq_cst
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            return _compare_exchange(expected, desired, true,
+                order, detail::_cas_failure_order(order));
+        }
+
+        bool compare_exchange_strong(
+            value_type& expected, value_type const& desired,
+            std::memory_order order = std::memory_order_seq_cst
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            return _compare_exchange(expected, desired, false,
+                order, detail::_cas_failure_order(order));
+        }
+
+    private:
+        bool _compare_exchange(
+            value_type& expected, value_type const& desired, bool weak,
+            std::memory_order success, std::memory_order failure
+        ) EGGS_CXX11_NOEXCEPT
+        {
+            _word w = _pack(expected);
+            if (_storage.compare_exchange(
+                    w, _pack(desired), weak, success, failure))
+                return true;
+
+            expected = _unpack(w);
+            return false;
+        }
+
+        static _word _pack(value_type const& v) EGGS_CXX11_NOEXCEPT
+        {
+            // the byte of an empty class holds no value, so it is skipped
+            // to keep the representation deterministic
+            std::size_t const sizes[] = {
+                std::is_empty<Ts>::value ? 0 : sizeof(Ts)...};
+
+            unsigned char bytes[sizeof(_word)] = {};
+            std::size_t const which = detail::access::storage(v).which();
+            if (which != 0)
+            {
+                std::memcpy(bytes, detail::access::storage(v).target(),
+                    sizes[which - 1]);
+            }
+            bytes[sizeof(_word) - 1] = static_cast<unsigned char>(which);
+
+            _word w;
+            std::memcpy(&w, bytes, sizeof(w));
+            return w;
+        }
+
+        static value_type _unpack(_word const& w) EGGS_CXX11_NOEXCEPT
+        {
+            unsigned char bytes[sizeof(_word)];
+            std::memcpy(bytes, &w, sizeof(w));
+
+            std::size_t const which = bytes[sizeof(_word) - 1];
+            if (which == 0)
+                return value_type();
+
+            return detail::visitor<
+                detail::_atomic_unpack<Ts...>,
+                value_type(unsigned char const*)
+            >{}(detail::typed_index_pack<detail::pack<Ts...>>{},
+                which - 1, bytes);
+        }
+
+    private:
+        _word_type _storage;
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_ATOMIC_VARIANT_HPP*/
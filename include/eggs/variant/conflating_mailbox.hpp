@@ -0,0 +1,314 @@
+//! \file eggs/variant/conflating_mailbox.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_CONFLATING_MAILBOX_HPP
+#define EGGS_VARIANT_CONFLATING_MAILBOX_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/bits.hpp>
+#include <eggs/variant/detail/concurrency.hpp>
+#include <eggs/variant/detail/futex.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Variant>
+    //! class conflating_mailbox;
+    //!
+    //! \requires `Variant` shall be the type `variant<Ts...>`.
+    template <typename Variant>
+    class conflating_mailbox;
+
+    //! template <class ...Ts>
+    //! class conflating_mailbox<variant<Ts...>>;
+    //!
+    //! A `conflating_mailbox<variant<Ts...>>` keeps the latest value of each
+    //! alternative of `variant<Ts...>` posted by any number of writers, for
+    //! a single reader that only cares about the latest values. It has one
+    //! slot per alternative, selected by the discriminator of the posted
+    //! value, and a bitmask of the slots that have been written since the
+    //! reader last drained them. A burst of writes overwrites slots rather
+    //! than queueing, so neither memory use nor the work of a drain grows
+    //! with the rate of writes.
+    //!
+    //! Each slot is guarded by a spinlock of its own, held only for the
+    //! duration of an assignment or a swap, so writers of different
+    //! alternatives do not contend on anything but the bitmask. The reader
+    //! blocks on the bitmask itself, as a futex where available; writers
+    //! only wake it when they turn the bitmask from clear to dirty while it
+    //! is blocked.
+    //!
+    //! \requires `sizeof...(Ts) <= 32`, and every type in `Ts...` shall be
+    //!  `MoveConstructible` and `Swappable`.
+    //!
+    //! \remarks Reader operations, `try_drain`, `drain` and `wait`, shall not
+    //!  be called concurrently with each other.
+    template <typename ...Ts>
+    class conflating_mailbox<variant<Ts...>>
+    {
+        static_assert(
+            sizeof...(Ts) > 0 && sizeof...(Ts) <= 32,
+            "conflating_mailbox supports between 1 and 32 alternatives");
+
+        struct _slot
+        {
+            std::atomic<bool> locked;
+            variant<Ts...> value;
+
+            // keeps writers of different alternatives in different cache
+            // lines
+            char padding[detail::_cache_line_size];
+        };
+
+    public:
+        using value_type = variant<Ts...>;
+
+    public:
+        //! conflating_mailbox() noexcept;
+        //!
+        //! \postconditions No alternative has a pending value.
+        conflating_mailbox() EGGS_CXX11_NOEXCEPT
+          : _dirty(0), _waiting(0)
+        {
+            for (_slot& slot : _slots)
+                slot.locked.store(false, std::memory_order_relaxed);
+        }
+
+        conflating_mailbox(conflating_mailbox const&) = delete;
+        conflating_mailbox& operator=(conflating_mailbox const&) = delete;
+
+        //! template <class V>
+        //! void store(V&& v);
+        //!
+        //! \requires `std::decay_t<V>` shall be the type `variant<Ts...>`.
+        //!
+        //! \effects Assigns `std::forward<V>(v)` to the slot for
+        //!  `v.which()`, replacing any value of that alternative that is
+        //!  still pending, and marks it pending.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member, or any
+        //!  exception thrown by the assignment, in which case the slot is
+        //!  left as by the exception safety guarantee of the assignment.
+        //!
+        //! \remarks The assignment reuses the value last drained from the
+        //!  slot, so that storing does not allocate whenever assigning the
+        //!  active member does not.
+        template <typename V>
+        void store(V&& v)
+        {
+            std::size_t const which = v.which();
+            if (which == value_type::npos)
+                detail::throw_bad_variant_access<void>();
+
+            {
+                _slot_lock const lock(_slots[which]);
+                _slots[which].value = std::forward<V>(v);
+            }
+            _mark(which);
+        }
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \requires `I < sizeof...(Ts)`.
+        //!
+        //! \effects Constructs the value of the `I`th slot as if by
+        //!  `emplace<I>(std::forward<Args>(args)...)`, replacing any value
+        //!  that is still pending, and marks it pending.
+        //!
+        //! \throws Any exception thrown by the selected constructor, in which
+        //!  case the slot holds no value.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            {
+                _slot_lock const lock(_slots[I]);
+                _slots[I].value.template emplace<I>(
+                    std::forward<Args>(args)...);
+            }
+            _mark(I);
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Equivalent to `emplace<I>(std::forward<Args>(args)...)`
+        //!  where `I` is the zero-based index of `T` in `Ts...`.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        void emplace(Args&&... args)
+        {
+            emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! template <class F>
+        //! std::size_t try_drain(F&& f);
+        //!
+        //! \requires `INVOKE(f, get<I>(m))` shall be a valid expression for
+        //!  every `I` in the range `[0u, sizeof...(Ts))`, where `m` is an
+        //!  lvalue of type `variant<Ts...>`.
+        //!
+        //! \effects Clears the pending mask, then evaluates `INVOKE(f,
+        //!  get<I>(m))` on the latest value `m` of every alternative `I` that
+        //!  was pending, in increasing order of `I`.
+        //!
+        //! \returns The number of values visited.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the
+        //!  alternatives not yet visited are marked pending again.
+        //!
+        //! \remarks Each value is taken out of its slot by a swap, so the
+        //!  slot lock is never held while `f` runs.
+        template <typename F>
+        std::size_t try_drain(F&& f)
+        {
+            std::uint32_t mask = _dirty.exchange(0, std::memory_order_acquire);
+
+            struct restore
+            {
+                conflating_mailbox& mailbox;
+                std::uint32_t& mask;
+
+                ~restore()
+                {
+                    if (mask != 0)
+                        mailbox._dirty.fetch_or(
+                            mask, std::memory_order_relaxed);
+                }
+            } const guard = {*this, mask};
+
+            std::size_t count = 0;
+            while (mask != 0)
+            {
+                std::size_t const which = detail::count_trailing_zeros(mask);
+                mask &= mask - 1;
+
+                value_type& value = _values[which];
+                {
+                    _slot_lock const lock(_slots[which]);
+                    using std::swap;
+                    swap(value, _slots[which].value);
+                }
+
+                // a write that threw leaves its slot pending with no value
+                if (value.which() == value_type::npos)
+                    continue;
+
+                ++count;
+                ::eggs::variants::apply<void>(f, value);
+            }
+            return count;
+        }
+
+        //! template <class F>
+        //! std::size_t drain(F&& f);
+        //!
+        //! \effects Equivalent to `wait()` followed by `try_drain(f)`.
+        template <typename F>
+        std::size_t drain(F&& f)
+        {
+            wait();
+            return try_drain(f);
+        }
+
+        //! void wait() noexcept;
+        //!
+        //! \effects Blocks until some alternative has a pending value.
+        void wait() EGGS_CXX11_NOEXCEPT
+        {
+            if (_dirty.load(std::memory_order_acquire) != 0)
+                return;
+
+            // writers read `_waiting` after setting a bit, and the reader
+            // reads the mask after setting `_waiting`; one of them sees the
+            // other's write
+            _waiting.store(1, std::memory_order_seq_cst);
+            while (_dirty.load(std::memory_order_seq_cst) == 0)
+                detail::_futex_wait(_dirty, 0);
+            _waiting.store(0, std::memory_order_relaxed);
+        }
+
+        //! bool pending() const noexcept;
+        //!
+        //! \returns `true` if some alternative has a pending value.
+        bool pending() const EGGS_CXX11_NOEXCEPT
+        {
+            return _dirty.load(std::memory_order_acquire) != 0;
+        }
+
+    private:
+        struct _slot_lock
+        {
+            explicit _slot_lock(_slot& slot) EGGS_CXX11_NOEXCEPT
+              : _locked(slot.locked)
+            {
+                while (_locked.exchange(true, std::memory_order_acquire))
+                {
+                    while (_locked.load(std::memory_order_relaxed))
+                        detail::_spin_pause();
+                }
+            }
+
+            ~_slot_lock()
+            {
+                _locked.store(false, std::memory_order_release);
+            }
+
+            _slot_lock(_slot_lock const&) = delete;
+            _slot_lock& operator=(_slot_lock const&) = delete;
+
+        private:
+            std::atomic<bool>& _locked;
+        };
+
+        void _mark(std::size_t which) EGGS_CXX11_NOEXCEPT
+        {
+            // if the bit reads as set, a drain has either yet to clear it, or
+            // cleared it without taking the slot lock before this write did;
+            // either way, that drain visits the value just written
+            std::uint32_t const bit = std::uint32_t(1) << which;
+            if ((_dirty.load(std::memory_order_relaxed) & bit) != 0)
+                return;
+
+            std::uint32_t const previous =
+                _dirty.fetch_or(bit, std::memory_order_seq_cst);
+            if (previous == 0 && _waiting.load(std::memory_order_seq_cst) != 0)
+                detail::_futex_wake_all(_dirty);
+        }
+
+    private:
+        _slot _slots[sizeof...(Ts)];
+
+        // written by writers and the reader
+        std::atomic<std::uint32_t> _dirty;
+        std::atomic<std::uint32_t> _waiting;
+        char _padding[detail::_cache_line_size];
+
+        // owned by the reader
+        value_type _values[sizeof...(Ts)];
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_CONFLATING_MAILBOX_HPP*/
@@ -0,0 +1,211 @@
+//! \file eggs/variant/detail/batch.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DETAIL_BATCH_HPP
+#define EGGS_VARIANT_DETAIL_BATCH_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/visitor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants { namespace detail
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // `pack<index<0>, ..., index<sizeof...(Ts)>>`, one index per value of the
+    // internal discriminator, with `index<0>` for empty.
+    template <typename V>
+    struct _discriminator_pack;
+
+    template <typename ...Ts>
+    struct _discriminator_pack<variant<Ts...>>
+      : _typed_index_pack<pack<empty, Ts...>>
+    {};
+
+    template <typename V>
+    struct _discriminator_pack<V const>
+      : _discriminator_pack<V>
+    {};
+
+    template <typename V>
+    using discriminator_pack = typename _discriminator_pack<V>::type;
+
+    template <typename V>
+    std::size_t discriminator(V const& v) EGGS_CXX11_NOEXCEPT
+    {
+        return access::storage(v).which();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    inline void prefetch(void const* ptr) EGGS_CXX11_NOEXCEPT
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(ptr);
+#else
+        (void)ptr;
+#endif
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Stable counting partition of a block of at most `Block` positions into
+    // `N` buckets, used to run a type-specialized loop per alternative.
+    template <std::size_t N, std::size_t Block = 256>
+    struct batch_partition
+    {
+        static_assert(N <= 65536 && Block <= 65536,
+            "batch_partition keys and positions must fit in 16 bits");
+
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t block_size = Block;
+
+        std::size_t offsets[N + 1];
+        std::uint16_t indices[Block];
+
+        // Partitions positions `[0, count)` by `key(i)`, which shall be in
+        // `[0, N)`. Returns the key shared by every position, or `N` if the
+        // block is mixed; in the former case `indices` is left unassigned.
+        template <typename Key>
+        std::size_t assign(std::size_t count, Key key)
+        {
+            if (count == 0)
+                return N;
+
+            std::size_t const first = key(0);
+            std::size_t uniform = 1;
+            while (uniform < count && key(uniform) == first)
+                ++uniform;
+            if (uniform == count)
+                return first;
+
+            std::uint16_t keys[Block];
+            std::size_t counts[N] = {};
+            counts[first] = uniform;
+            for (std::size_t i = 0; i < uniform; ++i)
+                keys[i] = static_cast<std::uint16_t>(first);
+            for (std::size_t i = uniform; i < count; ++i)
+            {
+                std::size_t const k = key(i);
+                keys[i] = static_cast<std::uint16_t>(k);
+                ++counts[k];
+            }
+
+            offsets[0] = 0;
+            for (std::size_t k = 0; k < N; ++k)
+                offsets[k + 1] = offsets[k] + counts[k];
+
+            std::size_t next[N];
+            for (std::size_t k = 0; k < N; ++k)
+                next[k] = offsets[k];
+            for (std::size_t i = 0; i < count; ++i)
+                indices[next[keys[i]]++] = static_cast<std::uint16_t>(i);
+
+            return N;
+        }
+
+        std::uint16_t const* begin(std::size_t k) const EGGS_CXX11_NOEXCEPT
+        {
+            return indices + offsets[k];
+        }
+
+        std::size_t size(std::size_t k) const EGGS_CXX11_NOEXCEPT
+        {
+            return offsets[k + 1] - offsets[k];
+        }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Calls `F::call<index<K>>(block, indices, count, offset, ctx)` once for
+    // each non-empty bucket `K` of each block of `[first, last)` partitioned
+    // by discriminator, where the positions in the bucket are `offset +
+    // indices[i]` for `i` in `[0, count)`. A block holding a single
+    // discriminator is passed with null `indices`, meaning the positions
+    // `offset + i`.
+    template <typename F, typename RandomIt, typename Ctx>
+    void batch_dispatch(RandomIt first, RandomIt last, Ctx& ctx)
+    {
+        using variant_type =
+            typename std::iterator_traits<RandomIt>::value_type;
+        using discriminators = discriminator_pack<variant_type>;
+        using partition = batch_partition<discriminators::size>;
+        using dispatch = visitor<F, void(RandomIt const&,
+            std::uint16_t const*, std::size_t, std::size_t, Ctx&)>;
+
+        partition p;
+        std::size_t const size = static_cast<std::size_t>(last - first);
+        for (std::size_t offset = 0; offset < size;
+            offset += partition::block_size)
+        {
+            std::size_t const count = size - offset < partition::block_size
+              ? size - offset : partition::block_size;
+            RandomIt const block = first + offset;
+
+            std::size_t const uniform = p.assign(count,
+                [&block](std::size_t i) -> std::size_t
+                {
+                    return discriminator(block[i]);
+                });
+
+            if (uniform != discriminators::size)
+            {
+                dispatch{}(discriminators{}, uniform, block,
+                    static_cast<std::uint16_t const*>(nullptr),
+                    std::size_t(count), std::size_t(offset), ctx);
+                continue;
+            }
+
+            for (std::size_t k = 0; k < discriminators::size; ++k)
+            {
+                if (p.size(k) != 0)
+                {
+                    dispatch{}(discriminators{}, k, block,
+                        p.begin(k), p.size(k), std::size_t(offset), ctx);
+                }
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Calls `F::call<index<K>>(run, count, offset, ctx)` once for each
+    // maximal run `[offset, offset + count)` of consecutive elements of
+    // `[first, last)` with discriminator `K`, in order.
+    template <typename F, typename RandomIt, typename Ctx>
+    void for_each_run(RandomIt first, RandomIt last, Ctx& ctx)
+    {
+        using variant_type =
+            typename std::iterator_traits<RandomIt>::value_type;
+        using discriminators = discriminator_pack<variant_type>;
+        using dispatch = visitor<F, void(RandomIt const&,
+            std::size_t, std::size_t, Ctx&)>;
+
+        std::size_t const size = static_cast<std::size_t>(last - first);
+        for (std::size_t offset = 0; offset < size; )
+        {
+            RandomIt const run = first + offset;
+            std::size_t const k = discriminator(*run);
+
+            std::size_t count = 1;
+            while (offset + count < size
+                && discriminator(run[count]) == k)
+            {
+                ++count;
+            }
+
+            dispatch{}(discriminators{}, k, run,
+                std::size_t(count), std::size_t(offset), ctx);
+            offset += count;
+        }
+    }
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DETAIL_BATCH_HPP*/
@@ -0,0 +1,80 @@
+//! \file eggs/variant/detail/bits.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DETAIL_BITS_HPP
+#define EGGS_VARIANT_DETAIL_BITS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants { namespace detail
+{
+    ///////////////////////////////////////////////////////////////////////////
+    template <std::size_t N, std::size_t Bits = 0>
+    struct bit_width
+      : bit_width<N / 2, Bits + 1>
+    {};
+
+    template <std::size_t Bits>
+    struct bit_width<0, Bits>
+      : std::integral_constant<std::size_t, Bits>
+    {};
+
+    ///////////////////////////////////////////////////////////////////////////
+    inline std::size_t count_trailing_zeros(std::uint32_t v) EGGS_CXX11_NOEXCEPT
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<std::size_t>(__builtin_ctz(v));
+#else
+        std::size_t n = 0;
+        for (; (v & 1u) == 0; v >>= 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    inline std::size_t count_trailing_zeros(std::uint64_t v) EGGS_CXX11_NOEXCEPT
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<std::size_t>(__builtin_ctzll(v));
+#else
+        std::size_t n = 0;
+        for (; (v & 1u) == 0; v >>= 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    inline std::size_t popcount(std::uint64_t v) EGGS_CXX11_NOEXCEPT
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<std::size_t>(__builtin_popcountll(v));
+#else
+        std::size_t n = 0;
+        for (; v != 0; v &= v - 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Spreads the entropy of a hash value, which may well be the identity
+    // for integral types, over all of its bits.
+    inline std::size_t hash_mix(std::size_t h) EGGS_CXX11_NOEXCEPT
+    {
+        std::uint64_t const m = std::uint64_t(h) * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(m ^ (m >> 32));
+    }
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DETAIL_BITS_HPP*/
@@ -0,0 +1,36 @@
+//! \file eggs/variant/detail/concurrency.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DETAIL_CONCURRENCY_HPP
+#define EGGS_VARIANT_DETAIL_CONCURRENCY_HPP
+
+#include <cstddef>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_X86_HAS_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace eggs { namespace variants { namespace detail
+{
+    ///////////////////////////////////////////////////////////////////////////
+    EGGS_CXX11_CONSTEXPR std::size_t const _cache_line_size = 64;
+
+    // Hints the processor that the caller is spinning on a shared location.
+    inline void _spin_pause() EGGS_CXX11_NOEXCEPT
+    {
+#if EGGS_X86_HAS_SSE2
+        _mm_pause();
+#endif
+    }
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DETAIL_CONCURRENCY_HPP*/
@@ -212,6 +212,35 @@
 #  define EGGS_CXX14_HAS_VARIABLE_TEMPLATES_DEFINED
 #endif
 
+/// coroutines support
+#ifndef EGGS_CXX20_HAS_COROUTINES
+#  if defined(__cpp_impl_coroutine) && defined(__has_include)
+#    if __has_include(<coroutine>)
+#      define EGGS_CXX20_HAS_COROUTINES 1
+#    else
+#      define EGGS_CXX20_HAS_COROUTINES 0
+#    endif
+#  else
+#    define EGGS_CXX20_HAS_COROUTINES 0
+#  endif
+#  define EGGS_CXX20_HAS_COROUTINES_DEFINED
+#endif
+
+/// ranges support
+#ifndef EGGS_CXX20_HAS_RANGES
+#  if defined(__cpp_concepts) && __cplusplus > 201703L \
+   && defined(__has_include)
+#    if __has_include(<ranges>)
+#      define EGGS_CXX20_HAS_RANGES 1
+#    else
+#      define EGGS_CXX20_HAS_RANGES 0
+#    endif
+#  else
+#    define EGGS_CXX20_HAS_RANGES 0
+#  endif
+#  define EGGS_CXX20_HAS_RANGES_DEFINED
+#endif
+
 /// std::aligned_union support
 #ifndef EGGS_CXX11_STD_HAS_ALIGNED_UNION
 #  if defined(__GLIBCXX__)
@@ -254,6 +283,69 @@
 #  define EGGS_CXX11_STD_HAS_IS_TRIVIALLY_DESTRUCTIBLE_DEFINED
 #endif
 
+/// SSE2 support
+#ifndef EGGS_X86_HAS_SSE2
+#  if defined(__SSE2__) || defined(_M_X64)
+#    define EGGS_X86_HAS_SSE2 1
+#  elif defined(_M_IX86_FP) && _M_IX86_FP >= 2
+#    define EGGS_X86_HAS_SSE2 1
+#  else
+#    define EGGS_X86_HAS_SSE2 0
+#  endif
+#  define EGGS_X86_HAS_SSE2_DEFINED
+#endif
+
+/// AVX2 runtime dispatch support
+#ifndef EGGS_X86_HAS_AVX2_DISPATCH
+#  if EGGS_X86_HAS_SSE2 && (defined(__GNUC__) || defined(__clang__)) \
+   && (defined(__x86_64__) || defined(__i386__))
+#    define EGGS_X86_HAS_AVX2_DISPATCH 1
+#  else
+#    define EGGS_X86_HAS_AVX2_DISPATCH 0
+#  endif
+#  define EGGS_X86_HAS_AVX2_DISPATCH_DEFINED
+#endif
+
+/// CMPXCHG16B runtime dispatch support
+#ifndef EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+#  if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#    define EGGS_X86_HAS_CMPXCHG16B_DISPATCH 1
+#  else
+#    define EGGS_X86_HAS_CMPXCHG16B_DISPATCH 0
+#  endif
+#  define EGGS_X86_HAS_CMPXCHG16B_DISPATCH_DEFINED
+#endif
+
+/// futex support
+#ifndef EGGS_LINUX_HAS_FUTEX
+#  if defined(__linux__)
+#    define EGGS_LINUX_HAS_FUTEX 1
+#  else
+#    define EGGS_LINUX_HAS_FUTEX 0
+#  endif
+#  define EGGS_LINUX_HAS_FUTEX_DEFINED
+#endif
+
+/// thread affinity support
+#ifndef EGGS_LINUX_HAS_THREAD_AFFINITY
+#  if defined(__linux__) && defined(__GLIBC__)
+#    define EGGS_LINUX_HAS_THREAD_AFFINITY 1
+#  else
+#    define EGGS_LINUX_HAS_THREAD_AFFINITY 0
+#  endif
+#  define EGGS_LINUX_HAS_THREAD_AFFINITY_DEFINED
+#endif
+
+/// POSIX shared memory support
+#ifndef EGGS_POSIX_HAS_SHARED_MEMORY
+#  if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#    define EGGS_POSIX_HAS_SHARED_MEMORY 1
+#  else
+#    define EGGS_POSIX_HAS_SHARED_MEMORY 0
+#  endif
+#  define EGGS_POSIX_HAS_SHARED_MEMORY_DEFINED
+#endif
+
 #if defined(_MSC_FULL_VER)
 #  pragma warning(push)
 /// destructor was implicitly defined as deleted because a base class
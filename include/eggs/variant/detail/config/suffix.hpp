@@ -110,6 +110,18 @@
 #  undef EGGS_CXX14_HAS_VARIABLE_TEMPLATES_DEFINED
 #endif
 
+/// coroutines support
+#ifdef EGGS_CXX20_HAS_COROUTINES_DEFINED
+#  undef EGGS_CXX20_HAS_COROUTINES
+#  undef EGGS_CXX20_HAS_COROUTINES_DEFINED
+#endif
+
+/// ranges support
+#ifdef EGGS_CXX20_HAS_RANGES_DEFINED
+#  undef EGGS_CXX20_HAS_RANGES
+#  undef EGGS_CXX20_HAS_RANGES_DEFINED
+#endif
+
 /// std::aligned_union support
 #ifdef EGGS_CXX11_STD_HAS_ALIGNED_UNION_DEFINED
 #  undef EGGS_CXX11_STD_HAS_ALIGNED_UNION
@@ -134,6 +146,42 @@
 #  undef EGGS_CXX11_STD_HAS_IS_TRIVIALLY_DESTRUCTIBLE_DEFINED
 #endif
 
+/// SSE2 support
+#ifdef EGGS_X86_HAS_SSE2_DEFINED
+#  undef EGGS_X86_HAS_SSE2
+#  undef EGGS_X86_HAS_SSE2_DEFINED
+#endif
+
+/// AVX2 runtime dispatch support
+#ifdef EGGS_X86_HAS_AVX2_DISPATCH_DEFINED
+#  undef EGGS_X86_HAS_AVX2_DISPATCH
+#  undef EGGS_X86_HAS_AVX2_DISPATCH_DEFINED
+#endif
+
+/// CMPXCHG16B runtime dispatch support
+#ifdef EGGS_X86_HAS_CMPXCHG16B_DISPATCH_DEFINED
+#  undef EGGS_X86_HAS_CMPXCHG16B_DISPATCH
+#  undef EGGS_X86_HAS_CMPXCHG16B_DISPATCH_DEFINED
+#endif
+
+/// futex support
+#ifdef EGGS_LINUX_HAS_FUTEX_DEFINED
+#  undef EGGS_LINUX_HAS_FUTEX
+#  undef EGGS_LINUX_HAS_FUTEX_DEFINED
+#endif
+
+/// thread affinity support
+#ifdef EGGS_LINUX_HAS_THREAD_AFFINITY_DEFINED
+#  undef EGGS_LINUX_HAS_THREAD_AFFINITY
+#  undef EGGS_LINUX_HAS_THREAD_AFFINITY_DEFINED
+#endif
+
+/// POSIX shared memory support
+#ifdef EGGS_POSIX_HAS_SHARED_MEMORY_DEFINED
+#  undef EGGS_POSIX_HAS_SHARED_MEMORY
+#  undef EGGS_POSIX_HAS_SHARED_MEMORY_DEFINED
+#endif
+
 #if defined(_MSC_FULL_VER)
 #  pragma warning(pop)
 #endif
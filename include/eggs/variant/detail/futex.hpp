@@ -0,0 +1,139 @@
+//! \file eggs/variant/detail/futex.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DETAIL_FUTEX_HPP
+#define EGGS_VARIANT_DETAIL_FUTEX_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_LINUX_HAS_FUTEX
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+namespace eggs { namespace variants { namespace detail
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Waiting on an address: `_futex_wait(word, expected)` blocks for as long
+    // as `word` holds `expected`, and `_futex_wake_all(word)` wakes every
+    // thread blocked on `word`. A waker shall change the value of `word`
+    // before waking. Waits may return spuriously.
+#if EGGS_LINUX_HAS_FUTEX
+    inline void _futex_wait(
+        std::atomic<std::uint32_t>& word, std::uint32_t expected)
+    {
+        static_assert(
+            sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+            "futex requires a plain 32 bit word");
+
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+
+    inline void _futex_wake_all(std::atomic<std::uint32_t>& word)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAKE_PRIVATE, 0x7fffffff, nullptr, nullptr, 0);
+    }
+#else
+    // Without futexes, waiters park on one of a fixed set of condition
+    // variables chosen by address; unrelated words sharing a bucket only
+    // cause spurious wakeups.
+    struct _parking_bucket
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    inline _parking_bucket& _parking_lot(void const* address)
+    {
+        static _parking_bucket buckets[64];
+        std::size_t const key = reinterpret_cast<std::uintptr_t>(address);
+        return buckets[(key / sizeof(std::uint32_t)) % 64];
+    }
+
+    inline void _futex_wait(
+        std::atomic<std::uint32_t>& word, std::uint32_t expected)
+    {
+        _parking_bucket& bucket = _parking_lot(&word);
+        std::unique_lock<std::mutex> lock(bucket.mutex);
+        if (word.load(std::memory_order_acquire) == expected)
+            bucket.cv.wait(lock);
+    }
+
+    inline void _futex_wake_all(std::atomic<std::uint32_t>& word)
+    {
+        _parking_bucket& bucket = _parking_lot(&word);
+        {
+            // a waiter that has checked the word but not yet blocked still
+            // holds the mutex, so it cannot miss the notification
+            std::lock_guard<std::mutex> lock(bucket.mutex);
+        }
+        bucket.cv.notify_all();
+    }
+#endif
+
+    ///////////////////////////////////////////////////////////////////////////
+    // The same, for a `word` in memory shared between processes; waits give
+    // up after `timeout`, unless negative. Without futexes there is nothing to
+    // park on that another process could notify, so waiters poll instead.
+#if EGGS_LINUX_HAS_FUTEX
+    inline void _futex_wait_shared(
+        std::atomic<std::uint32_t>& word, std::uint32_t expected,
+        std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1))
+    {
+        static_assert(
+            sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+            "futex requires a plain 32 bit word");
+
+        ::timespec ts = {};
+        if (timeout.count() >= 0)
+        {
+            ts.tv_sec = static_cast<::time_t>(timeout.count() / 1000000000);
+            ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+        }
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAIT, expected, timeout.count() >= 0 ? &ts : nullptr,
+            nullptr, 0);
+    }
+
+    inline void _futex_wake_all_shared(std::atomic<std::uint32_t>& word)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+            FUTEX_WAKE, 0x7fffffff, nullptr, nullptr, 0);
+    }
+#else
+    inline void _futex_wait_shared(
+        std::atomic<std::uint32_t>& word, std::uint32_t expected,
+        std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1))
+    {
+        std::chrono::nanoseconds const poll = std::chrono::microseconds(50);
+        if (word.load(std::memory_order_acquire) == expected)
+        {
+            std::this_thread::sleep_for(
+                timeout.count() >= 0 && timeout < poll ? timeout : poll);
+        }
+    }
+
+    inline void _futex_wake_all_shared(std::atomic<std::uint32_t>&) {}
+#endif
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DETAIL_FUTEX_HPP*/
@@ -0,0 +1,210 @@
+//! \file eggs/variant/detail/small_function.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DETAIL_SMALL_FUNCTION_HPP
+#define EGGS_VARIANT_DETAIL_SMALL_FUNCTION_HPP
+
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/storage.hpp>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants { namespace detail
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // A move-only, type-erased callable that stores small targets inline,
+    // so that wrapping a function pointer, a member function bound to an
+    // object or a lambda capturing a few references does not allocate.
+    // Larger targets, or ones that may throw when moved, are allocated.
+    template <typename Signature>
+    class _small_function;
+
+    template <typename R, typename ...Args>
+    class _small_function<R(Args...)>
+    {
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _size = 4 * sizeof(void*);
+        using _buffer = typename std::aligned_storage<_size>::type;
+
+        struct _vtable
+        {
+            R (*invoke)(void*, Args&&...);
+            void (*relocate)(void* dst, void* src) EGGS_CXX11_NOEXCEPT;
+            void (*destroy)(void*) EGGS_CXX11_NOEXCEPT;
+        };
+
+        template <typename F>
+        struct _is_local
+          : std::integral_constant<bool,
+                sizeof(F) <= sizeof(_buffer)
+             && std::alignment_of<F>::value
+                    <= std::alignment_of<_buffer>::value
+#if EGGS_CXX11_STD_HAS_IS_NOTHROW_TRAITS
+             && std::is_nothrow_move_constructible<F>::value
+#else
+             && is_trivially_copyable<F>::value
+#endif
+            >
+        {};
+
+        template <typename F, bool Local = _is_local<F>::value>
+        struct _ops
+        {
+            static F& target(void* ptr) EGGS_CXX11_NOEXCEPT
+            {
+                return *static_cast<F*>(ptr);
+            }
+
+            template <typename G>
+            static void create(void* ptr, G&& g)
+            {
+                ::new (ptr) F(std::forward<G>(g));
+            }
+
+            static void relocate(void* dst, void* src) EGGS_CXX11_NOEXCEPT
+            {
+                ::new (dst) F(std::move(target(src)));
+                target(src).~F();
+            }
+
+            static void destroy(void* ptr) EGGS_CXX11_NOEXCEPT
+            {
+                target(ptr).~F();
+            }
+
+            static R invoke(void* ptr, Args&&... args)
+            {
+                return _invoke_guard<R>{}(
+                    target(ptr), std::forward<Args>(args)...);
+            }
+        };
+
+        template <typename F>
+        struct _ops<F, false>
+        {
+            static F& target(void* ptr) EGGS_CXX11_NOEXCEPT
+            {
+                return **static_cast<F**>(ptr);
+            }
+
+            template <typename G>
+            static void create(void* ptr, G&& g)
+            {
+                ::new (ptr) F*(new F(std::forward<G>(g)));
+            }
+
+            static void relocate(void* dst, void* src) EGGS_CXX11_NOEXCEPT
+            {
+                ::new (dst) F*(*static_cast<F**>(src));
+            }
+
+            static void destroy(void* ptr) EGGS_CXX11_NOEXCEPT
+            {
+                delete *static_cast<F**>(ptr);
+            }
+
+            static R invoke(void* ptr, Args&&... args)
+            {
+                return _invoke_guard<R>{}(
+                    target(ptr), std::forward<Args>(args)...);
+            }
+        };
+
+        template <typename F>
+        static _vtable const* _vtable_for() EGGS_CXX11_NOEXCEPT
+        {
+            static _vtable const vtable = {
+                &_ops<F>::invoke, &_ops<F>::relocate, &_ops<F>::destroy};
+            return &vtable;
+        }
+
+    public:
+        _small_function() EGGS_CXX11_NOEXCEPT
+          : _vtable_ptr(nullptr)
+        {}
+
+        template <
+            typename F
+          , typename D = typename std::decay<F>::type
+          , typename Enable = typename std::enable_if<
+                !std::is_same<D, _small_function>::value
+            >::type
+        >
+        _small_function(F&& f)
+          : _vtable_ptr(nullptr)
+        {
+            _ops<D>::create(&_storage, std::forward<F>(f));
+            _vtable_ptr = _vtable_for<D>();
+        }
+
+        _small_function(_small_function&& other) EGGS_CXX11_NOEXCEPT
+          : _vtable_ptr(other._vtable_ptr)
+        {
+            if (_vtable_ptr != nullptr)
+            {
+                _vtable_ptr->relocate(&_storage, &other._storage);
+                other._vtable_ptr = nullptr;
+            }
+        }
+
+        _small_function& operator=(_small_function&& other) EGGS_CXX11_NOEXCEPT
+        {
+            if (this != &other)
+            {
+                _reset();
+                if (other._vtable_ptr != nullptr)
+                {
+                    other._vtable_ptr->relocate(&_storage, &other._storage);
+                    _vtable_ptr = other._vtable_ptr;
+                    other._vtable_ptr = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        _small_function(_small_function const&) = delete;
+        _small_function& operator=(_small_function const&) = delete;
+
+        ~_small_function()
+        {
+            _reset();
+        }
+
+        R operator()(Args... args) const
+        {
+            return _vtable_ptr->invoke(&_storage, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const EGGS_CXX11_NOEXCEPT
+        {
+            return _vtable_ptr != nullptr;
+        }
+
+    private:
+        void _reset() EGGS_CXX11_NOEXCEPT
+        {
+            if (_vtable_ptr != nullptr)
+            {
+                _vtable_ptr->destroy(&_storage);
+                _vtable_ptr = nullptr;
+            }
+        }
+
+    private:
+        _vtable const* _vtable_ptr;
+        mutable _buffer _storage;
+    };
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DETAIL_SMALL_FUNCTION_HPP*/
@@ -25,6 +25,32 @@ namespace eggs { namespace variants { namespace detail
     template <typename Ts, bool IsTriviallyDestructible>
     struct _union;
 
+    ///////////////////////////////////////////////////////////////////////////
+#if EGGS_CXX11_STD_HAS_ALIGNED_UNION
+    using std::aligned_union;
+#else
+    template <std::size_t ...Vs>
+    struct _static_max;
+
+    template <std::size_t V0>
+    struct _static_max<V0>
+      : std::integral_constant<std::size_t, V0>
+    {};
+
+    template <std::size_t V0, std::size_t V1, std::size_t ...Vs>
+    struct _static_max<V0, V1, Vs...>
+      : _static_max<V0 < V1 ? V1 : V0, Vs...>
+    {};
+
+    template <std::size_t Len, typename ...Types>
+    struct aligned_union
+      : std::aligned_storage<
+            _static_max<Len, sizeof(Types)...>::value
+          , _static_max<std::alignment_of<Types>::value...>::value
+        >
+    {};
+#endif
+
 #if EGGS_CXX11_HAS_UNRESTRICTED_UNIONS
     ///////////////////////////////////////////////////////////////////////////
     template <bool IsTriviallyDestructible>
@@ -236,32 +262,6 @@ namespace eggs { namespace variants { namespace detail
         conditionally_deleted::assign<CopyAssign, MoveAssign>;
 
     ///////////////////////////////////////////////////////////////////////////
-#  if EGGS_CXX11_STD_HAS_ALIGNED_UNION
-    using std::aligned_union;
-#  else
-    template <std::size_t ...Vs>
-    struct _static_max;
-
-    template <std::size_t V0>
-    struct _static_max<V0>
-      : std::integral_constant<std::size_t, V0>
-    {};
-
-    template <std::size_t V0, std::size_t V1, std::size_t ...Vs>
-    struct _static_max<V0, V1, Vs...>
-      : _static_max<V0 < V1 ? V1 : V0, Vs...>
-    {};
-
-    template <std::size_t Len, typename ...Types>
-    struct aligned_union
-      : std::aligned_storage<
-            _static_max<Len, sizeof(Types)...>::value
-          , _static_max<std::alignment_of<Types>::value...>::value
-        >
-    {};
-#  endif
-
-    ///////////////////////////////////////////////////////////////////////////
     template <typename ...Ts, bool IsTriviallyDestructible>
     struct _union<pack<Ts...>, IsTriviallyDestructible>
       : conditionally_deleted_cnstr<
@@ -0,0 +1,375 @@
+//! \file eggs/variant/detail/tag_scan.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DETAIL_TAG_SCAN_HPP
+#define EGGS_VARIANT_DETAIL_TAG_SCAN_HPP
+
+#include <eggs/variant/detail/bits.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_X86_HAS_SSE2
+#  include <emmintrin.h>
+#endif
+#if EGGS_X86_HAS_AVX2_DISPATCH
+#  include <immintrin.h>
+#endif
+
+// Kernels over contiguous arrays of discriminators. Every operation has a
+// scalar version for any tag width; for 8-bit tags there are SSE2 versions,
+// and AVX2 versions selected at runtime when the processor supports them.
+namespace eggs { namespace variants { namespace detail
+{
+    ///////////////////////////////////////////////////////////////////////////
+    template <typename Tag>
+    std::size_t count_eq(Tag const* tags, std::size_t n, Tag tag)
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            count += tags[i] == tag;
+        return count;
+    }
+
+    template <typename Tag>
+    std::size_t find_eq(Tag const* tags, std::size_t n, Tag tag)
+    {
+        std::size_t i = 0;
+        while (i < n && tags[i] != tag)
+            ++i;
+        return i;
+    }
+
+    // Sets bit `i % 64` of `words[i / 64]` iff `tags[i] == tag`; writes all
+    // of the `(n + 63) / 64` words.
+    template <typename Tag>
+    void mask_eq(Tag const* tags, std::size_t n, Tag tag, std::uint64_t* words)
+    {
+        for (std::size_t w = 0; w * 64 < n; ++w)
+        {
+            std::size_t const first = w * 64;
+            std::size_t const last = n - first < 64 ? n : first + 64;
+
+            std::uint64_t word = 0;
+            for (std::size_t i = first; i < last; ++i)
+                word |= std::uint64_t(tags[i] == tag) << (i - first);
+            words[w] = word;
+        }
+    }
+
+    template <typename Index>
+    std::size_t _compress_word(
+        std::uint64_t word, std::size_t base, Index* out) EGGS_CXX11_NOEXCEPT
+    {
+        std::size_t count = 0;
+        for (; word != 0; word &= word - 1)
+            out[count++] = static_cast<Index>(base + count_trailing_zeros(word));
+        return count;
+    }
+
+    // Writes the positions `i` for which `tags[i] == tag` to `out`, in
+    // increasing order, and returns how many were written.
+    template <typename Tag, typename Index>
+    std::size_t compress_eq(Tag const* tags, std::size_t n, Tag tag, Index* out)
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (tags[i] == tag)
+                out[count++] = static_cast<Index>(i);
+        }
+        return count;
+    }
+
+#if EGGS_X86_HAS_SSE2
+    ///////////////////////////////////////////////////////////////////////////
+    inline std::uint64_t _mask64_sse2(
+        std::uint8_t const* p, __m128i t) EGGS_CXX11_NOEXCEPT
+    {
+        __m128i const* const v = reinterpret_cast<__m128i const*>(p);
+        std::uint64_t const m0 = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 0), t)));
+        std::uint64_t const m1 = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 1), t)));
+        std::uint64_t const m2 = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 2), t)));
+        std::uint64_t const m3 = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 3), t)));
+        return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+    }
+
+    inline std::size_t _count_eq_sse2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag)
+    {
+        __m128i const t = _mm_set1_epi8(static_cast<char>(tag));
+        __m128i const zero = _mm_setzero_si128();
+
+        std::size_t i = 0, count = 0;
+        while (n - i >= 16)
+        {
+            // byte counters saturate after 255 steps; flush them before that
+            std::size_t blocks = (n - i) / 16;
+            if (blocks > 255)
+                blocks = 255;
+
+            __m128i acc = zero;
+            for (std::size_t b = 0; b < blocks; ++b, i += 16)
+            {
+                __m128i const v = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(tags + i));
+                acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, t));
+            }
+            __m128i const sums = _mm_sad_epu8(acc, zero);
+            count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums))
+              + static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+        }
+        return count + count_eq(tags + i, n - i, tag);
+    }
+
+    inline std::size_t _find_eq_sse2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag)
+    {
+        __m128i const t = _mm_set1_epi8(static_cast<char>(tag));
+
+        std::size_t i = 0;
+        for (; n - i >= 16; i += 16)
+        {
+            __m128i const v = _mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(tags + i));
+            std::uint32_t const m = static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(v, t)));
+            if (m != 0)
+                return i + count_trailing_zeros(m);
+        }
+        return i + find_eq(tags + i, n - i, tag);
+    }
+
+    inline void _mask_eq_sse2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag,
+        std::uint64_t* words)
+    {
+        __m128i const t = _mm_set1_epi8(static_cast<char>(tag));
+
+        std::size_t i = 0;
+        for (; n - i >= 64; i += 64)
+            *words++ = _mask64_sse2(tags + i, t);
+        if (i != n)
+            mask_eq(tags + i, n - i, tag, words);
+    }
+
+    template <typename Index>
+    std::size_t _compress_eq_sse2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag, Index* out)
+    {
+        __m128i const t = _mm_set1_epi8(static_cast<char>(tag));
+
+        std::size_t i = 0, count = 0;
+        for (; n - i >= 64; i += 64)
+            count += _compress_word(_mask64_sse2(tags + i, t), i, out + count);
+        for (; i < n; ++i)
+        {
+            if (tags[i] == tag)
+                out[count++] = static_cast<Index>(i);
+        }
+        return count;
+    }
+#endif
+
+#if EGGS_X86_HAS_AVX2_DISPATCH
+    ///////////////////////////////////////////////////////////////////////////
+    inline bool _has_avx2() EGGS_CXX11_NOEXCEPT
+    {
+        static bool const has_avx2 =
+            (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+        return has_avx2;
+    }
+
+    __attribute__((target("avx2")))
+    inline std::uint64_t _mask64_avx2(
+        std::uint8_t const* p, __m256i t) EGGS_CXX11_NOEXCEPT
+    {
+        __m256i const* const v = reinterpret_cast<__m256i const*>(p);
+        std::uint64_t const lo = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(v), t)));
+        std::uint64_t const hi = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(v + 1), t)));
+        return lo | (hi << 32);
+    }
+
+    __attribute__((target("avx2")))
+    inline std::size_t _count_eq_avx2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag)
+    {
+        __m256i const t = _mm256_set1_epi8(static_cast<char>(tag));
+        __m256i const zero = _mm256_setzero_si256();
+
+        std::size_t i = 0, count = 0;
+        while (n - i >= 32)
+        {
+            std::size_t blocks = (n - i) / 32;
+            if (blocks > 255)
+                blocks = 255;
+
+            __m256i acc = zero;
+            for (std::size_t b = 0; b < blocks; ++b, i += 32)
+            {
+                __m256i const v = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(tags + i));
+                acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, t));
+            }
+            __m256i const sums = _mm256_sad_epu8(acc, zero);
+            __m128i const half = _mm_add_epi64(
+                _mm256_castsi256_si128(sums),
+                _mm256_extracti128_si256(sums, 1));
+            count += static_cast<std::size_t>(_mm_cvtsi128_si32(half))
+              + static_cast<std::size_t>(_mm_extract_epi16(half, 4));
+        }
+        return count + count_eq(tags + i, n - i, tag);
+    }
+
+    __attribute__((target("avx2")))
+    inline std::size_t _find_eq_avx2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag)
+    {
+        __m256i const t = _mm256_set1_epi8(static_cast<char>(tag));
+
+        std::size_t i = 0;
+        for (; n - i >= 32; i += 32)
+        {
+            __m256i const v = _mm256_loadu_si256(
+                reinterpret_cast<__m256i const*>(tags + i));
+            std::uint32_t const m = static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, t)));
+            if (m != 0)
+                return i + count_trailing_zeros(m);
+        }
+        return i + find_eq(tags + i, n - i, tag);
+    }
+
+    __attribute__((target("avx2")))
+    inline void _mask_eq_avx2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag,
+        std::uint64_t* words)
+    {
+        __m256i const t = _mm256_set1_epi8(static_cast<char>(tag));
+
+        std::size_t i = 0;
+        for (; n - i >= 64; i += 64)
+            *words++ = _mask64_avx2(tags + i, t);
+        if (i != n)
+            mask_eq(tags + i, n - i, tag, words);
+    }
+
+    template <typename Index>
+    __attribute__((target("avx2")))
+    std::size_t _compress_eq_avx2(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag, Index* out)
+    {
+        __m256i const t = _mm256_set1_epi8(static_cast<char>(tag));
+
+        std::size_t i = 0, count = 0;
+        for (; n - i >= 64; i += 64)
+            count += _compress_word(_mask64_avx2(tags + i, t), i, out + count);
+        for (; i < n; ++i)
+        {
+            if (tags[i] == tag)
+                out[count++] = static_cast<Index>(i);
+        }
+        return count;
+    }
+#endif
+
+#if EGGS_X86_HAS_SSE2
+    ///////////////////////////////////////////////////////////////////////////
+    inline std::size_t count_eq(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag)
+    {
+#  if EGGS_X86_HAS_AVX2_DISPATCH
+        if (_has_avx2())
+            return _count_eq_avx2(tags, n, tag);
+#  endif
+        return _count_eq_sse2(tags, n, tag);
+    }
+
+    inline std::size_t find_eq(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag)
+    {
+#  if EGGS_X86_HAS_AVX2_DISPATCH
+        if (_has_avx2())
+            return _find_eq_avx2(tags, n, tag);
+#  endif
+        return _find_eq_sse2(tags, n, tag);
+    }
+
+    inline void mask_eq(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag,
+        std::uint64_t* words)
+    {
+#  if EGGS_X86_HAS_AVX2_DISPATCH
+        if (_has_avx2())
+            return _mask_eq_avx2(tags, n, tag, words);
+#  endif
+        return _mask_eq_sse2(tags, n, tag, words);
+    }
+
+    template <typename Index>
+    std::size_t compress_eq(
+        std::uint8_t const* tags, std::size_t n, std::uint8_t tag, Index* out)
+    {
+#  if EGGS_X86_HAS_AVX2_DISPATCH
+        if (_has_avx2())
+            return _compress_eq_avx2(tags, n, tag, out);
+#  endif
+        return _compress_eq_sse2(tags, n, tag, out);
+    }
+#endif
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Sets `counts[k]` to the number of tags equal to `k`, for every `k` in
+    // `[0, N)`; every tag shall be less than `N`. Few distinct tags are
+    // counted with one vectorized `count_eq` per tag over cache-sized blocks,
+    // many with a scalar pass over four interleaved histograms.
+    template <std::size_t N, typename Tag>
+    void histogram(Tag const* tags, std::size_t n, std::size_t (&counts)[N])
+    {
+        for (std::size_t k = 0; k < N; ++k)
+            counts[k] = 0;
+
+        if (N <= 8)
+        {
+            std::size_t const block = 16 * 1024;
+            for (std::size_t i = 0; i < n; i += block)
+            {
+                std::size_t const m = n - i < block ? n - i : block;
+                for (std::size_t k = 0; k < N; ++k)
+                    counts[k] += count_eq(tags + i, m, static_cast<Tag>(k));
+            }
+        } else {
+            std::size_t partial[4][N] = {};
+            std::size_t i = 0;
+            for (; n - i >= 4; i += 4)
+            {
+                ++partial[0][tags[i + 0]];
+                ++partial[1][tags[i + 1]];
+                ++partial[2][tags[i + 2]];
+                ++partial[3][tags[i + 3]];
+            }
+            for (; i < n; ++i)
+                ++partial[0][tags[i]];
+            for (std::size_t k = 0; k < N; ++k)
+                counts[k] = partial[0][k] + partial[1][k]
+                  + partial[2][k] + partial[3][k];
+        }
+    }
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DETAIL_TAG_SCAN_HPP*/
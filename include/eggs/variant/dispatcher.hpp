@@ -0,0 +1,235 @@
+//! \file eggs/variant/dispatcher.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_DISPATCHER_HPP
+#define EGGS_VARIANT_DISPATCHER_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/small_function.hpp>
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        // Adapts a handler of `T const&` to the address of the active
+        // member; it is as small as the handler itself, so that it fits
+        // wherever the handler would.
+        template <typename T, typename F>
+        struct _typed_handler
+        {
+            F f;
+
+            void operator()(void const* ptr)
+            {
+                detail::_invoke(f, *static_cast<T const*>(ptr));
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Variant>
+    //! class dispatcher;
+    //!
+    //! \requires `Variant` shall be the type `variant<Ts...>`.
+    template <typename Variant>
+    class dispatcher;
+
+    //! template <class ...Ts>
+    //! class dispatcher<variant<Ts...>>;
+    //!
+    //! A `dispatcher<variant<Ts...>>` routes messages of type `variant<Ts...>`
+    //! to the handlers subscribed to the type of their active member. The
+    //! handlers of each alternative are kept in an array indexed by
+    //! `which()`, so that routing a message is an index rather than a lookup
+    //! by `target_type()`.
+    //!
+    //! Handlers are type-erased in a small buffer, so that subscribing a
+    //! function pointer or a lambda capturing a few references does not
+    //! allocate, and dispatching never allocates. Handlers known at compile
+    //! time can be passed to `dispatch` instead, which invokes them through
+    //! `apply` where they can be inlined.
+    //!
+    //! \remarks `subscribe` and `unsubscribe` shall not be called while a
+    //!  message is being dispatched, including from within a handler.
+    template <typename ...Ts>
+    class dispatcher<variant<Ts...>>
+    {
+        using _handler = detail::_small_function<void(void const*)>;
+
+        struct _entry
+        {
+            std::size_t id;
+            _handler handler;
+        };
+
+    public:
+        using value_type = variant<Ts...>;
+
+        //! struct subscription;
+        //!
+        //! Identifies a handler subscribed to alternative `which`.
+        struct subscription
+        {
+            std::size_t which;
+            std::size_t id;
+        };
+
+    public:
+        //! dispatcher() noexcept;
+        //!
+        //! \postconditions No handler is subscribed.
+        dispatcher() EGGS_CXX11_NOEXCEPT
+          : _next_id(0)
+        {}
+
+        dispatcher(dispatcher const&) = delete;
+        dispatcher& operator=(dispatcher const&) = delete;
+
+        //! template <std::size_t I, class F>
+        //! subscription subscribe(F&& f);
+        //!
+        //! Let `T` be the `I`th element in `Ts...`, where indexing is
+        //! zero-based.
+        //!
+        //! \requires `I < sizeof...(Ts)`. `std::decay_t<F>` shall be
+        //!  `MoveConstructible`, and `INVOKE(f, t)` shall be a valid
+        //!  expression for an lvalue `t` of type `T const`.
+        //!
+        //! \effects Subscribes a handler initialized from `std::forward<F>(f)`
+        //!  to messages whose active member is the `I`th alternative, after
+        //!  the handlers already subscribed to it.
+        //!
+        //! \returns A `subscription` that identifies the handler.
+        //!
+        //! \throws `std::bad_alloc`, or any exception thrown by the
+        //!  initialization of the handler.
+        template <std::size_t I, typename F>
+        subscription subscribe(F&& f)
+        {
+            using T = typename detail::at_index<
+                I, detail::pack<Ts...>>::type;
+            using handler = detail::_typed_handler<
+                T, typename std::decay<F>::type>;
+
+            _entry entry = {_next_id, _handler(handler{std::forward<F>(f)})};
+            _handlers[I].push_back(std::move(entry));
+            subscription const s = {I, _next_id++};
+            return s;
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class F>
+        //! subscription subscribe(F&& f);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Equivalent to `return subscribe<I>(std::forward<F>(f));`
+        //!  where `I` is the zero-based index of `T` in `Ts...`.
+        template <
+            typename T, typename F
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        subscription subscribe(F&& f)
+        {
+            return subscribe<I>(std::forward<F>(f));
+        }
+#endif
+
+        //! bool unsubscribe(subscription s) noexcept;
+        //!
+        //! \effects Removes the handler identified by `s`, if any, keeping
+        //!  the order of the remaining handlers.
+        //!
+        //! \returns `true` if a handler was removed.
+        bool unsubscribe(subscription s) EGGS_CXX11_NOEXCEPT
+        {
+            if (s.which >= sizeof...(Ts))
+                return false;
+
+            std::vector<_entry>& handlers = _handlers[s.which];
+            for (std::size_t i = 0; i < handlers.size(); ++i)
+            {
+                if (handlers[i].id == s.id)
+                {
+                    handlers.erase(handlers.begin() + i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //! std::size_t dispatch(variant<Ts...> const& v) const;
+        //!
+        //! \effects Invokes every handler subscribed to the alternative
+        //!  `v.which()` with the active member of `v`, in the order they were
+        //!  subscribed.
+        //!
+        //! \returns The number of handlers invoked.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member, or any
+        //!  exception thrown by a handler, in which case the handlers after
+        //!  it are not invoked.
+        std::size_t dispatch(value_type const& v) const
+        {
+            std::size_t const which = v.which();
+            if (which == value_type::npos)
+                detail::throw_bad_variant_access<void>();
+
+            void const* const target = v.target();
+            std::vector<_entry> const& handlers = _handlers[which];
+            for (_entry const& entry : handlers)
+                entry.handler(target);
+            return handlers.size();
+        }
+
+        //! template <class F>
+        //! std::size_t dispatch(variant<Ts...> const& v, F&& f) const;
+        //!
+        //! \requires `INVOKE(f, get<I>(v))` shall be a valid expression for
+        //!  every `I` in the range `[0u, sizeof...(Ts))`.
+        //!
+        //! \effects Equivalent to `apply<void>(f, v)` followed by
+        //!  `dispatch(v)`.
+        //!
+        //! \returns The number of subscribed handlers invoked.
+        template <typename F>
+        std::size_t dispatch(value_type const& v, F&& f) const
+        {
+            ::eggs::variants::apply<void>(f, v);
+            return dispatch(v);
+        }
+
+        //! std::size_t subscribers(std::size_t which) const noexcept;
+        //!
+        //! \returns The number of handlers subscribed to the alternative
+        //!  `which`, or `0` if `which >= sizeof...(Ts)`.
+        std::size_t subscribers(std::size_t which) const EGGS_CXX11_NOEXCEPT
+        {
+            return which < sizeof...(Ts) ? _handlers[which].size() : 0;
+        }
+
+    private:
+        std::array<std::vector<_entry>, sizeof...(Ts)> _handlers;
+        std::size_t _next_id;
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_DISPATCHER_HPP*/
@@ -0,0 +1,775 @@
+//! \file eggs/variant/flat_hash_map.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_FLAT_HASH_MAP_HPP
+#define EGGS_VARIANT_FLAT_HASH_MAP_HPP
+
+#include <eggs/variant/detail/bits.hpp>
+
+#include <eggs/variant/variant.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_X86_HAS_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        ///////////////////////////////////////////////////////////////////////
+        enum _ctrl_byte : signed char
+        {
+            _ctrl_empty = -128 // 0b10000000
+          , _ctrl_deleted = -2 // 0b11111110
+        };
+
+        // A group of control bytes, probed at once. Full slots have the high
+        // bit clear, empty and deleted slots have it set.
+        struct _ctrl_group
+        {
+            EGGS_CXX11_STATIC_CONSTEXPR std::size_t width = 16;
+
+#if EGGS_X86_HAS_SSE2
+            explicit _ctrl_group(signed char const* ctrl) EGGS_CXX11_NOEXCEPT
+              : _bytes(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ctrl)))
+            {}
+
+            std::uint32_t match(signed char h2) const EGGS_CXX11_NOEXCEPT
+            {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_set1_epi8(h2), _bytes)));
+            }
+
+            std::uint32_t match_empty_or_deleted() const EGGS_CXX11_NOEXCEPT
+            {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_bytes));
+            }
+
+            __m128i _bytes;
+#else
+            explicit _ctrl_group(signed char const* ctrl) EGGS_CXX11_NOEXCEPT
+              : _bytes(ctrl)
+            {}
+
+            std::uint32_t match(signed char h2) const EGGS_CXX11_NOEXCEPT
+            {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < width; ++i)
+                    mask |= std::uint32_t(_bytes[i] == h2) << i;
+                return mask;
+            }
+
+            std::uint32_t match_empty_or_deleted() const EGGS_CXX11_NOEXCEPT
+            {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < width; ++i)
+                    mask |= std::uint32_t(_bytes[i] < 0) << i;
+                return mask;
+            }
+
+            signed char const* _bytes;
+#endif
+
+            std::uint32_t match_empty() const EGGS_CXX11_NOEXCEPT
+            {
+                return match(_ctrl_empty);
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+    //! class flat_hash_map;
+    //!
+    //! An open-addressing hash map for keys of `variant` type, with storage
+    //! for its elements in a single flat array. Next to each element slot a
+    //! control byte records whether the slot is empty, deleted, or full; for
+    //! full slots it holds the discriminator of the key together with some
+    //! bits of its hash value. Lookups scan a group of control bytes at once
+    //! and only compare keys whose control byte matches, which rejects keys
+    //! with a different active member without touching their payload.
+    //!
+    //! `Key` shall be a type for which `variant_size<Key>` is defined and
+    //! which provides a member function `which()` with the semantics of
+    //! `variant<Ts...>::which()`, such as `variant` or `hashed_variant`.
+    //!
+    //! \remarks Rehashing recomputes the hash value of every element;
+    //!  `hashed_variant` keys avoid doing so for expensive payloads. Keys are
+    //!  copied, rather than moved, when the table is rehashed. Insertion
+    //!  invalidates all iterators and references if it causes a rehash;
+    //!  erasure invalidates only those to the erased element.
+    template <
+        typename Key, typename T
+      , typename Hash = std::hash<Key>
+      , typename KeyEqual = std::equal_to<Key>
+    >
+    class flat_hash_map
+    {
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _tag_bits =
+            detail::bit_width<variant_size<Key>::value>::value < 4
+          ? detail::bit_width<variant_size<Key>::value>::value : 4;
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _hash_bits = 7 - _tag_bits;
+
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _width =
+            detail::_ctrl_group::width;
+
+        template <typename V>
+        class _iterator;
+
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key const, T>;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+        using reference = value_type&;
+        using const_reference = value_type const&;
+        using pointer = value_type*;
+        using const_pointer = value_type const*;
+        using iterator = _iterator<value_type>;
+        using const_iterator = _iterator<value_type const>;
+
+    public:
+        //! flat_hash_map();
+        //!
+        //! \postconditions `size() == 0` and `bucket_count() == 0`. No memory
+        //!  is allocated.
+        flat_hash_map()
+          : flat_hash_map(0)
+        {}
+
+        //! explicit flat_hash_map(std::size_t n, Hash const& hash = Hash(), KeyEqual const& equal = KeyEqual());
+        //!
+        //! \effects Constructs an empty map with room for at least `n`
+        //!  elements before rehashing.
+        explicit flat_hash_map(std::size_t n
+          , Hash const& hash = Hash(), KeyEqual const& equal = KeyEqual())
+          : _ctrl{nullptr}
+          , _slots{nullptr}
+          , _capacity{0}
+          , _size{0}
+          , _growth_left{0}
+          , _hash{hash}
+          , _equal{equal}
+        {
+            reserve(n);
+        }
+
+        //! flat_hash_map(std::initializer_list<value_type> il);
+        //!
+        //! \effects Constructs a map with the elements of `il`, as if by
+        //!  calling `insert(v)` for each `v` in `il`.
+        flat_hash_map(std::initializer_list<value_type> il)
+          : flat_hash_map(il.size())
+        {
+            for (value_type const& v : il)
+                insert(v);
+        }
+
+        //! flat_hash_map(flat_hash_map const& rhs);
+        flat_hash_map(flat_hash_map const& rhs)
+          : flat_hash_map(0, rhs._hash, rhs._equal)
+        {
+            if (rhs._size == 0)
+                return;
+
+            // deleted slots are kept, as probe sequences may go past them
+            _allocate(rhs._capacity);
+            for (std::size_t i = 0; i < _capacity; ++i)
+            {
+                if (rhs._ctrl[i] >= 0)
+                {
+                    ::new (_slots + i) value_type(rhs._slots[i]);
+                    ++_size;
+                }
+                _ctrl[i] = rhs._ctrl[i];
+            }
+            _growth_left = rhs._growth_left;
+        }
+
+        //! flat_hash_map(flat_hash_map&& rhs) noexcept;
+        //!
+        //! \postconditions `rhs` is empty.
+        flat_hash_map(flat_hash_map&& rhs) EGGS_CXX11_NOEXCEPT
+          : _ctrl{rhs._ctrl}
+          , _slots{rhs._slots}
+          , _capacity{rhs._capacity}
+          , _size{rhs._size}
+          , _growth_left{rhs._growth_left}
+          , _hash{std::move(rhs._hash)}
+          , _equal{std::move(rhs._equal)}
+        {
+            rhs._ctrl = nullptr;
+            rhs._slots = nullptr;
+            rhs._capacity = rhs._size = rhs._growth_left = 0;
+        }
+
+        ~flat_hash_map()
+        {
+            _destroy();
+            _deallocate();
+        }
+
+        flat_hash_map& operator=(flat_hash_map const& rhs)
+        {
+            flat_hash_map(rhs).swap(*this);
+            return *this;
+        }
+
+        flat_hash_map& operator=(flat_hash_map&& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            flat_hash_map(std::move(rhs)).swap(*this);
+            return *this;
+        }
+
+        void swap(flat_hash_map& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            using std::swap;
+            swap(_ctrl, rhs._ctrl);
+            swap(_slots, rhs._slots);
+            swap(_capacity, rhs._capacity);
+            swap(_size, rhs._size);
+            swap(_growth_left, rhs._growth_left);
+            swap(_hash, rhs._hash);
+            swap(_equal, rhs._equal);
+        }
+
+        //! iterators
+        iterator begin() EGGS_CXX11_NOEXCEPT
+        {
+            return iterator{_ctrl, _slots, _ctrl + _capacity};
+        }
+
+        const_iterator begin() const EGGS_CXX11_NOEXCEPT
+        {
+            return const_iterator{_ctrl, _slots, _ctrl + _capacity};
+        }
+
+        const_iterator cbegin() const EGGS_CXX11_NOEXCEPT
+        {
+            return begin();
+        }
+
+        iterator end() EGGS_CXX11_NOEXCEPT
+        {
+            return iterator{};
+        }
+
+        const_iterator end() const EGGS_CXX11_NOEXCEPT
+        {
+            return const_iterator{};
+        }
+
+        const_iterator cend() const EGGS_CXX11_NOEXCEPT
+        {
+            return end();
+        }
+
+        //! capacity
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return _size == 0;
+        }
+
+        std::size_t size() const EGGS_CXX11_NOEXCEPT
+        {
+            return _size;
+        }
+
+        std::size_t bucket_count() const EGGS_CXX11_NOEXCEPT
+        {
+            return _capacity;
+        }
+
+        float load_factor() const EGGS_CXX11_NOEXCEPT
+        {
+            return _capacity != 0 ? float(_size) / float(_capacity) : 0.f;
+        }
+
+        float max_load_factor() const EGGS_CXX11_NOEXCEPT
+        {
+            return 7.f / 8.f;
+        }
+
+        //! void reserve(std::size_t n);
+        //!
+        //! \effects Rehashes the map, if needed, so that it can hold `n`
+        //!  elements without rehashing.
+        void reserve(std::size_t n)
+        {
+            std::size_t capacity = _width;
+            while (_max_size(capacity) < n)
+                capacity *= 2;
+            if (n != 0 && capacity > _capacity)
+                _rehash(capacity);
+        }
+
+        //! modifiers
+        void clear() EGGS_CXX11_NOEXCEPT
+        {
+            _destroy();
+            if (_capacity != 0)
+                std::memset(_ctrl, _ctrl_empty_byte(), _capacity);
+            _size = 0;
+            _growth_left = _max_size(_capacity);
+        }
+
+        std::pair<iterator, bool> insert(value_type const& v)
+        {
+            return try_emplace(v.first, v.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& v)
+        {
+            return try_emplace(v.first, std::move(v.second));
+        }
+
+        //! template <class K, class ...Args>
+        //! std::pair<iterator, bool> emplace(K&& k, Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace(key_type(std::forward<K>(k)),
+        //!  std::forward<Args>(args)...)`.
+        template <typename K, typename ...Args>
+        std::pair<iterator, bool> emplace(K&& k, Args&&... args)
+        {
+            return try_emplace(
+                key_type(std::forward<K>(k)), std::forward<Args>(args)...);
+        }
+
+        //! template <class ...Args>
+        //! std::pair<iterator, bool> try_emplace(key_type const& k, Args&&... args);
+        //!
+        //! \effects If the map already contains an element whose key is
+        //!  equivalent to `k`, there is no effect. Otherwise, inserts an
+        //!  element constructed from `std::piecewise_construct,
+        //!  std::forward_as_tuple(k), std::forward_as_tuple(
+        //!  std::forward<Args>(args)...)`.
+        //!
+        //! \returns A pair of an iterator to the element with key equivalent
+        //!  to `k`, and `true` if and only if the insertion took place.
+        template <typename ...Args>
+        std::pair<iterator, bool> try_emplace(key_type const& k, Args&&... args)
+        {
+            return _try_emplace(k, std::forward<Args>(args)...);
+        }
+
+        //! template <class ...Args>
+        //! std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace(k, std::forward<Args>(
+        //!  args)...)`, except that the key is move constructed from `k`.
+        template <typename ...Args>
+        std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        {
+            return _try_emplace(std::move(k), std::forward<Args>(args)...);
+        }
+
+        //! iterator erase(const_iterator pos);
+        //!
+        //! \effects Erases the element pointed to by `pos`.
+        //!
+        //! \returns An iterator to the element following the erased one.
+        iterator erase(const_iterator pos)
+        {
+            std::size_t const i = static_cast<std::size_t>(pos._slot - _slots);
+            iterator next{_ctrl + i + 1, _slots + i + 1, _ctrl + _capacity};
+            _erase(i);
+            return next;
+        }
+
+        //! std::size_t erase(key_type const& k);
+        //!
+        //! \effects Erases the element with key equivalent to `k`, if any.
+        //!
+        //! \returns The number of elements erased.
+        std::size_t erase(key_type const& k)
+        {
+            std::size_t const i = _find(k, _hash_of(k));
+            if (i == _npos)
+                return 0;
+            _erase(i);
+            return 1;
+        }
+
+        //! lookup
+        iterator find(key_type const& k)
+        {
+            std::size_t const i = _find(k, _hash_of(k));
+            return i != _npos ? _make_iterator(i) : end();
+        }
+
+        const_iterator find(key_type const& k) const
+        {
+            std::size_t const i = _find(k, _hash_of(k));
+            return i != _npos ? _make_iterator(i) : end();
+        }
+
+        std::size_t count(key_type const& k) const
+        {
+            return _find(k, _hash_of(k)) != _npos ? 1 : 0;
+        }
+
+        bool contains(key_type const& k) const
+        {
+            return _find(k, _hash_of(k)) != _npos;
+        }
+
+        T& operator[](key_type const& k)
+        {
+            return try_emplace(k).first->second;
+        }
+
+        T& operator[](key_type&& k)
+        {
+            return try_emplace(std::move(k)).first->second;
+        }
+
+        //! T& at(key_type const& k);
+        //!
+        //! \throws `std::out_of_range` if the map contains no element with
+        //!  key equivalent to `k`.
+        T& at(key_type const& k)
+        {
+            std::size_t const i = _find(k, _hash_of(k));
+            return i != _npos ? _slots[i].second : _throw_out_of_range();
+        }
+
+        T const& at(key_type const& k) const
+        {
+            std::size_t const i = _find(k, _hash_of(k));
+            return i != _npos ? _slots[i].second : _throw_out_of_range();
+        }
+
+        //! observers
+        hasher hash_function() const
+        {
+            return _hash;
+        }
+
+        key_equal key_eq() const
+        {
+            return _equal;
+        }
+
+    private:
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _npos = std::size_t(-1);
+
+        static std::size_t _max_size(std::size_t capacity) EGGS_CXX11_NOEXCEPT
+        {
+            return capacity - capacity / 8;
+        }
+
+        static int _ctrl_empty_byte() EGGS_CXX11_NOEXCEPT
+        {
+            return static_cast<unsigned char>(detail::_ctrl_empty);
+        }
+
+        EGGS_CXX11_NORETURN static T& _throw_out_of_range()
+        {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            throw std::out_of_range{"flat_hash_map::at"};
+#else
+            std::terminate();
+#endif
+        }
+
+        std::size_t _hash_of(key_type const& k) const
+        {
+            return detail::hash_mix(_hash(k));
+        }
+
+        static signed char _h2(key_type const& k, std::size_t hash)
+            EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const tag =
+                (k.which() + 1) & ((std::size_t(1) << _tag_bits) - 1);
+            return static_cast<signed char>(
+                (tag << _hash_bits)
+              | (hash & ((std::size_t(1) << _hash_bits) - 1)));
+        }
+
+        iterator _make_iterator(std::size_t i) const EGGS_CXX11_NOEXCEPT
+        {
+            return iterator{_ctrl + i, _slots + i, _ctrl + _capacity};
+        }
+
+        std::size_t _find(key_type const& k, std::size_t hash) const
+        {
+            if (_size == 0)
+                return _npos;
+
+            signed char const h2 = _h2(k, hash);
+            std::size_t const mask = _capacity / _width - 1;
+            std::size_t g = (hash >> 7) & mask;
+            for (std::size_t step = 1; ; ++step)
+            {
+                detail::_ctrl_group const group(_ctrl + g * _width);
+                for (std::uint32_t m = group.match(h2); m != 0; m &= m - 1)
+                {
+                    std::size_t const i =
+                        g * _width + detail::count_trailing_zeros(m);
+                    if (_equal(_slots[i].first, k))
+                        return i;
+                }
+                if (group.match_empty() != 0)
+                    return _npos;
+                g = (g + step) & mask;
+            }
+        }
+
+        std::size_t _find_insert_slot(std::size_t hash) const EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const mask = _capacity / _width - 1;
+            std::size_t g = (hash >> 7) & mask;
+            for (std::size_t step = 1; ; ++step)
+            {
+                detail::_ctrl_group const group(_ctrl + g * _width);
+                std::uint32_t const m = group.match_empty_or_deleted();
+                if (m != 0)
+                    return g * _width + detail::count_trailing_zeros(m);
+                g = (g + step) & mask;
+            }
+        }
+
+        template <typename K, typename ...Args>
+        std::pair<iterator, bool> _try_emplace(K&& k, Args&&... args)
+        {
+            std::size_t const hash = _hash_of(k);
+            std::size_t i = _find(k, hash);
+            if (i != _npos)
+                return std::make_pair(_make_iterator(i), false);
+
+            if (_capacity == 0)
+                _rehash(_width);
+            i = _find_insert_slot(hash);
+            if (_growth_left == 0 && _ctrl[i] != detail::_ctrl_deleted)
+            {
+                _rehash(_size * 2 > _max_size(_capacity)
+                    ? _capacity * 2 : _capacity);
+                i = _find_insert_slot(hash);
+            }
+
+            signed char const h2 = _h2(k, hash);
+            ::new (_slots + i) value_type(
+                std::piecewise_construct
+              , std::forward_as_tuple(std::forward<K>(k))
+              , std::forward_as_tuple(std::forward<Args>(args)...));
+            if (_ctrl[i] == detail::_ctrl_empty)
+                --_growth_left;
+            _ctrl[i] = h2;
+            ++_size;
+            return std::make_pair(_make_iterator(i), true);
+        }
+
+        void _erase(std::size_t i) EGGS_CXX11_NOEXCEPT
+        {
+            _slots[i].~value_type();
+            --_size;
+
+            // a probe sequence never went past a group that still has an
+            // empty slot, so the slot can be made empty rather than deleted
+            detail::_ctrl_group const group(_ctrl + i / _width * _width);
+            if (group.match_empty() != 0)
+            {
+                _ctrl[i] = detail::_ctrl_empty;
+                ++_growth_left;
+            } else {
+                _ctrl[i] = detail::_ctrl_deleted;
+            }
+        }
+
+        void _rehash(std::size_t capacity)
+        {
+            flat_hash_map tmp(0, _hash, _equal);
+            tmp._allocate(capacity);
+            for (std::size_t i = 0; i < _capacity; ++i)
+            {
+                if (_ctrl[i] >= 0)
+                {
+                    std::size_t const j =
+                        tmp._find_insert_slot(_hash_of(_slots[i].first));
+                    ::new (tmp._slots + j) value_type(std::move(_slots[i]));
+                    tmp._ctrl[j] = _ctrl[i];
+                    ++tmp._size;
+                }
+            }
+            tmp._growth_left = _max_size(capacity) - tmp._size;
+            swap(tmp);
+        }
+
+        void _allocate(std::size_t capacity)
+        {
+            std::allocator<value_type> slot_alloc;
+            std::allocator<signed char> ctrl_alloc;
+
+            _slots = slot_alloc.allocate(capacity);
+            _ctrl = ctrl_alloc.allocate(capacity);
+            std::memset(_ctrl, _ctrl_empty_byte(), capacity);
+            _capacity = capacity;
+            _growth_left = _max_size(capacity);
+        }
+
+        void _deallocate() EGGS_CXX11_NOEXCEPT
+        {
+            if (_capacity != 0)
+            {
+                std::allocator<value_type>().deallocate(_slots, _capacity);
+                std::allocator<signed char>().deallocate(_ctrl, _capacity);
+            }
+        }
+
+        void _destroy() EGGS_CXX11_NOEXCEPT
+        {
+            if (!std::is_trivially_destructible<value_type>::value)
+            {
+                for (std::size_t i = 0; i < _capacity; ++i)
+                {
+                    if (_ctrl[i] >= 0)
+                        _slots[i].~value_type();
+                }
+            }
+        }
+
+        template <typename V>
+        class _iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = typename std::remove_const<V>::type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = V*;
+            using reference = V&;
+
+        public:
+            _iterator() EGGS_CXX11_NOEXCEPT
+              : _ctrl{nullptr}
+              , _slot{nullptr}
+              , _end{nullptr}
+            {}
+
+            template <
+                typename U
+              , typename Enable = typename std::enable_if<
+                    std::is_convertible<U*, V*>::value
+                >::type
+            >
+            _iterator(_iterator<U> const& other) EGGS_CXX11_NOEXCEPT
+              : _ctrl{other._ctrl}
+              , _slot{other._slot}
+              , _end{other._end}
+            {}
+
+            reference operator*() const EGGS_CXX11_NOEXCEPT
+            {
+                return *_slot;
+            }
+
+            pointer operator->() const EGGS_CXX11_NOEXCEPT
+            {
+                return _slot;
+            }
+
+            _iterator& operator++() EGGS_CXX11_NOEXCEPT
+            {
+                ++_ctrl;
+                ++_slot;
+                _skip_empty();
+                return *this;
+            }
+
+            _iterator operator++(int) EGGS_CXX11_NOEXCEPT
+            {
+                _iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            friend bool operator==(
+                _iterator const& lhs, _iterator const& rhs) EGGS_CXX11_NOEXCEPT
+            {
+                return lhs._slot == rhs._slot;
+            }
+
+            friend bool operator!=(
+                _iterator const& lhs, _iterator const& rhs) EGGS_CXX11_NOEXCEPT
+            {
+                return lhs._slot != rhs._slot;
+            }
+
+        private:
+            friend class flat_hash_map;
+            template <typename U> friend class _iterator;
+
+            _iterator(signed char const* ctrl, V* slot, signed char const* end)
+                EGGS_CXX11_NOEXCEPT
+              : _ctrl{ctrl}
+              , _slot{slot}
+              , _end{end}
+            {
+                _skip_empty();
+            }
+
+            void _skip_empty() EGGS_CXX11_NOEXCEPT
+            {
+                while (_ctrl != _end && *_ctrl < 0)
+                {
+                    ++_ctrl;
+                    ++_slot;
+                }
+                if (_ctrl == _end)
+                    *this = _iterator{};
+            }
+
+            signed char const* _ctrl;
+            V* _slot;
+            signed char const* _end;
+        };
+
+    private:
+        signed char* _ctrl;
+        value_type* _slots;
+        std::size_t _capacity;
+        std::size_t _size;
+        std::size_t _growth_left;
+        Hash _hash;
+        KeyEqual _equal;
+    };
+
+    //! template <class Key, class T, class Hash, class KeyEqual>
+    //! void swap(flat_hash_map<Key, T, Hash, KeyEqual>& x, flat_hash_map<Key, T, Hash, KeyEqual>& y) noexcept;
+    //!
+    //! \effects Calls `x.swap(y)`.
+    template <typename Key, typename T, typename Hash, typename KeyEqual>
+    void swap(
+        flat_hash_map<Key, T, Hash, KeyEqual>& x
+      , flat_hash_map<Key, T, Hash, KeyEqual>& y) EGGS_CXX11_NOEXCEPT
+    {
+        x.swap(y);
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_FLAT_HASH_MAP_HPP*/
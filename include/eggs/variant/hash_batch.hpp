@@ -0,0 +1,95 @@
+//! \file eggs/variant/hash_batch.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_HASH_BATCH_HPP
+#define EGGS_VARIANT_HASH_BATCH_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        ///////////////////////////////////////////////////////////////////////
+        template <typename ...Ts>
+        std::size_t _hash_one(variant<Ts...> const& /*v*/, index<0>)
+        {
+            return 0u;
+        }
+
+        template <typename ...Ts, std::size_t I>
+        std::size_t _hash_one(variant<Ts...> const& v, index<I>)
+        {
+            using T = typename at_index<I - 1, pack<Ts...>>::type;
+            return std::hash<T>{}(access::get(v, index<I - 1>{}));
+        }
+
+        template <typename RandomIt, typename RandomOutIt>
+        struct _hash_batch
+        {
+            template <typename I>
+            static void call(
+                RandomIt const& block, std::uint16_t const* indices,
+                std::size_t count, std::size_t offset, RandomOutIt& out)
+            {
+                if (indices == nullptr)
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                        out[offset + i] = _hash_one(block[i], I{});
+                } else {
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        std::size_t const j = indices[i];
+                        out[offset + j] = _hash_one(block[j], I{});
+                    }
+                }
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt, class RandomOutIt>
+    //! RandomOutIt hash_batch(RandomIt first, RandomIt last, RandomOutIt out);
+    //!
+    //! \requires `RandomIt` and `RandomOutIt` shall satisfy the requirements
+    //!  of random access iterators. The value type of `RandomIt` shall be
+    //!  `variant<Ts...>` and the template specialization `std::hash<T>` shall
+    //!  meet the requirements of class template `std::hash` for all `T` in
+    //!  `Ts...`. The ranges `[first, last)` and `[out, out + (last - first))`
+    //!  shall not overlap.
+    //!
+    //! \effects For every `i` in `[0, last - first)`, assigns
+    //!  `std::hash<variant<Ts...>>{}(first[i])` to `out[i]`.
+    //!
+    //! \returns `out + (last - first)`.
+    //!
+    //! \remarks The input is processed in blocks, each of which is partitioned
+    //!  by `which()`. A single indirect dispatch per alternative per block then
+    //!  runs a loop specialized for that alternative, instead of dispatching
+    //!  once per element. Blocks holding a single alternative are not
+    //!  partitioned.
+    template <typename RandomIt, typename RandomOutIt>
+    RandomOutIt hash_batch(RandomIt first, RandomIt last, RandomOutIt out)
+    {
+        detail::batch_dispatch<detail::_hash_batch<RandomIt, RandomOutIt>>(
+            first, last, out);
+        return out + (last - first);
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_HASH_BATCH_HPP*/
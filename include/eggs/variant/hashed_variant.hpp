@@ -0,0 +1,510 @@
+//! \file eggs/variant/hashed_variant.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_HASHED_VARIANT_HPP
+#define EGGS_VARIANT_HASHED_VARIANT_HPP
+
+#include <eggs/variant/detail/pack.hpp>
+
+#include <eggs/variant/in_place.hpp>
+#include <eggs/variant/variant.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts> class hashed_variant;
+    //!
+    //! A `hashed_variant` holds a `variant<Ts...>` along with a cache of its
+    //! hash value. The hash value is computed on first use, as if by
+    //! `std::hash<variant<Ts...>>`, and the cache is discarded whenever the
+    //! contained `variant` is modified through the interface of
+    //! `hashed_variant`.
+    //!
+    //! \remarks The cache is not synchronized; concurrent calls to `hash()`
+    //!  on the same object shall not take place before the hash value has
+    //!  been computed.
+    template <typename ...Ts>
+    class hashed_variant
+    {
+    public:
+        //! using variant_type = variant<Ts...>;
+        using variant_type = variant<Ts...>;
+
+        //! static constexpr std::size_t npos = std::size_t(-1);
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t npos = std::size_t(-1);
+
+    public:
+        //! constexpr hashed_variant() noexcept;
+        //!
+        //! \postconditions `*this` does not have an active member, and has no
+        //!  cached hash value.
+        EGGS_CXX11_CONSTEXPR hashed_variant() EGGS_CXX11_NOEXCEPT
+          : _variant{}
+          , _hash{0}
+          , _has_hash{false}
+        {}
+
+        //! hashed_variant(hashed_variant const& rhs);
+        //!
+        //! \effects Copies the contained `variant` and the cached hash value
+        //!  (if any) of `rhs`.
+#if EGGS_CXX11_HAS_DEFAULTED_FUNCTIONS
+        hashed_variant(hashed_variant const& rhs) = default;
+#endif
+
+        //! hashed_variant(hashed_variant&& rhs) noexcept(see below);
+        //!
+        //! \effects Moves the contained `variant` and copies the cached hash
+        //!  value (if any) of `rhs`.
+#if EGGS_CXX11_HAS_DEFAULTED_FUNCTIONS
+        hashed_variant(hashed_variant&& rhs) = default;
+#endif
+
+        //! template <class U>
+        //! constexpr hashed_variant(U&& v);
+        //!
+        //! \effects Initializes the contained `variant` as if direct-non-list-
+        //!  initializing an object of type `variant<Ts...>` with the
+        //!  expression `std::forward<U>(v)`.
+        //!
+        //! \postconditions `*this` has no cached hash value.
+        //!
+        //! \remarks This constructor shall not participate in overload
+        //!  resolution unless `std::decay_t<U>` is not `hashed_variant` and
+        //!  `std::is_constructible_v<variant<Ts...>, U&&>` is `true`.
+        template <
+            typename U
+          , typename Enable = typename std::enable_if<
+                !std::is_same<
+                    typename std::decay<U>::type, hashed_variant
+                >::value
+             && std::is_constructible<variant_type, U&&>::value
+            >::type
+        >
+        EGGS_CXX11_CONSTEXPR hashed_variant(U&& v)
+#if EGGS_CXX11_STD_HAS_IS_NOTHROW_TRAITS
+            EGGS_CXX11_NOEXCEPT_IF(
+                std::is_nothrow_constructible<variant_type, U&&>::value)
+#endif
+          : _variant(std::forward<U>(v))
+          , _hash{0}
+          , _has_hash{false}
+        {}
+
+        //! template <class Tag, class ...Args>
+        //! constexpr explicit hashed_variant(in_place_t(*tag)(Tag), Args&&... args);
+        //!
+        //! \effects Initializes the contained `variant` as if by
+        //!  `variant<Ts...>(tag, std::forward<Args>(args)...)`.
+        //!
+        //! \postconditions `*this` has no cached hash value.
+        template <typename Tag, typename ...Args>
+        EGGS_CXX11_CONSTEXPR explicit hashed_variant(
+            in_place_t(*tag)(Tag), Args&&... args)
+          : _variant(tag, std::forward<Args>(args)...)
+          , _hash{0}
+          , _has_hash{false}
+        {}
+
+#if EGGS_CXX11_HAS_INITIALIZER_LIST_OVERLOADING
+        //! template <class Tag, class U, class ...Args>
+        //! constexpr explicit hashed_variant(in_place_t(*tag)(Tag), std::initializer_list<U> il, Args&&... args);
+        //!
+        //! \effects Initializes the contained `variant` as if by
+        //!  `variant<Ts...>(tag, il, std::forward<Args>(args)...)`.
+        //!
+        //! \postconditions `*this` has no cached hash value.
+        template <typename Tag, typename U, typename ...Args>
+        EGGS_CXX11_CONSTEXPR explicit hashed_variant(
+            in_place_t(*tag)(Tag)
+          , std::initializer_list<U> il, Args&&... args)
+          : _variant(tag, il, std::forward<Args>(args)...)
+          , _hash{0}
+          , _has_hash{false}
+        {}
+#endif
+
+#if EGGS_CXX11_HAS_DEFAULTED_FUNCTIONS
+        ~hashed_variant() = default;
+#endif
+
+        //! hashed_variant& operator=(hashed_variant const& rhs);
+        //!
+        //! \effects Assigns the contained `variant` and the cached hash value
+        //!  (if any) of `rhs`.
+#if EGGS_CXX11_HAS_DEFAULTED_FUNCTIONS
+        hashed_variant& operator=(hashed_variant const& rhs) = default;
+#endif
+
+        //! hashed_variant& operator=(hashed_variant&& rhs) noexcept(see below);
+        //!
+        //! \effects Move assigns the contained `variant` and copies the
+        //!  cached hash value (if any) of `rhs`.
+#if EGGS_CXX11_HAS_DEFAULTED_FUNCTIONS
+        hashed_variant& operator=(hashed_variant&& rhs) = default;
+#endif
+
+        //! template <class U>
+        //! hashed_variant& operator=(U&& v);
+        //!
+        //! \effects Discards the cached hash value. Then, equivalent to
+        //!  `value_ref() = std::forward<U>(v)`, where `value_ref()` denotes
+        //!  the contained `variant`.
+        //!
+        //! \returns `*this`.
+        //!
+        //! \remarks This operator shall not participate in overload
+        //!  resolution unless `std::decay_t<U>` is not `hashed_variant` and
+        //!  `std::is_assignable_v<variant<Ts...>&, U&&>` is `true`.
+        template <
+            typename U
+          , typename Enable = typename std::enable_if<
+                !std::is_same<
+                    typename std::decay<U>::type, hashed_variant
+                >::value
+             && std::is_assignable<variant_type&, U&&>::value
+            >::type
+        >
+        hashed_variant& operator=(U&& v)
+        {
+            _has_hash = false;
+            _variant = std::forward<U>(v);
+            return *this;
+        }
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Discards the cached hash value. Then, equivalent to
+        //!  `value_ref().emplace<I>(std::forward<Args>(args)...)`, where
+        //!  `value_ref()` denotes the contained `variant`.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            _has_hash = false;
+            _variant.template emplace<I>(std::forward<Args>(args)...);
+        }
+
+#if EGGS_CXX11_HAS_INITIALIZER_LIST_OVERLOADING
+        //! template <std::size_t I, class U, class ...Args>
+        //! void emplace(std::initializer_list<U> il, Args&&... args);
+        //!
+        //! \effects Discards the cached hash value. Then, equivalent to
+        //!  `value_ref().emplace<I>(il, std::forward<Args>(args)...)`, where
+        //!  `value_ref()` denotes the contained `variant`.
+        template <std::size_t I, typename U, typename ...Args>
+        void emplace(std::initializer_list<U> il, Args&&... args)
+        {
+            _has_hash = false;
+            _variant.template emplace<I>(il, std::forward<Args>(args)...);
+        }
+#endif
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Discards the cached hash value. Then, equivalent to
+        //!  `value_ref().emplace<T>(std::forward<Args>(args)...)`, where
+        //!  `value_ref()` denotes the contained `variant`.
+        template <typename T, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            _has_hash = false;
+            _variant.template emplace<T>(std::forward<Args>(args)...);
+        }
+
+#if EGGS_CXX11_HAS_INITIALIZER_LIST_OVERLOADING
+        //! template <class T, class U, class ...Args>
+        //! void emplace(std::initializer_list<U> il, Args&&... args);
+        //!
+        //! \effects Discards the cached hash value. Then, equivalent to
+        //!  `value_ref().emplace<T>(il, std::forward<Args>(args)...)`, where
+        //!  `value_ref()` denotes the contained `variant`.
+        template <typename T, typename U, typename ...Args>
+        void emplace(std::initializer_list<U> il, Args&&... args)
+        {
+            _has_hash = false;
+            _variant.template emplace<T>(il, std::forward<Args>(args)...);
+        }
+#endif
+#endif
+
+        //! void swap(hashed_variant& rhs) noexcept(see below);
+        //!
+        //! \effects Swaps the contained `variant`s and the cached hash values
+        //!  of `*this` and `rhs`.
+        //!
+        //! \remarks The expression inside `noexcept` is equivalent to
+        //!  `noexcept(std::declval<variant<Ts...>&>().swap(
+        //!  std::declval<variant<Ts...>&>()))`.
+        void swap(hashed_variant& rhs)
+            EGGS_CXX11_NOEXCEPT_IF(EGGS_CXX11_NOEXCEPT_EXPR(
+                std::declval<variant_type&>().swap(
+                    std::declval<variant_type&>())))
+        {
+            _variant.swap(rhs._variant);
+            std::swap(_hash, rhs._hash);
+            std::swap(_has_hash, rhs._has_hash);
+        }
+
+        //! constexpr explicit operator bool() const noexcept;
+        //!
+        //! \returns `bool(value())`.
+        EGGS_CXX11_CONSTEXPR explicit operator bool() const EGGS_CXX11_NOEXCEPT
+        {
+            return bool(_variant);
+        }
+
+        //! constexpr std::size_t which() const noexcept;
+        //!
+        //! \returns `value().which()`.
+        EGGS_CXX11_CONSTEXPR std::size_t which() const EGGS_CXX11_NOEXCEPT
+        {
+            return _variant.which();
+        }
+
+#if EGGS_CXX98_HAS_RTTI
+        //! constexpr std::type_info const& target_type() const noexcept;
+        //!
+        //! \returns `value().target_type()`.
+        EGGS_CXX11_CONSTEXPR std::type_info const& target_type() const EGGS_CXX11_NOEXCEPT
+        {
+            return _variant.target_type();
+        }
+#endif
+
+        //! void* target() noexcept;
+        //!
+        //! \effects Discards the cached hash value.
+        //!
+        //! \returns `value_ref().target()`, where `value_ref()` denotes the
+        //!  contained `variant`.
+        //!
+        //! \remarks Modifications made through the returned pointer after a
+        //!  subsequent call to `hash()` are not reflected by the cache.
+        void* target() EGGS_CXX11_NOEXCEPT
+        {
+            _has_hash = false;
+            return _variant.target();
+        }
+
+        //! constexpr void const* target() const noexcept;
+        //!
+        //! \returns `value().target()`.
+        EGGS_CXX11_CONSTEXPR void const* target() const EGGS_CXX11_NOEXCEPT
+        {
+            return _variant.target();
+        }
+
+        //! template <class T>
+        //! T* target() noexcept;
+        //!
+        //! \effects Discards the cached hash value.
+        //!
+        //! \returns `value_ref().target<T>()`, where `value_ref()` denotes
+        //!  the contained `variant`.
+        //!
+        //! \remarks Modifications made through the returned pointer after a
+        //!  subsequent call to `hash()` are not reflected by the cache.
+        template <typename T>
+        T* target() EGGS_CXX11_NOEXCEPT
+        {
+            _has_hash = false;
+            return _variant.template target<T>();
+        }
+
+        //! template <class T>
+        //! constexpr T const* target() const noexcept;
+        //!
+        //! \returns `value().target<T>()`.
+        template <typename T>
+        EGGS_CXX11_CONSTEXPR T const* target() const EGGS_CXX11_NOEXCEPT
+        {
+            return _variant.template target<T>();
+        }
+
+        //! constexpr variant<Ts...> const& value() const noexcept;
+        //!
+        //! \returns A const reference to the contained `variant`.
+        EGGS_CXX11_CONSTEXPR variant_type const& value() const EGGS_CXX11_NOEXCEPT
+        {
+            return _variant;
+        }
+
+        //! std::size_t hash() const;
+        //!
+        //! \effects If `*this` has no cached hash value, computes it as if by
+        //!  `std::hash<variant<Ts...>>{}(value())` and caches it.
+        //!
+        //! \returns The cached hash value.
+        std::size_t hash() const
+        {
+            if (!_has_hash)
+            {
+                _hash = std::hash<variant_type>{}(_variant);
+                _has_hash = true;
+            }
+            return _hash;
+        }
+
+        //! constexpr bool has_cached_hash() const noexcept;
+        //!
+        //! \returns `true` if and only if `*this` has a cached hash value.
+        EGGS_CXX11_CONSTEXPR bool has_cached_hash() const EGGS_CXX11_NOEXCEPT
+        {
+            return _has_hash;
+        }
+
+    private:
+        variant_type _variant;
+        mutable std::size_t _hash;
+        mutable bool _has_hash;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! struct variant_size<hashed_variant<Ts...>>;
+    //!
+    //! \remarks Has a `BaseCharacteristic` of `std::integral_constant<
+    //!  std::size_t, sizeof...(Ts)>`.
+    template <typename ...Ts>
+    struct variant_size<hashed_variant<Ts...>>
+      : std::integral_constant<std::size_t, sizeof...(Ts)>
+    {};
+
+    //! template <std::size_t I, class ...Ts>
+    //! struct variant_element<I, hashed_variant<Ts...>>;
+    //!
+    //! \requires `I < sizeof...(Ts)`.
+    //!
+    //! \remarks The member typedef `type` shall name the type of the `I`th
+    //!  element of `Ts...`, where indexing is zero-based.
+    template <std::size_t I, typename ...Ts>
+    struct variant_element<I, hashed_variant<Ts...>>
+      : detail::at_index<I, detail::pack<Ts...>>
+    {};
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! bool operator==(hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs);
+    //!
+    //! \returns If both `lhs` and `rhs` have a cached hash value and those
+    //!  values differ, `false`; otherwise, `lhs.value() == rhs.value()`.
+    template <typename ...Ts>
+    bool operator==(
+        hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs)
+    {
+        return lhs.has_cached_hash() && rhs.has_cached_hash()
+            && lhs.hash() != rhs.hash()
+          ? false
+          : lhs.value() == rhs.value();
+    }
+
+    //! template <class ...Ts>
+    //! bool operator!=(hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs);
+    //!
+    //! \returns `!(lhs == rhs)`.
+    template <typename ...Ts>
+    bool operator!=(
+        hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    //! template <class ...Ts>
+    //! constexpr bool operator<(hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs);
+    //!
+    //! \returns `lhs.value() < rhs.value()`.
+    template <typename ...Ts>
+    EGGS_CXX11_CONSTEXPR bool operator<(
+        hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs)
+    {
+        return lhs.value() < rhs.value();
+    }
+
+    //! template <class ...Ts>
+    //! constexpr bool operator>(hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs);
+    //!
+    //! \returns `rhs < lhs`.
+    template <typename ...Ts>
+    EGGS_CXX11_CONSTEXPR bool operator>(
+        hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs)
+    {
+        return rhs < lhs;
+    }
+
+    //! template <class ...Ts>
+    //! constexpr bool operator<=(hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs);
+    //!
+    //! \returns `!(rhs < lhs)`.
+    template <typename ...Ts>
+    EGGS_CXX11_CONSTEXPR bool operator<=(
+        hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    //! template <class ...Ts>
+    //! constexpr bool operator>=(hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs);
+    //!
+    //! \returns `!(lhs < rhs)`.
+    template <typename ...Ts>
+    EGGS_CXX11_CONSTEXPR bool operator>=(
+        hashed_variant<Ts...> const& lhs, hashed_variant<Ts...> const& rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! void swap(hashed_variant<Ts...>& x, hashed_variant<Ts...>& y)
+    //!   noexcept(noexcept(x.swap(y))
+    //!
+    //! \effects Calls `x.swap(y)`.
+    template <typename ...Ts>
+    void swap(hashed_variant<Ts...>& x, hashed_variant<Ts...>& y)
+        EGGS_CXX11_NOEXCEPT_IF(EGGS_CXX11_NOEXCEPT_EXPR(x.swap(y)))
+    {
+        x.swap(y);
+    }
+}}
+
+namespace std
+{
+    //! template <class ...Ts>
+    //! struct hash<::eggs::variants::hashed_variant<Ts...>>;
+    //!
+    //! \returns For an object `v` of type `hashed_variant<Ts...>`,
+    //!  `std::hash<hashed_variant<Ts...>>()(v)` evaluates to `v.hash()`.
+    template <typename ...Ts>
+    struct hash< ::eggs::variants::hashed_variant<Ts...>>
+    {
+        using argument_type = ::eggs::variants::hashed_variant<Ts...>;
+        using result_type = std::size_t;
+
+        std::size_t operator()(
+            ::eggs::variants::hashed_variant<Ts...> const& v) const
+        {
+            return v.hash();
+        }
+    };
+}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_HASHED_VARIANT_HPP*/
@@ -0,0 +1,314 @@
+//! \file eggs/variant/intern_pool.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_INTERN_POOL_HPP
+#define EGGS_VARIANT_INTERN_POOL_HPP
+
+#include <eggs/variant/detail/bits.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    template <typename Variant, std::size_t Shards>
+    class intern_pool;
+
+    namespace detail
+    {
+        template <typename Variant>
+        struct _interned_node
+        {
+            Variant value;
+            std::size_t hash;
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Variant>
+    //! class interned;
+    //!
+    //! A handle to a value owned by an `intern_pool`. Two handles obtained
+    //! from the same pool compare equal if and only if the values they refer
+    //! to compare equal, so equality is a pointer comparison; the hash of the
+    //! value is computed once, when the value is first interned.
+    template <typename Variant>
+    class interned
+    {
+        template <typename V, std::size_t Shards>
+        friend class intern_pool;
+
+        using node = detail::_interned_node<Variant>;
+
+    public:
+        using value_type = Variant;
+
+    public:
+        //! constexpr interned() noexcept;
+        //!
+        //! \postconditions `bool(*this) == false`.
+        EGGS_CXX11_CONSTEXPR interned() EGGS_CXX11_NOEXCEPT
+          : _node(nullptr)
+        {}
+
+        //! constexpr explicit operator bool() const noexcept;
+        //!
+        //! \returns `true` if and only if `*this` refers to an interned value.
+        EGGS_CXX11_CONSTEXPR explicit operator bool() const EGGS_CXX11_NOEXCEPT
+        {
+            return _node != nullptr;
+        }
+
+        //! Variant const& get() const noexcept;
+        //!
+        //! \requires `bool(*this) == true`.
+        //!
+        //! \returns A reference to the interned value.
+        Variant const& get() const EGGS_CXX11_NOEXCEPT
+        {
+            return _node->value;
+        }
+
+        Variant const& operator*() const EGGS_CXX11_NOEXCEPT
+        {
+            return _node->value;
+        }
+
+        Variant const* operator->() const EGGS_CXX11_NOEXCEPT
+        {
+            return &_node->value;
+        }
+
+        //! std::size_t hash() const noexcept;
+        //!
+        //! \returns `std::hash<Variant>{}(get())` if `bool(*this) == true`;
+        //!  otherwise, `0`.
+        std::size_t hash() const EGGS_CXX11_NOEXCEPT
+        {
+            return _node != nullptr ? _node->hash : 0u;
+        }
+
+        //! friend bool operator==(interned const& lhs, interned const& rhs) noexcept;
+        //!
+        //! \requires `lhs` and `rhs` were obtained from the same pool, or are
+        //!  empty.
+        //!
+        //! \returns `true` if `lhs` and `rhs` refer to the same value.
+        friend bool operator==(
+            interned const& lhs, interned const& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            return lhs._node == rhs._node;
+        }
+
+        friend bool operator!=(
+            interned const& lhs, interned const& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            return lhs._node != rhs._node;
+        }
+
+        //! friend bool operator<(interned const& lhs, interned const& rhs) noexcept;
+        //!
+        //! \returns An unspecified strict total order over handles, consistent
+        //!  within a single run of the program; it is unrelated to the order
+        //!  of the interned values.
+        friend bool operator<(
+            interned const& lhs, interned const& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            return std::less<node const*>{}(lhs._node, rhs._node);
+        }
+
+    private:
+        explicit interned(node const* n) EGGS_CXX11_NOEXCEPT
+          : _node(n)
+        {}
+
+        node const* _node;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Variant, std::size_t Shards = 16>
+    //! class intern_pool;
+    //!
+    //! An `intern_pool` stores a single copy of each distinct value of type
+    //! `Variant` it is given, and hands out `interned<Variant>` handles to
+    //! them. Interned values are never modified nor destroyed before the pool
+    //! itself, so handles remain valid for the lifetime of the pool.
+    //!
+    //! Values are distributed over `Shards` independently locked shards by
+    //! their hash, so that concurrent calls to `intern` contend only when
+    //! they land on the same shard.
+    //!
+    //! \requires `Variant` shall be `CopyConstructible`, `EqualityComparable`,
+    //!  and the template specialization `std::hash<Variant>` shall meet the
+    //!  requirements of class template `std::hash`. `Shards` shall be greater
+    //!  than `0`.
+    template <typename Variant, std::size_t Shards = 16>
+    class intern_pool
+    {
+        static_assert(Shards > 0, "intern_pool requires at least one shard");
+
+        using node = detail::_interned_node<Variant>;
+
+        struct shard
+        {
+            mutable std::mutex mutex;
+            std::deque<node> nodes;
+            std::unordered_multimap<std::size_t, node const*> index;
+        };
+
+    public:
+        using value_type = Variant;
+        using handle = interned<Variant>;
+
+    public:
+        //! intern_pool();
+        //!
+        //! \postconditions `size() == 0`.
+        intern_pool() = default;
+
+        intern_pool(intern_pool const&) = delete;
+        intern_pool& operator=(intern_pool const&) = delete;
+
+        //! handle intern(Variant const& v);
+        //!
+        //! \effects If the pool holds a value equal to `v`, does nothing.
+        //!  Otherwise, stores a copy of `v` in the pool.
+        //!
+        //! \returns A handle to the value in the pool that compares equal to
+        //!  `v`.
+        //!
+        //! \remarks This function may be called concurrently from multiple
+        //!  threads.
+        handle intern(Variant const& v)
+        {
+            return _intern(v, std::hash<Variant>{}(v));
+        }
+
+        //! handle intern(Variant&& v);
+        //!
+        //! \effects Equivalent to `intern(v)`, except that when `v` is stored
+        //!  it is move constructed into the pool.
+        handle intern(Variant&& v)
+        {
+            std::size_t const hash = std::hash<Variant>{}(v);
+            return _intern(std::move(v), hash);
+        }
+
+        //! handle find(Variant const& v) const;
+        //!
+        //! \returns A handle to the value in the pool that compares equal to
+        //!  `v` if there is one; otherwise, an empty handle.
+        //!
+        //! \remarks This function may be called concurrently from multiple
+        //!  threads.
+        handle find(Variant const& v) const
+        {
+            std::size_t const hash = std::hash<Variant>{}(v);
+            shard const& s = _shard(hash);
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+            return handle(_find(s, v, hash));
+        }
+
+        //! std::size_t size() const;
+        //!
+        //! \returns The number of distinct values held by the pool.
+        std::size_t size() const
+        {
+            std::size_t size = 0;
+            for (std::size_t i = 0; i < Shards; ++i)
+            {
+                std::lock_guard<std::mutex> lock(_shards[i].mutex);
+                size += _shards[i].nodes.size();
+            }
+            return size;
+        }
+
+    private:
+        shard& _shard(std::size_t hash) EGGS_CXX11_NOEXCEPT
+        {
+            return _shards[detail::hash_mix(hash) % Shards];
+        }
+
+        shard const& _shard(std::size_t hash) const EGGS_CXX11_NOEXCEPT
+        {
+            return _shards[detail::hash_mix(hash) % Shards];
+        }
+
+        static node const* _find(
+            shard const& s, Variant const& v, std::size_t hash)
+        {
+            auto const range = s.index.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second->value == v)
+                    return it->second;
+            }
+            return nullptr;
+        }
+
+        template <typename V>
+        handle _intern(V&& v, std::size_t hash)
+        {
+            shard& s = _shard(hash);
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (node const* n = _find(s, v, hash))
+                return handle(n);
+
+            s.nodes.push_back(node{std::forward<V>(v), hash});
+            node const* n = &s.nodes.back();
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+                s.index.emplace(hash, n);
+            } catch (...) {
+                s.nodes.pop_back();
+                throw;
+            }
+#else
+            s.index.emplace(hash, n);
+#endif
+            return handle(n);
+        }
+
+    private:
+        shard _shards[Shards];
+    };
+}}
+
+namespace std
+{
+    //! template <class Variant>
+    //! struct hash<::eggs::variants::interned<Variant>>;
+    //!
+    //! \remarks `std::hash<interned<Variant>>()(h)` evaluates to `h.hash()`,
+    //!  which is computed once when the value is interned.
+    template <typename Variant>
+    struct hash< ::eggs::variants::interned<Variant>>
+    {
+        using argument_type = ::eggs::variants::interned<Variant>;
+        using result_type = std::size_t;
+
+        std::size_t operator()(
+            ::eggs::variants::interned<Variant> const& h) const
+        {
+            return h.hash();
+        }
+    };
+}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_INTERN_POOL_HPP*/
@@ -0,0 +1,413 @@
+//! \file eggs/variant/numeric.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_NUMERIC_HPP
+#define EGGS_VARIANT_NUMERIC_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        template <typename V>
+        struct _numeric_common;
+
+        template <typename ...Ts>
+        struct _numeric_common<variant<Ts...>>
+        {
+            static_assert(
+                sizeof...(Ts) > 0 &&
+                all_of<pack<std::is_arithmetic<Ts>...>>::value,
+                "numeric kernels require every alternative to be arithmetic");
+
+            using type = typename std::common_type<Ts...>::type;
+        };
+
+        template <typename V>
+        struct _numeric_common<V const>
+          : _numeric_common<V>
+        {};
+
+        template <typename RandomIt>
+        using numeric_common = typename _numeric_common<
+            typename std::iterator_traits<RandomIt>::value_type>::type;
+
+        // The elements of a run with internal discriminator `I`, which is
+        // never 0 for the kernels below since empty runs are rejected
+        // before dispatching on the alternative.
+        template <typename Run, std::size_t I>
+        auto _run_at(Run const& run, std::size_t i, index<I>)
+            -> decltype(access::get(run[i], index<I - 1>{}))
+        {
+            return access::get(run[i], index<I - 1>{});
+        }
+
+        template <typename RandomIt>
+        struct _numeric_gather
+        {
+            RandomIt const& block;
+            std::uint16_t const* indices;
+
+            auto operator[](std::size_t i) const -> decltype(block[0])
+            {
+                return block[indices[i]];
+            }
+        };
+
+        template <typename F, typename RandomIt, typename Ctx>
+        struct _numeric_run
+        {
+            // for `for_each_run`
+            template <typename I>
+            static void call(
+                RandomIt const& run, std::size_t count,
+                std::size_t /*offset*/, Ctx& ctx)
+            {
+                _call(run, count, ctx, I{});
+            }
+
+            // for `batch_dispatch`
+            template <typename I>
+            static void call(
+                RandomIt const& block, std::uint16_t const* indices,
+                std::size_t count, std::size_t /*offset*/, Ctx& ctx)
+            {
+                if (indices == nullptr)
+                {
+                    _call(block, count, ctx, I{});
+                } else {
+                    _numeric_gather<RandomIt> const gather = {block, indices};
+                    _call(gather, count, ctx, I{});
+                }
+            }
+
+            template <typename Run>
+            static void _call(
+                Run const& /*run*/, std::size_t /*count*/,
+                Ctx& /*ctx*/, index<0>)
+            {
+                throw_bad_variant_access<void>();
+            }
+
+            template <typename Run, std::size_t I>
+            static void _call(
+                Run const& run, std::size_t count,
+                Ctx& ctx, index<I>)
+            {
+                F::call(run, count, ctx, index<I>{});
+            }
+        };
+
+        // In order, one call per maximal run of a single alternative.
+        template <typename F, typename RandomIt, typename Ctx>
+        void _for_each_numeric_run(RandomIt first, RandomIt last, Ctx& ctx)
+        {
+            detail::for_each_run<_numeric_run<F, RandomIt, Ctx>>(
+                first, last, ctx);
+        }
+
+        // In unspecified order, one call per alternative per block; for the
+        // reductions, which do not care about order, this keeps dispatch
+        // off the hot path even when alternatives are finely mixed.
+        template <typename F, typename RandomIt, typename Ctx>
+        void _for_each_numeric_bucket(RandomIt first, RandomIt last, Ctx& ctx)
+        {
+            detail::batch_dispatch<_numeric_run<F, RandomIt, Ctx>>(
+                first, last, ctx);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        struct _numeric_sum
+        {
+            // four independent accumulators break the dependency chain so
+            // that the loop can be pipelined, and vectorized when the
+            // payloads are laid out contiguously enough
+            template <typename Run, typename R, std::size_t I>
+            static void call(
+                Run const& run, std::size_t count, R& acc, index<I> i)
+            {
+                R a0 = R(), a1 = R(), a2 = R(), a3 = R();
+                std::size_t n = 0;
+                for (; count - n >= 4; n += 4)
+                {
+                    a0 += static_cast<R>(_run_at(run, n + 0, i));
+                    a1 += static_cast<R>(_run_at(run, n + 1, i));
+                    a2 += static_cast<R>(_run_at(run, n + 2, i));
+                    a3 += static_cast<R>(_run_at(run, n + 3, i));
+                }
+                for (; n < count; ++n)
+                    a0 += static_cast<R>(_run_at(run, n, i));
+                acc += (a0 + a1) + (a2 + a3);
+            }
+        };
+
+        template <typename R>
+        struct _numeric_extremum
+        {
+            R value;
+            bool engaged;
+        };
+
+        template <bool Max>
+        struct _numeric_min_max
+        {
+            template <typename T>
+            static bool _better(T const& x, T const& y)
+            {
+                return Max ? y < x : x < y;
+            }
+
+            template <typename Run, typename R, std::size_t I>
+            static void call(
+                Run const& run, std::size_t count,
+                _numeric_extremum<R>& acc, index<I> i)
+            {
+                using type = typename std::decay<
+                    decltype(_run_at(run, 0, i))>::type;
+
+                // the extremum of a run is found in its own type, and only
+                // that one value is converted to the common type
+                type best = _run_at(run, 0, i);
+                for (std::size_t n = 1; n < count; ++n)
+                {
+                    type const x = _run_at(run, n, i);
+                    best = _better(x, best) ? x : best;
+                }
+
+                R const value = static_cast<R>(best);
+                if (!acc.engaged || _better(value, acc.value))
+                {
+                    acc.value = value;
+                    acc.engaged = true;
+                }
+            }
+        };
+
+        template <typename U, typename OutputIt>
+        struct _numeric_convert_to
+        {
+            template <typename RandomIt, std::size_t I>
+            static void call(
+                RandomIt const& run, std::size_t count,
+                OutputIt& out, index<I> i)
+            {
+                for (std::size_t n = 0; n < count; ++n, ++out)
+                    *out = static_cast<U>(_run_at(run, n, i));
+            }
+        };
+
+        template <typename S, typename OutputIt, typename Compare>
+        struct _numeric_compare_ctx
+        {
+            S const& value;
+            OutputIt out;
+            Compare& comp;
+        };
+
+        struct _numeric_compare_to_scalar
+        {
+            template <typename RandomIt, typename S, typename OutputIt,
+                typename Compare, std::size_t I>
+            static void call(
+                RandomIt const& run, std::size_t count,
+                _numeric_compare_ctx<S, OutputIt, Compare>& ctx, index<I> i)
+            {
+                for (std::size_t n = 0; n < count; ++n, ++ctx.out)
+                    *ctx.out = ctx.comp(_run_at(run, n, i), ctx.value);
+            }
+        };
+
+        struct _numeric_less
+        {
+            template <typename T, typename U>
+            bool operator()(T const& x, U const& y) const
+            {
+                return x < y;
+            }
+        };
+    }
+}}
+
+namespace eggs { namespace variants { namespace numeric
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt>
+    //! std::common_type_t<Ts...> sum(RandomIt first, RandomIt last);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>` where every
+    //!  type in `Ts...` is an arithmetic type.
+    //!
+    //! \returns The sum of the active members of the elements in `[first,
+    //!  last)`, each converted to `std::common_type_t<Ts...>`, or a value
+    //!  initialized `std::common_type_t<Ts...>` if the range is empty.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member.
+    //!
+    //! \remarks The range is processed in blocks, each of which is partitioned
+    //!  by alternative, and the elements of each alternative are summed by a
+    //!  loop specialized for their type, with several independent
+    //!  accumulators; there is a single dispatch per alternative per block.
+    //!  For floating point types the order of the additions is unspecified.
+    template <typename RandomIt>
+    detail::numeric_common<RandomIt> sum(RandomIt first, RandomIt last)
+    {
+        using result_type = detail::numeric_common<RandomIt>;
+
+        result_type acc = result_type();
+        detail::_for_each_numeric_bucket<detail::_numeric_sum>(
+            first, last, acc);
+        return acc;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt>
+    //! std::common_type_t<Ts...> min(RandomIt first, RandomIt last);
+    //!
+    //! \requires The same as for `sum(first, last)`. `[first, last)` shall
+    //!  not be empty.
+    //!
+    //! \returns The smallest of the active members of the elements in
+    //!  `[first, last)`, each converted to `std::common_type_t<Ts...>`, as
+    //!  determined by `operator<`.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member.
+    //!
+    //! \remarks The smallest element of each alternative in a block is found
+    //!  by comparing in the type of that alternative, so only one value per
+    //!  alternative per block is converted.
+    template <typename RandomIt>
+    detail::numeric_common<RandomIt> min(RandomIt first, RandomIt last)
+    {
+        using result_type = detail::numeric_common<RandomIt>;
+
+        detail::_numeric_extremum<result_type> acc = {result_type(), false};
+        detail::_for_each_numeric_bucket<detail::_numeric_min_max<false>>(
+            first, last, acc);
+        return acc.value;
+    }
+
+    //! template <class RandomIt>
+    //! std::common_type_t<Ts...> max(RandomIt first, RandomIt last);
+    //!
+    //! \requires The same as for `min(first, last)`.
+    //!
+    //! \returns The largest of the active members of the elements in `[first,
+    //!  last)`, each converted to `std::common_type_t<Ts...>`, as determined
+    //!  by `operator<`.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member.
+    template <typename RandomIt>
+    detail::numeric_common<RandomIt> max(RandomIt first, RandomIt last)
+    {
+        using result_type = detail::numeric_common<RandomIt>;
+
+        detail::_numeric_extremum<result_type> acc = {result_type(), false};
+        detail::_for_each_numeric_bucket<detail::_numeric_min_max<true>>(
+            first, last, acc);
+        return acc.value;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class U, class RandomIt, class OutputIt>
+    //! OutputIt convert_to(RandomIt first, RandomIt last, OutputIt out);
+    //!
+    //! \requires The same as for `sum(first, last)`. `static_cast<U>(x)`
+    //!  shall be a valid expression for every active member `x`, and `*out
+    //!  = static_cast<U>(x)` shall be valid.
+    //!
+    //! \effects Assigns `static_cast<U>(x)` through `out`, incrementing it,
+    //!  for the active member `x` of every element in `[first, last)`, in
+    //!  order.
+    //!
+    //! \returns `out` past the last element written.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, in which case the elements that precede it have been
+    //!  written.
+    template <typename U, typename RandomIt, typename OutputIt>
+    OutputIt convert_to(RandomIt first, RandomIt last, OutputIt out)
+    {
+        (void)sizeof(detail::numeric_common<RandomIt>);
+
+        using kernel = detail::_numeric_convert_to<U, OutputIt>;
+        detail::_for_each_numeric_run<kernel>(first, last, out);
+        return out;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt, class S, class OutputIt, class Compare>
+    //! OutputIt compare_to_scalar(
+    //!     RandomIt first, RandomIt last, S const& value,
+    //!     OutputIt out, Compare comp);
+    //!
+    //! \requires The same as for `sum(first, last)`. `comp(x, value)` shall
+    //!  be a valid expression convertible to `bool` for every active member
+    //!  `x`, and assignable through `out`.
+    //!
+    //! \effects Assigns `comp(x, value)` through `out`, incrementing it, for
+    //!  the active member `x` of every element in `[first, last)`, in
+    //!  order.
+    //!
+    //! \returns `out` past the last element written.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, in which case the elements that precede it have been
+    //!  written.
+    //!
+    //! \remarks `comp` is called with the active member in its own type, so a
+    //!  heterogeneous comparison follows the usual arithmetic conversions
+    //!  for the pair of types involved.
+    template <typename RandomIt, typename S, typename OutputIt,
+        typename Compare>
+    OutputIt compare_to_scalar(
+        RandomIt first, RandomIt last, S const& value,
+        OutputIt out, Compare comp)
+    {
+        (void)sizeof(detail::numeric_common<RandomIt>);
+
+        detail::_numeric_compare_ctx<S, OutputIt, Compare> ctx =
+            {value, out, comp};
+        detail::_for_each_numeric_run<detail::_numeric_compare_to_scalar>(
+            first, last, ctx);
+        return ctx.out;
+    }
+
+    //! template <class RandomIt, class S, class OutputIt>
+    //! OutputIt compare_to_scalar(
+    //!     RandomIt first, RandomIt last, S const& value, OutputIt out);
+    //!
+    //! \effects Equivalent to `compare_to_scalar(first, last, value, out,
+    //!  less)` where `less(x, y)` evaluates `x < y`.
+    template <typename RandomIt, typename S, typename OutputIt>
+    OutputIt compare_to_scalar(
+        RandomIt first, RandomIt last, S const& value, OutputIt out)
+    {
+        return numeric::compare_to_scalar(
+            first, last, value, out, detail::_numeric_less{});
+    }
+}}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_NUMERIC_HPP*/
@@ -0,0 +1,317 @@
+//! \file eggs/variant/parallel.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_PARALLEL_HPP
+#define EGGS_VARIANT_PARALLEL_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/apply_batch.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/thread_pool.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/concurrency.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Splits `[0, size)` of the range at `first` into chunks of at least
+        // `grain` elements. Split points are placed at cache line boundaries
+        // of the underlying storage when the element size allows it, so
+        // that no two chunks write to the same line.
+        template <typename RandomIt>
+        class _parallel_partition
+        {
+            using value_type =
+                typename std::iterator_traits<RandomIt>::value_type;
+
+        public:
+            _parallel_partition(
+                RandomIt first, std::size_t size, std::size_t workers)
+              : _line(1), _phase(0)
+            {
+                if (_cache_line_size % sizeof(value_type) == 0 && size != 0)
+                {
+                    _line = _cache_line_size / sizeof(value_type);
+                    std::uintptr_t const address =
+                        reinterpret_cast<std::uintptr_t>(
+                            std::addressof(*first));
+                    _phase = (address % _cache_line_size) / sizeof(value_type);
+                }
+
+                // a few chunks per worker leave room for stealing to even
+                // out the load, without making chunks too small to amortize
+                std::size_t const chunks = workers * 8;
+                _grain = size / chunks > 1024 ? size / chunks : 1024;
+                _grain = (_grain + _line - 1) / _line * _line;
+            }
+
+            std::size_t grain() const EGGS_CXX11_NOEXCEPT
+            {
+                return _grain;
+            }
+
+            // The split point for `[b, e)`, in `(b, e)`.
+            std::size_t split(std::size_t b, std::size_t e) const
+            {
+                std::size_t mid = b + (e - b) / 2;
+                std::size_t const misalignment = (_phase + mid) % _line;
+                if (mid - b > misalignment)
+                    mid -= misalignment;
+                return mid;
+            }
+
+        private:
+            std::size_t _line;
+            std::size_t _phase;
+            std::size_t _grain;
+        };
+
+        // Calls `body(b, e)` for consecutive chunks `[b, e)` covering
+        // `[b, e)`, splitting recursively so that idle workers steal the
+        // largest halves first.
+        template <typename RandomIt, typename Body>
+        void _parallel_split(
+            task_group& group, _parallel_partition<RandomIt> const& partition,
+            std::size_t b, std::size_t e, Body& body)
+        {
+            while (e - b > partition.grain())
+            {
+                std::size_t const mid = partition.split(b, e);
+                group.run([&group, &partition, mid, e, &body]
+                {
+                    _parallel_split(group, partition, mid, e, body);
+                });
+                e = mid;
+            }
+            body(b, e);
+        }
+
+        template <typename RandomIt, typename Body>
+        void _parallel_chunks(
+            thread_pool& pool, RandomIt first, RandomIt last, Body& body)
+        {
+            std::size_t const size = static_cast<std::size_t>(last - first);
+            if (size == 0)
+                return;
+
+            _parallel_partition<RandomIt> const partition(
+                first, size, pool.size());
+
+            task_group group(pool);
+            group.run([&group, &partition, size, &body]
+            {
+                _parallel_split(group, partition, 0, size, body);
+            });
+            group.wait();
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        template <typename RandomIt, typename F>
+        struct _parallel_apply_body
+        {
+            RandomIt first;
+            F& f;
+
+            void operator()(std::size_t b, std::size_t e) const
+            {
+                apply_batch(unordered, f, first + b, first + e);
+            }
+        };
+
+        template <typename R>
+        struct _parallel_slot
+        {
+            R value;
+
+            // keeps the accumulators of different workers in different
+            // cache lines
+            char padding[_cache_line_size];
+        };
+
+        template <typename R, typename F>
+        struct _reduce_ctx
+        {
+            R* accumulators;
+            F& f;
+        };
+
+        template <typename RandomIt, typename R, typename F>
+        struct _parallel_reduce_batch
+        {
+            using ctx = _reduce_ctx<R, F>;
+
+            template <typename I>
+            static void call(
+                RandomIt const& block, std::uint16_t const* indices,
+                std::size_t count, std::size_t /*offset*/, ctx& c)
+            {
+                _call(block, indices, count, c, I{});
+            }
+
+            static void _call(
+                RandomIt const& /*block*/, std::uint16_t const* /*indices*/,
+                std::size_t /*count*/, ctx& /*c*/, index<0>)
+            {
+                throw_bad_variant_access<void>();
+            }
+
+            template <std::size_t I>
+            static void _call(
+                RandomIt const& block, std::uint16_t const* indices,
+                std::size_t count, ctx& c, index<I>)
+            {
+                R acc = std::move(c.accumulators[I - 1]);
+                if (indices == nullptr)
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                        acc = detail::_invoke(c.f, std::move(acc),
+                            access::get(block[i], index<I - 1>{}));
+                } else {
+                    for (std::size_t i = 0; i < count; ++i)
+                        acc = detail::_invoke(c.f, std::move(acc),
+                            access::get(block[indices[i]], index<I - 1>{}));
+                }
+                c.accumulators[I - 1] = std::move(acc);
+            }
+        };
+
+        template <typename RandomIt, typename R, typename F, typename Combine>
+        struct _parallel_reduce_body
+        {
+            using variant_type =
+                typename std::iterator_traits<RandomIt>::value_type;
+            using batch = _parallel_reduce_batch<RandomIt, R, F>;
+
+            RandomIt first;
+            thread_pool& pool;
+            R const& identity;
+            F& f;
+            Combine& combine;
+            std::vector<_parallel_slot<R>>& slots;
+
+            void operator()(std::size_t b, std::size_t e) const
+            {
+                EGGS_CXX11_CONSTEXPR std::size_t alternatives =
+                    variant_size<variant_type>::value;
+
+                // one accumulator per alternative, so that the loop for
+                // each alternative carries its own dependency chain
+                std::vector<R> accumulators(alternatives, identity);
+                _reduce_ctx<R, F> c = {accumulators.data(), f};
+                batch_dispatch<batch>(first + b, first + e, c);
+
+                // only the calling worker ever touches its slot; the last
+                // slot is for threads outside the pool
+                R& slot = slots[pool.this_worker()].value;
+                for (std::size_t k = 0; k < alternatives; ++k)
+                    slot = detail::_invoke(
+                        combine, std::move(slot), std::move(accumulators[k]));
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt, class F>
+    //! void parallel_apply(thread_pool& pool, RandomIt first, RandomIt last, F&& f);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>`. `INVOKE(f,
+    //!  get<I>(*it))` shall be a valid expression for every iterator `it` in
+    //!  `[first, last)` and every `I` in the range `[0u, sizeof...(Ts))`, and
+    //!  it shall be safe to evaluate concurrently for different elements.
+    //!
+    //! \effects Evaluates `INVOKE(f, get<I>(*it))` exactly once for every `it`
+    //!  in `[first, last)`, where `I` is `it->which()`, on the workers of
+    //!  `pool`, in an unspecified order. Returns when every evaluation has
+    //!  completed.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, or any exception thrown by `f`, in which case `f` may
+    //!  have been invoked on an unspecified subset of the elements.
+    //!
+    //! \remarks The range is split recursively into chunks whose boundaries
+    //!  fall on cache lines, which idle workers steal; each chunk is then
+    //!  processed as with `apply_batch(unordered, f, ...)`.
+    template <typename RandomIt, typename F>
+    void parallel_apply(
+        thread_pool& pool, RandomIt first, RandomIt last, F&& f)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        detail::_parallel_apply_body<RandomIt, fun> body = {first, f};
+        detail::_parallel_chunks(pool, first, last, body);
+    }
+
+    //! template <class RandomIt, class R, class F, class Combine>
+    //! R parallel_reduce(
+    //!     thread_pool& pool, RandomIt first, RandomIt last,
+    //!     R identity, F&& f, Combine&& combine);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>`. `R` shall
+    //!  be `CopyConstructible` and `MoveAssignable`. `INVOKE(f, std::move(r),
+    //!  get<I>(*it))` and `INVOKE(combine, std::move(r), std::move(s))` shall
+    //!  be valid expressions convertible to `R` for all `r` and `s` of type
+    //!  `R`, every iterator `it` in `[first, last)` and every `I` in the range
+    //!  `[0u, sizeof...(Ts))`, and shall be safe to evaluate concurrently.
+    //!  `combine` shall be associative and commutative, and `identity` shall
+    //!  be an identity for it; `f` shall be consistent with `combine`, such
+    //!  that folding a sequence with `f` from `identity` in parts and
+    //!  combining the results gives the same value in any order.
+    //!
+    //! \returns The result of folding every element of `[first, last)` with
+    //!  `f`, starting from `identity`, combining partial results with
+    //!  `combine` as needed.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, or any exception thrown by `f` or `combine`.
+    //!
+    //! \remarks Each chunk keeps one accumulator per alternative, folded by
+    //!  a loop specialized for that alternative, and each worker combines
+    //!  its chunks into an accumulator of its own; the partial results are
+    //!  combined once every chunk has completed. No synchronization takes
+    //!  place while folding.
+    template <typename RandomIt, typename R, typename F, typename Combine>
+    R parallel_reduce(
+        thread_pool& pool, RandomIt first, RandomIt last,
+        R identity, F&& f, Combine&& combine)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        using comb = typename std::remove_reference<Combine>::type;
+
+        std::vector<detail::_parallel_slot<R>> slots(
+            pool.size() + 1, detail::_parallel_slot<R>{identity, {}});
+
+        detail::_parallel_reduce_body<RandomIt, R, fun, comb> body =
+            {first, pool, identity, f, combine, slots};
+        detail::_parallel_chunks(pool, first, last, body);
+
+        R result = std::move(identity);
+        for (detail::_parallel_slot<R>& slot : slots)
+            result = detail::_invoke(
+                combine, std::move(result), std::move(slot.value));
+        return result;
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_PARALLEL_HPP*/
@@ -0,0 +1,237 @@
+//! \file eggs/variant/parallel_tree.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_PARALLEL_TREE_HPP
+#define EGGS_VARIANT_PARALLEL_TREE_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/thread_pool.hpp>
+#include <eggs/variant/detail/apply.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        template <typename R, typename F, typename Evaluator>
+        struct _tree_visit
+        {
+            F& f;
+            Evaluator const& eval;
+
+            template <typename T>
+            R operator()(T&& t) const
+            {
+                return detail::_invoke(f, std::forward<T>(t), eval);
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class R, class F>
+    //! class tree_evaluator;
+    //!
+    //! A `tree_evaluator<R, F>` evaluates trees of variants, whose
+    //! alternatives refer to their child subtrees, by recursively applying
+    //! a visitor `f` of type `F` to every node. The visitor is invoked as
+    //! `INVOKE(f, get<I>(v), eval)`, where `eval` is a `tree_evaluator`, and
+    //! it evaluates the children of the node through `eval(child)` or, when
+    //! they are independent, through `eval.fork(children...)`.
+    //!
+    //! Forking is fork/join parallelism on a `thread_pool`: every child but
+    //! the last is submitted as a task, which idle workers steal, while the
+    //! calling thread evaluates the last child and then helps with the rest.
+    //! Below `cutoff()` levels of forking subtrees are evaluated
+    //! sequentially, as by `eval(child)`, so that small subtrees do not pay
+    //! for task creation.
+    //!
+    //! \remarks The cutoff bounds the depth of forking rather than the size
+    //!  of the subtrees, which would take a traversal to compute; trees that
+    //!  are very unbalanced near the root may want a larger cutoff.
+    template <typename R, typename F>
+    class tree_evaluator
+    {
+    public:
+        using result_type = R;
+
+    public:
+        //! tree_evaluator(thread_pool& pool, F& f) noexcept;
+        //!
+        //! \effects Initializes `*this` to evaluate trees with `f` on the
+        //!  workers of `pool`, with a cutoff of `default_cutoff(pool)`.
+        tree_evaluator(thread_pool& pool, F& f) EGGS_CXX11_NOEXCEPT
+          : _pool(&pool), _f(&f), _depth(0), _cutoff(default_cutoff(pool))
+        {}
+
+        //! tree_evaluator(thread_pool& pool, F& f, std::size_t cutoff) noexcept;
+        //!
+        //! \effects Initializes `*this` to evaluate trees with `f` on the
+        //!  workers of `pool`, forking up to `cutoff` levels deep.
+        tree_evaluator(
+            thread_pool& pool, F& f, std::size_t cutoff) EGGS_CXX11_NOEXCEPT
+          : _pool(&pool), _f(&f), _depth(0), _cutoff(cutoff)
+        {}
+
+        //! template <class V>
+        //! R operator()(V&& v) const;
+        //!
+        //! \requires `std::decay_t<V>` shall be the type `variant<Ts...>`.
+        //!  `INVOKE(f, get<I>(std::forward<V>(v)), *this)` shall be a valid
+        //!  expression convertible to `R` for every `I` in the range `[0u,
+        //!  sizeof...(Ts))`.
+        //!
+        //! \effects Equivalent to `INVOKE(f, get<I>(std::forward<V>(v)),
+        //!  *this)`, where `I` is `v.which()`.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member, or any
+        //!  exception thrown by `f`.
+        template <typename V>
+        R operator()(V&& v) const
+        {
+            detail::_tree_visit<R, F, tree_evaluator> visit = {*_f, *this};
+            return ::eggs::variants::apply<R>(visit, std::forward<V>(v));
+        }
+
+        //! template <class ...Vs>
+        //! std::array<R, sizeof...(Vs)> fork(Vs&&... vs) const;
+        //!
+        //! \requires `(*this)(std::forward<Vs>(vs))` shall be a valid
+        //!  expression for every `vs`, and it shall be safe to evaluate them
+        //!  concurrently. `R` shall be `DefaultConstructible` and
+        //!  `MoveAssignable`.
+        //!
+        //! \returns An array whose `i`-th element is the result of
+        //!  evaluating the `i`-th subtree in `vs...`.
+        //!
+        //! \effects If `depth() < cutoff()`, evaluates the subtrees in
+        //!  parallel with evaluators whose depth is `depth() + 1`, and
+        //!  returns once they have all completed; otherwise, evaluates them
+        //!  in order, as if by `(*this)(std::forward<Vs>(vs))...`.
+        //!
+        //! \throws Any exception thrown by evaluating the subtrees; if more
+        //!  than one throws, which exception is propagated is unspecified.
+        template <typename ...Vs>
+        std::array<R, sizeof...(Vs)> fork(Vs&&... vs) const
+        {
+            if (_depth >= _cutoff || sizeof...(Vs) < 2)
+            {
+                std::array<R, sizeof...(Vs)> results =
+                    {{(*this)(std::forward<Vs>(vs))...}};
+                return results;
+            }
+
+            tree_evaluator child = *this;
+            ++child._depth;
+
+            std::array<R, sizeof...(Vs)> results;
+            task_group group(*_pool);
+            child._fork(group, results.data(), std::forward<Vs>(vs)...);
+            group.wait();
+            return results;
+        }
+
+        //! std::size_t depth() const noexcept;
+        //!
+        //! \returns The number of forks between the root and the subtree
+        //!  being evaluated by `*this`.
+        std::size_t depth() const EGGS_CXX11_NOEXCEPT
+        {
+            return _depth;
+        }
+
+        //! std::size_t cutoff() const noexcept;
+        //!
+        //! \returns The depth from which `fork` evaluates sequentially.
+        std::size_t cutoff() const EGGS_CXX11_NOEXCEPT
+        {
+            return _cutoff;
+        }
+
+        //! static std::size_t default_cutoff(thread_pool const& pool) noexcept;
+        //!
+        //! \returns `0` if `pool.size() == 1`; otherwise, `floor(log2(
+        //!  pool.size())) + 4`, which gives each worker around 16 subtrees
+        //!  to steal from a balanced binary tree.
+        static std::size_t default_cutoff(
+            thread_pool const& pool) EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const workers = pool.size();
+            if (workers < 2)
+                return 0;
+
+            std::size_t levels = 0;
+            for (std::size_t n = workers; n > 1; n /= 2)
+                ++levels;
+            return levels + 4;
+        }
+
+    private:
+        template <typename V>
+        void _fork(task_group& /*group*/, R* results, V&& v) const
+        {
+            *results = (*this)(std::forward<V>(v));
+        }
+
+        template <typename V, typename ...Vs>
+        void _fork(
+            task_group& group, R* results, V&& v, Vs&&... vs) const
+        {
+            tree_evaluator const* self = this;
+            typename std::remove_reference<V>::type* node = std::addressof(v);
+            group.run([self, results, node]
+            {
+                *results = (*self)(std::forward<V>(*node));
+            });
+            _fork(group, results + 1, std::forward<Vs>(vs)...);
+        }
+
+    private:
+        thread_pool* _pool;
+        F* _f;
+        std::size_t _depth;
+        std::size_t _cutoff;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class R, class V, class F>
+    //! R parallel_evaluate(thread_pool& pool, V&& root, F&& f);
+    //!
+    //! \effects Equivalent to `tree_evaluator<R, std::remove_reference_t<F>>(
+    //!  pool, f)(std::forward<V>(root))`.
+    template <typename R, typename V, typename F>
+    R parallel_evaluate(thread_pool& pool, V&& root, F&& f)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        return tree_evaluator<R, fun>(pool, f)(std::forward<V>(root));
+    }
+
+    //! template <class R, class V, class F>
+    //! R parallel_evaluate(
+    //!     thread_pool& pool, V&& root, F&& f, std::size_t cutoff);
+    //!
+    //! \effects Equivalent to `tree_evaluator<R, std::remove_reference_t<F>>(
+    //!  pool, f, cutoff)(std::forward<V>(root))`.
+    template <typename R, typename V, typename F>
+    R parallel_evaluate(
+        thread_pool& pool, V&& root, F&& f, std::size_t cutoff)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        return tree_evaluator<R, fun>(pool, f, cutoff)(std::forward<V>(root));
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_PARALLEL_TREE_HPP*/
@@ -0,0 +1,441 @@
+//! \file eggs/variant/pipeline.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_PIPELINE_HPP
+#define EGGS_VARIANT_PIPELINE_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/detail/apply.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_CXX20_HAS_COROUTINES
+#  include <coroutine>
+#endif
+
+#if EGGS_CXX20_HAS_COROUTINES
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class T>
+    //! class generator;
+    //!
+    //! A `generator<T>` is a lazy input range of `T` lvalues produced by a
+    //! coroutine, one for each `co_yield`. The coroutine starts when the
+    //! range is first iterated, and runs up to its next `co_yield` each time
+    //! the iterator is incremented; a yielded lvalue is passed by reference,
+    //! and a yielded rvalue lives in the coroutine until it is resumed.
+    //!
+    //! Since a coroutine only runs when its consumer asks for the next
+    //! element, `co_yield` is where it awaits downstream capacity: nothing
+    //! is buffered between a generator and its consumer, and no memory is
+    //! allocated per element. The coroutine frame is allocated once, when
+    //! the generator is created.
+    //!
+    //! \remarks A generator is move-only, and shall be iterated at most
+    //!  once. An exception that escapes the coroutine is rethrown from the
+    //!  increment that resumed it. The coroutine shall not use `co_await`.
+    template <typename T>
+    class generator
+    {
+    public:
+        class promise_type
+        {
+        public:
+            generator get_return_object() EGGS_CXX11_NOEXCEPT
+            {
+                return generator(
+                    std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() const EGGS_CXX11_NOEXCEPT
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() const EGGS_CXX11_NOEXCEPT
+            {
+                return {};
+            }
+
+            std::suspend_always yield_value(T& value) EGGS_CXX11_NOEXCEPT
+            {
+                _value = std::addressof(value);
+                return {};
+            }
+
+            // the temporary outlives the suspension, as it is destroyed at
+            // the end of the `co_yield` full-expression
+            std::suspend_always yield_value(T&& value) EGGS_CXX11_NOEXCEPT
+            {
+                _value = std::addressof(value);
+                return {};
+            }
+
+            void return_void() const EGGS_CXX11_NOEXCEPT {}
+
+            void unhandled_exception()
+            {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+                _exception = std::current_exception();
+#else
+                std::terminate();
+#endif
+            }
+
+            // elements are pulled, never awaited
+            template <typename U>
+            std::suspend_never await_transform(U&&) = delete;
+
+        private:
+            friend class generator;
+
+            T* _value = nullptr;
+            std::exception_ptr _exception;
+        };
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+        public:
+            iterator() EGGS_CXX11_NOEXCEPT
+              : _coroutine(nullptr)
+            {}
+
+            reference operator*() const EGGS_CXX11_NOEXCEPT
+            {
+                return *_coroutine.promise()._value;
+            }
+
+            pointer operator->() const EGGS_CXX11_NOEXCEPT
+            {
+                return _coroutine.promise()._value;
+            }
+
+            iterator& operator++()
+            {
+                generator::_resume(_coroutine);
+                return *this;
+            }
+
+            void operator++(int)
+            {
+                ++*this;
+            }
+
+            friend bool operator==(
+                iterator const& it, std::default_sentinel_t) EGGS_CXX11_NOEXCEPT
+            {
+                return !it._coroutine || it._coroutine.done();
+            }
+
+        private:
+            friend class generator;
+
+            explicit iterator(
+                std::coroutine_handle<promise_type> coroutine
+            ) EGGS_CXX11_NOEXCEPT
+              : _coroutine(coroutine)
+            {}
+
+            std::coroutine_handle<promise_type> _coroutine;
+        };
+
+    public:
+        //! generator(generator&& rhs) noexcept;
+        //!
+        //! \effects Takes over the coroutine of `rhs`.
+        generator(generator&& rhs) EGGS_CXX11_NOEXCEPT
+          : _coroutine(std::exchange(rhs._coroutine, nullptr))
+        {}
+
+        //! generator& operator=(generator&& rhs) noexcept;
+        //!
+        //! \effects Destroys the coroutine of `*this`, if any, then takes
+        //!  over the coroutine of `rhs`.
+        generator& operator=(generator&& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            if (this != &rhs)
+            {
+                if (_coroutine)
+                    _coroutine.destroy();
+                _coroutine = std::exchange(rhs._coroutine, nullptr);
+            }
+            return *this;
+        }
+
+        generator(generator const&) = delete;
+        generator& operator=(generator const&) = delete;
+
+        //! ~generator();
+        //!
+        //! \effects Destroys the coroutine, if any, together with the objects
+        //!  in scope at its current suspension point.
+        ~generator()
+        {
+            if (_coroutine)
+                _coroutine.destroy();
+        }
+
+        //! iterator begin();
+        //!
+        //! \effects Runs the coroutine up to its first `co_yield`.
+        //!
+        //! \returns An iterator to the first element, if any.
+        iterator begin()
+        {
+            if (_coroutine)
+                _resume(_coroutine);
+            return iterator(_coroutine);
+        }
+
+        //! std::default_sentinel_t end() const noexcept;
+        std::default_sentinel_t end() const EGGS_CXX11_NOEXCEPT
+        {
+            return {};
+        }
+
+    private:
+        explicit generator(
+            std::coroutine_handle<promise_type> coroutine
+        ) EGGS_CXX11_NOEXCEPT
+          : _coroutine(coroutine)
+        {}
+
+        static void _resume(std::coroutine_handle<promise_type> coroutine)
+        {
+            coroutine.resume();
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            if (coroutine.done() && coroutine.promise()._exception)
+            {
+                std::rethrow_exception(
+                    std::exchange(coroutine.promise()._exception, nullptr));
+            }
+#endif
+        }
+
+    private:
+        std::coroutine_handle<promise_type> _coroutine;
+    };
+
+    namespace detail
+    {
+        // Applies `f` to the active member of `v`, if `f` accepts it; a
+        // result other than `void` replaces the message.
+        template <typename F, typename V>
+        void _stage_transform(F& f, V& v)
+        {
+            ::eggs::variants::apply<void>([&f, &v](auto& member)
+            {
+                using M = decltype(member);
+                if constexpr (std::is_invocable_v<F&, M>)
+                {
+                    if constexpr (std::is_void_v<std::invoke_result_t<F&, M>>)
+                    {
+                        std::invoke(f, member);
+                    } else {
+                        // the result is complete before `member` goes away
+                        V result(std::invoke(f, member));
+                        v = std::move(result);
+                    }
+                }
+            }, v);
+        }
+
+        // Returns whether `f` keeps `v`; messages whose active member `f`
+        // does not accept are kept.
+        template <typename F, typename V>
+        bool _stage_filter(F& f, V& v)
+        {
+            return ::eggs::variants::apply<bool>([&f](auto& member) -> bool
+            {
+                if constexpr (std::is_invocable_v<F&, decltype(member)>)
+                    return static_cast<bool>(std::invoke(f, member));
+                else
+                    return true;
+            }, v);
+        }
+
+        // Applies `f` to the active member of `v`, if `f` accepts it.
+        template <typename F, typename V>
+        void _stage_sink(F& f, V& v)
+        {
+            ::eggs::variants::apply<void>([&f](auto& member)
+            {
+                if constexpr (std::is_invocable_v<F&, decltype(member)>)
+                    std::invoke(f, member);
+            }, v);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class F>
+    //! struct transform_stage_t { F f; };
+    //!
+    //! template <class F>
+    //! struct filter_stage_t { F f; };
+    //!
+    //! template <class F>
+    //! struct sink_t { F f; };
+    //!
+    //! Pipeline stage objects, applied to a `generator<variant<Ts...>>` with
+    //! `operator|`. Each visits the active member of every message with `f`
+    //! through `apply`; an alternative `T` for which `INVOKE(f, t)` is not a
+    //! valid expression, where `t` is a `T&`, is not handled by the stage.
+    //!
+    //! \remarks Implicit conversions count: a function taking an `int` by
+    //!  value handles a `double` alternative as well. Taking parameters by
+    //!  lvalue reference to non-const restricts a stage to exact matches.
+    template <typename F>
+    struct transform_stage_t
+    {
+        F f;
+    };
+
+    template <typename F>
+    struct filter_stage_t
+    {
+        F f;
+    };
+
+    template <typename F>
+    struct sink_t
+    {
+        F f;
+    };
+
+    //! template <class F>
+    //! transform_stage_t<std::decay_t<F>> transform_stage(F&& f);
+    template <typename F>
+    transform_stage_t<std::decay_t<F>> transform_stage(F&& f)
+    {
+        return {std::forward<F>(f)};
+    }
+
+    //! template <class F>
+    //! filter_stage_t<std::decay_t<F>> filter_stage(F&& f);
+    template <typename F>
+    filter_stage_t<std::decay_t<F>> filter_stage(F&& f)
+    {
+        return {std::forward<F>(f)};
+    }
+
+    //! template <class F>
+    //! sink_t<std::decay_t<F>> sink(F&& f);
+    template <typename F>
+    sink_t<std::decay_t<F>> sink(F&& f)
+    {
+        return {std::forward<F>(f)};
+    }
+
+    //! template <class Range>
+    //! generator<range_value_t<Range>> source(Range& r);
+    //!
+    //! \requires The elements of `r` shall be of type `variant<Ts...>`.
+    //!
+    //! \returns A generator that yields each element of `r`, by reference.
+    //!
+    //! \remarks `r` shall outlive the generator.
+    template <typename Range>
+    generator<std::remove_cv_t<
+        std::remove_reference_t<decltype(*std::begin(std::declval<Range&>()))>
+    >> source(Range& r)
+    {
+        for (auto& v : r)
+            co_yield v;
+    }
+
+    //! template <class ...Ts, class F>
+    //! generator<variant<Ts...>> operator|(
+    //!     generator<variant<Ts...>> in, transform_stage_t<F> s);
+    //!
+    //! \effects For each message `m` of `in`, evaluates `INVOKE(s.f, t)`
+    //!  where `t` is the active member of `m`, if the stage handles it. If
+    //!  the result is not `void`, it replaces `m` as if by `m =
+    //!  variant<Ts...>(INVOKE(s.f, t))`. Then yields `m`, by reference.
+    //!
+    //! \returns A generator for the stage.
+    //!
+    //! \throws `bad_variant_access` from an increment, if a message has no
+    //!  active member.
+    template <typename ...Ts, typename F>
+    generator<variant<Ts...>> operator|(
+        generator<variant<Ts...>> in, transform_stage_t<F> s)
+    {
+        for (variant<Ts...>& m : in)
+        {
+            detail::_stage_transform(s.f, m);
+            co_yield m;
+        }
+    }
+
+    //! template <class ...Ts, class F>
+    //! generator<variant<Ts...>> operator|(
+    //!     generator<variant<Ts...>> in, filter_stage_t<F> s);
+    //!
+    //! \effects For each message `m` of `in`, yields `m`, by reference,
+    //!  unless the stage handles its active member `t` and `INVOKE(s.f, t)`
+    //!  converts to `false`.
+    //!
+    //! \returns A generator for the stage.
+    //!
+    //! \throws `bad_variant_access` from an increment, if a message has no
+    //!  active member.
+    template <typename ...Ts, typename F>
+    generator<variant<Ts...>> operator|(
+        generator<variant<Ts...>> in, filter_stage_t<F> s)
+    {
+        for (variant<Ts...>& m : in)
+        {
+            if (detail::_stage_filter(s.f, m))
+                co_yield m;
+        }
+    }
+
+    //! template <class ...Ts, class F>
+    //! std::size_t operator|(generator<variant<Ts...>> in, sink_t<F> s);
+    //!
+    //! \effects Runs the pipeline to completion, evaluating `INVOKE(s.f, t)`
+    //!  for the active member `t` of each message of `in` that the stage
+    //!  handles.
+    //!
+    //! \returns The number of messages that reached the sink.
+    //!
+    //! \throws `bad_variant_access` if a message has no active member, or
+    //!  any exception thrown by `s.f` or by an upstream stage.
+    template <typename ...Ts, typename F>
+    std::size_t operator|(generator<variant<Ts...>> in, sink_t<F> s)
+    {
+        std::size_t count = 0;
+        for (variant<Ts...>& m : in)
+        {
+            detail::_stage_sink(s.f, m);
+            ++count;
+        }
+        return count;
+    }
+}}
+#endif
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_PIPELINE_HPP*/
@@ -0,0 +1,459 @@
+//! \file eggs/variant/rcu_variant.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_RCU_VARIANT_HPP
+#define EGGS_VARIANT_RCU_VARIANT_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/in_place.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // The epoch announced by a thread while it is reading, or `idle`.
+        // Records are padded to a cache line of their own, so that pinning
+        // only ever writes to memory private to the reading thread.
+        struct _rcu_record
+        {
+            static EGGS_CXX11_CONSTEXPR std::uint64_t idle = ~std::uint64_t(0);
+
+            std::atomic<std::uint64_t> epoch;
+            std::atomic<bool> in_use;
+            _rcu_record* next;
+            char padding[64];
+        };
+
+        struct _rcu_retired
+        {
+            std::uint64_t epoch;
+            void* object;
+            void (*destroy)(void*);
+        };
+
+        // The reading threads and the retired objects shared by every
+        // `rcu_variant`. It is never destroyed, so that variants and threads
+        // that outlive static destruction can still use it; records are
+        // recycled when threads exit.
+        class _rcu_domain
+        {
+        public:
+            _rcu_domain() EGGS_CXX11_NOEXCEPT
+              : _epoch(1), _records(nullptr)
+            {}
+
+            static _rcu_domain& instance()
+            {
+                static _rcu_domain* const domain = new _rcu_domain();
+                return *domain;
+            }
+
+            std::uint64_t epoch() const EGGS_CXX11_NOEXCEPT
+            {
+                return _epoch.load(std::memory_order_acquire);
+            }
+
+            _rcu_record* acquire_record()
+            {
+                for (_rcu_record* r = _records.load(std::memory_order_acquire);
+                        r != nullptr; r = r->next)
+                {
+                    bool expected = false;
+                    if (!r->in_use.load(std::memory_order_relaxed)
+                     && r->in_use.compare_exchange_strong(expected, true))
+                        return r;
+                }
+
+                _rcu_record* const r = new _rcu_record();
+                r->epoch.store(_rcu_record::idle, std::memory_order_relaxed);
+                r->in_use.store(true, std::memory_order_relaxed);
+                r->next = _records.load(std::memory_order_relaxed);
+                while (!_records.compare_exchange_weak(r->next, r,
+                        std::memory_order_release, std::memory_order_relaxed))
+                    ;
+                return r;
+            }
+
+            void release_record(_rcu_record* r) EGGS_CXX11_NOEXCEPT
+            {
+                r->epoch.store(_rcu_record::idle, std::memory_order_release);
+                r->in_use.store(false, std::memory_order_release);
+            }
+
+            // Retires `object`, which is no longer reachable by new readers,
+            // and destroys every retired object no reader can still see.
+            void retire(void* object, void (*destroy)(void*))
+            {
+                std::uint64_t const stamp =
+                    _epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _rcu_retired const retired = {stamp, object, destroy};
+                    _retired.push_back(retired);
+                }
+                reclaim();
+            }
+
+            // Destroys the retired objects that were retired before every
+            // reader currently pinned started reading.
+            std::size_t reclaim()
+            {
+                std::uint64_t const oldest = _oldest_reader();
+
+                std::vector<_rcu_retired> ready;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    std::size_t kept = 0;
+                    for (std::size_t i = 0; i < _retired.size(); ++i)
+                    {
+                        if (_retired[i].epoch <= oldest)
+                            ready.push_back(_retired[i]);
+                        else
+                            _retired[kept++] = _retired[i];
+                    }
+                    _retired.resize(kept);
+                }
+
+                for (_rcu_retired const& retired : ready)
+                    retired.destroy(retired.object);
+                return ready.size();
+            }
+
+            // Waits for every reader pinned at the time of the call to unpin,
+            // then reclaims.
+            std::size_t synchronize()
+            {
+                std::uint64_t const target =
+                    _epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+                while (_oldest_reader() < target)
+                    std::this_thread::yield();
+                return reclaim();
+            }
+
+        private:
+            std::uint64_t _oldest_reader() const EGGS_CXX11_NOEXCEPT
+            {
+                // pairs with `_rcu_thread::pin`: either this sees the
+                // announcement of a reader, or that reader sees the new value
+                // published before the retirement
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                std::uint64_t oldest = _rcu_record::idle;
+                for (_rcu_record const* r =
+                        _records.load(std::memory_order_acquire);
+                        r != nullptr; r = r->next)
+                {
+                    std::uint64_t const epoch =
+                        r->epoch.load(std::memory_order_seq_cst);
+                    if (epoch < oldest)
+                        oldest = epoch;
+                }
+                return oldest;
+            }
+
+        private:
+            std::atomic<std::uint64_t> _epoch;
+            std::atomic<_rcu_record*> _records;
+            std::mutex _mutex;
+            std::vector<_rcu_retired> _retired;
+        };
+
+        ///////////////////////////////////////////////////////////////////////
+        class _rcu_thread
+        {
+        public:
+            _rcu_thread()
+              : _record(_rcu_domain::instance().acquire_record())
+              , _nesting(0)
+            {}
+
+            ~_rcu_thread()
+            {
+                _rcu_domain::instance().release_record(_record);
+            }
+
+            _rcu_thread(_rcu_thread const&) = delete;
+            _rcu_thread& operator=(_rcu_thread const&) = delete;
+
+            static _rcu_thread& current()
+            {
+                static thread_local _rcu_thread thread;
+                return thread;
+            }
+
+            void pin() EGGS_CXX11_NOEXCEPT
+            {
+                if (_nesting++ != 0)
+                    return;
+
+                // sequentially consistent, so that it is ordered before the
+                // load of the published pointer; cheaper than a fence on x86
+                _record->epoch.store(
+                    _rcu_domain::instance().epoch(),
+                    std::memory_order_seq_cst);
+            }
+
+            void unpin() EGGS_CXX11_NOEXCEPT
+            {
+                if (--_nesting != 0)
+                    return;
+
+                _record->epoch.store(
+                    _rcu_record::idle, std::memory_order_release);
+            }
+
+        private:
+            _rcu_record* _record;
+            std::size_t _nesting;
+        };
+
+        template <typename T>
+        void _rcu_destroy(void* object)
+        {
+            delete static_cast<T*>(object);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! std::size_t rcu_synchronize();
+    //!
+    //! \requires The calling thread shall not hold an `rcu_variant` read
+    //!  guard.
+    //!
+    //! \effects Waits until every read guard that existed at the time of the
+    //!  call is destroyed, then destroys the values retired by every
+    //!  `rcu_variant` that are no longer visible to any reader.
+    //!
+    //! \returns The number of values destroyed.
+    inline std::size_t rcu_synchronize()
+    {
+        return detail::_rcu_domain::instance().synchronize();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class rcu_variant;
+    //!
+    //! An `rcu_variant<Ts...>` publishes a heap allocated `variant<Ts...>`
+    //! for readers that vastly outnumber writers, with read-copy-update
+    //! semantics: writers never modify a published value, they publish a
+    //! new one and retire the old one, which is destroyed once no reader can
+    //! be referring to it.
+    //!
+    //! Reading goes through a `read_guard`, which pins the calling thread
+    //! by announcing the current epoch in a per-thread record, and gives a
+    //! `variant<Ts...> const&` that stays valid until the guard is
+    //! destroyed. Readers take no locks and do no reference counting; the
+    //! only write is to the cache line of their own record. Writers are
+    //! serialized, and reclaim the retired values whose retirement epoch is
+    //! not after that of any pinned reader.
+    //!
+    //! \remarks Retired values are destroyed by whichever thread reclaims
+    //!  them, during a later write or `rcu_synchronize`. A thread that
+    //!  stays pinned delays reclamation for every `rcu_variant`.
+    template <typename ...Ts>
+    class rcu_variant
+    {
+    public:
+        using value_type = variant<Ts...>;
+
+        //! class read_guard;
+        //!
+        //! A `read_guard` pins the thread that created it, and refers to the
+        //! value published when it was created. Guards can be nested, and
+        //! shall be destroyed by the thread that created them.
+        class read_guard
+        {
+        public:
+            read_guard(read_guard&& other) EGGS_CXX11_NOEXCEPT
+              : _thread(other._thread), _value(other._value)
+            {
+                other._thread = nullptr;
+            }
+
+            read_guard(read_guard const&) = delete;
+            read_guard& operator=(read_guard const&) = delete;
+
+            ~read_guard()
+            {
+                if (_thread != nullptr)
+                    _thread->unpin();
+            }
+
+            //! variant<Ts...> const& get() const noexcept;
+            //!
+            //! \returns A reference to the value published when `*this` was
+            //!  created.
+            value_type const& get() const EGGS_CXX11_NOEXCEPT
+            {
+                return *_value;
+            }
+
+            value_type const& operator*() const EGGS_CXX11_NOEXCEPT
+            {
+                return *_value;
+            }
+
+            value_type const* operator->() const EGGS_CXX11_NOEXCEPT
+            {
+                return _value;
+            }
+
+        private:
+            friend class rcu_variant;
+
+            explicit read_guard(std::atomic<value_type*> const& published)
+              : _thread(&detail::_rcu_thread::current())
+            {
+                _thread->pin();
+                _value = published.load(std::memory_order_seq_cst);
+            }
+
+            detail::_rcu_thread* _thread;
+            value_type const* _value;
+        };
+
+    public:
+        //! rcu_variant();
+        //!
+        //! \effects Publishes a variant with no active member.
+        rcu_variant()
+          : _published(new value_type())
+        {}
+
+        //! explicit rcu_variant(variant<Ts...> v);
+        //!
+        //! \effects Publishes `std::move(v)`.
+        explicit rcu_variant(value_type v)
+          : _published(new value_type(std::move(v)))
+        {}
+
+        rcu_variant(rcu_variant const&) = delete;
+        rcu_variant& operator=(rcu_variant const&) = delete;
+
+        //! ~rcu_variant();
+        //!
+        //! \requires No read guard of `*this` shall exist.
+        //!
+        //! \effects Destroys the published value; values retired earlier
+        //!  are destroyed as they get reclaimed.
+        ~rcu_variant()
+        {
+            delete _published.load(std::memory_order_relaxed);
+        }
+
+        //! read_guard read() const;
+        //!
+        //! \returns A guard referring to the value currently published.
+        read_guard read() const
+        {
+            return read_guard(_published);
+        }
+
+        //! variant<Ts...> load() const;
+        //!
+        //! \returns A copy of the value currently published.
+        value_type load() const
+        {
+            read_guard const guard = read();
+            return *guard;
+        }
+
+        //! void store(variant<Ts...> v);
+        //!
+        //! \effects Publishes `std::move(v)` and retires the value
+        //!  previously published.
+        void store(value_type v)
+        {
+            std::unique_ptr<value_type> next(new value_type(std::move(v)));
+
+            std::lock_guard<std::mutex> lock(_writer);
+            _publish(std::move(next));
+        }
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Publishes a variant constructed from `in_place<I>` or
+        //!  `in_place<T>`, respectively, and `std::forward<Args>(args)...`,
+        //!  and retires the value previously published.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            std::unique_ptr<value_type> next(new value_type(
+                in_place<I>, std::forward<Args>(args)...));
+
+            std::lock_guard<std::mutex> lock(_writer);
+            _publish(std::move(next));
+        }
+
+        template <typename T, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            std::unique_ptr<value_type> next(new value_type(
+                in_place<T>, std::forward<Args>(args)...));
+
+            std::lock_guard<std::mutex> lock(_writer);
+            _publish(std::move(next));
+        }
+
+        //! template <class F>
+        //! void update(F&& f);
+        //!
+        //! \requires `f(v)` shall be a valid expression convertible to
+        //!  `variant<Ts...>` for an lvalue `v` of type `variant<Ts...> const`.
+        //!
+        //! \effects Publishes the result of `f(v)`, where `v` is the
+        //!  value currently published, and retires `v`. Writers are
+        //!  serialized, so no write can happen between reading `v` and
+        //!  publishing the result.
+        template <typename F>
+        void update(F&& f)
+        {
+            std::lock_guard<std::mutex> lock(_writer);
+
+            value_type const& current =
+                *_published.load(std::memory_order_relaxed);
+            std::unique_ptr<value_type> next(
+                new value_type(std::forward<F>(f)(current)));
+            _publish(std::move(next));
+        }
+
+    private:
+        void _publish(std::unique_ptr<value_type> next)
+        {
+            value_type* const previous =
+                _published.exchange(next.release(), std::memory_order_seq_cst);
+            detail::_rcu_domain::instance().retire(
+                previous, &detail::_rcu_destroy<value_type>);
+        }
+
+    private:
+        std::atomic<value_type*> _published;
+        std::mutex _writer;
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_RCU_VARIANT_HPP*/
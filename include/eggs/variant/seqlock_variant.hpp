@@ -0,0 +1,236 @@
+//! \file eggs/variant/seqlock_variant.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_SEQLOCK_VARIANT_HPP
+#define EGGS_VARIANT_SEQLOCK_VARIANT_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/in_place.hpp>
+#include <eggs/variant/detail/concurrency.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/storage.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class seqlock_variant;
+    //!
+    //! A `seqlock_variant<Ts...>` publishes a `variant<Ts...>` from a single
+    //! writer to any number of readers. The writer never waits for readers:
+    //! it bumps a sequence number to odd, overwrites the value and bumps it
+    //! back to even. Readers copy the value out and retry if the sequence
+    //! number was odd or changed meanwhile, which means the copy may be
+    //! torn.
+    //!
+    //! Since every type in `Ts...` is trivially copyable, `variant<Ts...>`
+    //! is trivially copyable as well, and its object representation is
+    //! copied as a whole, in 8 byte words. The words are relaxed atomics,
+    //! so a torn copy is a well defined value that gets discarded.
+    //!
+    //! \requires Every type in `Ts...` shall be trivially copyable.
+    //!
+    //! \remarks Operations that write, `store`, `emplace` and assignment,
+    //!  shall not be called concurrently with each other.
+    template <typename ...Ts>
+    class seqlock_variant
+    {
+        static_assert(
+            detail::all_of<detail::pack<
+                detail::is_trivially_copyable<Ts>...
+            >>::value,
+            "seqlock_variant requires trivially copyable alternatives");
+
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _words =
+            (sizeof(variant<Ts...>) + sizeof(std::uint64_t) - 1)
+          / sizeof(std::uint64_t);
+
+        struct alignas(variant<Ts...>) _buffer
+        {
+            unsigned char bytes[_words * sizeof(std::uint64_t)];
+        };
+
+    public:
+        using value_type = variant<Ts...>;
+
+    public:
+        //! seqlock_variant() noexcept;
+        //!
+        //! \postconditions `load().which() == npos`.
+        seqlock_variant() EGGS_CXX11_NOEXCEPT
+          : _sequence(0)
+        {
+            _write(value_type());
+        }
+
+        //! seqlock_variant(variant<Ts...> const& v) noexcept;
+        //!
+        //! \postconditions `load() == v`.
+        seqlock_variant(value_type const& v) EGGS_CXX11_NOEXCEPT
+          : _sequence(0)
+        {
+            _write(v);
+        }
+
+        seqlock_variant(seqlock_variant const&) = delete;
+        seqlock_variant& operator=(seqlock_variant const&) = delete;
+
+        //! seqlock_variant& operator=(variant<Ts...> const& v) noexcept;
+        //!
+        //! \effects Equivalent to `store(v)`.
+        //!
+        //! \returns `*this`.
+        seqlock_variant& operator=(value_type const& v) EGGS_CXX11_NOEXCEPT
+        {
+            store(v);
+            return *this;
+        }
+
+        //! void store(variant<Ts...> const& v) noexcept;
+        //!
+        //! \effects Publishes `v`. Readers that start after `store` returns
+        //!  observe `v` or a later value.
+        void store(value_type const& v) EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const sequence =
+                _sequence.load(std::memory_order_relaxed);
+            _sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            _write(v);
+
+            _sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `store(variant<Ts...>(in_place<I>,
+        //!  std::forward<Args>(args)...))`.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            store(value_type(in_place<I>, std::forward<Args>(args)...));
+        }
+
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `store(variant<Ts...>(in_place<T>,
+        //!  std::forward<Args>(args)...))`.
+        template <typename T, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            store(value_type(in_place<T>, std::forward<Args>(args)...));
+        }
+
+        //! bool try_load(variant<Ts...>& v) const noexcept;
+        //!
+        //! \effects Makes a single attempt at copying out the published
+        //!  value. If the copy is consistent, assigns it to `v`; otherwise,
+        //!  `v` is left unchanged.
+        //!
+        //! \returns `true` if `v` was assigned.
+        bool try_load(value_type& v) const EGGS_CXX11_NOEXCEPT
+        {
+            _buffer buffer;
+            if (!_try_read(buffer))
+                return false;
+
+            std::memcpy(static_cast<void*>(&v), &buffer, sizeof(value_type));
+            return true;
+        }
+
+        //! variant<Ts...> load() const noexcept;
+        //!
+        //! \returns The published value.
+        //!
+        //! \remarks Retries while a write is in progress, so it does not
+        //!  return until a copy is made that no write overlaps.
+        value_type load() const EGGS_CXX11_NOEXCEPT
+        {
+            _buffer buffer;
+            while (!_try_read(buffer))
+                detail::_spin_pause();
+
+            // `value_type` is trivially copyable, so its value can be taken
+            // from the bytes; this saves initializing a variant to overwrite
+            return *reinterpret_cast<value_type const*>(buffer.bytes);
+        }
+
+        //! operator variant<Ts...>() const noexcept;
+        //!
+        //! \returns `load()`.
+        operator value_type() const EGGS_CXX11_NOEXCEPT
+        {
+            return load();
+        }
+
+        //! std::size_t version() const noexcept;
+        //!
+        //! \returns The number of values published by `*this`, including the
+        //!  initial one. Readers can compare versions to detect whether the
+        //!  value has changed without copying it out.
+        std::size_t version() const EGGS_CXX11_NOEXCEPT
+        {
+            return _sequence.load(std::memory_order_acquire) / 2 + 1;
+        }
+
+    private:
+        bool _try_read(_buffer& buffer) const EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const sequence =
+                _sequence.load(std::memory_order_acquire);
+            if (sequence % 2 != 0)
+                return false;
+
+            for (std::size_t i = 0; i < _words; ++i)
+            {
+                std::uint64_t const word =
+                    _data[i].load(std::memory_order_relaxed);
+                std::memcpy(
+                    buffer.bytes + i * sizeof(word), &word, sizeof(word));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return _sequence.load(std::memory_order_relaxed) == sequence;
+        }
+
+        void _write(value_type const& v) EGGS_CXX11_NOEXCEPT
+        {
+            _buffer buffer;
+            std::memset(
+                buffer.bytes + sizeof(v), 0, sizeof(buffer) - sizeof(v));
+            std::memcpy(&buffer, static_cast<void const*>(&v), sizeof(v));
+            for (std::size_t i = 0; i < _words; ++i)
+            {
+                std::uint64_t word;
+                std::memcpy(
+                    &word, buffer.bytes + i * sizeof(word), sizeof(word));
+                _data[i].store(word, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        std::atomic<std::size_t> _sequence;
+        std::atomic<std::uint64_t> _data[_words];
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_SEQLOCK_VARIANT_HPP*/
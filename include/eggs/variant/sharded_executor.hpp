@@ -0,0 +1,487 @@
+//! \file eggs/variant/sharded_executor.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_SHARDED_EXECUTOR_HPP
+#define EGGS_VARIANT_SHARDED_EXECUTOR_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/variant_queue.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/bits.hpp>
+#include <eggs/variant/detail/concurrency.hpp>
+#include <eggs/variant/detail/futex.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_LINUX_HAS_THREAD_AFFINITY
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        // Pins the calling thread to the `cpu`-th processor, modulo their
+        // number; failure is not an error, as the thread merely loses its
+        // affinity.
+        inline void _pin_this_thread(std::size_t cpu) EGGS_CXX11_NOEXCEPT
+        {
+#if EGGS_LINUX_HAS_THREAD_AFFINITY
+            std::size_t const cpus = std::thread::hardware_concurrency();
+            if (cpus == 0)
+                return;
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu % cpus, &set);
+            ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+            (void)cpu;
+#endif
+        }
+
+        // Invokes the handler of a shard, keeping the first exception it
+        // throws so that a failing message does not stop the others.
+        template <typename F>
+        struct _shard_visit
+        {
+            F& f;
+            std::exception_ptr& error;
+
+            template <typename T>
+            void operator()(T&& t) const
+            {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+                try
+                {
+                    detail::_invoke(f, std::forward<T>(t));
+                } catch (...) {
+                    if (!error)
+                        error = std::current_exception();
+                }
+#else
+                detail::_invoke(f, std::forward<T>(t));
+#endif
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Variant, class F>
+    //! class sharded_executor;
+    //!
+    //! \requires `Variant` shall be the type `variant<Ts...>`.
+    template <typename Variant, typename F>
+    class sharded_executor;
+
+    //! template <class ...Ts, class F>
+    //! class sharded_executor<variant<Ts...>, F>;
+    //!
+    //! A `sharded_executor<variant<Ts...>, F>` processes a stream of
+    //! messages of type `variant<Ts...>` on a fixed set of shards, each made
+    //! of a worker thread pinned to a processor, a `spsc_queue<Ts...>` and a
+    //! handler of type `F` of its own. Messages are routed to shards by their
+    //! alternative, or by their alternative and a user key, so that every
+    //! message of an alternative, or of an alternative and key, is handled
+    //! on the same processor by the same handler, in the order submitted;
+    //! handler code and state then stay in that processor's caches.
+    //!
+    //! When the queue of a shard is full, submitting to it waits for the
+    //! worker to catch up, which propagates backpressure to the submitter.
+    //! Idle workers spin briefly, then sleep until a message arrives.
+    //!
+    //! \requires `F` shall be `CopyConstructible`, and `INVOKE(f, get<I>(
+    //!  std::move(m)))` shall be a valid expression for every `I` in the
+    //!  range `[0u, sizeof...(Ts))`, where `f` is an lvalue of type `F` and
+    //!  `m` a message.
+    //!
+    //! \remarks Submitting operations, `submit`, `try_submit`, `submit_to`,
+    //!  `emplace` and `flush`, shall not be called concurrently with each
+    //!  other.
+    template <typename ...Ts, typename F>
+    class sharded_executor<variant<Ts...>, F>
+    {
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _batch = 64;
+
+        struct _shard
+        {
+            explicit _shard(F const& f, std::size_t capacity)
+              : queue(capacity), submitted(0)
+              , processed(0), handler(f)
+              , sleeping(false), signal(0)
+            {}
+
+            spsc_queue<Ts...> queue;
+
+            // written by the submitter
+            std::size_t submitted;
+            char padding0[detail::_cache_line_size];
+
+            // written by the worker
+            std::atomic<std::size_t> processed;
+            F handler;
+            std::exception_ptr error;
+            char padding1[detail::_cache_line_size];
+
+            // written when the worker goes to sleep or is woken up
+            std::atomic<bool> sleeping;
+            std::atomic<std::uint32_t> signal;
+            char padding2[detail::_cache_line_size];
+        };
+
+    public:
+        using value_type = variant<Ts...>;
+
+    public:
+        //! sharded_executor(F const& f, std::size_t shards, std::size_t capacity = 1024);
+        //!
+        //! \effects Starts `max(shards, 1)` worker threads, the `i`-th pinned
+        //!  to the `i`-th processor where supported, each with a copy of `f`
+        //!  and a queue that holds up to `capacity` messages, rounded up to
+        //!  a power of 2.
+        //!
+        //! \throws `std::system_error` if a thread could not be started, or
+        //!  any exception thrown by the copy constructor of `F`.
+        sharded_executor(
+            F const& f, std::size_t shards, std::size_t capacity = 1024)
+          : _stop(false)
+        {
+            shards = shards != 0 ? shards : 1;
+
+            _shards.reserve(shards);
+            for (std::size_t i = 0; i < shards; ++i)
+                _shards.emplace_back(new _shard(f, capacity));
+
+            _threads.reserve(shards);
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+                for (std::size_t i = 0; i < shards; ++i)
+                    _threads.emplace_back(&sharded_executor::_work, this, i);
+            } catch (...) {
+                _shutdown();
+                throw;
+            }
+#else
+            for (std::size_t i = 0; i < shards; ++i)
+                _threads.emplace_back(&sharded_executor::_work, this, i);
+#endif
+        }
+
+        sharded_executor(sharded_executor const&) = delete;
+        sharded_executor& operator=(sharded_executor const&) = delete;
+
+        //! ~sharded_executor();
+        //!
+        //! \effects Waits for every submitted message to be handled, then
+        //!  joins every worker thread. Exceptions thrown by handlers and not
+        //!  yet propagated by `flush` are discarded.
+        ~sharded_executor()
+        {
+            _shutdown();
+        }
+
+        //! template <class V>
+        //! void submit(V&& v);
+        //!
+        //! \requires `std::decay_t<V>` shall be the type `variant<Ts...>`.
+        //!
+        //! \effects Equivalent to `submit_to(shard_of(v.which()),
+        //!  std::forward<V>(v))`.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        template <typename V>
+        void submit(V&& v)
+        {
+            submit_to(shard_of(_which(v)), std::forward<V>(v));
+        }
+
+        //! template <class V>
+        //! void submit(V&& v, std::size_t key);
+        //!
+        //! \effects Equivalent to `submit_to(shard_of(v.which(), key),
+        //!  std::forward<V>(v))`.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        template <typename V>
+        void submit(V&& v, std::size_t key)
+        {
+            submit_to(shard_of(_which(v), key), std::forward<V>(v));
+        }
+
+        //! template <class V>
+        //! bool try_submit(V&& v);
+        //!
+        //! \effects If the queue of the shard `shard_of(v.which())` is not
+        //!  full, enqueues `std::forward<V>(v)` to it.
+        //!
+        //! \returns `true` if the message was enqueued.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        template <typename V>
+        bool try_submit(V&& v)
+        {
+            return _try_submit(
+                *_shards[shard_of(_which(v))], std::forward<V>(v));
+        }
+
+        //! template <class V>
+        //! bool try_submit(V&& v, std::size_t key);
+        //!
+        //! \effects If the queue of the shard `shard_of(v.which(), key)` is
+        //!  not full, enqueues `std::forward<V>(v)` to it.
+        //!
+        //! \returns `true` if the message was enqueued.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        template <typename V>
+        bool try_submit(V&& v, std::size_t key)
+        {
+            return _try_submit(
+                *_shards[shard_of(_which(v), key)], std::forward<V>(v));
+        }
+
+        //! template <class V>
+        //! void submit_to(std::size_t shard, V&& v);
+        //!
+        //! \requires `shard < shards()`, and `v` shall have an active member.
+        //!
+        //! \effects Enqueues `std::forward<V>(v)` to the queue of the shard
+        //!  `shard`, waiting while it is full.
+        template <typename V>
+        void submit_to(std::size_t shard, V&& v)
+        {
+            // `v` is only moved from once it has been enqueued
+            _shard& s = *_shards[shard];
+            for (std::size_t spins = 0;
+                    !_try_submit(s, std::forward<V>(v)); ++spins)
+                _backoff(spins);
+        }
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \requires `I < sizeof...(Ts)`.
+        //!
+        //! \effects Constructs a message whose active member is the `I`th
+        //!  element of `Ts...` directly in the queue of the shard
+        //!  `shard_of(I)`, as if by `emplace<I>(std::forward<Args>(
+        //!  args)...)`, waiting while it is full.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            _shard& s = *_shards[shard_of(I)];
+            for (std::size_t spins = 0;
+                    !s.queue.template try_emplace<I>(
+                        std::forward<Args>(args)...); ++spins)
+                _backoff(spins);
+            _published(s);
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Equivalent to `emplace<I>(std::forward<Args>(args)...)`
+        //!  where `I` is the zero-based index of `T` in `Ts...`.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        void emplace(Args&&... args)
+        {
+            emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! void flush();
+        //!
+        //! \effects Blocks until every message submitted so far has been
+        //!  handled.
+        //!
+        //! \throws The first exception thrown by a handler since the last
+        //!  call to `flush`, if any; the remaining messages are handled
+        //!  nevertheless.
+        void flush()
+        {
+            for (std::unique_ptr<_shard> const& s : _shards)
+            {
+                for (std::size_t spins = 0;
+                        s->processed.load(std::memory_order_acquire)
+                     != s->submitted; ++spins)
+                    _backoff(spins);
+            }
+
+            for (std::unique_ptr<_shard> const& s : _shards)
+            {
+                if (s->error)
+                {
+                    std::exception_ptr error = std::move(s->error);
+                    s->error = nullptr;
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        //! std::size_t shards() const noexcept;
+        //!
+        //! \returns The number of shards.
+        std::size_t shards() const EGGS_CXX11_NOEXCEPT
+        {
+            return _shards.size();
+        }
+
+        //! std::size_t shard_of(std::size_t which) const noexcept;
+        //!
+        //! \returns `which % shards()`, the shard that handles the messages
+        //!  whose active member is the `which`-th alternative.
+        std::size_t shard_of(std::size_t which) const EGGS_CXX11_NOEXCEPT
+        {
+            return which % _shards.size();
+        }
+
+        //! std::size_t shard_of(std::size_t which, std::size_t key) const noexcept;
+        //!
+        //! \returns The shard that handles the messages whose active member
+        //!  is the `which`-th alternative and whose key is `key`, given by a
+        //!  hash of both.
+        std::size_t shard_of(
+            std::size_t which, std::size_t key) const EGGS_CXX11_NOEXCEPT
+        {
+            return detail::hash_mix(key * sizeof...(Ts) + which)
+              % _shards.size();
+        }
+
+        //! F const& handler(std::size_t shard) const noexcept;
+        //!
+        //! \requires `shard < shards()`. No message shall have been submitted
+        //!  since the last call to `flush`.
+        //!
+        //! \returns The handler of the shard `shard`.
+        F const& handler(std::size_t shard) const EGGS_CXX11_NOEXCEPT
+        {
+            return _shards[shard]->handler;
+        }
+
+    private:
+        template <typename V>
+        static std::size_t _which(V const& v)
+        {
+            std::size_t const which = v.which();
+            if (which == value_type::npos)
+                detail::throw_bad_variant_access<void>();
+            return which;
+        }
+
+        template <typename V>
+        bool _try_submit(_shard& s, V&& v)
+        {
+            if (!s.queue.try_push(std::forward<V>(v)))
+                return false;
+
+            _published(s);
+            return true;
+        }
+
+        void _published(_shard& s)
+        {
+            ++s.submitted;
+
+            // the worker sets `sleeping` before checking its queue, and the
+            // submitter checks `sleeping` after publishing to it; the
+            // fences make sure one of them sees the other
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (s.sleeping.load(std::memory_order_relaxed))
+                _wake(s);
+        }
+
+        static void _wake(_shard& s)
+        {
+            s.signal.fetch_add(1, std::memory_order_release);
+            detail::_futex_wake_all(s.signal);
+        }
+
+        static void _backoff(std::size_t spins) EGGS_CXX11_NOEXCEPT
+        {
+            if (spins < 64)
+                detail::_spin_pause();
+            else
+                std::this_thread::yield();
+        }
+
+        void _work(std::size_t index)
+        {
+            _shard& s = *_shards[index];
+            detail::_pin_this_thread(index);
+
+            detail::_shard_visit<F> visit = {s.handler, s.error};
+            for (std::size_t idle = 0;;)
+            {
+                std::size_t const count = s.queue.consume(visit, _batch);
+                if (count != 0)
+                {
+                    s.processed.store(
+                        s.processed.load(std::memory_order_relaxed) + count,
+                        std::memory_order_release);
+                    idle = 0;
+                } else if (_stop.load(std::memory_order_acquire)) {
+                    if (s.queue.empty())
+                        return;
+                } else if (++idle < 128) {
+                    _backoff(idle);
+                } else {
+                    _sleep(s);
+                }
+            }
+        }
+
+        void _sleep(_shard& s)
+        {
+            std::uint32_t const signal =
+                s.signal.load(std::memory_order_acquire);
+            s.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (s.queue.empty() && !_stop.load(std::memory_order_relaxed))
+                detail::_futex_wait(s.signal, signal);
+            s.sleeping.store(false, std::memory_order_relaxed);
+        }
+
+        void _shutdown() EGGS_CXX11_NOEXCEPT
+        {
+            _stop.store(true, std::memory_order_seq_cst);
+            for (std::unique_ptr<_shard> const& s : _shards)
+                _wake(*s);
+            for (std::thread& thread : _threads)
+                thread.join();
+        }
+
+    private:
+        std::vector<std::unique_ptr<_shard>> _shards;
+        std::vector<std::thread> _threads;
+        std::atomic<bool> _stop;
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_SHARDED_EXECUTOR_HPP*/
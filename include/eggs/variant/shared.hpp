@@ -0,0 +1,305 @@
+//! \file eggs/variant/shared.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_SHARED_HPP
+#define EGGS_VARIANT_SHARED_HPP
+
+#include <eggs/variant/in_place.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        template <typename T>
+        struct _shared_block
+        {
+            template <typename ...Args>
+            explicit _shared_block(Args&&... args)
+              : refs(1)
+              , value(std::forward<Args>(args)...)
+            {}
+
+            std::atomic<std::size_t> refs;
+            T value;
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class T>
+    //! class shared;
+    //!
+    //! A `shared<T>` holds a value of type `T` in a heap allocated block along
+    //! with an intrusive reference count. Copies of a `shared<T>` refer to the
+    //! same block, so copying costs O(1) regardless of the size of the value;
+    //! as a `variant` alternative it makes `copy_construct` and `copy_assign`
+    //! on large payloads cheap. Access through `get` is always read-only;
+    //! `mutate` copies the value into a fresh block first if the block is
+    //! shared (copy-on-write).
+    //!
+    //! Moving a `shared<T>` shares the block as copying does, so that a
+    //! moved-from `shared<T>` still holds its value; a `variant` moved-from
+    //! while holding a `shared<T>` can still be compared, hashed and read.
+    //!
+    //! \requires `T` shall be `CopyConstructible`.
+    template <typename T>
+    class shared
+    {
+        using block = detail::_shared_block<T>;
+
+    public:
+        using element_type = T;
+
+    public:
+        //! shared();
+        //!
+        //! \effects Initializes the contained value as if value-initializing
+        //!  an object of type `T` with the expression `T()`.
+        shared()
+          : _block(new block())
+        {}
+
+        //! shared(T const& v);
+        //!
+        //! \effects Initializes the contained value as if direct-
+        //!  non-list-initializing an object of type `T` with the expression
+        //!  `v`.
+        shared(T const& v)
+          : _block(new block(v))
+        {}
+
+        //! shared(T&& v);
+        //!
+        //! \effects Initializes the contained value as if direct-
+        //!  non-list-initializing an object of type `T` with the expression
+        //!  `std::move(v)`.
+        shared(T&& v)
+          : _block(new block(std::move(v)))
+        {}
+
+        //! template <class ...Args>
+        //! explicit shared(in_place_t(*)(unspecified<T>), Args&&... args);
+        //!
+        //! \effects Initializes the contained value as if direct-
+        //!  non-list-initializing an object of type `T` with the arguments
+        //!  `std::forward<Args>(args)...`.
+        template <typename ...Args>
+        explicit shared(
+            in_place_t(*)(detail::pack<T>), Args&&... args)
+          : _block(new block(std::forward<Args>(args)...))
+        {}
+
+        //! shared(shared const& rhs) noexcept;
+        //!
+        //! \effects Shares the block of `rhs`.
+        shared(shared const& rhs) EGGS_CXX11_NOEXCEPT
+          : _block(rhs._block)
+        {
+            _block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        //! shared(shared&& rhs) noexcept;
+        //!
+        //! \effects Shares the block of `rhs`.
+        //!
+        //! \postconditions `rhs` is unchanged.
+        shared(shared&& rhs) EGGS_CXX11_NOEXCEPT
+          : shared(static_cast<shared const&>(rhs))
+        {}
+
+        //! ~shared();
+        //!
+        //! \effects Releases the block held by `*this`, destroying the
+        //!  contained value when this was its last reference.
+        ~shared()
+        {
+            _release(_block);
+        }
+
+        //! shared& operator=(shared const& rhs) noexcept;
+        //!
+        //! \effects Releases the block held by `*this` and shares the block of
+        //!  `rhs`.
+        //!
+        //! \returns `*this`.
+        shared& operator=(shared const& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            shared(rhs).swap(*this);
+            return *this;
+        }
+
+        //! shared& operator=(shared&& rhs) noexcept;
+        //!
+        //! \effects Releases the block held by `*this` and shares the block of
+        //!  `rhs`.
+        //!
+        //! \returns `*this`.
+        shared& operator=(shared&& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            shared(static_cast<shared const&>(rhs)).swap(*this);
+            return *this;
+        }
+
+        //! void swap(shared& rhs) noexcept;
+        //!
+        //! \effects Exchanges the blocks of `*this` and `rhs`.
+        void swap(shared& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            std::swap(_block, rhs._block);
+        }
+
+        //! T const& get() const noexcept;
+        //!
+        //! \returns A reference to the contained value.
+        T const& get() const EGGS_CXX11_NOEXCEPT
+        {
+            return _block->value;
+        }
+
+        T const& operator*() const EGGS_CXX11_NOEXCEPT
+        {
+            return _block->value;
+        }
+
+        T const* operator->() const EGGS_CXX11_NOEXCEPT
+        {
+            return &_block->value;
+        }
+
+        //! T& mutate();
+        //!
+        //! \effects If `unique()` is `false`, copies the contained value into
+        //!  a new block and releases the shared one.
+        //!
+        //! \returns A reference to the contained value.
+        //!
+        //! \postconditions `unique() == true`.
+        //!
+        //! \throws Any exception thrown by the selected constructor of `T`, or
+        //!  `std::bad_alloc`. If an exception is thrown, `*this` still shares
+        //!  its original block.
+        T& mutate()
+        {
+            if (!unique())
+            {
+                block* const copy = new block(
+                    static_cast<T const&>(_block->value));
+                _release(_block);
+                _block = copy;
+            }
+            return _block->value;
+        }
+
+        //! bool unique() const noexcept;
+        //!
+        //! \returns `true` if `*this` holds the only reference to its block.
+        bool unique() const EGGS_CXX11_NOEXCEPT
+        {
+            return _block->refs.load(std::memory_order_acquire) == 1;
+        }
+
+        //! std::size_t use_count() const noexcept;
+        //!
+        //! \returns The number of `shared` objects that refer to the block of
+        //!  `*this`.
+        std::size_t use_count() const EGGS_CXX11_NOEXCEPT
+        {
+            return _block->refs.load(std::memory_order_relaxed);
+        }
+
+        //! friend bool operator==(shared const& lhs, shared const& rhs);
+        //!
+        //! \returns `true` if `lhs` and `rhs` share the same block; otherwise,
+        //!  `lhs.get() == rhs.get()`.
+        friend bool operator==(shared const& lhs, shared const& rhs)
+        {
+            return lhs._block == rhs._block || lhs.get() == rhs.get();
+        }
+
+        friend bool operator!=(shared const& lhs, shared const& rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+        //! friend bool operator<(shared const& lhs, shared const& rhs);
+        //!
+        //! \returns `lhs.get() < rhs.get()`.
+        friend bool operator<(shared const& lhs, shared const& rhs)
+        {
+            return lhs._block != rhs._block && lhs.get() < rhs.get();
+        }
+
+        friend bool operator>(shared const& lhs, shared const& rhs)
+        {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(shared const& lhs, shared const& rhs)
+        {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(shared const& lhs, shared const& rhs)
+        {
+            return !(lhs < rhs);
+        }
+
+    private:
+        static void _release(block* b) EGGS_CXX11_NOEXCEPT
+        {
+            if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete b;
+        }
+
+        block* _block;
+    };
+
+    //! template <class T>
+    //! void swap(shared<T>& x, shared<T>& y) noexcept;
+    //!
+    //! \effects Calls `x.swap(y)`.
+    template <typename T>
+    void swap(shared<T>& x, shared<T>& y) EGGS_CXX11_NOEXCEPT
+    {
+        x.swap(y);
+    }
+}}
+
+namespace std
+{
+    //! template <class T>
+    //! struct hash<::eggs::variants::shared<T>>;
+    //!
+    //! \requires The template specialization `std::hash<T>` shall meet the
+    //!  requirements of class template `std::hash`.
+    //!
+    //! \remarks `std::hash<shared<T>>()(s)` evaluates to the same value as
+    //!  `std::hash<T>()(s.get())`.
+    template <typename T>
+    struct hash< ::eggs::variants::shared<T>>
+    {
+        using argument_type = ::eggs::variants::shared<T>;
+        using result_type = std::size_t;
+
+        std::size_t operator()(::eggs::variants::shared<T> const& s) const
+        {
+            return std::hash<T>{}(s.get());
+        }
+    };
+}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_SHARED_HPP*/
@@ -0,0 +1,810 @@
+//! \file eggs/variant/shm_channel.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_SHM_CHANNEL_HPP
+#define EGGS_VARIANT_SHM_CHANNEL_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/variant_queue.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/concurrency.hpp>
+#include <eggs/variant/detail/futex.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/storage.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_CXX98_HAS_RTTI
+#  include <typeinfo>
+#endif
+
+#if EGGS_POSIX_HAS_SHARED_MEMORY
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#if EGGS_POSIX_HAS_SHARED_MEMORY
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+#if ATOMIC_INT_LOCK_FREE != 2
+#  error "shm_channel requires lock-free 32 bit atomics"
+#endif
+
+        EGGS_CXX11_CONSTEXPR std::uint32_t const _shm_magic =
+            0x45675631u; // "EgV1"
+        EGGS_CXX11_CONSTEXPR std::uint32_t const _shm_version = 1;
+
+        ///////////////////////////////////////////////////////////////////////
+        // FNV-1a over the sizes, alignments, and (when available) names of
+        // the alternatives; two processes agree on it only if they agree on
+        // the layout of every message.
+        inline std::uint64_t _shm_hash(
+            std::uint64_t h, void const* data, std::size_t size)
+        {
+            unsigned char const* bytes =
+                static_cast<unsigned char const*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                h ^= bytes[i];
+                h *= 0x100000001b3ull;
+            }
+            return h;
+        }
+
+        inline std::uint64_t _shm_hash(std::uint64_t h, std::uint64_t value)
+        {
+            return _shm_hash(h, &value, sizeof(value));
+        }
+
+        template <typename T>
+        std::uint64_t _shm_fingerprint_of(std::uint64_t h)
+        {
+            h = _shm_hash(h, sizeof(T));
+            h = _shm_hash(h, alignof(T));
+#if EGGS_CXX98_HAS_RTTI
+            char const* const name = typeid(T).name();
+            h = _shm_hash(h, name, std::strlen(name));
+#endif
+            return h;
+        }
+
+        template <typename ...Ts>
+        std::uint64_t _shm_fingerprint()
+        {
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            h = _shm_hash(h, sizeof...(Ts));
+            h = _shm_hash(h, sizeof(variant<Ts...>));
+            h = _shm_hash(h, alignof(variant<Ts...>));
+            int const expand[] = {0, (h = _shm_fingerprint_of<Ts>(h), 0)...};
+            (void)expand;
+            return h;
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // The header at the start of the shared region. `magic` is written
+        // last by the creator, so an attached process that sees it sees the
+        // rest of the header as well.
+        struct _shm_header
+        {
+            std::atomic<std::uint32_t> magic;
+            std::uint32_t version;
+            std::uint64_t fingerprint;
+            std::uint64_t slots_offset;
+            std::uint32_t slot_size;
+            std::uint32_t capacity;
+            char _padding0[detail::_cache_line_size];
+
+            // written by the sender
+            std::atomic<std::uint32_t> tail;
+            std::atomic<std::uint32_t> sender_waiting;
+            char _padding1[detail::_cache_line_size];
+
+            // written by the receiver
+            std::atomic<std::uint32_t> head;
+            std::atomic<std::uint32_t> receiver_waiting;
+            char _padding2[detail::_cache_line_size];
+        };
+
+        EGGS_CXX11_NORETURN inline void _throw_shm_error(char const* what)
+        {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            throw std::system_error(errno, std::system_category(), what);
+#else
+            (void)what;
+            std::terminate();
+#endif
+        }
+
+        EGGS_CXX11_NORETURN inline void _throw_shm_mismatch(char const* what)
+        {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            throw std::runtime_error(what);
+#else
+            (void)what;
+            std::terminate();
+#endif
+        }
+
+        // Creates and maps a new shared memory object of `length` bytes;
+        // the object is removed again if it cannot be mapped.
+        inline void* _shm_create(char const* name, std::size_t length)
+        {
+            int const fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd == -1)
+                _throw_shm_error("shm_open");
+
+            void* base = MAP_FAILED;
+            if (::ftruncate(fd, static_cast<::off_t>(length)) == 0)
+            {
+                base = ::mmap(nullptr, length,
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            if (base == MAP_FAILED)
+            {
+                int const error = errno;
+                ::close(fd);
+                ::shm_unlink(name);
+                errno = error;
+                _throw_shm_error("shm_channel::create");
+            }
+            ::close(fd);
+            return base;
+        }
+
+        // Maps an existing shared memory object as a whole, storing its
+        // size in `length`. An object is empty between its creation and its
+        // sizing, so an empty object is given up to a second to grow.
+        inline void* _shm_open(char const* name, std::size_t& length)
+        {
+            int const fd = ::shm_open(name, O_RDWR, 0);
+            if (fd == -1)
+                _throw_shm_error("shm_open");
+
+            struct ::stat st;
+            int result;
+            for (int i = 0; (result = ::fstat(fd, &st)) == 0
+                 && st.st_size == 0 && i < 1000; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            void* base = MAP_FAILED;
+            if (result == 0)
+            {
+                length = static_cast<std::size_t>(st.st_size);
+                if (length < sizeof(_shm_header))
+                {
+                    ::close(fd);
+                    _throw_shm_mismatch("shm_channel: region too small");
+                }
+                base = ::mmap(nullptr, length,
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            if (base == MAP_FAILED)
+            {
+                int const error = errno;
+                ::close(fd);
+                errno = error;
+                _throw_shm_error("shm_channel::open");
+            }
+            ::close(fd);
+            return base;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class shm_channel;
+    //!
+    //! A `shm_channel<Ts...>` is a bounded queue of `variant<Ts...>` messages
+    //! from a single sender to a single receiver, which may live in different
+    //! processes. The ring of slots lives in a named POSIX shared memory
+    //! object, next to a header describing its layout; a message is written
+    //! once, in place, by the sender, and visited in place by the receiver.
+    //!
+    //! One process calls `create`, which makes a new object, and the other
+    //! calls `open`, which checks that the header was written for the same
+    //! `Ts...` —same sizes, alignments and, with RTTI, type names— before
+    //! attaching. A side that finds the channel full or empty can block; it
+    //! sleeps on a futex in the shared region, where supported, and polls
+    //! otherwise.
+    //!
+    //! \requires Every type in `Ts...` shall be trivially copyable, and shall
+    //!  not hold pointers into the address space of either process.
+    //!
+    //! \remarks Sender operations, `try_emplace`, `emplace`, `try_send` and
+    //!  `send`, shall not be called concurrently with each other, from any
+    //!  process; neither shall receiver operations, `consume` and `wait`.
+    //!  Both processes shall be built for the same architecture, and shall
+    //!  trust each other: a message is not validated beyond its layout.
+    template <typename ...Ts>
+    class shm_channel
+    {
+        static_assert(sizeof...(Ts) > 0, "shm_channel requires alternatives");
+        static_assert(
+            detail::all_of<detail::pack<
+                detail::is_trivially_copyable<Ts>...
+            >>::value,
+            "shm_channel requires trivially copyable alternatives");
+
+    public:
+        using value_type = variant<Ts...>;
+
+    public:
+        //! static shm_channel create(char const* name, std::size_t capacity);
+        //!
+        //! \requires `name` shall be a valid POSIX shared memory object
+        //!  name, starting with `'/'`.
+        //!
+        //! \effects Creates a shared memory object named `name`, holding an
+        //!  empty channel of up to `capacity` messages, rounded up to a power
+        //!  of 2. The object is removed when the returned channel, or the one
+        //!  it is moved into, is destroyed.
+        //!
+        //! \throws `std::system_error` if the object already exists, or
+        //!  cannot be created or mapped. `std::length_error` if `capacity`
+        //!  exceeds `2^31`.
+        static shm_channel create(char const* name, std::size_t capacity)
+        {
+            std::size_t const slots = detail::_queue_capacity(capacity);
+            if (slots > (std::size_t(1) << 31))
+                _throw_length_error();
+
+            std::size_t const length =
+                _slots_offset() + slots * sizeof(value_type);
+            void* const base = detail::_shm_create(name, length);
+
+            detail::_shm_header* const header =
+                ::new (base) detail::_shm_header();
+            header->fingerprint = detail::_shm_fingerprint<Ts...>();
+            header->slots_offset = _slots_offset();
+            header->version = detail::_shm_version;
+            header->slot_size = sizeof(value_type);
+            header->capacity = static_cast<std::uint32_t>(slots);
+            header->tail.store(0, std::memory_order_relaxed);
+            header->sender_waiting.store(0, std::memory_order_relaxed);
+            header->head.store(0, std::memory_order_relaxed);
+            header->receiver_waiting.store(0, std::memory_order_relaxed);
+            value_type* const storage = reinterpret_cast<value_type*>(
+                static_cast<char*>(base) + _slots_offset());
+            for (std::size_t i = 0; i < slots; ++i)
+                ::new (&storage[i]) value_type();
+            header->magic.store(detail::_shm_magic, std::memory_order_release);
+
+            shm_channel channel(base, length, name, true);
+            channel._capacity = header->capacity;
+            return channel;
+        }
+
+        //! static shm_channel open(char const* name);
+        //!
+        //! \effects Attaches to the channel in the shared memory object named
+        //!  `name`, waiting up to a second for its creator to finish writing
+        //!  the header.
+        //!
+        //! \throws `std::system_error` if the object does not exist, or
+        //!  cannot be mapped. `std::runtime_error` if the object does not
+        //!  hold a channel of `variant<Ts...>` messages.
+        static shm_channel open(char const* name)
+        {
+            std::size_t length = 0;
+            void* const base = detail::_shm_open(name, length);
+            shm_channel channel(base, length, name, false);
+
+            detail::_shm_header const* const header = channel._header;
+            for (int i = 0; i < 1000; ++i)
+            {
+                if (header->magic.load(std::memory_order_acquire) != 0)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            if (header->magic.load(std::memory_order_acquire)
+                    != detail::_shm_magic
+             || header->version != detail::_shm_version)
+            {
+                detail::_throw_shm_mismatch(
+                    "shm_channel: not a channel, or of another version");
+            }
+            if (header->fingerprint != detail::_shm_fingerprint<Ts...>()
+             || header->slot_size != sizeof(value_type)
+             || header->slots_offset != _slots_offset())
+            {
+                detail::_throw_shm_mismatch(
+                    "shm_channel: channel of different alternatives");
+            }
+            std::uint32_t const slots = header->capacity;
+            if (slots == 0 || (slots & (slots - 1)) != 0
+             || length < _slots_offset() + slots * sizeof(value_type))
+            {
+                detail::_throw_shm_mismatch("shm_channel: corrupt header");
+            }
+
+            channel._capacity = slots;
+            channel._cached_head = header->head.load(std::memory_order_acquire);
+            channel._cached_tail = header->tail.load(std::memory_order_acquire);
+            return channel;
+        }
+
+        //! shm_channel(shm_channel&& rhs) noexcept;
+        //!
+        //! \effects Takes over the mapping, and the ownership of the shared
+        //!  memory object, of `rhs`.
+        //!
+        //! \postconditions `rhs` is not attached to a channel; it can only
+        //!  be destroyed or assigned to.
+        shm_channel(shm_channel&& rhs) EGGS_CXX11_NOEXCEPT
+          : _base(rhs._base), _length(rhs._length)
+          , _header(rhs._header), _slots(rhs._slots)
+          , _capacity(rhs._capacity)
+          , _cached_head(rhs._cached_head), _cached_tail(rhs._cached_tail)
+          , _name(std::move(rhs._name)), _owner(rhs._owner)
+        {
+            rhs._base = nullptr;
+            rhs._owner = false;
+        }
+
+        //! shm_channel& operator=(shm_channel&& rhs) noexcept;
+        //!
+        //! \effects Detaches from the current channel, if any, as if by
+        //!  destruction, then takes over the mapping of `rhs`.
+        shm_channel& operator=(shm_channel&& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            if (this != &rhs)
+            {
+                _detach();
+                _base = rhs._base;
+                _length = rhs._length;
+                _header = rhs._header;
+                _slots = rhs._slots;
+                _capacity = rhs._capacity;
+                _cached_head = rhs._cached_head;
+                _cached_tail = rhs._cached_tail;
+                _name = std::move(rhs._name);
+                _owner = rhs._owner;
+                rhs._base = nullptr;
+                rhs._owner = false;
+            }
+            return *this;
+        }
+
+        shm_channel(shm_channel const&) = delete;
+        shm_channel& operator=(shm_channel const&) = delete;
+
+        //! ~shm_channel();
+        //!
+        //! \effects Unmaps the shared region, and removes the shared memory
+        //!  object if this channel created it. A process that is still
+        //!  attached keeps its mapping.
+        ~shm_channel()
+        {
+            _detach();
+        }
+
+        //! template <std::size_t I, class ...Args>
+        //! bool try_emplace(Args&&... args);
+        //!
+        //! \requires `I < sizeof...(Ts)`.
+        //!
+        //! \effects If the channel is not full, constructs a message whose
+        //!  active member is the `I`th element of `Ts...` directly in the
+        //!  next slot, as if by `emplace<I>(std::forward<Args>(args)...)`,
+        //!  and publishes it to the receiver.
+        //!
+        //! \returns `true` if the message was sent.
+        //!
+        //! \throws Any exception thrown by the selected constructor, in which
+        //!  case nothing is sent.
+        template <std::size_t I, typename ...Args>
+        bool try_emplace(Args&&... args)
+        {
+            value_type* const slot = _claim();
+            if (slot == nullptr)
+                return false;
+
+            slot->template emplace<I>(std::forward<Args>(args)...);
+            _publish();
+            return true;
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! bool try_emplace(Args&&... args);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Equivalent to `try_emplace<I>(std::forward<Args>(
+        //!  args)...)` where `I` is the zero-based index of `T` in `Ts...`.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        bool try_emplace(Args&&... args)
+        {
+            return try_emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace<I>(std::forward<Args>(
+        //!  args)...)`, blocking while the channel is full.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            value_type* const slot = _claim_wait();
+            slot->template emplace<I>(std::forward<Args>(args)...);
+            _publish();
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace<T>(std::forward<Args>(
+        //!  args)...)`, blocking while the channel is full.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        void emplace(Args&&... args)
+        {
+            emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! bool try_send(variant<Ts...> const& v);
+        //!
+        //! \effects If the channel is not full, sends a copy of `v`.
+        //!
+        //! \returns `true` if the message was sent.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        bool try_send(value_type const& v)
+        {
+            if (v.which() == value_type::npos)
+                detail::throw_bad_variant_access<void>();
+
+            value_type* const slot = _claim();
+            if (slot == nullptr)
+                return false;
+
+            *slot = v;
+            _publish();
+            return true;
+        }
+
+        //! void send(variant<Ts...> const& v);
+        //!
+        //! \effects Equivalent to `try_send(v)`, blocking while the channel
+        //!  is full.
+        void send(value_type const& v)
+        {
+            if (v.which() == value_type::npos)
+                detail::throw_bad_variant_access<void>();
+
+            value_type* const slot = _claim_wait();
+            *slot = v;
+            _publish();
+        }
+
+        //! template <class F>
+        //! bool consume(F&& f);
+        //!
+        //! \requires `INVOKE(f, get<I>(m))` shall be a valid expression for
+        //!  every `I` in the range `[0u, sizeof...(Ts))`, where `m` is a
+        //!  `variant<Ts...> const` lvalue.
+        //!
+        //! \effects If the channel is not empty, evaluates `INVOKE(f,
+        //!  get<I>(m))` on the oldest message `m` in place, in the shared
+        //!  region, where `I` is `m.which()`, then dequeues it.
+        //!
+        //! \returns `true` if a message was consumed.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the message is
+        //!  dequeued nevertheless.
+        template <typename F>
+        bool consume(F&& f)
+        {
+            return consume(f, 1) != 0;
+        }
+
+        //! template <class F>
+        //! std::size_t consume(F&& f, std::size_t max);
+        //!
+        //! \effects Consumes, as by `consume(f)`, up to `max` messages that
+        //!  are in the channel on entry.
+        //!
+        //! \returns The number of messages consumed.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the messages
+        //!  consumed until then, including the one for which `f` threw, are
+        //!  dequeued.
+        //!
+        //! \remarks The index of the sender is read once, and the index of
+        //!  the receiver is published once, for the whole batch.
+        template <typename F>
+        std::size_t consume(F&& f, std::size_t max)
+        {
+            std::uint32_t const head =
+                _header->head.load(std::memory_order_relaxed);
+            if (_cached_tail - head < max)
+            {
+                _cached_tail = _header->tail.load(std::memory_order_acquire);
+                if (_cached_tail == head)
+                    return 0;
+            }
+
+            std::size_t const count =
+                _cached_tail - head < max ? _cached_tail - head : max;
+
+            struct publish
+            {
+                detail::_shm_header* header;
+                std::uint32_t position;
+
+                ~publish()
+                {
+                    header->head.store(position, std::memory_order_release);
+
+                    // pairs with the fence in `_claim_wait`, so that either
+                    // the sender sees the new head or it is seen waiting;
+                    // clearing the flag wakes it once, not once per batch
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (header->sender_waiting.load(
+                            std::memory_order_relaxed) != 0
+                     && header->sender_waiting.exchange(
+                            0, std::memory_order_relaxed) != 0)
+                    {
+                        detail::_futex_wake_all_shared(header->head);
+                    }
+                }
+            } guard = {_header, head};
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                value_type const& slot =
+                    _slots[(head + i) & (_capacity - 1)];
+                ++guard.position;
+                ::eggs::variants::apply<void>(f, slot);
+            }
+            return count;
+        }
+
+        //! void wait();
+        //!
+        //! \effects Blocks until the channel is not empty.
+        void wait()
+        {
+            while (!_wait_nonempty(std::chrono::nanoseconds(-1)))
+                ;
+        }
+
+        //! template <class Rep, class Period>
+        //! bool wait_for(std::chrono::duration<Rep, Period> const& timeout);
+        //!
+        //! \effects Blocks until the channel is not empty, or until
+        //!  `timeout` has elapsed.
+        //!
+        //! \returns `!empty()`.
+        template <typename Rep, typename Period>
+        bool wait_for(std::chrono::duration<Rep, Period> const& timeout)
+        {
+            using clock = std::chrono::steady_clock;
+            clock::time_point const deadline = clock::now()
+              + std::chrono::duration_cast<clock::duration>(timeout);
+            for (;;)
+            {
+                std::chrono::nanoseconds const remaining =
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        deadline - clock::now());
+                if (remaining.count() <= 0)
+                    return !empty();
+                if (_wait_nonempty(remaining))
+                    return true;
+            }
+        }
+
+        //! std::size_t capacity() const noexcept;
+        //!
+        //! \returns The maximum number of messages in the channel.
+        std::size_t capacity() const EGGS_CXX11_NOEXCEPT
+        {
+            return _capacity;
+        }
+
+        //! std::size_t size_approx() const noexcept;
+        //!
+        //! \returns The number of messages in the channel at some point
+        //!  during the call. It is exact when called by either side while
+        //!  the other side is idle.
+        std::size_t size_approx() const EGGS_CXX11_NOEXCEPT
+        {
+            std::uint32_t const head =
+                _header->head.load(std::memory_order_acquire);
+            std::uint32_t const tail =
+                _header->tail.load(std::memory_order_acquire);
+            return std::uint32_t(tail - head);
+        }
+
+        //! bool empty() const noexcept;
+        //!
+        //! \returns `size_approx() == 0`.
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return size_approx() == 0;
+        }
+
+    private:
+        shm_channel(
+            void* base, std::size_t length, char const* name, bool owner)
+          : _base(base), _length(length)
+          , _header(static_cast<detail::_shm_header*>(base))
+          , _slots(reinterpret_cast<value_type*>(
+                static_cast<char*>(base) + _slots_offset()))
+          , _capacity(0)
+          , _cached_head(0), _cached_tail(0)
+          , _name(), _owner(false)
+        {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+                _name = name;
+            } catch (...) {
+                ::munmap(base, length);
+                if (owner)
+                    ::shm_unlink(name);
+                throw;
+            }
+#else
+            _name = name;
+#endif
+            _owner = owner;
+        }
+
+        static EGGS_CXX11_CONSTEXPR std::size_t _slots_offset()
+        {
+            return (sizeof(detail::_shm_header) + alignof(value_type) - 1)
+              / alignof(value_type) * alignof(value_type);
+        }
+
+        EGGS_CXX11_NORETURN static void _throw_length_error()
+        {
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            throw std::length_error("shm_channel::create");
+#else
+            std::terminate();
+#endif
+        }
+
+        void _detach() EGGS_CXX11_NOEXCEPT
+        {
+            if (_base == nullptr)
+                return;
+
+            ::munmap(_base, _length);
+            if (_owner)
+                ::shm_unlink(_name.c_str());
+            _base = nullptr;
+            _owner = false;
+        }
+
+        // Returns the slot for the next message, or `nullptr` if the channel
+        // is full; the slot is not visible to the receiver until `_publish`.
+        value_type* _claim() EGGS_CXX11_NOEXCEPT
+        {
+            std::uint32_t const tail =
+                _header->tail.load(std::memory_order_relaxed);
+            if (tail - _cached_head == _capacity)
+            {
+                _cached_head = _header->head.load(std::memory_order_acquire);
+                if (tail - _cached_head == _capacity)
+                    return nullptr;
+            }
+            return &_slots[tail & (_capacity - 1)];
+        }
+
+        // Returns the slot for the next message, sleeping on the index of
+        // the receiver for as long as the channel is full.
+        value_type* _claim_wait() EGGS_CXX11_NOEXCEPT
+        {
+            for (;;)
+            {
+                if (value_type* const slot = _claim())
+                    return slot;
+
+                _header->sender_waiting.store(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::uint32_t const head =
+                    _header->head.load(std::memory_order_relaxed);
+                std::uint32_t const tail =
+                    _header->tail.load(std::memory_order_relaxed);
+                if (tail - head == _capacity)
+                    detail::_futex_wait_shared(_header->head, head);
+                _header->sender_waiting.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void _publish() EGGS_CXX11_NOEXCEPT
+        {
+            std::uint32_t const tail =
+                _header->tail.load(std::memory_order_relaxed);
+            _header->tail.store(tail + 1, std::memory_order_release);
+
+            // pairs with the fence in `_wait_nonempty`, so that either the
+            // receiver sees the new tail or it is seen waiting; clearing the
+            // flag wakes it once, not once per message sent until it runs
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_header->receiver_waiting.load(std::memory_order_relaxed) != 0
+             && _header->receiver_waiting.exchange(
+                    0, std::memory_order_relaxed) != 0)
+            {
+                detail::_futex_wake_all_shared(_header->tail);
+            }
+        }
+
+        // Sleeps on the index of the sender while the channel is empty, for
+        // up to `timeout` if not negative; returns whether it is not empty.
+        bool _wait_nonempty(std::chrono::nanoseconds timeout)
+        {
+            std::uint32_t const head =
+                _header->head.load(std::memory_order_relaxed);
+            if (_header->tail.load(std::memory_order_acquire) != head)
+                return true;
+
+            _header->receiver_waiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::uint32_t const tail =
+                _header->tail.load(std::memory_order_relaxed);
+            if (tail == head)
+                detail::_futex_wait_shared(_header->tail, tail, timeout);
+            _header->receiver_waiting.store(0, std::memory_order_relaxed);
+
+            return _header->tail.load(std::memory_order_acquire) != head;
+        }
+
+    private:
+        void* _base;
+        std::size_t _length;
+        detail::_shm_header* _header;
+        value_type* _slots;
+        std::uint32_t _capacity;
+
+        // private to the sender and the receiver, respectively
+        std::uint32_t _cached_head;
+        std::uint32_t _cached_tail;
+
+        std::string _name;
+        bool _owner;
+    };
+}}
+#endif
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_SHM_CHANNEL_HPP*/
@@ -0,0 +1,413 @@
+//! \file eggs/variant/state_machine.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_STATE_MACHINE_HPP
+#define EGGS_VARIANT_STATE_MACHINE_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/visitor.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class S, class ...Args>
+    //! class transition;
+    //!
+    //! A `transition<S, Args...>` is returned by a transition table entry to
+    //! move a `state_machine` into state `S`. It holds the arguments for the
+    //! constructor of `S`, which is deferred until the current state has been
+    //! destroyed, so that the next state is constructed in its storage.
+    //!
+    //! Since the current state is destroyed before the next one is built,
+    //! the arguments are held by value; a reference into the current state
+    //! would dangle.
+    template <typename S, typename ...Args>
+    class transition
+    {
+    public:
+        using state_type = S;
+
+    public:
+        //! explicit transition(Args... args);
+        //!
+        //! \effects Initializes the held arguments with `args...`.
+        explicit transition(Args... args)
+          : _args(std::move(args)...)
+        {}
+
+        //! std::tuple<Args...>& args() noexcept;
+        std::tuple<Args...>& args() EGGS_CXX11_NOEXCEPT
+        {
+            return _args;
+        }
+
+    private:
+        std::tuple<Args...> _args;
+    };
+
+    //! template <class S, class ...Args>
+    //! transition<S, std::decay_t<Args>...> transition_to(Args&&... args);
+    //!
+    //! \returns `transition<S, std::decay_t<Args>...>(
+    //!  std::forward<Args>(args)...)`.
+    template <typename S, typename ...Args>
+    transition<S, typename std::decay<Args>::type...>
+    transition_to(Args&&... args)
+    {
+        return transition<S, typename std::decay<Args>::type...>(
+            std::forward<Args>(args)...);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! struct null_tracer;
+    //!
+    //! The default tracer of a `state_machine`, whose hooks do nothing.
+    //!
+    //! A tracer is notified with `on_exit(from, e)` before a state is left,
+    //! `on_enter(to, e)` after the next state has been constructed,
+    //! `on_internal(s, e)` after an entry that returns `void`, and
+    //! `on_unhandled(s, e)` for a pair with no entry. Each hook takes the
+    //! state and the event by reference to const, so a tracer can overload
+    //! them to trace particular transitions.
+    struct null_tracer
+    {
+        template <typename S, typename E>
+        void on_exit(S const&, E const&) const EGGS_CXX11_NOEXCEPT {}
+
+        template <typename S, typename E>
+        void on_enter(S const&, E const&) const EGGS_CXX11_NOEXCEPT {}
+
+        template <typename S, typename E>
+        void on_internal(S const&, E const&) const EGGS_CXX11_NOEXCEPT {}
+
+        template <typename S, typename E>
+        void on_unhandled(S const&, E const&) const EGGS_CXX11_NOEXCEPT {}
+    };
+
+    namespace detail
+    {
+        struct _fsm_unhandled {};
+
+        template <typename F, typename S, typename E>
+        auto _fsm_invoke(F& f, S& s, E const& e) -> decltype(f(s, e));
+
+        _fsm_unhandled _fsm_invoke(...);
+
+        // The result of the table entry for `(S, E)`: `void`, a transition,
+        // or `_fsm_unhandled` if there is no entry.
+        template <typename Table, typename S, typename E>
+        struct _fsm_result
+        {
+            using type = decltype(_fsm_invoke(
+                std::declval<Table&>(), std::declval<S&>()
+              , std::declval<E const&>()));
+        };
+
+        template <typename Table, typename S, typename E>
+        struct _fsm_handles
+          : std::integral_constant<
+                bool
+              , !std::is_same<
+                    typename _fsm_result<Table, S, E>::type, _fsm_unhandled
+                >::value
+            >
+        {};
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class States, class Events, class Table,
+    //!     class Tracer = null_tracer>
+    //! class state_machine; // undefined
+    //!
+    //! template <class ...Ss, class ...Es, class Table, class Tracer>
+    //! class state_machine<variant<Ss...>, variant<Es...>, Table, Tracer>;
+    //!
+    //! A `state_machine` holds its current state as the active member of a
+    //! `variant<Ss...>`, and processes events of `variant<Es...>`. Its
+    //! transitions are the overloads of `Table::operator()`: an entry for
+    //! state `S` and event `E` is a call `table(s, e)` with `s` an `S&` and
+    //! `e` an `E const&`, that is resolved at compile time. An entry either
+    //! returns `void`, for an internal transition that stays in `S`, or a
+    //! `transition<T, Args...>`, which destroys `s` and constructs the next
+    //! state `T` from `Args...` in the same storage.
+    //!
+    //! Processing an event variant dispatches once, on a table of one entry
+    //! per pair of state and event alternatives, rather than once per
+    //! variant. The machine allocates no memory of its own.
+    //!
+    //! \requires `Table::operator()` shall return `void` or a specialization
+    //!  of `transition` whose state occurs exactly once in `Ss...`. `Tracer`
+    //!  shall provide the hooks described for `null_tracer`.
+    template <
+        typename States, typename Events, typename Table
+      , typename Tracer = null_tracer
+    >
+    class state_machine;
+
+    template <
+        typename ...Ss, typename ...Es, typename Table, typename Tracer
+    >
+    class state_machine<variant<Ss...>, variant<Es...>, Table, Tracer>
+    {
+        static_assert(sizeof...(Ss) > 0, "state_machine requires states");
+        static_assert(sizeof...(Es) > 0, "state_machine requires events");
+
+        using _states = detail::pack<Ss...>;
+        using _events = detail::pack<Es...>;
+
+        EGGS_CXX11_STATIC_CONSTEXPR std::size_t _event_count = sizeof...(Es);
+
+    public:
+        using states_type = variant<Ss...>;
+        using events_type = variant<Es...>;
+        using table_type = Table;
+        using tracer_type = Tracer;
+
+    public:
+        //! explicit state_machine(Table table = Table(),
+        //!     Tracer tracer = Tracer());
+        //!
+        //! \effects Initializes the table and the tracer, and the current
+        //!  state to a value-initialized first element of `Ss...`.
+        explicit state_machine(Table table = Table(), Tracer tracer = Tracer())
+          : _state(in_place<0>)
+          , _table(std::move(table))
+          , _tracer(std::move(tracer))
+        {}
+
+        //! template <std::size_t I, class ...Args>
+        //! void reset(Args&&... args);
+        //!
+        //! \requires `I < sizeof...(Ss)`.
+        //!
+        //! \effects Destroys the current state, if any, and constructs the
+        //!  `I`th element of `Ss...` in its place from `std::forward<Args>(
+        //!  args)...`. No hooks are called.
+        //!
+        //! \throws Any exception thrown by the selected constructor, in which
+        //!  case the machine has no state.
+        template <std::size_t I, typename ...Args>
+        void reset(Args&&... args)
+        {
+            _state.template emplace<I>(std::forward<Args>(args)...);
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class S, class ...Args>
+        //! void reset(Args&&... args);
+        //!
+        //! \requires `S` shall occur exactly once in `Ss...`.
+        //!
+        //! \effects Equivalent to `reset<I>(std::forward<Args>(args)...)`
+        //!  where `I` is the zero-based index of `S` in `Ss...`.
+        template <
+            typename S, typename ...Args
+          , std::size_t I = detail::index_of<S, _states>::value
+        >
+        void reset(Args&&... args)
+        {
+            reset<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! bool process(variant<Es...> const& e);
+        //!
+        //! \effects Runs the table entry for the current state and the active
+        //!  member of `e`, if any, notifying the tracer.
+        //!
+        //! \returns `true` if there was an entry for the pair.
+        //!
+        //! \throws `bad_variant_access` if `e` has no active member, or if
+        //!  the machine has no state. Any exception thrown by the entry, in
+        //!  which case the state is unchanged, or by the constructor of the
+        //!  next state, in which case the machine has no state.
+        bool process(events_type const& e)
+        {
+            if (_state.which() == states_type::npos
+             || e.which() == events_type::npos)
+            {
+                detail::throw_bad_variant_access<void>();
+            }
+
+            return _process_pair{}(
+                typename detail::_make_typed_pack<
+                    detail::make_index_pack<sizeof...(Ss) * sizeof...(Es)>
+                >::type{}
+              , _state.which() * _event_count + e.which()
+              , *this, e.target());
+        }
+
+        //! template <class E>
+        //! bool process(E const& e);
+        //!
+        //! \requires `E` shall occur exactly once in `Es...`.
+        //!
+        //! \effects Runs the table entry for the current state and `e`, if
+        //!  any, notifying the tracer. The event is not wrapped in a variant,
+        //!  and dispatch is on the current state alone.
+        //!
+        //! \returns `true` if there was an entry for the pair.
+        //!
+        //! \throws As `process(variant<Es...>(e))`.
+        template <
+            typename E
+          , typename Enable = typename std::enable_if<
+                !std::is_same<E, events_type>::value>::type
+          , std::size_t J = detail::index_of<E, _events>::value
+        >
+        bool process(E const& e)
+        {
+            if (_state.which() == states_type::npos)
+                detail::throw_bad_variant_access<void>();
+
+            return _process_state<J>{}(
+                detail::typed_index_pack<_states>{}, _state.which()
+              , *this, &e);
+        }
+
+        //! template <class S, class E>
+        //! static constexpr bool handles() noexcept;
+        //!
+        //! \returns `true` if the table has an entry for state `S` and event
+        //!  `E`.
+        template <typename S, typename E>
+        static EGGS_CXX11_CONSTEXPR bool handles() EGGS_CXX11_NOEXCEPT
+        {
+            return detail::_fsm_handles<Table, S, E>::value;
+        }
+
+        //! variant<Ss...> const& state() const noexcept;
+        //!
+        //! \returns The current state, whose active member is the state the
+        //!  machine is in.
+        states_type const& state() const EGGS_CXX11_NOEXCEPT
+        {
+            return _state;
+        }
+
+        //! Table& table() noexcept;
+        //! Table const& table() const noexcept;
+        Table& table() EGGS_CXX11_NOEXCEPT
+        {
+            return _table;
+        }
+
+        Table const& table() const EGGS_CXX11_NOEXCEPT
+        {
+            return _table;
+        }
+
+        //! Tracer& tracer() noexcept;
+        //! Tracer const& tracer() const noexcept;
+        Tracer& tracer() EGGS_CXX11_NOEXCEPT
+        {
+            return _tracer;
+        }
+
+        Tracer const& tracer() const EGGS_CXX11_NOEXCEPT
+        {
+            return _tracer;
+        }
+
+    private:
+        // Entry for the `K`th pair, a state index of `K / sizeof...(Es)`
+        // and an event index of `K % sizeof...(Es)`.
+        struct _process_pair
+          : detail::visitor<
+                _process_pair
+              , bool(state_machine&, void const*)
+            >
+        {
+            template <typename K>
+            static bool call(state_machine& m, void const* e)
+            {
+                return m.template _step<
+                    K::value / _event_count, K::value % _event_count
+                >(e);
+            }
+        };
+
+        template <std::size_t J>
+        struct _process_state
+          : detail::visitor<
+                _process_state<J>
+              , bool(state_machine&, void const*)
+            >
+        {
+            template <typename I>
+            static bool call(state_machine& m, void const* e)
+            {
+                return m.template _step<I::value, J>(e);
+            }
+        };
+
+        template <std::size_t I, std::size_t J>
+        bool _step(void const* e)
+        {
+            using S = typename detail::at_index<I, _states>::type;
+            using E = typename detail::at_index<J, _events>::type;
+            using R = typename detail::_fsm_result<Table, S, E>::type;
+
+            S& s = *_state.template target<S>();
+            return _run<I>(s, *static_cast<E const*>(e), detail::identity<R>{});
+        }
+
+        template <std::size_t I, typename S, typename E>
+        bool _run(S& s, E const& e, detail::identity<detail::_fsm_unhandled>)
+        {
+            _tracer.on_unhandled(static_cast<S const&>(s), e);
+            return false;
+        }
+
+        template <std::size_t I, typename S, typename E>
+        bool _run(S& s, E const& e, detail::identity<void>)
+        {
+            _table(s, e);
+            _tracer.on_internal(static_cast<S const&>(s), e);
+            return true;
+        }
+
+        template <
+            std::size_t I, typename S, typename E
+          , typename T, typename ...Args
+        >
+        bool _run(S& s, E const& e, detail::identity<transition<T, Args...>>)
+        {
+            transition<T, Args...> t = _table(s, e);
+            _tracer.on_exit(static_cast<S const&>(s), e);
+            _enter<detail::index_of<T, _states>::value>(
+                t.args(), detail::make_index_pack<sizeof...(Args)>{});
+            _tracer.on_enter(*_state.template target<T>(), e);
+            return true;
+        }
+
+        template <std::size_t N, typename Tuple, std::size_t ...Is>
+        void _enter(Tuple& args, detail::pack_c<std::size_t, Is...>)
+        {
+            _state.template emplace<N>(std::get<Is>(std::move(args))...);
+        }
+
+    private:
+        states_type _state;
+        Table _table;
+        Tracer _tracer;
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_STATE_MACHINE_HPP*/
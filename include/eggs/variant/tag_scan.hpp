@@ -0,0 +1,133 @@
+//! \file eggs/variant/tag_scan.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_TAG_SCAN_HPP
+#define EGGS_VARIANT_TAG_SCAN_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/variant_column.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/tag_scan.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! std::array<std::size_t, sizeof...(Ts)>
+    //!     count_by_alternative(variant_column<Ts...> const& c);
+    //!
+    //! \returns An array whose `I`-th element is `c.count(I)`, for every `I`
+    //!  in the range `[0u, sizeof...(Ts))`.
+    //!
+    //! \remarks Only the discriminator array is accessed, in a single pass
+    //!  when there are many alternatives or in cache-sized blocks revisited
+    //!  once per alternative when there are few. On x86 the 8-bit
+    //!  discriminators are compared 16 at a time with SSE2, or 32 at a time
+    //!  with AVX2 when the processor supports it.
+    template <typename ...Ts>
+    std::array<std::size_t, sizeof...(Ts)>
+    count_by_alternative(variant_column<Ts...> const& c)
+    {
+        std::size_t counts[sizeof...(Ts) + 1];
+        detail::histogram(c.tags(), c.size(), counts);
+
+        std::array<std::size_t, sizeof...(Ts)> result;
+        for (std::size_t i = 0; i < sizeof...(Ts); ++i)
+            result[i] = counts[i + 1];
+        return result;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class T, class ...Ts>
+    //! std::size_t find_first(
+    //!     variant_column<Ts...> const& c, std::size_t pos = 0);
+    //!
+    //! \requires `T` shall occur exactly once in `Ts...`.
+    //!
+    //! \returns The smallest index `i` in `[pos, c.size())` for which the
+    //!  active member of `c[i]` has type `T`, or `variant<Ts...>::npos` if
+    //!  there is none.
+    template <typename T, typename ...Ts>
+    std::size_t find_first(
+        variant_column<Ts...> const& c, std::size_t pos = 0)
+    {
+        using tag_type = typename variant_column<Ts...>::tag_type;
+        EGGS_CXX11_CONSTEXPR std::size_t which =
+            detail::index_of<T, detail::pack<Ts...>>::value;
+
+        if (pos >= c.size())
+            return variant<Ts...>::npos;
+
+        std::size_t const i = pos + detail::find_eq(
+            c.tags() + pos, c.size() - pos, static_cast<tag_type>(which + 1));
+        if (i == c.size())
+            return variant<Ts...>::npos;
+        return i;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class T, class ...Ts>
+    //! void mask_of(variant_column<Ts...> const& c, std::uint64_t* words);
+    //!
+    //! \requires `T` shall occur exactly once in `Ts...`. `words` shall point
+    //!  to an array of at least `(c.size() + 63) / 64` elements.
+    //!
+    //! \effects Stores a bitmap of the elements of `c` with an active member
+    //!  of type `T` in `words`: bit `i % 64` of `words[i / 64]` is set if,
+    //!  and only if, `c[i]` holds a `T`. The unused high bits of the last
+    //!  word are zero.
+    template <typename T, typename ...Ts>
+    void mask_of(variant_column<Ts...> const& c, std::uint64_t* words)
+    {
+        using tag_type = typename variant_column<Ts...>::tag_type;
+        EGGS_CXX11_CONSTEXPR std::size_t which =
+            detail::index_of<T, detail::pack<Ts...>>::value;
+
+        detail::mask_eq(
+            c.tags(), c.size(), static_cast<tag_type>(which + 1), words);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class T, class ...Ts, class Index>
+    //! std::size_t compress_indices(
+    //!     variant_column<Ts...> const& c, Index* out);
+    //!
+    //! \requires `T` shall occur exactly once in `Ts...`. `Index` shall be an
+    //!  integral type able to represent `c.size() - 1`, and `out` shall point
+    //!  to an array of at least `c.count<T>()` elements.
+    //!
+    //! \effects Writes to `out`, in increasing order, the index of every
+    //!  element of `c` with an active member of type `T`.
+    //!
+    //! \returns The number of indices written, `c.count<T>()`.
+    //!
+    //! \remarks The selected indices can be used to gather the payloads of a
+    //!  single alternative, e.g. for a `for_each` over them that does not
+    //!  need to dispatch.
+    template <typename T, typename ...Ts, typename Index>
+    std::size_t compress_indices(
+        variant_column<Ts...> const& c, Index* out)
+    {
+        using tag_type = typename variant_column<Ts...>::tag_type;
+        EGGS_CXX11_CONSTEXPR std::size_t which =
+            detail::index_of<T, detail::pack<Ts...>>::value;
+
+        return detail::compress_eq(
+            c.tags(), c.size(), static_cast<tag_type>(which + 1), out);
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_TAG_SCAN_HPP*/
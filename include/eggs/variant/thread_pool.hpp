@@ -0,0 +1,381 @@
+//! \file eggs/variant/thread_pool.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_THREAD_POOL_HPP
+#define EGGS_VARIANT_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    class thread_pool;
+    class task_group;
+
+    namespace detail
+    {
+        struct _pool_task
+        {
+            std::function<void()> f;
+            task_group* group;
+        };
+
+        struct _pool_queue
+        {
+            std::mutex mutex;
+            std::deque<_pool_task> tasks;
+        };
+
+        inline thread_pool*& _current_pool() EGGS_CXX11_NOEXCEPT
+        {
+            static thread_local thread_pool* pool = nullptr;
+            return pool;
+        }
+
+        inline std::size_t& _current_worker() EGGS_CXX11_NOEXCEPT
+        {
+            static thread_local std::size_t worker = 0;
+            return worker;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! class thread_pool;
+    //!
+    //! A `thread_pool` owns a fixed set of worker threads that execute the
+    //! tasks submitted through a `task_group`. Each worker has its own task
+    //! queue: it runs the tasks it spawns itself most recent first, and when
+    //! its queue is empty it steals the oldest task from another queue.
+    //! Tasks submitted from outside the pool go to a shared queue, from
+    //! which every worker steals.
+    class thread_pool
+    {
+    public:
+        //! explicit thread_pool(std::size_t threads = default_concurrency());
+        //!
+        //! \effects Starts `max(threads, 1)` worker threads.
+        //!
+        //! \throws `std::system_error` if a thread could not be started.
+        explicit thread_pool(std::size_t threads = default_concurrency())
+          : _size(threads != 0 ? threads : 1)
+          , _queued(0)
+          , _stop(false)
+        {
+            threads = _size;
+
+            for (std::size_t i = 0; i <= threads; ++i)
+                _queues.emplace_back(new detail::_pool_queue());
+
+            _threads.reserve(threads);
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+                for (std::size_t i = 0; i < threads; ++i)
+                    _threads.emplace_back(&thread_pool::_worker, this, i);
+            } catch (...) {
+                _shutdown();
+                throw;
+            }
+#else
+            for (std::size_t i = 0; i < threads; ++i)
+                _threads.emplace_back(&thread_pool::_worker, this, i);
+#endif
+        }
+
+        thread_pool(thread_pool const&) = delete;
+        thread_pool& operator=(thread_pool const&) = delete;
+
+        //! ~thread_pool();
+        //!
+        //! \requires Every `task_group` using `*this` shall have been waited
+        //!  for.
+        //!
+        //! \effects Joins every worker thread.
+        ~thread_pool()
+        {
+            _shutdown();
+        }
+
+        //! std::size_t size() const noexcept;
+        //!
+        //! \returns The number of worker threads.
+        std::size_t size() const EGGS_CXX11_NOEXCEPT
+        {
+            return _size;
+        }
+
+        //! std::size_t this_worker() const noexcept;
+        //!
+        //! \returns The index, in `[0, size())`, of the calling thread if it
+        //!  is a worker of `*this`; otherwise, `size()`.
+        std::size_t this_worker() const EGGS_CXX11_NOEXCEPT
+        {
+            return detail::_current_pool() == this
+              ? detail::_current_worker() : size();
+        }
+
+        //! static std::size_t default_concurrency() noexcept;
+        //!
+        //! \returns `std::thread::hardware_concurrency()` if it is not `0`;
+        //!  otherwise, `1`.
+        static std::size_t default_concurrency() EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const n = std::thread::hardware_concurrency();
+            return n != 0 ? n : 1;
+        }
+
+    private:
+        friend class task_group;
+
+        void _push(detail::_pool_task task)
+        {
+            detail::_pool_queue& queue = *_queues[this_worker()];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            _queued.fetch_add(1, std::memory_order_release);
+
+            // a worker checks `_queued` while holding `_mutex` before going
+            // to sleep, so taking it here ensures the notification is seen
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+            }
+            _wake.notify_one();
+        }
+
+        bool _try_pop(
+            detail::_pool_queue& queue, bool back, detail::_pool_task& task)
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                return false;
+
+            if (back)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Runs one task, popped from the queue of worker `self` or stolen
+        // from any other queue; returns `false` if there was none.
+        bool _try_run_one(std::size_t self);
+
+        void _worker(std::size_t self)
+        {
+            detail::_current_pool() = this;
+            detail::_current_worker() = self;
+
+            for (;;)
+            {
+                if (_try_run_one(self))
+                    continue;
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this]
+                {
+                    return _stop
+                        || _queued.load(std::memory_order_acquire) != 0;
+                });
+                if (_stop && _queued.load(std::memory_order_acquire) == 0)
+                    return;
+            }
+        }
+
+        void _shutdown()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _wake.notify_all();
+            for (std::thread& thread : _threads)
+                thread.join();
+            _threads.clear();
+        }
+
+    private:
+        std::vector<std::unique_ptr<detail::_pool_queue>> _queues;
+        std::vector<std::thread> _threads;
+        std::size_t _size;
+        std::atomic<std::size_t> _queued;
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        bool _stop;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! class task_group;
+    //!
+    //! A `task_group` submits tasks to a `thread_pool` and waits for them to
+    //! complete, which is the basis for fork/join parallelism: tasks can in
+    //! turn run and wait for tasks of their own. A worker thread that waits
+    //! keeps executing pending tasks in the meantime, so nested waits do not
+    //! starve the pool; any other thread blocks.
+    class task_group
+    {
+    public:
+        //! explicit task_group(thread_pool& pool) noexcept;
+        explicit task_group(thread_pool& pool) EGGS_CXX11_NOEXCEPT
+          : _pool(pool)
+          , _pending(0)
+        {}
+
+        task_group(task_group const&) = delete;
+        task_group& operator=(task_group const&) = delete;
+
+        //! ~task_group();
+        //!
+        //! \effects Waits for the tasks of `*this` to complete, discarding
+        //!  any exception they threw.
+        ~task_group()
+        {
+            _wait();
+        }
+
+        //! template <class F>
+        //! void run(F&& f);
+        //!
+        //! \effects Submits a task that evaluates `std::forward<F>(f)()` on
+        //!  some worker of the pool.
+        template <typename F>
+        void run(F&& f)
+        {
+            _pending.fetch_add(1, std::memory_order_relaxed);
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+                _pool._push(detail::_pool_task{
+                    std::function<void()>(std::forward<F>(f)), this});
+            } catch (...) {
+                _finish();
+                throw;
+            }
+#else
+            _pool._push(detail::_pool_task{
+                std::function<void()>(std::forward<F>(f)), this});
+#endif
+        }
+
+        //! void wait();
+        //!
+        //! \effects Blocks until every task submitted through `*this` has
+        //!  completed.
+        //!
+        //! \throws The first exception thrown by any of the tasks, if any.
+        //!  The exception is cleared, and `*this` can be reused.
+        void wait()
+        {
+            _wait();
+
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                std::swap(error, _error);
+            }
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+    private:
+        friend class thread_pool;
+
+        void _wait()
+        {
+            std::size_t const self = _pool.this_worker();
+            if (self != _pool.size())
+            {
+                while (_pending.load(std::memory_order_acquire) != 0)
+                {
+                    if (!_pool._try_run_one(self))
+                        std::this_thread::yield();
+                }
+
+                // the last task to finish may still be holding `_mutex`
+                std::lock_guard<std::mutex> lock(_mutex);
+            } else {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _done.wait(lock, [this]
+                {
+                    return _pending.load(std::memory_order_acquire) == 0;
+                });
+            }
+        }
+
+        void _fail(std::exception_ptr error)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_error)
+                _error = std::move(error);
+        }
+
+        void _finish()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                _done.notify_all();
+        }
+
+    private:
+        thread_pool& _pool;
+        std::atomic<std::size_t> _pending;
+        std::mutex _mutex;
+        std::condition_variable _done;
+        std::exception_ptr _error;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    inline bool thread_pool::_try_run_one(std::size_t self)
+    {
+        detail::_pool_task task;
+
+        std::size_t const queues = _queues.size();
+        bool found = self < size() && _try_pop(*_queues[self], true, task);
+        for (std::size_t i = 1; !found && i < queues; ++i)
+            found = _try_pop(*_queues[(self + i) % queues], false, task);
+        if (!found)
+            return false;
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+        try
+        {
+            task.f();
+        } catch (...) {
+            task.group->_fail(std::current_exception());
+        }
+#else
+        task.f();
+#endif
+
+        // the state of the task goes before the group can be released
+        task.f = nullptr;
+        task.group->_finish();
+        return true;
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_THREAD_POOL_HPP*/
@@ -0,0 +1,348 @@
+//! \file eggs/variant/transform_runs.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_TRANSFORM_RUNS_HPP
+#define EGGS_VARIANT_TRANSFORM_RUNS_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class T, class RandomIt>
+    //! class run_view;
+    //!
+    //! A `run_view<T, RandomIt>` is a random access range over the active
+    //! members, of type `T`, of a run of consecutive variants. `T` is const
+    //! qualified when the variants are accessed through a const iterator.
+    //! Accessing an element does not check the discriminator.
+    template <typename T, typename RandomIt>
+    class run_view
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename std::remove_cv<T>::type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+        public:
+            iterator()
+              : _it()
+            {}
+
+            explicit iterator(RandomIt it)
+              : _it(it)
+            {}
+
+            T& operator*() const
+            {
+                return *static_cast<T*>(
+                    detail::access::storage(*_it).target());
+            }
+
+            T* operator->() const
+            {
+                return &**this;
+            }
+
+            T& operator[](difference_type n) const
+            {
+                return *(*this + n);
+            }
+
+            iterator& operator++() { ++_it; return *this; }
+            iterator operator++(int) { iterator t = *this; ++_it; return t; }
+            iterator& operator--() { --_it; return *this; }
+            iterator operator--(int) { iterator t = *this; --_it; return t; }
+
+            iterator& operator+=(difference_type n) { _it += n; return *this; }
+            iterator& operator-=(difference_type n) { _it -= n; return *this; }
+
+            friend iterator operator+(iterator it, difference_type n)
+            {
+                return it += n;
+            }
+
+            friend iterator operator+(difference_type n, iterator it)
+            {
+                return it += n;
+            }
+
+            friend iterator operator-(iterator it, difference_type n)
+            {
+                return it -= n;
+            }
+
+            friend difference_type operator-(
+                iterator const& lhs, iterator const& rhs)
+            {
+                return static_cast<difference_type>(lhs._it - rhs._it);
+            }
+
+            friend bool operator==(iterator const& lhs, iterator const& rhs)
+            {
+                return lhs._it == rhs._it;
+            }
+
+            friend bool operator!=(iterator const& lhs, iterator const& rhs)
+            {
+                return !(lhs == rhs);
+            }
+
+            friend bool operator<(iterator const& lhs, iterator const& rhs)
+            {
+                return lhs._it < rhs._it;
+            }
+
+            friend bool operator>(iterator const& lhs, iterator const& rhs)
+            {
+                return rhs < lhs;
+            }
+
+            friend bool operator<=(iterator const& lhs, iterator const& rhs)
+            {
+                return !(rhs < lhs);
+            }
+
+            friend bool operator>=(iterator const& lhs, iterator const& rhs)
+            {
+                return !(lhs < rhs);
+            }
+
+        private:
+            RandomIt _it;
+        };
+
+        using value_type = typename std::remove_cv<T>::type;
+        using size_type = std::size_t;
+        using reference = T&;
+
+    public:
+        //! run_view(RandomIt first, std::size_t size, std::size_t offset);
+        //!
+        //! \requires Every element in `[first, first + size)` shall have an
+        //!  active member of type `T`.
+        //!
+        //! \effects Initializes the view to refer to `[first, first + size)`,
+        //!  which begins at position `offset` of the range being traversed.
+        run_view(RandomIt first, std::size_t size, std::size_t offset)
+          : _first(first), _size(size), _offset(offset)
+        {}
+
+        iterator begin() const
+        {
+            return iterator(_first);
+        }
+
+        iterator end() const
+        {
+            return iterator(_first) + static_cast<std::ptrdiff_t>(_size);
+        }
+
+        std::size_t size() const EGGS_CXX11_NOEXCEPT
+        {
+            return _size;
+        }
+
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return _size == 0;
+        }
+
+        T& operator[](std::size_t i) const
+        {
+            return begin()[static_cast<std::ptrdiff_t>(i)];
+        }
+
+        T& front() const
+        {
+            return (*this)[0];
+        }
+
+        T& back() const
+        {
+            return (*this)[_size - 1];
+        }
+
+        //! std::size_t offset() const noexcept;
+        //!
+        //! \returns The position of the first element of the run within the
+        //!  range being traversed.
+        std::size_t offset() const EGGS_CXX11_NOEXCEPT
+        {
+            return _offset;
+        }
+
+    private:
+        RandomIt _first;
+        std::size_t _size;
+        std::size_t _offset;
+    };
+
+    namespace detail
+    {
+        template <typename RandomIt, std::size_t I>
+        struct _run_element
+        {
+            using type = typename std::remove_reference<decltype(
+                access::get(*std::declval<RandomIt>(), index<I>{}))>::type;
+        };
+
+        template <typename F, typename OutputIt>
+        struct _transform_runs_ctx
+        {
+            F& f;
+            OutputIt out;
+        };
+
+        template <typename RandomIt, typename F, typename OutputIt>
+        struct _transform_run
+        {
+            using ctx = _transform_runs_ctx<F, OutputIt>;
+
+            template <typename I>
+            static void call(
+                RandomIt const& run, std::size_t count,
+                std::size_t /*offset*/, ctx& c)
+            {
+                _call(run, count, c, I{});
+            }
+
+            static void _call(
+                RandomIt const& /*run*/, std::size_t /*count*/,
+                ctx& /*c*/, index<0>)
+            {
+                throw_bad_variant_access<void>();
+            }
+
+            template <std::size_t I>
+            static void _call(
+                RandomIt const& run, std::size_t count,
+                ctx& c, index<I>)
+            {
+                // kept in locals so that the loop does not reload them
+                // through `c` after every store
+                F& f = c.f;
+                OutputIt out = c.out;
+                for (std::size_t i = 0; i < count; ++i, ++out)
+                    *out = detail::_invoke(
+                        f, access::get(run[i], index<I - 1>{}));
+                c.out = out;
+            }
+        };
+
+        template <typename RandomIt, typename F>
+        struct _for_each_run_view
+        {
+            template <typename I>
+            static void call(
+                RandomIt const& run, std::size_t count,
+                std::size_t offset, F& f)
+            {
+                _call(run, count, offset, f, I{});
+            }
+
+            static void _call(
+                RandomIt const& /*run*/, std::size_t /*count*/,
+                std::size_t /*offset*/, F& /*f*/, index<0>)
+            {
+                throw_bad_variant_access<void>();
+            }
+
+            template <std::size_t I>
+            static void _call(
+                RandomIt const& run, std::size_t count,
+                std::size_t offset, F& f, index<I>)
+            {
+                using T = typename _run_element<RandomIt, I - 1>::type;
+                detail::_invoke(f, run_view<T, RandomIt>(run, count, offset));
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt, class OutputIt, class F>
+    //! OutputIt transform_runs(
+    //!     RandomIt first, RandomIt last, OutputIt out, F&& f);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>`. `*out =
+    //!  INVOKE(f, get<I>(*it))` shall be a valid expression for every
+    //!  iterator `it` in `[first, last)` and every `I` in the range `[0u,
+    //!  sizeof...(Ts))`.
+    //!
+    //! \effects For every `it` in `[first, last)` in order, assigns `INVOKE(f,
+    //!  get<I>(*it))` through `out` and increments it, where `I` is
+    //!  `it->which()`.
+    //!
+    //! \returns `out` past the last element written.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, in which case the elements that precede it have been
+    //!  written.
+    //!
+    //! \remarks The range is split into maximal runs of consecutive elements
+    //!  holding the same alternative, and each run is processed by a loop
+    //!  specialized for its type, in which the call to `f` can be inlined.
+    //!  There is a single indirect dispatch per run, rather than per element.
+    template <typename RandomIt, typename OutputIt, typename F>
+    OutputIt transform_runs(
+        RandomIt first, RandomIt last, OutputIt out, F&& f)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        detail::_transform_runs_ctx<fun, OutputIt> ctx = {f, out};
+        detail::for_each_run<detail::_transform_run<RandomIt, fun, OutputIt>>(
+            first, last, ctx);
+        return ctx.out;
+    }
+
+    //! template <class RandomIt, class F>
+    //! void for_each_run(RandomIt first, RandomIt last, F&& f);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>`. `INVOKE(f,
+    //!  run_view<T, RandomIt>(...))` shall be a valid expression for every
+    //!  `T` in `Ts...`, const qualified if `*first` is a const lvalue.
+    //!
+    //! \effects For every maximal run `[first + i, first + i + n)` of
+    //!  consecutive elements holding an alternative of type `T`, in order,
+    //!  evaluates `INVOKE(f, run_view<T, RandomIt>(first + i, n, i))`.
+    //!
+    //! \throws `bad_variant_access` if any element in `[first, last)` has no
+    //!  active member, in which case `f` has been invoked on all the runs
+    //!  that precede it.
+    //!
+    //! \remarks This is the batch form of `transform_runs`: `f` sees a whole
+    //!  run at once as a typed range, and can process it as such.
+    template <typename RandomIt, typename F>
+    void for_each_run(RandomIt first, RandomIt last, F&& f)
+    {
+        using fun = typename std::remove_reference<F>::type;
+        detail::for_each_run<detail::_for_each_run_view<RandomIt, fun>>(
+            first, last, f);
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_TRANSFORM_RUNS_HPP*/
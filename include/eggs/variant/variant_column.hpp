@@ -0,0 +1,497 @@
+//! \file eggs/variant/variant_column.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_VARIANT_COLUMN_HPP
+#define EGGS_VARIANT_VARIANT_COLUMN_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/in_place.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/storage.hpp>
+#include <eggs/variant/detail/tag_scan.hpp>
+#include <eggs/variant/detail/visitor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        template <std::size_t N>
+        struct _narrow_tag
+        {
+            using type = typename std::conditional<
+                N <= 0xFFu, std::uint8_t, std::uint16_t>::type;
+        };
+
+        template <typename Variant>
+        struct _make_variant
+        {
+            template <typename I>
+            static Variant call(void const* ptr)
+            {
+                return _make(ptr, I{});
+            }
+
+            static Variant _make(void const* /*ptr*/, index<0>)
+            {
+                return Variant();
+            }
+
+            template <std::size_t I>
+            static Variant _make(void const* ptr, index<I>)
+            {
+                using T = typename variant_element<I - 1, Variant>::type;
+                return Variant(in_place<I - 1>, *static_cast<T const*>(ptr));
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class variant_column;
+    //!
+    //! A `variant_column` is a sequence container of `variant<Ts...>` values
+    //! stored in two parallel arrays: one of narrow discriminators, and one of
+    //! payload slots. A scan that only looks at which alternative each element
+    //! holds, such as `count`, walks the discriminator array alone, touching
+    //! one or two bytes per element rather than a full `variant`.
+    //!
+    //! Elements are accessed through proxy references, which provide the
+    //! `which`/`target` interface of `variant` and convert to and from it.
+    //!
+    //! \requires Every `T` in `Ts...` shall be a complete object type that
+    //!  is `CopyConstructible` and `MoveConstructible`; `sizeof...(Ts)` shall
+    //!  be less than `65535`.
+    template <typename ...Ts>
+    class variant_column
+    {
+        static_assert(sizeof...(Ts) != 0,
+            "variant_column requires at least one alternative");
+        static_assert(sizeof...(Ts) < 0xFFFFu,
+            "variant_column discriminators must fit in 16 bits");
+
+        using _alternatives = detail::pack<detail::empty, Ts...>;
+        using _slot = typename detail::aligned_union<0, Ts...>::type;
+
+        template <bool IsConst>
+        class _reference;
+
+    public:
+        //! using tag_type = unspecified;
+        //!
+        //! The narrowest unsigned integral type that can hold `which() + 1`
+        //! for every alternative; a tag of `0` denotes an element with no
+        //! active member.
+        using tag_type = typename detail::_narrow_tag<sizeof...(Ts) + 1>::type;
+
+        using value_type = variant<Ts...>;
+        using size_type = std::size_t;
+        using reference = _reference<false>;
+        using const_reference = _reference<true>;
+
+    public:
+        //! variant_column() noexcept;
+        //!
+        //! \postconditions `size() == 0`.
+        variant_column() EGGS_CXX11_NOEXCEPT
+          : _tags(), _slots(nullptr), _capacity(0)
+        {}
+
+        //! variant_column(variant_column const& rhs);
+        //!
+        //! \effects Copies the elements of `rhs`.
+        variant_column(variant_column const& rhs)
+          : variant_column()
+        {
+            reserve(rhs.size());
+            for (std::size_t i = 0; i < rhs.size(); ++i)
+                _push_back(rhs._tags[i], &rhs._slots[i]);
+        }
+
+        //! variant_column(variant_column&& rhs) noexcept;
+        //!
+        //! \postconditions `rhs.empty() == true`.
+        variant_column(variant_column&& rhs) EGGS_CXX11_NOEXCEPT
+          : _tags(std::move(rhs._tags))
+          , _slots(rhs._slots)
+          , _capacity(rhs._capacity)
+        {
+            rhs._tags.clear();
+            rhs._slots = nullptr;
+            rhs._capacity = 0;
+        }
+
+        variant_column& operator=(variant_column const& rhs)
+        {
+            variant_column(rhs).swap(*this);
+            return *this;
+        }
+
+        variant_column& operator=(variant_column&& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            variant_column(std::move(rhs)).swap(*this);
+            return *this;
+        }
+
+        //! ~variant_column();
+        //!
+        //! \effects Destroys the elements and releases the storage.
+        ~variant_column()
+        {
+            clear();
+            delete[] _slots;
+        }
+
+        void swap(variant_column& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            _tags.swap(rhs._tags);
+            std::swap(_slots, rhs._slots);
+            std::swap(_capacity, rhs._capacity);
+        }
+
+        std::size_t size() const EGGS_CXX11_NOEXCEPT
+        {
+            return _tags.size();
+        }
+
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return _tags.empty();
+        }
+
+        std::size_t capacity() const EGGS_CXX11_NOEXCEPT
+        {
+            return _capacity;
+        }
+
+        //! void reserve(std::size_t n);
+        //!
+        //! \effects Ensures `capacity() >= n`, move constructing the elements
+        //!  into new storage if necessary.
+        //!
+        //! \remarks If an exception is thrown there are no effects.
+        void reserve(std::size_t n)
+        {
+            if (n <= _capacity)
+                return;
+
+            _tags.reserve(n);
+            _slot* const slots = new _slot[n];
+            std::size_t i = 0;
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+#endif
+                for (; i < size(); ++i)
+                {
+                    detail::move_construct{}(_alternatives{}, _tags[i],
+                        &slots[i], &_slots[i]);
+                }
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            } catch (...) {
+                while (i-- > 0)
+                    detail::destroy{}(_alternatives{}, _tags[i], &slots[i]);
+                delete[] slots;
+                throw;
+            }
+#endif
+            for (i = 0; i < size(); ++i)
+                detail::destroy{}(_alternatives{}, _tags[i], &_slots[i]);
+            delete[] _slots;
+            _slots = slots;
+            _capacity = n;
+        }
+
+        //! void push_back(variant<Ts...> const& v);
+        //!
+        //! \effects Appends a copy of `v`.
+        void push_back(variant<Ts...> const& v)
+        {
+            _push_back(
+                static_cast<tag_type>(detail::access::storage(v).which()),
+                detail::access::storage(v).target());
+        }
+
+        //! void push_back(variant<Ts...>&& v);
+        //!
+        //! \effects Appends `v`, move constructed.
+        void push_back(variant<Ts...>&& v)
+        {
+            _grow();
+            std::size_t const which = detail::access::storage(v).which();
+            detail::move_construct{}(_alternatives{}, which,
+                &_slots[size()], detail::access::storage(v).target());
+            _tags.push_back(static_cast<tag_type>(which));
+        }
+
+        //! void pop_back();
+        //!
+        //! \requires `empty() == false`.
+        //!
+        //! \effects Destroys the last element.
+        void pop_back() EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const i = size() - 1;
+            detail::destroy{}(_alternatives{}, _tags[i], &_slots[i]);
+            _tags.pop_back();
+        }
+
+        //! void clear() noexcept;
+        //!
+        //! \effects Destroys all elements.
+        void clear() EGGS_CXX11_NOEXCEPT
+        {
+            for (std::size_t i = 0; i < size(); ++i)
+                detail::destroy{}(_alternatives{}, _tags[i], &_slots[i]);
+            _tags.clear();
+        }
+
+        //! reference operator[](std::size_t i) noexcept;
+        //!
+        //! \requires `i < size()`.
+        //!
+        //! \returns A proxy reference to the `i`-th element.
+        reference operator[](std::size_t i) EGGS_CXX11_NOEXCEPT
+        {
+            return reference(this, i);
+        }
+
+        const_reference operator[](std::size_t i) const EGGS_CXX11_NOEXCEPT
+        {
+            return const_reference(this, i);
+        }
+
+        //! tag_type const* tags() const noexcept;
+        //!
+        //! \returns A pointer to the contiguous array of the `size()`
+        //!  discriminators, where the `i`-th one is `(*this)[i].which() + 1`
+        //!  if the `i`-th element has an active member, and `0` otherwise.
+        tag_type const* tags() const EGGS_CXX11_NOEXCEPT
+        {
+            return _tags.data();
+        }
+
+        //! std::size_t which(std::size_t i) const noexcept;
+        //!
+        //! \returns `(*this)[i].which()`.
+        std::size_t which(std::size_t i) const EGGS_CXX11_NOEXCEPT
+        {
+            return _tags[i] != 0 ? std::size_t(_tags[i] - 1) : value_type::npos;
+        }
+
+        //! std::size_t count(std::size_t which) const noexcept;
+        //!
+        //! \returns The number of elements whose active member has the index
+        //!  `which`, or that have no active member if `which == npos`.
+        //!
+        //! \remarks Only the discriminator array is accessed.
+        std::size_t count(std::size_t which) const EGGS_CXX11_NOEXCEPT
+        {
+            return detail::count_eq(
+                _tags.data(), _tags.size(), static_cast<tag_type>(which + 1));
+        }
+
+        //! template <class T>
+        //! std::size_t count() const noexcept;
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \returns The number of elements with an active member of type `T`.
+        template <typename T>
+        std::size_t count() const EGGS_CXX11_NOEXCEPT
+        {
+            return count(detail::index_of<T, detail::pack<Ts...>>::value);
+        }
+
+        //! template <class T, class F>
+        //! void for_each(F&& f);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects For each element with an active member `m` of type `T`,
+        //!  in order, evaluates `INVOKE(f, m)`.
+        //!
+        //! \remarks Payload slots of other elements are not accessed.
+        template <typename T, typename F>
+        void for_each(F&& f)
+        {
+            _for_each<T>(*this, f);
+        }
+
+        template <typename T, typename F>
+        void for_each(F&& f) const
+        {
+            _for_each<T>(*this, f);
+        }
+
+    private:
+        template <bool IsConst>
+        class _reference
+        {
+            friend class variant_column;
+
+            using column = typename std::conditional<
+                IsConst, variant_column const, variant_column>::type;
+
+            template <typename T>
+            using pointer = typename std::conditional<
+                IsConst, T const*, T*>::type;
+
+        public:
+            _reference(_reference const&) = default;
+
+            //! std::size_t which() const noexcept;
+            //!
+            //! \returns The zero-based index of the active member of the
+            //!  referenced element if it has one. Otherwise, returns `npos`.
+            std::size_t which() const EGGS_CXX11_NOEXCEPT
+            {
+                return _column->which(_index);
+            }
+
+            explicit operator bool() const EGGS_CXX11_NOEXCEPT
+            {
+                return _column->_tags[_index] != 0;
+            }
+
+            //! template <class T>
+            //! T* target() const noexcept;
+            //!
+            //! \requires `T` shall occur exactly once in `Ts...`.
+            //!
+            //! \returns If the referenced element has an active member of
+            //!  type `T`, a pointer to it; otherwise, a null pointer.
+            template <typename T>
+            pointer<T> target() const EGGS_CXX11_NOEXCEPT
+            {
+                using I = detail::index_of<T, _alternatives>;
+                return _column->_tags[_index] == I::value
+                  ? reinterpret_cast<pointer<T>>(&_column->_slots[_index])
+                  : nullptr;
+            }
+
+            //! operator variant<Ts...>() const;
+            //!
+            //! \returns A copy of the referenced element.
+            operator variant<Ts...>() const
+            {
+                return detail::visitor<
+                    detail::_make_variant<variant<Ts...>>
+                  , variant<Ts...>(void const*)
+                >{}(detail::typed_index_pack<_alternatives>{},
+                    _column->_tags[_index], &_column->_slots[_index]);
+            }
+
+            //! reference const& operator=(variant<Ts...> const& v) const;
+            //!
+            //! \requires `IsConst` is `false`.
+            //!
+            //! \effects Destroys the referenced element and replaces it with
+            //!  a copy of `v`. If an exception is thrown, the referenced
+            //!  element has no active member.
+            _reference const& operator=(variant<Ts...> const& v) const
+            {
+                static_assert(!IsConst, "cannot assign through const_reference");
+
+                tag_type& tag = _column->_tags[_index];
+                detail::destroy{}(_alternatives{}, tag, &_column->_slots[_index]);
+                tag = 0;
+
+                std::size_t const which = detail::access::storage(v).which();
+                detail::copy_construct{}(_alternatives{}, which,
+                    &_column->_slots[_index],
+                    detail::access::storage(v).target());
+                tag = static_cast<tag_type>(which);
+                return *this;
+            }
+
+            _reference const& operator=(_reference const& rhs) const
+            {
+                return *this = static_cast<variant<Ts...>>(rhs);
+            }
+
+            friend bool operator==(_reference const& lhs, variant<Ts...> const& rhs)
+            {
+                return static_cast<variant<Ts...>>(lhs) == rhs;
+            }
+
+            friend bool operator!=(_reference const& lhs, variant<Ts...> const& rhs)
+            {
+                return !(lhs == rhs);
+            }
+
+        private:
+            _reference(column* c, std::size_t i) EGGS_CXX11_NOEXCEPT
+              : _column(c), _index(i)
+            {}
+
+            column* _column;
+            std::size_t _index;
+        };
+
+        void _grow()
+        {
+            if (size() == _capacity)
+                reserve(_capacity == 0 ? 8 : _capacity * 2);
+        }
+
+        void _push_back(tag_type tag, void const* ptr)
+        {
+            _grow();
+            detail::copy_construct{}(_alternatives{}, tag,
+                &_slots[size()], static_cast<void const*>(ptr));
+            _tags.push_back(tag);
+        }
+
+        template <typename T, typename Self, typename F>
+        static void _for_each(Self& self, F& f)
+        {
+            using I = detail::index_of<T, _alternatives>;
+            using pointer = typename std::conditional<
+                std::is_const<Self>::value, T const*, T*>::type;
+
+            tag_type const tag = static_cast<tag_type>(I::value);
+            for (std::size_t i = 0; i < self.size(); ++i)
+            {
+                if (self._tags[i] == tag)
+                {
+                    detail::_invoke(f,
+                        *reinterpret_cast<pointer>(&self._slots[i]));
+                }
+            }
+        }
+
+    private:
+        std::vector<tag_type> _tags;
+        _slot* _slots;
+        std::size_t _capacity;
+    };
+
+    //! template <class ...Ts>
+    //! void swap(variant_column<Ts...>& x, variant_column<Ts...>& y) noexcept;
+    //!
+    //! \effects Calls `x.swap(y)`.
+    template <typename ...Ts>
+    void swap(variant_column<Ts...>& x, variant_column<Ts...>& y)
+        EGGS_CXX11_NOEXCEPT
+    {
+        x.swap(y);
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_VARIANT_COLUMN_HPP*/
@@ -0,0 +1,661 @@
+//! \file eggs/variant/variant_queue.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_VARIANT_QUEUE_HPP
+#define EGGS_VARIANT_VARIANT_QUEUE_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/concurrency.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        inline std::size_t _queue_capacity(std::size_t capacity)
+            EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t rounded = 1;
+            while (rounded < capacity)
+                rounded *= 2;
+            return rounded;
+        }
+
+        // Consumes the message in `slot` by passing it to `f` as an rvalue,
+        // then destroys it; the slot is left empty even if `f` throws.
+        template <typename F, typename ...Ts>
+        void _queue_consume(F& f, variant<Ts...>& slot)
+        {
+            struct reset
+            {
+                variant<Ts...>& slot;
+
+                ~reset()
+                {
+                    access::storage(slot).emplace(index<0>{});
+                }
+            } const guard = {slot};
+
+            ::eggs::variants::apply<void>(f, std::move(slot));
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class spsc_queue;
+    //!
+    //! A `spsc_queue<Ts...>` is a bounded, lock-free queue of `variant<Ts...>`
+    //! messages between a single producer thread and a single consumer
+    //! thread. Messages are constructed in place into a ring of slots by
+    //! `try_emplace`, and visited in place by `consume`, so that a message
+    //! is neither moved nor copied on its way through the queue.
+    //!
+    //! The index written by the producer and the one written by the consumer
+    //! live in different cache lines, next to a cached copy of the other
+    //! side's index, so that each side only reads the other's line when its
+    //! cached copy says the queue is full or empty.
+    //!
+    //! \remarks Producer operations, `try_emplace`, `emplace` and `try_push`,
+    //!  shall not be called concurrently with each other; neither shall
+    //!  consumer operations, `consume`.
+    template <typename ...Ts>
+    class spsc_queue
+    {
+        static_assert(sizeof...(Ts) > 0, "spsc_queue requires alternatives");
+
+    public:
+        using value_type = variant<Ts...>;
+
+    public:
+        //! explicit spsc_queue(std::size_t capacity);
+        //!
+        //! \effects Initializes an empty queue that holds up to `capacity`
+        //!  messages, rounded up to a power of 2.
+        //!
+        //! \throws `std::bad_alloc` if memory for the slots cannot be
+        //!  obtained.
+        explicit spsc_queue(std::size_t capacity)
+          : _capacity(detail::_queue_capacity(capacity))
+          , _slots(new value_type[_capacity])
+          , _tail(0), _cached_head(0)
+          , _head(0), _cached_tail(0)
+        {}
+
+        spsc_queue(spsc_queue const&) = delete;
+        spsc_queue& operator=(spsc_queue const&) = delete;
+
+        //! template <std::size_t I, class ...Args>
+        //! bool try_emplace(Args&&... args);
+        //!
+        //! \requires `I < sizeof...(Ts)`.
+        //!
+        //! \effects If the queue is not full, constructs a message whose
+        //!  active member is the `I`th element of `Ts...` directly in the
+        //!  next slot, as if by `emplace<I>(std::forward<Args>(args)...)`,
+        //!  and publishes it to the consumer.
+        //!
+        //! \returns `true` if the message was enqueued.
+        //!
+        //! \throws Any exception thrown by the selected constructor, in which
+        //!  case nothing is enqueued.
+        template <std::size_t I, typename ...Args>
+        bool try_emplace(Args&&... args)
+        {
+            value_type* const slot = _claim();
+            if (slot == nullptr)
+                return false;
+
+            slot->template emplace<I>(std::forward<Args>(args)...);
+            _publish();
+            return true;
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! bool try_emplace(Args&&... args);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Equivalent to `try_emplace<I>(std::forward<Args>(
+        //!  args)...)` where `I` is the zero-based index of `T` in `Ts...`.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        bool try_emplace(Args&&... args)
+        {
+            return try_emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace<I>(std::forward<Args>(
+        //!  args)...)`, spinning while the queue is full.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            value_type* slot;
+            while ((slot = _claim()) == nullptr)
+                detail::_spin_pause();
+
+            slot->template emplace<I>(std::forward<Args>(args)...);
+            _publish();
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace<T>(std::forward<Args>(
+        //!  args)...)`, spinning while the queue is full.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        void emplace(Args&&... args)
+        {
+            emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! template <class V>
+        //! bool try_push(V&& v);
+        //!
+        //! \requires `std::decay_t<V>` shall be the type `variant<Ts...>`,
+        //!  and `v` shall have an active member.
+        //!
+        //! \effects If the queue is not full, enqueues a copy of `v`, or a
+        //!  move if `v` is an rvalue.
+        //!
+        //! \returns `true` if the message was enqueued.
+        template <typename V>
+        bool try_push(V&& v)
+        {
+            value_type* const slot = _claim();
+            if (slot == nullptr)
+                return false;
+
+            *slot = std::forward<V>(v);
+            _publish();
+            return true;
+        }
+
+        //! template <class F>
+        //! bool consume(F&& f);
+        //!
+        //! \requires `INVOKE(f, get<I>(std::move(m)))` shall be a valid
+        //!  expression for every `I` in the range `[0u, sizeof...(Ts))`,
+        //!  where `m` is a message.
+        //!
+        //! \effects If the queue is not empty, evaluates `INVOKE(f, get<I>(
+        //!  std::move(m)))` on the oldest message `m` in place, where `I` is
+        //!  `m.which()`, then destroys and dequeues it.
+        //!
+        //! \returns `true` if a message was consumed.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the message is
+        //!  dequeued nevertheless.
+        template <typename F>
+        bool consume(F&& f)
+        {
+            return consume(f, 1) != 0;
+        }
+
+        //! template <class F>
+        //! std::size_t consume(F&& f, std::size_t max);
+        //!
+        //! \effects Consumes, as by `consume(f)`, up to `max` messages that
+        //!  are in the queue on entry.
+        //!
+        //! \returns The number of messages consumed.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the messages
+        //!  consumed until then, including the one for which `f` threw, are
+        //!  dequeued.
+        //!
+        //! \remarks The index of the producer is read once, and the index of
+        //!  the consumer is published once, for the whole batch.
+        template <typename F>
+        std::size_t consume(F&& f, std::size_t max)
+        {
+            std::size_t const head = _head.load(std::memory_order_relaxed);
+            if (_cached_tail - head < max)
+            {
+                _cached_tail = _tail.load(std::memory_order_acquire);
+                if (_cached_tail == head)
+                    return 0;
+            }
+
+            std::size_t const count =
+                _cached_tail - head < max ? _cached_tail - head : max;
+
+            struct publish
+            {
+                std::atomic<std::size_t>& head;
+                std::size_t position;
+
+                ~publish()
+                {
+                    head.store(position, std::memory_order_release);
+                }
+            } guard = {_head, head};
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                ++guard.position;
+                detail::_queue_consume(f, _slots[(head + i) & (_capacity - 1)]);
+            }
+            return count;
+        }
+
+        //! template <class F>
+        //! std::size_t consume_all(F&& f);
+        //!
+        //! \effects Equivalent to `consume(f, std::numeric_limits<
+        //!  std::size_t>::max())`.
+        template <typename F>
+        std::size_t consume_all(F&& f)
+        {
+            return consume(f, (std::numeric_limits<std::size_t>::max)());
+        }
+
+        //! std::size_t capacity() const noexcept;
+        //!
+        //! \returns The maximum number of messages in the queue.
+        std::size_t capacity() const EGGS_CXX11_NOEXCEPT
+        {
+            return _capacity;
+        }
+
+        //! std::size_t size_approx() const noexcept;
+        //!
+        //! \returns The number of messages in the queue at some point during
+        //!  the call. It is exact when called by either side while the other
+        //!  side is idle.
+        std::size_t size_approx() const EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const head = _head.load(std::memory_order_acquire);
+            std::size_t const tail = _tail.load(std::memory_order_acquire);
+            return tail - head;
+        }
+
+        //! bool empty() const noexcept;
+        //!
+        //! \returns `size_approx() == 0`.
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return size_approx() == 0;
+        }
+
+    private:
+        // Returns the slot for the next message, or `nullptr` if the queue
+        // is full; the slot is not visible to the consumer until `_publish`.
+        value_type* _claim() EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _cached_head == _capacity)
+            {
+                _cached_head = _head.load(std::memory_order_acquire);
+                if (tail - _cached_head == _capacity)
+                    return nullptr;
+            }
+            return &_slots[tail & (_capacity - 1)];
+        }
+
+        void _publish() EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const tail = _tail.load(std::memory_order_relaxed);
+            _tail.store(tail + 1, std::memory_order_release);
+        }
+
+    private:
+        // read-only after construction
+        std::size_t const _capacity;
+        std::unique_ptr<value_type[]> _slots;
+        char _padding0[detail::_cache_line_size];
+
+        // written by the producer
+        std::atomic<std::size_t> _tail;
+        std::size_t _cached_head;
+        char _padding1[detail::_cache_line_size];
+
+        // written by the consumer
+        std::atomic<std::size_t> _head;
+        std::size_t _cached_tail;
+        char _padding2[detail::_cache_line_size];
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class mpsc_queue;
+    //!
+    //! A `mpsc_queue<Ts...>` is a bounded queue of `variant<Ts...>` messages
+    //! from any number of producer threads to a single consumer thread, with
+    //! the same interface as `spsc_queue<Ts...>`.
+    //!
+    //! Each slot carries a sequence number that tells whose turn it is.
+    //! Producers claim slots with a compare-and-swap on the shared tail
+    //! index, then construct the message in place and hand the slot over by
+    //! advancing its sequence number; the consumer never touches the tail
+    //! index, and hands slots back the same way.
+    //!
+    //! \remarks A producer that has claimed a slot but not yet published it
+    //!  holds back the messages enqueued after it, but not other producers.
+    //!
+    //! \remarks Consumer operations, `consume`, shall not be called
+    //!  concurrently with each other.
+    template <typename ...Ts>
+    class mpsc_queue
+    {
+        static_assert(sizeof...(Ts) > 0, "mpsc_queue requires alternatives");
+
+        struct _slot
+        {
+            std::atomic<std::size_t> sequence;
+            variant<Ts...> value;
+        };
+
+    public:
+        using value_type = variant<Ts...>;
+
+    public:
+        //! explicit mpsc_queue(std::size_t capacity);
+        //!
+        //! \effects Initializes an empty queue that holds up to `capacity`
+        //!  messages, rounded up to a power of 2.
+        //!
+        //! \throws `std::bad_alloc` if memory for the slots cannot be
+        //!  obtained.
+        explicit mpsc_queue(std::size_t capacity)
+          : _capacity(detail::_queue_capacity(capacity))
+          , _slots(new _slot[_capacity])
+          , _tail(0), _head(0)
+        {
+            for (std::size_t i = 0; i < _capacity; ++i)
+                _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpsc_queue(mpsc_queue const&) = delete;
+        mpsc_queue& operator=(mpsc_queue const&) = delete;
+
+        //! template <std::size_t I, class ...Args>
+        //! bool try_emplace(Args&&... args);
+        //!
+        //! \requires `I < sizeof...(Ts)`.
+        //!
+        //! \effects If the queue is not full, claims the next slot and
+        //!  constructs a message whose active member is the `I`th element of
+        //!  `Ts...` directly in it, as if by `emplace<I>(std::forward<Args>(
+        //!  args)...)`, then publishes it to the consumer.
+        //!
+        //! \returns `true` if the message was enqueued.
+        //!
+        //! \throws Any exception thrown by the selected constructor, in which
+        //!  case the claimed slot is published with no active member and is
+        //!  skipped by the consumer.
+        template <std::size_t I, typename ...Args>
+        bool try_emplace(Args&&... args)
+        {
+            _slot* const slot = _claim();
+            if (slot == nullptr)
+                return false;
+
+            _publish_guard guard = {slot};
+            slot->value.template emplace<I>(std::forward<Args>(args)...);
+            return true;
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! bool try_emplace(Args&&... args);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Equivalent to `try_emplace<I>(std::forward<Args>(
+        //!  args)...)` where `I` is the zero-based index of `T` in `Ts...`.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        bool try_emplace(Args&&... args)
+        {
+            return try_emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! template <std::size_t I, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace<I>(std::forward<Args>(
+        //!  args)...)`, spinning while the queue is full.
+        template <std::size_t I, typename ...Args>
+        void emplace(Args&&... args)
+        {
+            _slot* slot;
+            while ((slot = _claim()) == nullptr)
+                detail::_spin_pause();
+
+            _publish_guard guard = {slot};
+            slot->value.template emplace<I>(std::forward<Args>(args)...);
+        }
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        //! template <class T, class ...Args>
+        //! void emplace(Args&&... args);
+        //!
+        //! \effects Equivalent to `try_emplace<T>(std::forward<Args>(
+        //!  args)...)`, spinning while the queue is full.
+        template <
+            typename T, typename ...Args
+          , std::size_t I = detail::index_of<T, detail::pack<Ts...>>::value
+        >
+        void emplace(Args&&... args)
+        {
+            emplace<I>(std::forward<Args>(args)...);
+        }
+#endif
+
+        //! template <class V>
+        //! bool try_push(V&& v);
+        //!
+        //! \requires `std::decay_t<V>` shall be the type `variant<Ts...>`,
+        //!  and `v` shall have an active member.
+        //!
+        //! \effects If the queue is not full, enqueues a copy of `v`, or a
+        //!  move if `v` is an rvalue.
+        //!
+        //! \returns `true` if the message was enqueued.
+        template <typename V>
+        bool try_push(V&& v)
+        {
+            _slot* const slot = _claim();
+            if (slot == nullptr)
+                return false;
+
+            _publish_guard guard = {slot};
+            slot->value = std::forward<V>(v);
+            return true;
+        }
+
+        //! template <class F>
+        //! bool consume(F&& f);
+        //!
+        //! \requires `INVOKE(f, get<I>(std::move(m)))` shall be a valid
+        //!  expression for every `I` in the range `[0u, sizeof...(Ts))`,
+        //!  where `m` is a message.
+        //!
+        //! \effects If a message is ready, evaluates `INVOKE(f, get<I>(
+        //!  std::move(m)))` on the oldest message `m` in place, where `I` is
+        //!  `m.which()`, then destroys and dequeues it.
+        //!
+        //! \returns `true` if a message was consumed.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the message is
+        //!  dequeued nevertheless.
+        template <typename F>
+        bool consume(F&& f)
+        {
+            return consume(f, 1) != 0;
+        }
+
+        //! template <class F>
+        //! std::size_t consume(F&& f, std::size_t max);
+        //!
+        //! \effects Consumes, as by `consume(f)`, up to `max` messages that
+        //!  are ready in order.
+        //!
+        //! \returns The number of messages consumed.
+        //!
+        //! \throws Any exception thrown by `f`, in which case the messages
+        //!  consumed until then, including the one for which `f` threw, are
+        //!  dequeued.
+        template <typename F>
+        std::size_t consume(F&& f, std::size_t max)
+        {
+            std::size_t head = _head.load(std::memory_order_relaxed);
+            std::size_t count = 0;
+            while (count < max)
+            {
+                _slot& slot = _slots[head & (_capacity - 1)];
+                if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+                    break;
+
+                struct release
+                {
+                    mpsc_queue& queue;
+                    _slot& slot;
+                    std::size_t head;
+
+                    ~release()
+                    {
+                        slot.sequence.store(
+                            head + queue._capacity, std::memory_order_release);
+                        queue._head.store(
+                            head + 1, std::memory_order_relaxed);
+                    }
+                } const guard = {*this, slot, head};
+
+                ++head;
+                if (slot.value.which() != value_type::npos)
+                {
+                    ++count;
+                    detail::_queue_consume(f, slot.value);
+                }
+            }
+            return count;
+        }
+
+        //! template <class F>
+        //! std::size_t consume_all(F&& f);
+        //!
+        //! \effects Equivalent to `consume(f, std::numeric_limits<
+        //!  std::size_t>::max())`.
+        template <typename F>
+        std::size_t consume_all(F&& f)
+        {
+            return consume(f, (std::numeric_limits<std::size_t>::max)());
+        }
+
+        //! std::size_t capacity() const noexcept;
+        //!
+        //! \returns The maximum number of messages in the queue.
+        std::size_t capacity() const EGGS_CXX11_NOEXCEPT
+        {
+            return _capacity;
+        }
+
+        //! std::size_t size_approx() const noexcept;
+        //!
+        //! \returns The number of slots claimed by producers and not yet
+        //!  consumed, at some point during the call.
+        std::size_t size_approx() const EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t const head = _head.load(std::memory_order_acquire);
+            std::size_t const tail = _tail.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        //! bool empty() const noexcept;
+        //!
+        //! \returns `size_approx() == 0`.
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return size_approx() == 0;
+        }
+
+    private:
+        // Claims the slot for the next message, or returns `nullptr` if the
+        // queue is full.
+        _slot* _claim() EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t tail = _tail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                _slot& slot = _slots[tail & (_capacity - 1)];
+                std::size_t const sequence =
+                    slot.sequence.load(std::memory_order_acquire);
+
+                if (sequence == tail)
+                {
+                    if (_tail.compare_exchange_weak(
+                            tail, tail + 1, std::memory_order_relaxed))
+                        return &slot;
+                } else if (sequence < tail) {
+                    // the consumer has yet to release the slot from the
+                    // previous lap
+                    return nullptr;
+                } else {
+                    tail = _tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Hands a claimed slot over to the consumer, whether construction
+        // succeeded or not.
+        struct _publish_guard
+        {
+            _slot* slot;
+
+            ~_publish_guard()
+            {
+                std::size_t const sequence =
+                    slot->sequence.load(std::memory_order_relaxed);
+                slot->sequence.store(sequence + 1, std::memory_order_release);
+            }
+        };
+
+    private:
+        // read-only after construction
+        std::size_t const _capacity;
+        std::unique_ptr<_slot[]> _slots;
+        char _padding0[detail::_cache_line_size];
+
+        // written by producers
+        std::atomic<std::size_t> _tail;
+        char _padding1[detail::_cache_line_size];
+
+        // written by the consumer
+        std::atomic<std::size_t> _head;
+        char _padding2[detail::_cache_line_size];
+    };
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_VARIANT_QUEUE_HPP*/
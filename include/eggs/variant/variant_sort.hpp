@@ -0,0 +1,294 @@
+//! \file eggs/variant/variant_sort.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_VARIANT_SORT_HPP
+#define EGGS_VARIANT_VARIANT_SORT_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/transform_runs.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/visitor.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Maps the values of an arithmetic type `T` to unsigned integers of
+        // the same size whose order matches `operator<` on `T`; `radix` is
+        // `false` for the types that have no such mapping.
+        template <typename T, typename Enable = void>
+        struct _radix_key
+        {
+            EGGS_CXX11_STATIC_CONSTEXPR bool radix = false;
+        };
+
+        template <std::size_t Size>
+        struct _unsigned_of_size;
+
+        template <> struct _unsigned_of_size<1> { using type = std::uint8_t; };
+        template <> struct _unsigned_of_size<2> { using type = std::uint16_t; };
+        template <> struct _unsigned_of_size<4> { using type = std::uint32_t; };
+        template <> struct _unsigned_of_size<8> { using type = std::uint64_t; };
+
+        template <typename T>
+        struct _radix_key<T, typename std::enable_if<
+            std::is_integral<T>::value && sizeof(T) <= 8>::type>
+        {
+            EGGS_CXX11_STATIC_CONSTEXPR bool radix = true;
+
+            using type = typename _unsigned_of_size<sizeof(T)>::type;
+
+            EGGS_CXX11_STATIC_CONSTEXPR type flip = std::is_signed<T>::value
+              ? type(type(1) << (sizeof(T) * 8 - 1)) : type(0);
+
+            static type encode(T v) EGGS_CXX11_NOEXCEPT
+            {
+                type k;
+                std::memcpy(&k, &v, sizeof(T));
+                return type(k ^ flip);
+            }
+
+            static T decode(type k) EGGS_CXX11_NOEXCEPT
+            {
+                k = type(k ^ flip);
+                T v;
+                std::memcpy(&v, &k, sizeof(T));
+                return v;
+            }
+        };
+
+        template <typename T>
+        struct _radix_key<T, typename std::enable_if<
+            std::is_floating_point<T>::value
+         && std::numeric_limits<T>::is_iec559
+         && (sizeof(T) == 4 || sizeof(T) == 8)>::type>
+        {
+            EGGS_CXX11_STATIC_CONSTEXPR bool radix = true;
+
+            using type = typename _unsigned_of_size<sizeof(T)>::type;
+
+            EGGS_CXX11_STATIC_CONSTEXPR type sign =
+                type(type(1) << (sizeof(T) * 8 - 1));
+
+            // negative values have all their bits flipped so that larger
+            // magnitudes sort first, non-negative ones only the sign bit
+            static type encode(T v) EGGS_CXX11_NOEXCEPT
+            {
+                type k;
+                std::memcpy(&k, &v, sizeof(T));
+                return (k & sign) != 0 ? type(~k) : type(k | sign);
+            }
+
+            static T decode(type k) EGGS_CXX11_NOEXCEPT
+            {
+                k = (k & sign) != 0 ? type(k & ~sign) : type(~k);
+                T v;
+                std::memcpy(&v, &k, sizeof(T));
+                return v;
+            }
+        };
+
+        // Least significant digit first radix sort on 11-bit digits. The
+        // histograms for every digit are built in a single pass, and digits
+        // shared by every key are skipped.
+        template <typename U>
+        void _radix_sort(std::vector<U>& keys, std::vector<U>& buffer)
+        {
+            EGGS_CXX11_CONSTEXPR std::size_t bits = 11;
+            EGGS_CXX11_CONSTEXPR std::size_t radix = std::size_t(1) << bits;
+            EGGS_CXX11_CONSTEXPR std::size_t digits =
+                (sizeof(U) * 8 + bits - 1) / bits;
+
+            std::size_t const n = keys.size();
+            buffer.resize(n);
+
+            std::vector<std::size_t> histograms(digits * radix);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                U const k = keys[i];
+                for (std::size_t d = 0; d < digits; ++d)
+                    ++histograms[d * radix + ((k >> (d * bits)) & (radix - 1))];
+            }
+
+            for (std::size_t d = 0; d < digits; ++d)
+            {
+                std::size_t* const counts = &histograms[d * radix];
+                std::size_t const shift = d * bits;
+                if (counts[(keys[0] >> shift) & (radix - 1)] == n)
+                    continue;
+
+                std::size_t offset = 0;
+                for (std::size_t b = 0; b < radix; ++b)
+                {
+                    std::size_t const c = counts[b];
+                    counts[b] = offset;
+                    offset += c;
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    U const k = keys[i];
+                    buffer[counts[(k >> shift) & (radix - 1)]++] = k;
+                }
+                keys.swap(buffer);
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        template <typename RandomIt>
+        struct _sort_bucket
+        {
+            EGGS_CXX11_STATIC_CONSTEXPR std::size_t radix_threshold = 256;
+
+            template <typename I>
+            static void call(RandomIt const& first, std::size_t count)
+            {
+                _call(first, count, I{});
+            }
+
+            // empty elements are all equivalent
+            static void _call(
+                RandomIt const& /*first*/, std::size_t /*count*/, index<0>)
+            {}
+
+            template <std::size_t I>
+            static void _call(
+                RandomIt const& first, std::size_t count, index<I>)
+            {
+                using T = typename _run_element<RandomIt, I - 1>::type;
+                run_view<T, RandomIt> const bucket(first, count, 0);
+
+                _sort(bucket,
+                    std::integral_constant<bool, _radix_key<
+                        typename std::remove_cv<T>::type>::radix>{});
+            }
+
+            template <typename T>
+            static void _sort(
+                run_view<T, RandomIt> const& bucket, std::false_type)
+            {
+                std::sort(bucket.begin(), bucket.end());
+            }
+
+            // arithmetic values are their own identity, so they are sorted
+            // as bare keys and written back rather than moved around
+            template <typename T>
+            static void _sort(
+                run_view<T, RandomIt> const& bucket, std::true_type)
+            {
+                using key = _radix_key<T>;
+                using U = typename key::type;
+
+                std::vector<U> keys(bucket.size());
+                for (std::size_t i = 0; i < bucket.size(); ++i)
+                    keys[i] = key::encode(bucket[i]);
+
+                if (keys.size() < radix_threshold)
+                {
+                    std::sort(keys.begin(), keys.end());
+                } else {
+                    std::vector<U> buffer;
+                    _radix_sort(keys, buffer);
+                }
+
+                for (std::size_t i = 0; i < bucket.size(); ++i)
+                    bucket[i] = key::decode(keys[i]);
+            }
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class RandomIt>
+    //! void variant_sort(RandomIt first, RandomIt last);
+    //!
+    //! \requires `RandomIt` shall satisfy the requirements of random access
+    //!  iterators, and its value type shall be `variant<Ts...>`. Every `T` in
+    //!  `Ts...` shall meet the requirements of `LessThanComparable`,
+    //!  `MoveConstructible` and `MoveAssignable`, and lvalues of type `T`
+    //!  and of type `variant<Ts...>` shall be swappable.
+    //!
+    //! \effects Sorts the elements in `[first, last)` in ascending order as
+    //!  determined by `operator<` for `variant<Ts...>`. The sort is not
+    //!  stable.
+    //!
+    //! \remarks The elements are first placed in buckets by `which()` with
+    //!  an in-place counting sort, empty elements first; since `operator<`
+    //!  orders by `which()` before comparing values, no element crosses a
+    //!  bucket afterwards. Then each bucket is sorted with a single dispatch:
+    //!  integral and IEC 559 floating point alternatives are sorted as raw
+    //!  keys, with a radix sort for large buckets, and any other alternative
+    //!  `T` with `std::sort` on its members, comparing them as `T` directly.
+    template <typename RandomIt>
+    void variant_sort(RandomIt first, RandomIt last)
+    {
+        using variant_type =
+            typename std::iterator_traits<RandomIt>::value_type;
+        using discriminators = detail::discriminator_pack<variant_type>;
+        using dispatch = detail::visitor<
+            detail::_sort_bucket<RandomIt>, void(RandomIt const&, std::size_t)>;
+
+        EGGS_CXX11_CONSTEXPR std::size_t N = discriminators::size;
+
+        std::size_t const size = static_cast<std::size_t>(last - first);
+        std::size_t counts[N] = {};
+        for (std::size_t i = 0; i < size; ++i)
+            ++counts[detail::discriminator(first[i])];
+
+        std::size_t bounds[N + 1];
+        bounds[0] = 0;
+        for (std::size_t k = 0; k < N; ++k)
+            bounds[k + 1] = bounds[k] + counts[k];
+
+        // in-place permutation into buckets, every swap places at least
+        // one element in its final bucket
+        std::size_t next[N];
+        for (std::size_t k = 0; k < N; ++k)
+            next[k] = bounds[k];
+        for (std::size_t k = 0; k < N; ++k)
+        {
+            while (next[k] < bounds[k + 1])
+            {
+                std::size_t const d = detail::discriminator(first[next[k]]);
+                if (d == k)
+                {
+                    ++next[k];
+                } else {
+                    using std::swap;
+                    swap(first[next[k]], first[next[d]]);
+                    ++next[d];
+                }
+            }
+        }
+
+        for (std::size_t k = 0; k < N; ++k)
+        {
+            if (counts[k] > 1)
+            {
+                dispatch{}(discriminators{}, k,
+                    first + bounds[k], std::size_t(counts[k]));
+            }
+        }
+    }
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_VARIANT_SORT_HPP*/
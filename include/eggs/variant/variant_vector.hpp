@@ -0,0 +1,523 @@
+//! \file eggs/variant/variant_vector.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_VARIANT_VECTOR_HPP
+#define EGGS_VARIANT_VARIANT_VECTOR_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/bad_variant_access.hpp>
+#include <eggs/variant/detail/apply.hpp>
+#include <eggs/variant/detail/pack.hpp>
+#include <eggs/variant/detail/visitor.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+namespace eggs { namespace variants
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class ...Ts>
+    //! class variant_vector;
+    //!
+    //! A `variant_vector` is a sequence container of values whose types are
+    //! any of `Ts...`. Instead of a single array of `variant<Ts...>`, it keeps
+    //! one dense array per alternative, so that a loop over the elements of a
+    //! single type walks contiguous memory of exactly that type. A compact
+    //! sequence of handles records the insertion order of the elements.
+    //!
+    //! Every inserted element is identified by a `handle`, which remains
+    //! valid until the element is erased; erasure moves the last element of
+    //! the same type into the gap, so the dense arrays stay dense.
+    //!
+    //! \requires Every `T` in `Ts...` shall be a complete object type, and
+    //!  shall be `MoveConstructible` and `MoveAssignable`.
+    template <typename ...Ts>
+    class variant_vector
+    {
+        static_assert(sizeof...(Ts) != 0,
+            "variant_vector requires at least one alternative");
+
+        EGGS_CXX11_STATIC_CONSTEXPR std::uint32_t _npos = std::uint32_t(-1);
+
+    public:
+        using value_type = variant<Ts...>;
+        using size_type = std::size_t;
+
+        //! class handle;
+        //!
+        //! A stable reference to an element of a `variant_vector`, made of the
+        //! zero-based index of its alternative and a slot within the
+        //! alternative.
+        class handle
+        {
+            friend class variant_vector;
+
+        public:
+            EGGS_CXX11_CONSTEXPR handle() EGGS_CXX11_NOEXCEPT
+              : _which(_npos), _slot(_npos)
+            {}
+
+            //! constexpr std::size_t which() const noexcept;
+            //!
+            //! \returns The zero-based index of the alternative of the element
+            //!  referred to by `*this`, or `npos` for a default constructed
+            //!  handle.
+            EGGS_CXX11_CONSTEXPR std::size_t which() const EGGS_CXX11_NOEXCEPT
+            {
+                return _which != _npos ? std::size_t(_which) : value_type::npos;
+            }
+
+            friend EGGS_CXX11_CONSTEXPR bool operator==(
+                handle lhs, handle rhs) EGGS_CXX11_NOEXCEPT
+            {
+                return lhs._which == rhs._which && lhs._slot == rhs._slot;
+            }
+
+            friend EGGS_CXX11_CONSTEXPR bool operator!=(
+                handle lhs, handle rhs) EGGS_CXX11_NOEXCEPT
+            {
+                return !(lhs == rhs);
+            }
+
+        private:
+            EGGS_CXX11_CONSTEXPR handle(
+                std::uint32_t which, std::uint32_t slot) EGGS_CXX11_NOEXCEPT
+              : _which(which), _slot(slot)
+            {}
+
+            std::uint32_t _which;
+            std::uint32_t _slot;
+        };
+
+    public:
+        //! variant_vector();
+        //!
+        //! \postconditions `size() == 0`.
+        variant_vector()
+          : _columns(), _index(), _sequence(), _erased(0)
+        {}
+
+        variant_vector(variant_vector const&) = default;
+        variant_vector& operator=(variant_vector const&) = default;
+
+        //! variant_vector(variant_vector&& rhs) noexcept;
+        //!
+        //! \postconditions `rhs.empty() == true`.
+        variant_vector(variant_vector&& rhs) EGGS_CXX11_NOEXCEPT
+          : _columns(std::move(rhs._columns))
+          , _index(std::move(rhs._index))
+          , _sequence(std::move(rhs._sequence))
+          , _erased(rhs._erased)
+        {
+            rhs.clear();
+        }
+
+        variant_vector& operator=(variant_vector&& rhs) EGGS_CXX11_NOEXCEPT
+        {
+            _columns = std::move(rhs._columns);
+            _index = std::move(rhs._index);
+            _sequence = std::move(rhs._sequence);
+            _erased = rhs._erased;
+            rhs.clear();
+            return *this;
+        }
+
+        //! std::size_t size() const noexcept;
+        //!
+        //! \returns The number of elements in the container.
+        std::size_t size() const EGGS_CXX11_NOEXCEPT
+        {
+            return _sequence.size() - _erased;
+        }
+
+        //! bool empty() const noexcept;
+        //!
+        //! \returns `size() == 0`.
+        bool empty() const EGGS_CXX11_NOEXCEPT
+        {
+            return size() == 0;
+        }
+
+        //! template <class T>
+        //! std::size_t size() const noexcept;
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \returns The number of elements of type `T` in the container.
+        template <typename T>
+        std::size_t size() const EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().size();
+        }
+
+        //! template <class T>
+        //! T* data() noexcept;
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \returns A pointer to the contiguous array of the `size<T>()`
+        //!  elements of type `T`, in unspecified order.
+        template <typename T>
+        T* data() EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().data();
+        }
+
+        template <typename T>
+        T const* data() const EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().data();
+        }
+
+        //! template <class T>
+        //! T* begin() noexcept;
+        //!
+        //! \returns `data<T>()`.
+        template <typename T>
+        T* begin() EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().data();
+        }
+
+        template <typename T>
+        T const* begin() const EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().data();
+        }
+
+        //! template <class T>
+        //! T* end() noexcept;
+        //!
+        //! \returns `data<T>() + size<T>()`.
+        template <typename T>
+        T* end() EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().data() + _column<T>().size();
+        }
+
+        template <typename T>
+        T const* end() const EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>().data() + _column<T>().size();
+        }
+
+        //! template <class T, class ...Args>
+        //! handle emplace_back(Args&&... args);
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`.
+        //!
+        //! \effects Appends an element of type `T` direct-non-list-initialized
+        //!  with `std::forward<Args>(args)...`.
+        //!
+        //! \returns A handle to the new element.
+        //!
+        //! \remarks If an exception is thrown there are no effects.
+        template <typename T, typename ...Args>
+        handle emplace_back(Args&&... args)
+        {
+            using I = detail::index_of<T, detail::pack<Ts...>>;
+            return _emplace_back(I{}, std::forward<Args>(args)...);
+        }
+
+        //! handle push_back(variant<Ts...> const& v);
+        //!
+        //! \effects Appends a copy of the active member of `v`.
+        //!
+        //! \returns A handle to the new element.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        //!
+        //! \remarks There is a single dispatch on `v.which()`. If an exception
+        //!  is thrown there are no effects.
+        handle push_back(variant<Ts...> const& v)
+        {
+            return v.which() != value_type::npos
+              ? detail::visitor<_push_back<variant<Ts...> const&>,
+                    handle(variant_vector&, variant<Ts...> const&)>{}(
+                        detail::typed_index_pack<detail::pack<Ts...>>{},
+                        v.which(), *this, v)
+              : detail::throw_bad_variant_access<handle>();
+        }
+
+        //! handle push_back(variant<Ts...>&& v);
+        //!
+        //! \effects Appends the active member of `v`, move constructed.
+        //!
+        //! \returns A handle to the new element.
+        //!
+        //! \throws `bad_variant_access` if `v` has no active member.
+        handle push_back(variant<Ts...>&& v)
+        {
+            return v.which() != value_type::npos
+              ? detail::visitor<_push_back<variant<Ts...>&&>,
+                    handle(variant_vector&, variant<Ts...>&&)>{}(
+                        detail::typed_index_pack<detail::pack<Ts...>>{},
+                        v.which(), *this, std::move(v))
+              : detail::throw_bad_variant_access<handle>();
+        }
+
+        //! void erase(handle h);
+        //!
+        //! \requires `h` shall refer to an element of `*this`.
+        //!
+        //! \effects Destroys the element referred to by `h`. Within its
+        //!  alternative, the last element is moved into the position of the
+        //!  erased one. Handles to other elements remain valid.
+        void erase(handle h)
+        {
+            detail::visitor<_erase, void(variant_vector&, std::uint32_t)>{}(
+                detail::typed_index_pack<detail::pack<Ts...>>{},
+                h._which, *this, std::uint32_t(h._slot));
+
+            _sequence[_index[h._which].slot_seq[h._slot]] = handle();
+            _index[h._which].free(h._slot);
+            if (++_erased > _sequence.size() / 2)
+                _compact();
+        }
+
+        //! template <class T>
+        //! T& get(handle h) noexcept;
+        //!
+        //! \requires `T` shall occur exactly once in `Ts...`, and `h` shall
+        //!  refer to an element of `*this` of type `T`.
+        //!
+        //! \returns A reference to the element referred to by `h`.
+        template <typename T>
+        T& get(handle h) EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>()[_index[h._which].slot_dense[h._slot]];
+        }
+
+        template <typename T>
+        T const& get(handle h) const EGGS_CXX11_NOEXCEPT
+        {
+            return _column<T>()[_index[h._which].slot_dense[h._slot]];
+        }
+
+        //! template <class F>
+        //! void for_each(F&& f);
+        //!
+        //! \effects For each element `e` in insertion order, evaluates
+        //!  `INVOKE(f, e)`.
+        template <typename F>
+        void for_each(F&& f)
+        {
+            _for_each(*this, f);
+        }
+
+        template <typename F>
+        void for_each(F&& f) const
+        {
+            _for_each(*this, f);
+        }
+
+        //! void clear() noexcept;
+        //!
+        //! \effects Destroys all elements.
+        //!
+        //! \postconditions `size() == 0`.
+        void clear() EGGS_CXX11_NOEXCEPT
+        {
+            _clear(detail::make_index_pack<sizeof...(Ts)>{});
+        }
+
+    private:
+        struct _column_index
+        {
+            _column_index()
+              : dense_slot(), slot_dense(), slot_seq(), free_head(_npos)
+            {}
+
+            std::uint32_t allocate()
+            {
+                if (free_head != _npos)
+                {
+                    std::uint32_t const slot = free_head;
+                    free_head = slot_dense[slot];
+                    return slot;
+                }
+                slot_dense.reserve(slot_dense.size() + 1);
+                slot_seq.reserve(slot_seq.size() + 1);
+                slot_dense.push_back(_npos);
+                slot_seq.push_back(_npos);
+                return std::uint32_t(slot_dense.size() - 1);
+            }
+
+            void free(std::uint32_t slot) EGGS_CXX11_NOEXCEPT
+            {
+                slot_dense[slot] = free_head;
+                slot_seq[slot] = _npos;
+                free_head = slot;
+            }
+
+            std::vector<std::uint32_t> dense_slot;
+            std::vector<std::uint32_t> slot_dense;
+            std::vector<std::uint32_t> slot_seq;
+            std::uint32_t free_head;
+        };
+
+        template <typename V>
+        struct _push_back
+        {
+            template <typename I>
+            static handle call(variant_vector& self, V v)
+            {
+                using T = typename detail::at_index<
+                    I::value, detail::pack<Ts...>>::type;
+                using M = typename std::conditional<
+                    std::is_lvalue_reference<V>::value, T const&, T&&
+                >::type;
+
+                return self._emplace_back(I{},
+                    static_cast<M>(detail::access::get(v, I{})));
+            }
+        };
+
+        struct _erase
+        {
+            template <typename I>
+            static void call(variant_vector& self, std::uint32_t slot)
+            {
+                auto& column = std::get<I::value>(self._columns);
+                _column_index& index = self._index[I::value];
+
+                std::uint32_t const dense = index.slot_dense[slot];
+                std::uint32_t const last = std::uint32_t(column.size() - 1);
+                if (dense != last)
+                {
+                    column[dense] = std::move(column[last]);
+                    std::uint32_t const moved = index.dense_slot[last];
+                    index.dense_slot[dense] = moved;
+                    index.slot_dense[moved] = dense;
+                }
+                column.pop_back();
+                index.dense_slot.pop_back();
+            }
+        };
+
+        template <typename Self, typename F>
+        struct _visit
+        {
+            template <typename I>
+            static void call(Self& self, F& f, std::uint32_t dense)
+            {
+                detail::_invoke(f, std::get<I::value>(self._columns)[dense]);
+            }
+        };
+
+        template <typename T>
+        std::vector<T>& _column() EGGS_CXX11_NOEXCEPT
+        {
+            return std::get<detail::index_of<T, detail::pack<Ts...>>::value>(
+                _columns);
+        }
+
+        template <typename T>
+        std::vector<T> const& _column() const EGGS_CXX11_NOEXCEPT
+        {
+            return std::get<detail::index_of<T, detail::pack<Ts...>>::value>(
+                _columns);
+        }
+
+        template <std::size_t I, typename ...Args>
+        handle _emplace_back(detail::index<I>, Args&&... args)
+        {
+            auto& column = std::get<I>(_columns);
+            _column_index& index = _index[I];
+
+            _sequence.reserve(_sequence.size() + 1);
+            index.dense_slot.reserve(index.dense_slot.size() + 1);
+            column.emplace_back(std::forward<Args>(args)...);
+
+            std::uint32_t slot;
+#if EGGS_CXX98_HAS_EXCEPTIONS
+            try
+            {
+                slot = index.allocate();
+            } catch (...) {
+                column.pop_back();
+                throw;
+            }
+#else
+            slot = index.allocate();
+#endif
+            index.slot_dense[slot] = std::uint32_t(column.size() - 1);
+            index.slot_seq[slot] = std::uint32_t(_sequence.size());
+            index.dense_slot.push_back(slot);
+
+            handle const h(static_cast<std::uint32_t>(I), slot);
+            _sequence.push_back(h);
+            return h;
+        }
+
+        template <typename Self, typename F>
+        static void _for_each(Self& self, F& f)
+        {
+            using visitor = detail::visitor<_visit<Self, F>,
+                void(Self&, F&, std::uint32_t)>;
+
+            for (handle h : self._sequence)
+            {
+                if (h._which == _npos)
+                    continue;
+
+                visitor{}(detail::typed_index_pack<detail::pack<Ts...>>{},
+                    h._which, self, f,
+                    std::uint32_t(self._index[h._which].slot_dense[h._slot]));
+            }
+        }
+
+        void _compact() EGGS_CXX11_NOEXCEPT
+        {
+            std::size_t next = 0;
+            for (std::size_t i = 0; i < _sequence.size(); ++i)
+            {
+                handle const h = _sequence[i];
+                if (h._which == _npos)
+                    continue;
+
+                _index[h._which].slot_seq[h._slot] = std::uint32_t(next);
+                _sequence[next++] = h;
+            }
+            _sequence.resize(next);
+            _erased = 0;
+        }
+
+        template <std::size_t ...Is>
+        void _clear(detail::pack_c<std::size_t, Is...>) EGGS_CXX11_NOEXCEPT
+        {
+            int const _[] = {0, (std::get<Is>(_columns).clear(), 0)...};
+            (void)_;
+
+            for (std::size_t i = 0; i < sizeof...(Ts); ++i)
+                _index[i] = _column_index();
+            _sequence.clear();
+            _erased = 0;
+        }
+
+    private:
+        std::tuple<std::vector<Ts>...> _columns;
+        std::array<_column_index, sizeof...(Ts)> _index;
+        std::vector<handle> _sequence;
+        std::size_t _erased;
+    };
+
+    template <typename ...Ts>
+    EGGS_CXX11_CONSTEXPR std::uint32_t variant_vector<Ts...>::_npos;
+}}
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_VARIANT_VECTOR_HPP*/
@@ -0,0 +1,542 @@
+//! \file eggs/variant/views.hpp
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EGGS_VARIANT_VIEWS_HPP
+#define EGGS_VARIANT_VIEWS_HPP
+
+#include <eggs/variant/variant.hpp>
+#include <eggs/variant/detail/batch.hpp>
+#include <eggs/variant/detail/pack.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_CXX20_HAS_RANGES
+#  include <ranges>
+#endif
+
+namespace eggs { namespace variants
+{
+    namespace detail
+    {
+        template <typename T, typename V>
+        struct _alternative_index;
+
+        template <typename T, typename ...Ts>
+        struct _alternative_index<T, variant<Ts...>>
+          : index_of<T, pack<Ts...>>
+        {};
+
+        template <typename T, typename V>
+        struct _alternative_index<T, V const>
+          : _alternative_index<T, V>
+        {};
+
+        template <typename Range>
+        struct _range_iterator
+        {
+            using type = decltype(std::begin(std::declval<Range&>()));
+        };
+
+        template <typename Iterator>
+        using _iterator_variant = typename std::remove_reference<
+            typename std::iterator_traits<Iterator>::reference>::type;
+
+        // Holds an optional `F`, so that iterators of a `visit_view` can hold
+        // their own copy and still be default constructible and assignable
+        // when `F` is not, as is the case for lambdas. Assignment destroys
+        // and copy constructs the target; if that throws, the box is empty.
+        template <typename F>
+        class _view_function
+        {
+        public:
+            _view_function() EGGS_CXX11_NOEXCEPT
+              : _engaged(false)
+            {}
+
+            explicit _view_function(F f)
+              : _engaged(false)
+            {
+                _emplace(std::move(f));
+            }
+
+            _view_function(_view_function const& rhs)
+              : _engaged(false)
+            {
+                if (rhs._engaged)
+                    _emplace(*rhs);
+            }
+
+            _view_function(_view_function&& rhs)
+              : _engaged(false)
+            {
+                if (rhs._engaged)
+                    _emplace(std::move(rhs._target()));
+            }
+
+            ~_view_function()
+            {
+                _reset();
+            }
+
+            _view_function& operator=(_view_function const& rhs)
+            {
+                if (this != &rhs)
+                {
+                    _reset();
+                    if (rhs._engaged)
+                        _emplace(*rhs);
+                }
+                return *this;
+            }
+
+            _view_function& operator=(_view_function&& rhs)
+            {
+                if (this != &rhs)
+                {
+                    _reset();
+                    if (rhs._engaged)
+                        _emplace(std::move(rhs._target()));
+                }
+                return *this;
+            }
+
+            F const& operator*() const EGGS_CXX11_NOEXCEPT
+            {
+                return *static_cast<F const*>(
+                    static_cast<void const*>(&_storage));
+            }
+
+        private:
+            F& _target() EGGS_CXX11_NOEXCEPT
+            {
+                return *static_cast<F*>(static_cast<void*>(&_storage));
+            }
+
+            template <typename G>
+            void _emplace(G&& g)
+            {
+                ::new (static_cast<void*>(&_storage)) F(std::forward<G>(g));
+                _engaged = true;
+            }
+
+            void _reset() EGGS_CXX11_NOEXCEPT
+            {
+                if (_engaged)
+                {
+                    _target().~F();
+                    _engaged = false;
+                }
+            }
+
+            typename std::aligned_storage<
+                sizeof(F), std::alignment_of<F>::value>::type _storage;
+            bool _engaged;
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Iterator, std::size_t I>
+    //! class alternative_view;
+    //!
+    //! An `alternative_view<Iterator, I>` is a lazy forward range over the
+    //! active members of the elements of `[first, last)` whose active member
+    //! has index `I`, skipping the other elements. Its elements have type
+    //! `T&`, where `T` is the `I`-th alternative, const qualified if the
+    //! elements of the underlying range are const.
+    //!
+    //! \remarks Advancing to the next element costs a single discriminator
+    //!  comparison per underlying element, and dereferencing involves no
+    //!  dispatch. The view refers to the underlying range, which shall
+    //!  outlive it.
+    template <typename Iterator, std::size_t I>
+    class alternative_view
+    {
+        using variant_type = detail::_iterator_variant<Iterator>;
+
+    public:
+        using value_type = typename variant_element<I,
+            typename std::remove_cv<variant_type>::type>::type;
+        using reference = typename std::conditional<
+            std::is_const<variant_type>::value,
+            value_type const&, value_type&>::type;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = alternative_view::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = alternative_view::reference;
+            using pointer = typename std::remove_reference<reference>::type*;
+
+        public:
+            iterator()
+              : _it(), _last()
+            {}
+
+            iterator(Iterator it, Iterator last)
+              : _it(it), _last(last)
+            {
+                _skip();
+            }
+
+            reference operator*() const
+            {
+                return *static_cast<pointer>(
+                    detail::access::storage(*_it).target());
+            }
+
+            pointer operator->() const
+            {
+                return std::addressof(**this);
+            }
+
+            iterator& operator++()
+            {
+                ++_it;
+                _skip();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator t = *this;
+                ++*this;
+                return t;
+            }
+
+            //! Iterator base() const;
+            //!
+            //! \returns An iterator to the underlying element.
+            Iterator base() const
+            {
+                return _it;
+            }
+
+            friend bool operator==(iterator const& lhs, iterator const& rhs)
+            {
+                return lhs._it == rhs._it;
+            }
+
+            friend bool operator!=(iterator const& lhs, iterator const& rhs)
+            {
+                return !(lhs == rhs);
+            }
+
+        private:
+            void _skip()
+            {
+                while (_it != _last && detail::discriminator(*_it) != I + 1)
+                    ++_it;
+            }
+
+            Iterator _it;
+            Iterator _last;
+        };
+
+    public:
+        alternative_view(Iterator first, Iterator last)
+          : _first(first), _last(last)
+        {}
+
+        iterator begin() const
+        {
+            return iterator(_first, _last);
+        }
+
+        iterator end() const
+        {
+            return iterator(_last, _last);
+        }
+
+    private:
+        Iterator _first;
+        Iterator _last;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <class Iterator, class F>
+    //! class visit_view;
+    //!
+    //! A `visit_view<Iterator, F>` is a lazy range over the results of
+    //! `apply(f, *it)` for every `it` in `[first, last)`, computed when
+    //! dereferenced. Its iterators are input iterators, since they yield
+    //! values rather than references.
+    //!
+    //! \remarks The view and each of its iterators hold a copy of `f`, so
+    //!  iterators remain valid when the view is moved or destroyed. The view
+    //!  refers to the underlying range, which shall outlive it.
+    template <typename Iterator, typename F>
+    class visit_view
+    {
+    public:
+        using reference = decltype(::eggs::variants::apply(
+            std::declval<F const&>(), *std::declval<Iterator>()));
+        using value_type = typename std::decay<reference>::type;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = visit_view::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = visit_view::reference;
+
+        public:
+            iterator()
+              : _it(), _f()
+            {}
+
+            iterator(Iterator it, detail::_view_function<F> const& f)
+              : _it(it), _f(f)
+            {}
+
+            reference operator*() const
+            {
+                return ::eggs::variants::apply(*_f, *_it);
+            }
+
+            iterator& operator++() { ++_it; return *this; }
+            iterator operator++(int) { iterator t = *this; ++_it; return t; }
+
+            Iterator base() const
+            {
+                return _it;
+            }
+
+            friend bool operator==(iterator const& lhs, iterator const& rhs)
+            {
+                return lhs._it == rhs._it;
+            }
+
+            friend bool operator!=(iterator const& lhs, iterator const& rhs)
+            {
+                return !(lhs == rhs);
+            }
+
+        private:
+            Iterator _it;
+            detail::_view_function<F> _f;
+        };
+
+    public:
+        visit_view(Iterator first, Iterator last, F f)
+          : _first(first), _last(last), _f(std::move(f))
+        {}
+
+        iterator begin() const
+        {
+            return iterator(_first, _f);
+        }
+
+        iterator end() const
+        {
+            return iterator(_last, _f);
+        }
+
+    private:
+        Iterator _first;
+        Iterator _last;
+        detail::_view_function<F> _f;
+    };
+
+    namespace detail
+    {
+        template <typename Range>
+        struct _is_variant_view
+          : std::false_type
+        {};
+
+        template <typename Iterator, std::size_t I>
+        struct _is_variant_view<alternative_view<Iterator, I>>
+          : std::true_type
+        {};
+
+        template <typename Iterator, typename F>
+        struct _is_variant_view<visit_view<Iterator, F>>
+          : std::true_type
+        {};
+
+        // Whether the iterators of `Range`, as deduced for a forwarding
+        // reference, outlive the object: lvalues, the views above, and under
+        // C++20 any `std::ranges::borrowed_range`.
+        template <typename Range>
+        struct _is_borrowed_range
+          : std::integral_constant<
+                bool
+              , std::is_lvalue_reference<Range>::value
+             || _is_variant_view<
+                    typename std::remove_cv<
+                        typename std::remove_reference<Range>::type>::type
+                >::value
+#if EGGS_CXX20_HAS_RANGES
+             || std::ranges::borrowed_range<Range>
+#endif
+            >
+        {};
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! template <std::size_t I>
+    //! struct where_alternative_t {};
+    //!
+    //! template <class T>
+    //! struct only_t {};
+    //!
+    //! template <class F>
+    //! struct visit_each_t { F f; };
+    //!
+    //! Range adaptor objects, applied to a range of variants with `operator|`.
+    //! The range is either an lvalue, or an rvalue whose iterators do not
+    //! refer to it, such as one of the views above or, under C++20, a
+    //! `std::ranges::borrowed_range`. The resulting views chain with further
+    //! adaptors, and under C++20 model `std::ranges::view`.
+    template <std::size_t I>
+    struct where_alternative_t {};
+
+    template <typename T>
+    struct only_t {};
+
+    template <typename F>
+    struct visit_each_t
+    {
+        F f;
+    };
+
+    //! template <std::size_t I>
+    //! constexpr where_alternative_t<I> where_alternative() noexcept;
+    template <std::size_t I>
+    EGGS_CXX11_CONSTEXPR where_alternative_t<I>
+    where_alternative() EGGS_CXX11_NOEXCEPT
+    {
+        return where_alternative_t<I>{};
+    }
+
+    //! template <class T>
+    //! constexpr only_t<T> only() noexcept;
+    template <typename T>
+    EGGS_CXX11_CONSTEXPR only_t<T> only() EGGS_CXX11_NOEXCEPT
+    {
+        return only_t<T>{};
+    }
+
+    //! template <class F>
+    //! visit_each_t<std::decay_t<F>> visit_each(F&& f);
+    template <typename F>
+    visit_each_t<typename std::decay<F>::type> visit_each(F&& f)
+    {
+        return visit_each_t<typename std::decay<F>::type>{
+            std::forward<F>(f)};
+    }
+
+    //! template <class Range, std::size_t I>
+    //! alternative_view<unspecified, I> operator|(
+    //!     Range&& r, where_alternative_t<I>);
+    //!
+    //! \requires The elements of `r` shall be of type `variant<Ts...>`,
+    //!  possibly const, and `I < sizeof...(Ts)`.
+    //!
+    //! \returns `alternative_view<It, I>(std::begin(r), std::end(r))`, where
+    //!  `It` is the iterator type of `r`.
+    //!
+    //! \remarks This function shall not participate in overload resolution
+    //!  unless `r` is an lvalue, or an rvalue whose iterators do not refer to
+    //!  it.
+    template <
+        typename Range, std::size_t I
+      , typename Enable = typename std::enable_if<
+            detail::_is_borrowed_range<Range>::value>::type
+    >
+    alternative_view<typename detail::_range_iterator<Range>::type, I>
+    operator|(Range&& r, where_alternative_t<I>)
+    {
+        return {std::begin(r), std::end(r)};
+    }
+
+    //! template <class Range, class T>
+    //! alternative_view<unspecified, I> operator|(Range&& r, only_t<T>);
+    //!
+    //! \requires The elements of `r` shall be of type `variant<Ts...>`,
+    //!  possibly const, and `T` shall occur exactly once in `Ts...`.
+    //!
+    //! \returns `r | where_alternative<I>()`, where `I` is the zero-based
+    //!  index of `T` in `Ts...`.
+    //!
+    //! \remarks This function shall not participate in overload resolution
+    //!  unless `r` is an lvalue, or an rvalue whose iterators do not refer to
+    //!  it.
+    template <
+        typename Range, typename T
+      , typename Enable = typename std::enable_if<
+            detail::_is_borrowed_range<Range>::value>::type
+      , typename It = typename detail::_range_iterator<Range>::type
+      , std::size_t I = detail::_alternative_index<
+            T, detail::_iterator_variant<It>>::value
+    >
+    alternative_view<It, I> operator|(Range&& r, only_t<T>)
+    {
+        return {std::begin(r), std::end(r)};
+    }
+
+    //! template <class Range, class F>
+    //! visit_view<unspecified, F> operator|(Range&& r, visit_each_t<F> v);
+    //!
+    //! \requires The elements of `r` shall be of type `variant<Ts...>`,
+    //!  possibly const, and `apply(v.f, e)` shall be a valid expression for
+    //!  every element `e` of `r`.
+    //!
+    //! \returns `visit_view<It, F>(std::begin(r), std::end(r),
+    //!  std::move(v.f))`, where `It` is the iterator type of `r`.
+    //!
+    //! \remarks This function shall not participate in overload resolution
+    //!  unless `r` is an lvalue, or an rvalue whose iterators do not refer to
+    //!  it.
+    template <
+        typename Range, typename F
+      , typename Enable = typename std::enable_if<
+            detail::_is_borrowed_range<Range>::value>::type
+    >
+    visit_view<typename detail::_range_iterator<Range>::type, F>
+    operator|(Range&& r, visit_each_t<F> v)
+    {
+        return {std::begin(r), std::end(r), std::move(v.f)};
+    }
+}}
+
+#if EGGS_CXX20_HAS_RANGES
+namespace std { namespace ranges
+{
+    template <typename Iterator, std::size_t I>
+    inline constexpr bool enable_view<
+        ::eggs::variants::alternative_view<Iterator, I>> = true;
+
+    template <typename Iterator, std::size_t I>
+    inline constexpr bool enable_borrowed_range<
+        ::eggs::variants::alternative_view<Iterator, I>> = true;
+
+    template <typename Iterator, typename F>
+    inline constexpr bool enable_view<
+        ::eggs::variants::visit_view<Iterator, F>> = true;
+
+    template <typename Iterator, typename F>
+    inline constexpr bool enable_borrowed_range<
+        ::eggs::variants::visit_view<Iterator, F>> = true;
+}}
+#endif
+
+#include <eggs/variant/detail/config/suffix.hpp>
+
+#endif /*EGGS_VARIANT_VIEWS_HPP*/
@@ -0,0 +1,116 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/apply_batch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+struct Record
+{
+    std::vector<std::string> seen;
+
+    void operator()(int i) { seen.push_back("i" + std::to_string(i)); }
+    void operator()(std::string const& s) { seen.push_back("s" + s); }
+};
+
+struct Increment
+{
+    void operator()(int& i) const { ++i; }
+    void operator()(std::string& s) const { s += '+'; }
+};
+
+std::vector<eggs::variant<int, std::string>> make_range(std::size_t n)
+{
+    std::vector<eggs::variant<int, std::string>> vs;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (i % 3 == 0 || i % 5 == 0)
+            vs.push_back(std::to_string(i));
+        else
+            vs.push_back(int(i));
+    }
+    return vs;
+}
+
+TEST_CASE("apply_batch(ordered_t, F&&, RandomIt, RandomIt)", "[apply_batch]")
+{
+    std::vector<eggs::variant<int, std::string>> const vs = make_range(1000);
+
+    Record r;
+    eggs::variants::apply_batch(eggs::variants::ordered, r, vs.begin(), vs.end());
+
+    REQUIRE(r.seen.size() == vs.size());
+    for (std::size_t i = 0; i < vs.size(); ++i)
+    {
+        CHECK(r.seen[i] == (vs[i].which() == 0 ? "i" : "s") + std::to_string(i));
+    }
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    SECTION("throws")
+    {
+        std::vector<eggs::variant<int, std::string>> vs = make_range(10);
+        vs[7] = eggs::variant<int, std::string>();
+
+        Record r;
+        CHECK_THROWS_AS(
+            eggs::variants::apply_batch(eggs::variants::ordered, r, vs.begin(), vs.end()),
+            eggs::variants::bad_variant_access);
+        CHECK(r.seen.size() == 7u);
+    }
+#endif
+}
+
+TEST_CASE("apply_batch(F&&, RandomIt, RandomIt)", "[apply_batch]")
+{
+    std::vector<eggs::variant<int, std::string>> vs = make_range(1000);
+
+    Record r;
+    eggs::variants::apply_batch(r, vs.data(), vs.data() + vs.size());
+
+    REQUIRE(r.seen.size() == vs.size());
+
+    std::vector<std::string> expected;
+    for (std::size_t i = 0; i < vs.size(); ++i)
+        expected.push_back((vs[i].which() == 0 ? "i" : "s") + std::to_string(i));
+    std::sort(expected.begin(), expected.end());
+    std::sort(r.seen.begin(), r.seen.end());
+    CHECK(r.seen == expected);
+
+    SECTION("mutable")
+    {
+        eggs::variants::apply_batch(
+            eggs::variants::unordered, Increment{}, vs.begin(), vs.end());
+
+        for (std::size_t i = 0; i < vs.size(); ++i)
+        {
+            if (vs[i].which() == 0)
+                CHECK(*vs[i].target<int>() == int(i) + 1);
+            else
+                CHECK(*vs[i].target<std::string>() == std::to_string(i) + "+");
+        }
+    }
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    SECTION("throws")
+    {
+        vs[700] = eggs::variant<int, std::string>();
+
+        Record r;
+        CHECK_THROWS_AS(
+            eggs::variants::apply_batch(r, vs.begin(), vs.end()),
+            eggs::variants::bad_variant_access);
+    }
+#endif
+}
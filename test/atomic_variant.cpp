@@ -0,0 +1,203 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/atomic_variant.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+EGGS_CXX11_STATIC_CONSTEXPR std::size_t npos = eggs::variant<>::npos;
+
+struct Idle {};
+struct Running { std::uint16_t step; std::uint16_t total; };
+struct Failed { std::int32_t code; };
+
+// packs into 8 bytes
+using small_state = eggs::variants::atomic_variant<Idle, Running, Failed>;
+
+struct Progress { std::uint32_t done; std::uint32_t check; std::uint32_t seq; };
+
+// packs into 16 bytes
+using large_state = eggs::variants::atomic_variant<Idle, Progress, Failed>;
+
+TEST_CASE("atomic_variant<Ts...>::atomic_variant()", "[atomic_variant]")
+{
+    small_state s;
+    CHECK(s.load().which() == npos);
+
+    large_state l;
+    CHECK(l.load().which() == npos);
+
+    CHECK(small_state::is_always_lock_free == (ATOMIC_LLONG_LOCK_FREE == 2));
+    CHECK_FALSE(large_state::is_always_lock_free);
+    CHECK(s.is_lock_free() == (ATOMIC_LLONG_LOCK_FREE == 2));
+    (void)l.is_lock_free();
+}
+
+TEST_CASE("atomic_variant<Ts...>::load/store", "[atomic_variant]")
+{
+    small_state s(Running{3, 10});
+
+    small_state::value_type v = s.load();
+    REQUIRE(v.which() == 1u);
+    CHECK(v.target<Running>()->step == 3);
+    CHECK(v.target<Running>()->total == 10);
+
+    s.store(Failed{-42}, std::memory_order_release);
+    v = s.load(std::memory_order_acquire);
+    REQUIRE(v.which() == 2u);
+    CHECK(v.target<Failed>()->code == -42);
+
+    s = Idle{};
+    v = s;
+    CHECK(v.which() == 0u);
+
+    s.store(small_state::value_type());
+    CHECK(s.load().which() == npos);
+
+    large_state l(Progress{1, 2, 3});
+    large_state::value_type lv = l.load();
+    REQUIRE(lv.which() == 1u);
+    CHECK(lv.target<Progress>()->done == 1u);
+    CHECK(lv.target<Progress>()->check == 2u);
+    CHECK(lv.target<Progress>()->seq == 3u);
+
+    l.store(Failed{7});
+    CHECK(l.load().target<Failed>()->code == 7);
+}
+
+TEST_CASE("atomic_variant<Ts...>::exchange", "[atomic_variant]")
+{
+    small_state s(Idle{});
+    small_state::value_type old = s.exchange(Failed{1});
+    CHECK(old.which() == 0u);
+    CHECK(s.load().target<Failed>()->code == 1);
+
+    large_state l(Progress{4, 5, 6});
+    large_state::value_type lold = l.exchange(Idle{});
+    REQUIRE(lold.which() == 1u);
+    CHECK(lold.target<Progress>()->seq == 6u);
+    CHECK(l.load().which() == 0u);
+}
+
+TEST_CASE("atomic_variant<Ts...>::compare_exchange", "[atomic_variant]")
+{
+    small_state s(Running{1, 2});
+
+    small_state::value_type expected = Running{1, 2};
+    CHECK(s.compare_exchange_strong(expected, Running{2, 2}));
+    CHECK(s.load().target<Running>()->step == 2);
+
+    // a different alternative never compares equal
+    expected = Failed{0};
+    CHECK_FALSE(s.compare_exchange_strong(expected, Idle{}));
+    REQUIRE(expected.which() == 1u);
+    CHECK(expected.target<Running>()->step == 2);
+
+    while (!s.compare_exchange_weak(expected, Idle{},
+            std::memory_order_acq_rel, std::memory_order_acquire))
+        ;
+    CHECK(s.load().which() == 0u);
+
+    large_state l;
+    large_state::value_type lexpected;
+    CHECK(l.compare_exchange_strong(lexpected, Progress{1, 1, 1}));
+    lexpected = Progress{1, 1, 2};
+    CHECK_FALSE(l.compare_exchange_strong(lexpected, Idle{}));
+    CHECK(lexpected.target<Progress>()->seq == 1u);
+    CHECK(l.compare_exchange_weak(lexpected, Failed{3}));
+    CHECK(l.load().target<Failed>()->code == 3);
+}
+
+// Writers keep `check == ~done` for every value they store, so a torn read
+// would break the invariant; increments through compare exchange must not
+// get lost.
+TEST_CASE("atomic_variant<Ts...> contention", "[atomic_variant]")
+{
+    std::size_t const threads = 4;
+    std::uint32_t const increments = 20000;
+
+    large_state l(Progress{0, ~0u, 0});
+    std::atomic<bool> torn(false);
+
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]
+        {
+            large_state::value_type expected = l.load();
+            for (std::uint32_t i = 0; i < increments; ++i)
+            {
+                for (;;)
+                {
+                    Progress const* p = expected.target<Progress>();
+                    if (p == nullptr || p->check != ~p->done)
+                    {
+                        torn.store(true);
+                        return;
+                    }
+
+                    Progress const next = {p->done + 1, ~(p->done + 1), 0};
+                    if (l.compare_exchange_weak(expected, next))
+                        break;
+                }
+            }
+        });
+    }
+    workers.emplace_back([&]
+    {
+        for (std::uint32_t i = 0; i < increments; ++i)
+        {
+            large_state::value_type const v = l.load();
+            Progress const* p = v.target<Progress>();
+            if (p == nullptr || p->check != ~p->done)
+                torn.store(true);
+        }
+    });
+    for (std::thread& worker : workers)
+        worker.join();
+
+    CHECK_FALSE(torn.load());
+    large_state::value_type const v = l.load();
+    REQUIRE(v.which() == 1u);
+    CHECK(v.target<Progress>()->done == threads * increments);
+
+    // the same with an 8 byte word, through exchange
+    small_state s(Running{0, 0xffff});
+    std::atomic<std::uint32_t> swaps(0);
+
+    workers.clear();
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (std::uint32_t i = 0; i < increments; ++i)
+            {
+                std::uint16_t const step = std::uint16_t(t * increments + i);
+                small_state::value_type const old =
+                    s.exchange(Running{step, std::uint16_t(~step)});
+                Running const* r = old.target<Running>();
+                if (r == nullptr || r->total != std::uint16_t(~r->step))
+                    torn.store(true);
+                swaps.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+
+    CHECK_FALSE(torn.load());
+    CHECK(swaps.load() == threads * increments);
+}
@@ -0,0 +1,161 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/conflating_mailbox.hpp>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+struct quote
+{
+    int bid;
+    int ask;
+
+    quote(int bid, int ask) : bid(bid), ask(ask) {}
+};
+
+using market_data = eggs::variant<int, std::string, quote>;
+
+struct record
+{
+    std::vector<std::size_t>* order;
+    int last_int;
+    std::string last_string;
+    int last_bid;
+
+    void operator()(int i) { order->push_back(0); last_int = i; }
+    void operator()(std::string const& s) { order->push_back(1); last_string = s; }
+    void operator()(quote const& q) { order->push_back(2); last_bid = q.bid; }
+};
+
+struct throwing
+{
+    template <typename T>
+    void operator()(T const&) const { throw 0; }
+};
+
+TEST_CASE("conflating_mailbox<variant<Ts...>>::store", "[conflating_mailbox]")
+{
+    eggs::variants::conflating_mailbox<market_data> m;
+    CHECK(m.pending() == false);
+
+    m.store(market_data(quote(1, 2)));
+    m.store(market_data(std::string("first")));
+    m.store(market_data(42));
+    m.emplace<quote>(3, 4);
+    m.emplace<1>(3u, 'z');
+    m.store(market_data(43));
+    CHECK(m.pending() == true);
+
+    // one value per alternative, the latest one, in order of alternatives
+    std::vector<std::size_t> order;
+    record r = {&order, 0, std::string(), 0};
+    CHECK(m.try_drain(r) == 3u);
+    REQUIRE(order.size() == 3u);
+    CHECK(order[0] == 0u);
+    CHECK(order[1] == 1u);
+    CHECK(order[2] == 2u);
+    CHECK(r.last_int == 43);
+    CHECK(r.last_string == "zzz");
+    CHECK(r.last_bid == 3);
+
+    CHECK(m.pending() == false);
+    CHECK(m.try_drain(r) == 0u);
+
+    // only the alternatives written since the last drain are visited
+    m.store(market_data(std::string("second")));
+    order.clear();
+    CHECK(m.try_drain(r) == 1u);
+    REQUIRE(order.size() == 1u);
+    CHECK(order[0] == 1u);
+    CHECK(r.last_string == "second");
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS(m.store(market_data()));
+    CHECK(m.pending() == false);
+#endif
+}
+
+TEST_CASE("conflating_mailbox<variant<Ts...>>::try_drain", "[conflating_mailbox]")
+{
+    eggs::variants::conflating_mailbox<market_data> m;
+    m.store(market_data(1));
+    m.store(market_data(std::string("pending")));
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    // alternatives not yet visited stay pending if the visitor throws
+    CHECK_THROWS(m.try_drain(throwing{}));
+    CHECK(m.pending() == true);
+
+    std::vector<std::size_t> order;
+    record r = {&order, 0, std::string(), 0};
+    CHECK(m.try_drain(r) == 1u);
+    REQUIRE(order.size() == 1u);
+    CHECK(r.last_string == "pending");
+#endif
+}
+
+TEST_CASE("conflating_mailbox<variant<Ts...>>::drain", "[conflating_mailbox]")
+{
+    std::size_t const writers = 4;
+    int const updates = 20000;
+    eggs::variants::conflating_mailbox<market_data> m;
+
+    std::atomic<std::size_t> done(0);
+    std::vector<std::thread> threads;
+    for (std::size_t w = 0; w < writers; ++w)
+    {
+        threads.emplace_back([&m, &done, w, updates]
+        {
+            for (int i = 1; i <= updates; ++i)
+            {
+                if (w % 2 == 0)
+                    m.emplace<int>(i);
+                else
+                    m.emplace<quote>(i, i + 1);
+            }
+            ++done;
+            m.store(market_data(std::string("done")));
+        });
+    }
+
+    // values are never torn, and the last writes are eventually seen
+    struct check
+    {
+        std::size_t strings;
+        bool consistent;
+
+        void operator()(int i) { consistent = consistent && i > 0; }
+        void operator()(std::string const& s)
+        {
+            consistent = consistent && s == "done";
+            ++strings;
+        }
+        void operator()(quote const& q)
+        {
+            consistent = consistent && q.ask == q.bid + 1;
+        }
+    } c = {0, true};
+
+    while (done.load() < writers || m.pending())
+        m.drain(c);
+    for (std::thread& thread : threads)
+        thread.join();
+    m.try_drain(c);
+
+    CHECK(c.consistent);
+    CHECK(c.strings >= 1u);
+    CHECK(m.pending() == false);
+}
@@ -0,0 +1,132 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/dispatcher.hpp>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using message = eggs::variant<int, std::string>;
+using dispatcher = eggs::variants::dispatcher<message>;
+
+static int last_int = 0;
+
+static void on_int(int const& i) { last_int = i; }
+
+struct counter
+{
+    int& count;
+
+    void operator()(std::string const&) const { ++count; }
+};
+
+struct static_handler
+{
+    std::vector<int>* log;
+
+    void operator()(int i) const { log->push_back(i); }
+    void operator()(std::string const&) const { log->push_back(-1); }
+};
+
+TEST_CASE("dispatcher<variant<Ts...>>::subscribe", "[dispatcher]")
+{
+    dispatcher d;
+    CHECK(d.subscribers(0) == 0u);
+    CHECK(d.subscribers(1) == 0u);
+    CHECK(d.subscribers(2) == 0u);
+
+    std::vector<std::string> order;
+    int strings = 0;
+
+    d.subscribe<int>(&on_int);
+    d.subscribe<0>([&order](int const&) { order.push_back("lambda"); });
+    d.subscribe<std::string>(counter{strings});
+    d.subscribe<std::string>(
+        [&order](std::string const& s) { order.push_back(s); });
+    CHECK(d.subscribers(0) == 2u);
+    CHECK(d.subscribers(1) == 2u);
+
+    CHECK(d.dispatch(message(42)) == 2u);
+    CHECK(last_int == 42);
+    REQUIRE(order.size() == 1u);
+    CHECK(order[0] == "lambda");
+    CHECK(strings == 0);
+
+    CHECK(d.dispatch(message(std::string("hello"))) == 2u);
+    CHECK(strings == 1);
+    REQUIRE(order.size() == 2u);
+    CHECK(order[1] == "hello");
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(d.dispatch(message()), eggs::variants::bad_variant_access);
+#endif
+}
+
+TEST_CASE("dispatcher<variant<Ts...>>::unsubscribe", "[dispatcher]")
+{
+    dispatcher d;
+    std::vector<int> order;
+
+    dispatcher::subscription const first =
+        d.subscribe<int>([&order](int) { order.push_back(1); });
+    dispatcher::subscription const second =
+        d.subscribe<int>([&order](int) { order.push_back(2); });
+    d.subscribe<int>([&order](int) { order.push_back(3); });
+
+    CHECK(d.unsubscribe(second) == true);
+    CHECK(d.unsubscribe(second) == false);
+    CHECK(d.subscribers(0) == 2u);
+
+    CHECK(d.dispatch(message(0)) == 2u);
+    REQUIRE(order.size() == 2u);
+    CHECK(order[0] == 1);
+    CHECK(order[1] == 3);
+
+    CHECK(d.unsubscribe(first) == true);
+    dispatcher::subscription const bogus = {7, first.id};
+    CHECK(d.unsubscribe(bogus) == false);
+}
+
+TEST_CASE("dispatcher<variant<Ts...>>::dispatch", "[dispatcher]")
+{
+    dispatcher d;
+    std::vector<int> log;
+    d.subscribe<int>([&log](int i) { log.push_back(i * 10); });
+
+    // statically known handlers run first, through `apply`
+    static_handler const s = {&log};
+    CHECK(d.dispatch(message(4), s) == 1u);
+    CHECK(d.dispatch(message(std::string("x")), s) == 0u);
+    REQUIRE(log.size() == 3u);
+    CHECK(log[0] == 4);
+    CHECK(log[1] == 40);
+    CHECK(log[2] == -1);
+
+    // handlers too large for the small buffer still work, and are
+    // destroyed with the dispatcher
+    std::shared_ptr<int> const shared = std::make_shared<int>(0);
+    {
+        dispatcher big;
+        std::array<int, 32> padding = {{0}};
+        big.subscribe<int>(
+            [shared, padding](int i) { *shared += i + padding[0]; });
+        big.subscribe<int>([shared](int i) { *shared += i; });
+        CHECK(shared.use_count() == 3);
+
+        big.dispatch(message(5));
+        CHECK(*shared == 10);
+    }
+    CHECK(shared.use_count() == 1);
+}
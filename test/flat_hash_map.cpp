@@ -0,0 +1,139 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/flat_hash_map.hpp>
+#include <eggs/variant/hashed_variant.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using Key = eggs::variant<int, std::string>;
+
+TEST_CASE("flat_hash_map<variant<Ts...>, T>", "[flat_hash_map]")
+{
+    eggs::variants::flat_hash_map<Key, int> m;
+
+    REQUIRE(m.empty());
+    REQUIRE(m.bucket_count() == 0u);
+    CHECK(m.find(Key(42)) == m.end());
+
+    CHECK(m.try_emplace(Key(42), 1).second == true);
+    CHECK(m.try_emplace(Key(std::string{"42"}), 2).second == true);
+    CHECK(m.try_emplace(Key(42), 3).second == false);
+    CHECK(m.insert(std::make_pair(Key(), 4)).second == true);
+
+    CHECK(m.size() == 3u);
+    CHECK(m[Key(42)] == 1);
+    CHECK(m[Key(std::string{"42"})] == 2);
+    CHECK(m.at(Key()) == 4);
+    CHECK(m.count(Key(43)) == 0u);
+    CHECK(m.contains(Key(std::string{"42"})));
+
+    m[Key(43)] = 5;
+    CHECK(m.size() == 4u);
+    CHECK(m.find(Key(43))->second == 5);
+
+    CHECK(m.erase(Key(42)) == 1u);
+    CHECK(m.erase(Key(42)) == 0u);
+    CHECK(m.size() == 3u);
+    CHECK(m.find(Key(42)) == m.end());
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(m.at(Key(42)), std::out_of_range);
+#endif
+
+    std::size_t n = 0;
+    for (auto const& kv : m)
+    {
+        CHECK(m.find(kv.first)->second == kv.second);
+        ++n;
+    }
+    CHECK(n == m.size());
+
+    m.clear();
+    CHECK(m.empty());
+    CHECK(m.begin() == m.end());
+}
+
+TEST_CASE("flat_hash_map<variant<Ts...>, T> rehash", "[flat_hash_map]")
+{
+    eggs::variants::flat_hash_map<Key, std::size_t> m;
+    std::unordered_map<Key, std::size_t> r;
+
+    for (std::size_t i = 0; i < 2000; ++i)
+    {
+        Key const k = i % 3 == 0
+          ? Key(std::to_string(i % 1500)) : Key(int(i % 1500));
+        m[k] += i;
+        r[k] += i;
+
+        if (i % 7 == 0)
+        {
+            Key const e(int(i / 2));
+            CHECK(m.erase(e) == r.erase(e));
+        }
+    }
+
+    CHECK(m.size() == r.size());
+    CHECK(m.load_factor() <= m.max_load_factor());
+    for (auto const& kv : r)
+    {
+        auto it = m.find(kv.first);
+        REQUIRE(it != m.end());
+        CHECK(it->second == kv.second);
+    }
+
+    SECTION("copy")
+    {
+        eggs::variants::flat_hash_map<Key, std::size_t> const c = m;
+
+        CHECK(c.size() == m.size());
+        for (auto const& kv : m)
+            CHECK(c.at(kv.first) == kv.second);
+    }
+
+    SECTION("move")
+    {
+        std::size_t const size = m.size();
+        eggs::variants::flat_hash_map<Key, std::size_t> c = std::move(m);
+
+        CHECK(c.size() == size);
+        CHECK(m.empty());
+    }
+
+    SECTION("erase(const_iterator)")
+    {
+        for (auto it = m.begin(); it != m.end(); )
+            it = m.erase(it);
+
+        CHECK(m.empty());
+        CHECK(m.begin() == m.end());
+    }
+}
+
+TEST_CASE("flat_hash_map<hashed_variant<Ts...>, T>", "[flat_hash_map]")
+{
+    using HKey = eggs::variants::hashed_variant<int, std::string>;
+    eggs::variants::flat_hash_map<HKey, int> m(100);
+
+    REQUIRE(m.bucket_count() >= 100u);
+
+    for (int i = 0; i < 100; ++i)
+        m.try_emplace(HKey(std::to_string(i)), i);
+
+    CHECK(m.size() == 100u);
+    CHECK(m.at(HKey(std::string{"42"})) == 42);
+    CHECK(m.count(HKey(42)) == 0u);
+}
@@ -0,0 +1,66 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/hash_batch.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+TEST_CASE("hash_batch(RandomIt, RandomIt, RandomOutIt)", "[hash_batch]")
+{
+    using variant = eggs::variant<int, std::string, double>;
+
+    std::vector<variant> vs;
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        switch (i % 7)
+        {
+        case 0: vs.push_back(std::to_string(i)); break;
+        case 1: vs.push_back(double(i) / 2); break;
+        case 2: vs.push_back(variant()); break;
+        default: vs.push_back(int(i)); break;
+        }
+    }
+
+    std::vector<std::size_t> hs(vs.size());
+    std::vector<std::size_t>::iterator const end =
+        eggs::variants::hash_batch(vs.begin(), vs.end(), hs.begin());
+
+    CHECK(end == hs.end());
+    for (std::size_t i = 0; i < vs.size(); ++i)
+    {
+        CHECK(hs[i] == std::hash<variant>{}(vs[i]));
+    }
+
+    SECTION("uniform")
+    {
+        std::vector<variant> vs(600, variant(std::string{"42"}));
+        std::vector<std::size_t> hs(vs.size());
+
+        eggs::variants::hash_batch(vs.data(), vs.data() + vs.size(), hs.data());
+
+        for (std::size_t i = 0; i < vs.size(); ++i)
+        {
+            CHECK(hs[i] == std::hash<std::string>{}("42"));
+        }
+    }
+
+    SECTION("empty range")
+    {
+        std::size_t h = 42;
+        CHECK(eggs::variants::hash_batch(
+            vs.data(), vs.data(), &h) == &h);
+        CHECK(h == 42u);
+    }
+}
@@ -0,0 +1,174 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/hashed_variant.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_set>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+struct Counted
+{
+    static std::size_t hashes;
+    int x;
+
+    Counted(int x) : x(x) {}
+
+    bool operator==(Counted const& rhs) const { return x == rhs.x; }
+    bool operator<(Counted const& rhs) const { return x < rhs.x; }
+};
+
+std::size_t Counted::hashes = 0;
+
+namespace std
+{
+    template <>
+    struct hash<Counted>
+    {
+        std::size_t operator()(Counted const& c) const
+        {
+            ++Counted::hashes;
+            return std::hash<int>{}(c.x);
+        }
+    };
+}
+
+TEST_CASE("hashed_variant<Ts...>::hash()", "[hashed_variant]")
+{
+    using variant = eggs::variant<int, std::string>;
+    eggs::variants::hashed_variant<int, std::string> const v(std::string{"42"});
+
+    REQUIRE(v.which() == 1u);
+    REQUIRE(v.has_cached_hash() == false);
+
+    CHECK(v.hash() == std::hash<variant>{}(variant(std::string{"42"})));
+    CHECK(v.has_cached_hash() == true);
+    CHECK((std::hash<eggs::variants::hashed_variant<int, std::string>>{}(v)
+        == v.hash()));
+
+    SECTION("lazy")
+    {
+        Counted::hashes = 0;
+        eggs::variants::hashed_variant<int, Counted> v(Counted(42));
+
+        REQUIRE(Counted::hashes == 0u);
+
+        std::size_t const h = v.hash();
+        CHECK(v.hash() == h);
+        CHECK(Counted::hashes == 1u);
+
+        eggs::variants::hashed_variant<int, Counted> const c = v;
+        CHECK(c.hash() == h);
+        CHECK(Counted::hashes == 1u);
+    }
+}
+
+TEST_CASE("hashed_variant<Ts...> mutation", "[hashed_variant]")
+{
+    eggs::variants::hashed_variant<int, std::string> v(42);
+    v.hash();
+
+    REQUIRE(v.has_cached_hash() == true);
+
+    SECTION("assignment")
+    {
+        v = std::string{"42"};
+
+        CHECK(v.has_cached_hash() == false);
+        CHECK(v.which() == 1u);
+        CHECK(v.hash() == std::hash<std::string>{}("42"));
+    }
+
+    SECTION("emplace")
+    {
+        v.emplace<0>(43);
+
+        CHECK(v.has_cached_hash() == false);
+        CHECK(v.hash() == std::hash<int>{}(43));
+
+#if EGGS_CXX11_HAS_TEMPLATE_ARGUMENT_OVERLOADING
+        v.hash();
+        v.emplace<std::string>(3u, 'a');
+
+        CHECK(v.has_cached_hash() == false);
+        CHECK(v.hash() == std::hash<std::string>{}("aaa"));
+#endif
+    }
+
+    SECTION("target")
+    {
+        *v.target<int>() = 43;
+
+        CHECK(v.has_cached_hash() == false);
+        CHECK(v.hash() == std::hash<int>{}(43));
+    }
+
+    SECTION("swap")
+    {
+        eggs::variants::hashed_variant<int, std::string> w(std::string{"42"});
+        std::size_t const h = v.hash();
+
+        swap(v, w);
+
+        CHECK(v.has_cached_hash() == false);
+        CHECK(w.has_cached_hash() == true);
+        CHECK(w.hash() == h);
+        CHECK(v.which() == 1u);
+    }
+}
+
+TEST_CASE("operator==(hashed_variant<Ts...> const&, hashed_variant<Ts...> const&)", "[hashed_variant]")
+{
+    eggs::variants::hashed_variant<int, std::string> const v1(
+        eggs::variants::in_place<std::string>, "42");
+    eggs::variants::hashed_variant<int, std::string> const v2(
+        eggs::variants::in_place<1>, "42");
+    eggs::variants::hashed_variant<int, std::string> const v3(
+        std::string{"43"});
+
+    CHECK(v1 == v2);
+    CHECK(v1 != v3);
+    CHECK(v1 < v3);
+
+    v1.hash();
+    v2.hash();
+    v3.hash();
+
+    CHECK(v1 == v2);
+    CHECK(v1 != v3);
+
+    SECTION("unordered_set")
+    {
+        std::unordered_set<
+            eggs::variants::hashed_variant<int, std::string>
+        > s;
+
+        s.insert(v1);
+        s.insert(v2);
+        s.insert(v3);
+        s.insert(42);
+
+        CHECK(s.size() == 3u);
+        CHECK(s.count(std::string{"43"}) == 1u);
+    }
+}
+
+TEST_CASE("variant_size<hashed_variant<Ts...>>", "[hashed_variant]")
+{
+    std::size_t variant_size =
+        eggs::variants::variant_size<
+            eggs::variants::hashed_variant<int, std::string>
+        >::value;
+
+    CHECK(variant_size == 2u);
+}
@@ -0,0 +1,107 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/intern_pool.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using variant = eggs::variant<std::int64_t, double, std::string>;
+
+TEST_CASE("intern_pool<variant<Ts...>>::intern(variant<Ts...> const&)", "[intern_pool]")
+{
+    eggs::variants::intern_pool<variant> pool;
+    using handle = eggs::variants::intern_pool<variant>::handle;
+
+    REQUIRE(pool.size() == 0u);
+
+    handle const h1 = pool.intern(variant(std::int64_t(42)));
+    handle const h2 = pool.intern(variant(std::string{"42"}));
+    handle const h3 = pool.intern(variant(std::int64_t(42)));
+
+    CHECK(pool.size() == 2u);
+    CHECK(bool(h1) == true);
+    CHECK(h1 == h3);
+    CHECK(h1 != h2);
+    CHECK((h1 < h2 || h2 < h1));
+    CHECK(*h1 == variant(std::int64_t(42)));
+    CHECK(h2->which() == 2u);
+    CHECK(h1.hash() == std::hash<variant>{}(variant(std::int64_t(42))));
+    CHECK(std::hash<handle>{}(h2) == h2.hash());
+
+    CHECK(pool.find(variant(std::string{"42"})) == h2);
+    CHECK(bool(pool.find(variant(42.0))) == false);
+
+    SECTION("empty variant")
+    {
+        handle const e = pool.intern(variant());
+
+        CHECK(bool(e) == true);
+        CHECK(bool(*e) == false);
+        CHECK(pool.intern(variant()) == e);
+    }
+
+    SECTION("unordered_set")
+    {
+        std::unordered_set<handle> s;
+        s.insert(h1);
+        s.insert(h2);
+        s.insert(h3);
+
+        CHECK(s.size() == 2u);
+    }
+}
+
+TEST_CASE("intern_pool<variant<Ts...>> concurrent intern", "[intern_pool]")
+{
+    eggs::variants::intern_pool<variant, 4> pool;
+    using handle = eggs::variants::intern_pool<variant, 4>::handle;
+
+    std::size_t const values = 500;
+    std::size_t const threads = 4;
+
+    std::vector<std::vector<handle>> results(threads);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&results, t, values, &pool]
+        {
+            for (std::size_t i = 0; i < values; ++i)
+            {
+                std::size_t const j = (i * (t + 1)) % values;
+                variant v = j % 2 == 0
+                  ? variant(std::int64_t(j)) : variant(std::to_string(j));
+                results[t].push_back(pool.intern(std::move(v)));
+            }
+        });
+    }
+    for (std::thread& w : workers)
+        w.join();
+
+    CHECK(pool.size() == values);
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        for (std::size_t i = 0; i < values; ++i)
+        {
+            std::size_t const j = (i * (t + 1)) % values;
+            variant const v = j % 2 == 0
+              ? variant(std::int64_t(j)) : variant(std::to_string(j));
+            CHECK(results[t][i] == pool.find(v));
+            CHECK(*results[t][i] == v);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/numeric.hpp>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using number = eggs::variant<std::int32_t, std::int64_t, float, double>;
+
+static std::vector<number> make_numbers()
+{
+    std::vector<number> ns;
+    for (int i = 0; i < 10; ++i)
+        ns.push_back(std::int32_t(i));              // 45
+    ns.push_back(std::int64_t(1) << 40);
+    ns.push_back(std::int64_t(-7));
+    for (int i = 0; i < 5; ++i)
+        ns.push_back(float(i) + 0.5f);              // 12.5
+    ns.push_back(-2.25);
+    ns.push_back(std::int32_t(100));
+    ns.push_back(3.0);
+    return ns;
+}
+
+TEST_CASE("numeric::sum(RandomIt, RandomIt)", "[numeric]")
+{
+    std::vector<number> const ns = make_numbers();
+
+    CHECK((std::is_same<
+        decltype(eggs::variants::numeric::sum(ns.begin(), ns.end())),
+        double>::value));
+
+    double const expected =
+        45 + double(std::int64_t(1) << 40) - 7 + 12.5 - 2.25 + 100 + 3.0;
+    CHECK(eggs::variants::numeric::sum(ns.begin(), ns.end()) == expected);
+    CHECK(eggs::variants::numeric::sum(ns.begin(), ns.begin()) == 0.0);
+    CHECK(eggs::variants::numeric::sum(ns.begin(), ns.begin() + 7) == 21.0);
+
+    SECTION("integral")
+    {
+        using integer = eggs::variant<std::int32_t, std::int64_t>;
+        std::vector<integer> is;
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (i % 7 < 3)
+                is.push_back(std::int32_t(i));
+            else
+                is.push_back(std::int64_t(i) * 1000000000);
+        }
+
+        std::int64_t expected = 0;
+        for (int i = 0; i < 1000; ++i)
+            expected += i % 7 < 3 ? i : std::int64_t(i) * 1000000000;
+
+        std::int64_t const result =
+            eggs::variants::numeric::sum(is.begin(), is.end());
+        CHECK(result == expected);
+    }
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    SECTION("throws")
+    {
+        std::vector<number> es = ns;
+        es[13] = number();
+        CHECK_THROWS_AS(
+            eggs::variants::numeric::sum(es.begin(), es.end()),
+            eggs::variants::bad_variant_access);
+    }
+#endif
+}
+
+TEST_CASE("numeric::min(RandomIt, RandomIt)", "[numeric]")
+{
+    std::vector<number> const ns = make_numbers();
+
+    CHECK(eggs::variants::numeric::min(ns.begin(), ns.end()) == -7.0);
+    CHECK(eggs::variants::numeric::max(ns.begin(), ns.end())
+        == double(std::int64_t(1) << 40));
+    CHECK(eggs::variants::numeric::min(ns.begin(), ns.begin() + 10) == 0.0);
+    CHECK(eggs::variants::numeric::max(ns.begin(), ns.begin() + 10) == 9.0);
+    CHECK(eggs::variants::numeric::min(ns.end() - 3, ns.end()) == -2.25);
+    CHECK(eggs::variants::numeric::max(ns.end() - 3, ns.end()) == 100.0);
+}
+
+TEST_CASE("numeric::convert_to<U>(RandomIt, RandomIt, OutputIt)", "[numeric]")
+{
+    std::vector<number> const ns = make_numbers();
+
+    std::vector<double> ds;
+    eggs::variants::numeric::convert_to<double>(
+        ns.begin(), ns.end(), std::back_inserter(ds));
+
+    REQUIRE(ds.size() == ns.size());
+    CHECK(ds[3] == 3.0);
+    CHECK(ds[10] == double(std::int64_t(1) << 40));
+    CHECK(ds[11] == -7.0);
+    CHECK(ds[12] == 0.5);
+    CHECK(ds[17] == -2.25);
+    CHECK(ds[18] == 100.0);
+
+    std::vector<std::int32_t> is(ns.size(), 42);
+    std::int32_t* const last = eggs::variants::numeric::convert_to<
+        std::int32_t>(ns.begin() + 11, ns.end(), is.data());
+    CHECK(last == is.data() + (ns.size() - 11));
+    CHECK(is[0] == -7);
+    CHECK(is[1] == 0);
+    CHECK(is[6] == -2);
+    CHECK(is[8] == 3);
+    CHECK(is[9] == 42);
+}
+
+TEST_CASE("numeric::compare_to_scalar(RandomIt, RandomIt, S const&, OutputIt)", "[numeric]")
+{
+    std::vector<number> const ns = make_numbers();
+
+    std::vector<bool> less;
+    eggs::variants::numeric::compare_to_scalar(
+        ns.begin(), ns.end(), 2.5, std::back_inserter(less));
+
+    REQUIRE(less.size() == ns.size());
+    for (std::size_t i = 0; i < ns.size(); ++i)
+    {
+        double const x = eggs::variants::numeric::sum(
+            ns.begin() + i, ns.begin() + i + 1);
+        CHECK(less[i] == (x < 2.5));
+    }
+
+    std::vector<unsigned char> equal(ns.size());
+    eggs::variants::numeric::compare_to_scalar(
+        ns.begin(), ns.end(), 3, equal.begin(),
+        [](double x, int y) { return x == y; });
+    CHECK(equal[3] == 1);
+    CHECK(equal[4] == 0);
+    CHECK(equal[19] == 1);
+}
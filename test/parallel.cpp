@@ -0,0 +1,158 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/parallel.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using element = eggs::variant<int, double, std::string>;
+
+static std::vector<element> make_elements(std::size_t n)
+{
+    std::vector<element> es;
+    es.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        switch (i % 5)
+        {
+        case 0: case 1: es.push_back(int(i)); break;
+        case 2: case 3: es.push_back(double(i) + 0.5); break;
+        case 4: es.push_back(std::string(i % 7, 'x')); break;
+        }
+    }
+    return es;
+}
+
+struct scale
+{
+    void operator()(int& i) const { i *= 2; }
+    void operator()(double& d) const { d *= 4; }
+    void operator()(std::string& s) const { s += 'y'; }
+};
+
+TEST_CASE("parallel_apply(thread_pool&, RandomIt, RandomIt, F&&)", "[parallel]")
+{
+    eggs::variants::thread_pool pool(4);
+
+    std::vector<element> es = make_elements(100000);
+    eggs::variants::parallel_apply(pool, es.begin(), es.end(), scale{});
+
+    std::vector<element> const expected = make_elements(100000);
+    bool all = true;
+    for (std::size_t i = 0; i < es.size(); ++i)
+    {
+        switch (i % 5)
+        {
+        case 0: case 1:
+            all = all && *es[i].target<int>() == *expected[i].target<int>() * 2;
+            break;
+        case 2: case 3:
+            all = all && *es[i].target<double>()
+                == *expected[i].target<double>() * 4;
+            break;
+        case 4:
+            all = all && *es[i].target<std::string>()
+                == *expected[i].target<std::string>() + 'y';
+            break;
+        }
+    }
+    CHECK(all);
+
+    // empty and small ranges
+    std::vector<element> none;
+    eggs::variants::parallel_apply(pool, none.begin(), none.end(), scale{});
+
+    element few[] = {1, 2.0, std::string("a")};
+    eggs::variants::parallel_apply(pool, few, few + 3, scale{});
+    CHECK(*few[0].target<int>() == 2);
+    CHECK(*few[1].target<double>() == 8.0);
+    CHECK(*few[2].target<std::string>() == "ay");
+}
+
+struct weigh
+{
+    std::int64_t operator()(std::int64_t acc, int i) const
+    {
+        return acc + i;
+    }
+
+    std::int64_t operator()(std::int64_t acc, double d) const
+    {
+        return acc + std::int64_t(d * 2);
+    }
+
+    std::int64_t operator()(std::int64_t acc, std::string const& s) const
+    {
+        return acc + std::int64_t(s.size());
+    }
+};
+
+struct plus
+{
+    std::int64_t operator()(std::int64_t a, std::int64_t b) const
+    {
+        return a + b;
+    }
+};
+
+TEST_CASE("parallel_reduce(thread_pool&, RandomIt, RandomIt, R, F&&, Combine&&)", "[parallel]")
+{
+    eggs::variants::thread_pool pool(4);
+
+    std::vector<element> const es = make_elements(200000);
+
+    std::int64_t expected = 0;
+    for (std::size_t i = 0; i < es.size(); ++i)
+    {
+        if (int const* x = es[i].target<int>())
+            expected = weigh{}(expected, *x);
+        else if (double const* x = es[i].target<double>())
+            expected = weigh{}(expected, *x);
+        else
+            expected = weigh{}(expected, *es[i].target<std::string>());
+    }
+
+    std::int64_t const result = eggs::variants::parallel_reduce(
+        pool, es.begin(), es.end(), std::int64_t(0), weigh{}, plus{});
+    CHECK(result == expected);
+
+    std::vector<element> none;
+    CHECK(eggs::variants::parallel_reduce(
+        pool, none.begin(), none.end(), std::int64_t(0),
+        weigh{}, plus{}) == 0);
+
+    // a single worker gives the same result
+    eggs::variants::thread_pool single(1);
+    CHECK(eggs::variants::parallel_reduce(
+        single, es.begin(), es.end(), std::int64_t(0),
+        weigh{}, plus{}) == expected);
+}
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+TEST_CASE("parallel_reduce throws", "[parallel]")
+{
+    eggs::variants::thread_pool pool(2);
+
+    std::vector<element> es = make_elements(10000);
+    es[5000] = element();
+
+    CHECK_THROWS_AS(eggs::variants::parallel_reduce(
+        pool, es.begin(), es.end(), std::int64_t(0), weigh{}, plus{}),
+        eggs::variants::bad_variant_access);
+    CHECK_THROWS_AS(eggs::variants::parallel_apply(
+        pool, es.begin(), es.end(), scale{}),
+        eggs::variants::bad_variant_access);
+}
+#endif
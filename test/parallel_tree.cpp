@@ -0,0 +1,175 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/parallel_tree.hpp>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+struct node;
+
+struct Add { std::unique_ptr<node> lhs, rhs; };
+struct Mul { std::unique_ptr<node> lhs, rhs; };
+struct Neg { std::unique_ptr<node> operand; };
+struct Div { std::unique_ptr<node> lhs, rhs; };
+
+using expr = eggs::variant<long, Add, Mul, Neg, Div>;
+
+struct node { expr e; };
+
+static std::unique_ptr<node> leaf(long v)
+{
+    return std::unique_ptr<node>(new node{expr(v)});
+}
+
+template <typename Op>
+static std::unique_ptr<node> binary(
+    std::unique_ptr<node> lhs, std::unique_ptr<node> rhs)
+{
+    return std::unique_ptr<node>(
+        new node{expr(Op{std::move(lhs), std::move(rhs)})});
+}
+
+// a balanced tree whose value is the sum of `[first, last)`
+static std::unique_ptr<node> sum_tree(long first, long last)
+{
+    if (last - first == 1)
+        return leaf(first);
+    long const mid = first + (last - first) / 2;
+    return binary<Add>(sum_tree(first, mid), sum_tree(mid, last));
+}
+
+struct evaluate
+{
+    template <typename Eval>
+    long operator()(long v, Eval const&) const
+    {
+        return v;
+    }
+
+    template <typename Eval>
+    long operator()(Add const& a, Eval const& eval) const
+    {
+        std::array<long, 2> const r = eval.fork(a.lhs->e, a.rhs->e);
+        return r[0] + r[1];
+    }
+
+    template <typename Eval>
+    long operator()(Mul const& m, Eval const& eval) const
+    {
+        std::array<long, 2> const r = eval.fork(m.lhs->e, m.rhs->e);
+        return r[0] * r[1];
+    }
+
+    template <typename Eval>
+    long operator()(Neg const& n, Eval const& eval) const
+    {
+        return -eval(n.operand->e);
+    }
+
+    template <typename Eval>
+    long operator()(Div const& d, Eval const& eval) const
+    {
+        long const rhs = eval(d.rhs->e);
+        if (rhs == 0)
+            throw std::domain_error("division by zero");
+        return eval(d.lhs->e) / rhs;
+    }
+};
+
+TEST_CASE("parallel_evaluate<R>(thread_pool&, V&&, F&&)", "[parallel_tree]")
+{
+    eggs::variants::thread_pool pool(4);
+
+    // -(2 * 3) + (10 / 4)
+    std::unique_ptr<node> const small = binary<Add>(
+        std::unique_ptr<node>(new node{expr(Neg{
+            binary<Mul>(leaf(2), leaf(3))})}),
+        binary<Div>(leaf(10), leaf(4)));
+    CHECK(eggs::variants::parallel_evaluate<long>(
+        pool, small->e, evaluate{}) == -4);
+
+    std::unique_ptr<node> const big = sum_tree(0, 1 << 14);
+    long const expected = (1L << 14) * ((1L << 14) - 1) / 2;
+    CHECK(eggs::variants::parallel_evaluate<long>(
+        pool, big->e, evaluate{}) == expected);
+
+    // sequential from the root
+    CHECK(eggs::variants::parallel_evaluate<long>(
+        pool, big->e, evaluate{}, 0) == expected);
+
+    // forking all the way down
+    CHECK(eggs::variants::parallel_evaluate<long>(
+        pool, big->e, evaluate{}, 64) == expected);
+}
+
+struct depths
+{
+    template <typename Eval>
+    std::size_t operator()(long, Eval const& eval) const
+    {
+        return eval.depth();
+    }
+
+    template <typename T, typename Eval>
+    std::size_t operator()(T const& t, Eval const& eval) const
+    {
+        std::array<std::size_t, 2> const r = eval.fork(t.lhs->e, t.rhs->e);
+        return r[0] > r[1] ? r[0] : r[1];
+    }
+
+    template <typename Eval>
+    std::size_t operator()(Neg const& n, Eval const& eval) const
+    {
+        return eval(n.operand->e);
+    }
+};
+
+TEST_CASE("tree_evaluator<R, F>", "[parallel_tree]")
+{
+    eggs::variants::thread_pool pool(4);
+    depths f;
+
+    using evaluator = eggs::variants::tree_evaluator<std::size_t, depths>;
+    CHECK((std::is_same<evaluator::result_type, std::size_t>::value));
+
+    evaluator const eval(pool, f, 3);
+    CHECK(eval.depth() == 0u);
+    CHECK(eval.cutoff() == 3u);
+
+    // the depth stops growing at the cutoff
+    std::unique_ptr<node> const tree = sum_tree(0, 64);
+    CHECK(eval(tree->e) == 3u);
+
+    CHECK(evaluator::default_cutoff(pool) == 6u);
+    eggs::variants::thread_pool single(1);
+    CHECK(evaluator::default_cutoff(single) == 0u);
+}
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+TEST_CASE("parallel_evaluate<R> throws", "[parallel_tree]")
+{
+    eggs::variants::thread_pool pool(2);
+
+    std::unique_ptr<node> const tree = binary<Add>(
+        sum_tree(0, 256), binary<Div>(leaf(1), leaf(0)));
+    CHECK_THROWS_AS(eggs::variants::parallel_evaluate<long>(
+        pool, tree->e, evaluate{}), std::domain_error);
+
+    expr const empty;
+    CHECK_THROWS_AS(eggs::variants::parallel_evaluate<long>(
+        pool, empty, evaluate{}), eggs::variants::bad_variant_access);
+}
+#endif
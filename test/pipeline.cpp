@@ -0,0 +1,201 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/pipeline.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#if EGGS_CXX20_HAS_COROUTINES
+using message = eggs::variant<int, std::string, double>;
+using eggs::variants::generator;
+
+static generator<message> numbers(int count, int* produced)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        ++*produced;
+        co_yield message(i);
+    }
+}
+
+static generator<message> failing()
+{
+    co_yield message(1);
+    throw std::runtime_error("upstream");
+}
+
+TEST_CASE("generator<T>", "[pipeline]")
+{
+    // elements of a range are yielded by reference
+    std::vector<message> messages = {message(1), message(std::string("a"))};
+    std::vector<message*> seen;
+    for (message& m : eggs::variants::source(messages))
+        seen.push_back(&m);
+    REQUIRE(seen.size() == 2u);
+    CHECK(seen[0] == &messages[0]);
+    CHECK(seen[1] == &messages[1]);
+
+    // the coroutine runs only as far as it is pulled
+    int produced = 0;
+    {
+        generator<message> g = numbers(10, &produced);
+        CHECK(produced == 0);
+
+        generator<message> moved = std::move(g);
+        generator<message>::iterator it = moved.begin();
+        CHECK(produced == 1);
+        CHECK(eggs::variants::get<int>(*it) == 0);
+        ++it;
+        CHECK(produced == 2);
+        CHECK(it->which() == 0u);
+    }
+    CHECK(produced == 2);
+
+    int empty = 0;
+    generator<message> none = numbers(0, &empty);
+    CHECK(none.begin() == none.end());
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    generator<message> throws = failing();
+    generator<message>::iterator it = throws.begin();
+    CHECK(it != throws.end());
+    CHECK_THROWS_AS(++it, std::runtime_error);
+    CHECK(it == throws.end());
+#endif
+}
+
+struct shout
+{
+    void operator()(std::string& s) const { s += "!"; }
+};
+
+struct halve
+{
+    double operator()(int& i) const { return i / 2.0; }
+};
+
+struct even
+{
+    bool operator()(int& i) const { return i % 2 == 0; }
+};
+
+struct collect
+{
+    std::vector<std::string>* log;
+
+    void operator()(int i) const { log->push_back(std::to_string(i)); }
+    void operator()(double d) const { log->push_back(std::to_string(d)); }
+    void operator()(std::string const& s) const { log->push_back(s); }
+};
+
+TEST_CASE("generator<variant<Ts...>> | stages", "[pipeline]")
+{
+    using eggs::variants::filter_stage;
+    using eggs::variants::sink;
+    using eggs::variants::source;
+    using eggs::variants::transform_stage;
+
+    std::vector<message> messages = {
+        message(1), message(std::string("a")), message(2),
+        message(0.5), message(3), message(4)};
+
+    // stages handle only some alternatives, and forward the rest untouched;
+    // parameters taken by reference keep `int` handlers from taking doubles
+    std::vector<std::string> log;
+    std::size_t const count = source(messages)
+      | filter_stage(even())
+      | transform_stage(shout())
+      | transform_stage(halve())
+      | sink(collect{&log});
+
+    CHECK(count == 4u);
+    REQUIRE(log.size() == 4u);
+    CHECK(log[0] == "a!");
+    CHECK(log[1] == std::to_string(1.0));
+    CHECK(log[2] == std::to_string(0.5));
+    CHECK(log[3] == std::to_string(2.0));
+
+    // messages are transformed in place, by reference
+    CHECK(eggs::variants::get<std::string>(messages[1]) == "a!");
+    CHECK(eggs::variants::get<double>(messages[2]) == 1.0);
+    CHECK(eggs::variants::get<int>(messages[0]) == 1);
+
+    // sinks ignore alternatives they do not handle
+    std::size_t ints = 0;
+    CHECK((source(messages)
+      | sink([&ints](int&) { ++ints; })) == 6u);
+    CHECK(ints == 2u);
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    std::vector<message> empty(1);
+    CHECK_THROWS_AS(
+        source(empty) | sink(collect{&log}),
+        eggs::variants::bad_variant_access);
+    CHECK_THROWS_AS(
+        failing() | transform_stage(shout()) | sink(collect{&log}),
+        std::runtime_error);
+#endif
+}
+
+// counts copies and moves, to check that messages pass by reference
+struct tracked
+{
+    static std::size_t copies;
+
+    int value;
+
+    explicit tracked(int value) : value(value) {}
+    tracked(tracked const& other) : value(other.value) { ++copies; }
+    tracked(tracked&& other) : value(other.value) { ++copies; }
+    tracked& operator=(tracked const& other)
+    {
+        value = other.value;
+        ++copies;
+        return *this;
+    }
+};
+
+std::size_t tracked::copies = 0;
+
+TEST_CASE("generator<variant<Ts...>> by reference", "[pipeline]")
+{
+    using eggs::variants::filter_stage;
+    using eggs::variants::sink;
+    using eggs::variants::source;
+    using eggs::variants::transform_stage;
+
+    using tracked_message = eggs::variant<tracked, int>;
+    std::vector<tracked_message> messages;
+    messages.reserve(1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (i % 4 == 0)
+            messages.emplace_back(i);
+        else
+            messages.emplace_back(eggs::variants::in_place<tracked>, i);
+    }
+
+    int total = 0;
+    tracked::copies = 0;
+    std::size_t const count = source(messages)
+      | filter_stage([](tracked& t) { return t.value % 2 != 0; })
+      | transform_stage([](tracked& t) { t.value *= 2; })
+      | sink([&total](tracked& t) { total += t.value; });
+
+    CHECK(count == 750u);
+    CHECK(total == 2 * 500 * 500);
+    CHECK(tracked::copies == 0u);
+}
+#endif
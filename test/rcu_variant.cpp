@@ -0,0 +1,149 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/rcu_variant.hpp>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+EGGS_CXX11_STATIC_CONSTEXPR std::size_t npos = eggs::variant<>::npos;
+
+static std::atomic<int> alive(0);
+
+// a rule set whose elements all equal its size, so that a reader can tell a
+// value destroyed or modified under it
+struct rules
+{
+    std::vector<int> values;
+
+    explicit rules(int n) : values(std::size_t(n), n) { ++alive; }
+    rules(rules const& other) : values(other.values) { ++alive; }
+    ~rules()
+    {
+        for (int& v : values)
+            v = -1;
+        --alive;
+    }
+
+    bool consistent() const
+    {
+        for (int v : values)
+        {
+            if (v != int(values.size()))
+                return false;
+        }
+        return true;
+    }
+};
+
+using config = eggs::variants::rcu_variant<std::string, rules>;
+
+TEST_CASE("rcu_variant<Ts...>::rcu_variant()", "[rcu_variant]")
+{
+    config empty;
+    CHECK(empty.load().which() == npos);
+
+    config c(std::string("default"));
+    config::read_guard const guard = c.read();
+    REQUIRE(guard->which() == 0u);
+    CHECK(*guard.get().target<std::string>() == "default");
+    CHECK(&*guard == &guard.get());
+}
+
+TEST_CASE("rcu_variant<Ts...>::store", "[rcu_variant]")
+{
+    eggs::variants::rcu_synchronize();
+    int const before = alive.load();
+    {
+        config c(rules(3));
+        CHECK(alive.load() == before + 1);
+
+        {
+            config::read_guard const guard = c.read();
+            rules const& r = *guard->target<rules>();
+
+            // the value read stays alive while the guard is held
+            c.store(rules(5));
+            CHECK(r.values.size() == 3u);
+            CHECK(r.consistent());
+            CHECK(alive.load() == before + 2);
+
+            // new guards see the new value; nesting keeps the thread pinned
+            config::read_guard const nested = c.read();
+            CHECK(nested->target<rules>()->values.size() == 5u);
+        }
+
+        CHECK(eggs::variants::rcu_synchronize() >= 1u);
+        CHECK(alive.load() == before + 1);
+
+        c.emplace<std::string>("override");
+        CHECK(*c.load().target<std::string>() == "override");
+        c.emplace<1>(7);
+        CHECK(c.load().target<rules>()->values.size() == 7u);
+
+        c.update([](config::value_type const& v)
+        {
+            return config::value_type(
+                rules(int(v.target<rules>()->values.size()) + 1));
+        });
+        CHECK(c.load().target<rules>()->values.size() == 8u);
+    }
+    eggs::variants::rcu_synchronize();
+    CHECK(alive.load() == before);
+}
+
+TEST_CASE("rcu_variant<Ts...> contention", "[rcu_variant]")
+{
+    eggs::variants::rcu_synchronize();
+    int const before = alive.load();
+    {
+        config c(rules(1));
+
+        std::atomic<bool> done(false);
+        std::atomic<bool> torn(false);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r)
+        {
+            readers.emplace_back([&]
+            {
+                while (!done.load(std::memory_order_acquire))
+                {
+                    config::read_guard const guard = c.read();
+                    rules const* value = guard->target<rules>();
+                    if (value != nullptr && !value->consistent())
+                        torn.store(true);
+                    std::this_thread::yield();
+                    if (value != nullptr && !value->consistent())
+                        torn.store(true);
+                }
+            });
+        }
+
+        for (int i = 2; i < 2000; ++i)
+        {
+            if (i % 10 == 0)
+                c.store(std::string("reset"));
+            else
+                c.store(rules(i % 64 + 1));
+        }
+        done.store(true, std::memory_order_release);
+        for (std::thread& reader : readers)
+            reader.join();
+
+        CHECK_FALSE(torn.load());
+    }
+    eggs::variants::rcu_synchronize();
+    CHECK(alive.load() == before);
+}
@@ -0,0 +1,145 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/seqlock_variant.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+EGGS_CXX11_STATIC_CONSTEXPR std::size_t npos = eggs::variant<>::npos;
+
+struct Halted { int reason; };
+
+// every level holds the same sequence number, so that a torn copy can be
+// told apart
+struct Book
+{
+    std::uint64_t seq;
+    double bid[8];
+    double ask[8];
+    std::uint64_t check;
+};
+
+using snapshot = eggs::variants::seqlock_variant<Halted, Book>;
+
+static Book make_book(std::uint64_t seq)
+{
+    Book b;
+    b.seq = seq;
+    for (int i = 0; i < 8; ++i)
+    {
+        b.bid[i] = double(seq) - i;
+        b.ask[i] = double(seq) + i;
+    }
+    b.check = ~seq;
+    return b;
+}
+
+static bool consistent(Book const& b)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        if (b.bid[i] != double(b.seq) - i || b.ask[i] != double(b.seq) + i)
+            return false;
+    }
+    return b.check == ~b.seq;
+}
+
+TEST_CASE("seqlock_variant<Ts...>::seqlock_variant()", "[seqlock_variant]")
+{
+    snapshot s;
+    CHECK(s.load().which() == npos);
+    CHECK(s.version() == 1u);
+
+    snapshot h(Halted{3});
+    snapshot::value_type const v = h;
+    REQUIRE(v.which() == 0u);
+    CHECK(v.target<Halted>()->reason == 3);
+}
+
+TEST_CASE("seqlock_variant<Ts...>::store", "[seqlock_variant]")
+{
+    snapshot s;
+
+    s.store(make_book(7));
+    CHECK(s.version() == 2u);
+
+    snapshot::value_type v;
+    REQUIRE(s.try_load(v));
+    REQUIRE(v.which() == 1u);
+    CHECK(v.target<Book>()->seq == 7u);
+    CHECK(consistent(*v.target<Book>()));
+
+    s = Halted{1};
+    CHECK(s.version() == 3u);
+    CHECK(s.load().target<Halted>()->reason == 1);
+
+    s.emplace<0>(Halted{2});
+    CHECK(s.load().target<Halted>()->reason == 2);
+
+    s.emplace<Book>(make_book(9));
+    CHECK(s.load().target<Book>()->seq == 9u);
+    CHECK(s.version() == 5u);
+}
+
+TEST_CASE("seqlock_variant<Ts...> contention", "[seqlock_variant]")
+{
+    std::size_t const readers = 3;
+    std::uint64_t const writes = 50000;
+
+    snapshot s(make_book(0));
+    std::atomic<bool> done(false);
+    std::atomic<bool> torn(false);
+    std::atomic<bool> backwards(false);
+
+    std::vector<std::thread> threads;
+    for (std::size_t r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&]
+        {
+            std::uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire))
+            {
+                snapshot::value_type const v = s.load();
+                Book const* b = v.target<Book>();
+                if (b == nullptr)
+                    continue;
+                if (!consistent(*b))
+                    torn.store(true);
+                if (b->seq < last)
+                    backwards.store(true);
+                last = b->seq;
+            }
+        });
+    }
+
+    for (std::uint64_t i = 1; i <= writes; ++i)
+    {
+        if (i % 64 == 0)
+            s.emplace<Halted>(Halted{int(i)});
+        else
+            s.store(make_book(i));
+    }
+    s.store(make_book(writes + 1));
+    done.store(true, std::memory_order_release);
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    CHECK_FALSE(torn.load());
+    CHECK_FALSE(backwards.load());
+    CHECK(s.version() == writes + 2);
+    CHECK(s.load().target<Book>()->seq == writes + 1);
+}
@@ -0,0 +1,160 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/sharded_executor.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using message = eggs::variant<int, std::string, double>;
+
+// a per-shard handler that records what it handled, and on which thread
+struct recorder
+{
+    std::vector<int> ints;
+    std::vector<std::string> strings;
+    std::size_t doubles;
+    std::thread::id thread;
+    bool one_thread;
+
+    recorder() : doubles(0), one_thread(true) {}
+
+    void seen()
+    {
+        if (thread == std::thread::id())
+            thread = std::this_thread::get_id();
+        one_thread = one_thread && thread == std::this_thread::get_id();
+    }
+
+    void operator()(int i) { seen(); ints.push_back(i); }
+    void operator()(std::string&& s)
+    {
+        seen();
+        strings.push_back(std::move(s));
+    }
+    void operator()(double) { seen(); ++doubles; }
+};
+
+using executor = eggs::variants::sharded_executor<message, recorder>;
+
+TEST_CASE("sharded_executor<variant<Ts...>, F>::submit", "[sharded_executor]")
+{
+    executor e(recorder(), 3, 8);
+    REQUIRE(e.shards() == 3u);
+    CHECK(e.shard_of(0) == 0u);
+    CHECK(e.shard_of(1) == 1u);
+    CHECK(e.shard_of(2) == 2u);
+
+    // more messages than the queues hold, to exercise backpressure
+    for (int i = 0; i < 1000; ++i)
+    {
+        e.submit(message(i));
+        if (i % 10 == 0)
+            e.emplace<std::string>(std::size_t(i % 7), 'x');
+        if (i % 100 == 0)
+            e.submit(message(double(i)));
+    }
+    e.flush();
+
+    // every message of an alternative goes to the same shard, in order
+    recorder const& ints = e.handler(0);
+    REQUIRE(ints.ints.size() == 1000u);
+    for (int i = 0; i < 1000; ++i)
+        CHECK(ints.ints[std::size_t(i)] == i);
+    CHECK(ints.strings.empty());
+    CHECK(ints.doubles == 0u);
+    CHECK(ints.one_thread);
+
+    recorder const& strings = e.handler(1);
+    REQUIRE(strings.strings.size() == 100u);
+    for (std::size_t i = 0; i < 100; ++i)
+        CHECK(strings.strings[i].size() == i * 10 % 7);
+    CHECK(strings.ints.empty());
+    CHECK(strings.one_thread);
+
+    CHECK(e.handler(2).doubles == 10u);
+    CHECK(e.handler(2).ints.empty());
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(e.submit(message()), eggs::variants::bad_variant_access);
+#endif
+}
+
+TEST_CASE("sharded_executor<variant<Ts...>, F>::submit(v, key)", "[sharded_executor]")
+{
+    executor e(recorder(), 4);
+
+    for (int i = 0; i < 4000; ++i)
+        e.submit(message(i), std::size_t(i % 16));
+    e.flush();
+
+    // messages with the same key go to the same shard, in order
+    std::size_t total = 0;
+    for (std::size_t shard = 0; shard < e.shards(); ++shard)
+    {
+        std::vector<int> const& ints = e.handler(shard).ints;
+        total += ints.size();
+        for (std::size_t i = 0; i < ints.size(); ++i)
+        {
+            std::size_t const key = std::size_t(ints[i] % 16);
+            CHECK(e.shard_of(0, key) == shard);
+            if (i != 0 && ints[i - 1] % 16 == ints[i] % 16)
+                CHECK(ints[i - 1] < ints[i]);
+        }
+    }
+    CHECK(total == 4000u);
+
+    // try_submit and submit_to
+    CHECK(e.try_submit(message(std::string("a"))) == true);
+    e.submit_to(3, message(std::string("b")));
+    e.flush();
+    REQUIRE(e.handler(1).strings.size() == 1u);
+    CHECK(e.handler(1).strings[0] == "a");
+    REQUIRE(e.handler(3).strings.size() == 1u);
+    CHECK(e.handler(3).strings[0] == "b");
+}
+
+struct failing
+{
+    int handled;
+
+    failing() : handled(0) {}
+
+    template <typename T>
+    void operator()(T const&)
+    {
+        if (++handled == 2)
+            throw std::runtime_error("second");
+    }
+};
+
+TEST_CASE("sharded_executor<variant<Ts...>, F>::flush", "[sharded_executor]")
+{
+    eggs::variants::sharded_executor<message, failing> e(failing(), 1);
+
+    // idle workers go to sleep, and are woken by new messages
+    e.submit(message(1));
+    e.flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    e.submit(message(2));
+    e.submit(message(3));
+    CHECK_THROWS_AS(e.flush(), std::runtime_error);
+    CHECK(e.handler(0).handled == 3);
+
+    e.flush();
+#endif
+}
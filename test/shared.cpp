@@ -0,0 +1,136 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/shared.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+struct Payload
+{
+    static std::size_t copies;
+    std::vector<int> data;
+
+    Payload(std::size_t n) : data(n, 42) {}
+    Payload(Payload const& rhs) : data(rhs.data) { ++copies; }
+
+    bool operator==(Payload const& rhs) const { return data == rhs.data; }
+    bool operator<(Payload const& rhs) const { return data < rhs.data; }
+};
+
+std::size_t Payload::copies = 0;
+
+TEST_CASE("shared<T>", "[shared]")
+{
+    Payload::copies = 0;
+    eggs::variants::shared<Payload> s(eggs::variants::in_place<Payload>, 1000u);
+
+    REQUIRE(s.use_count() == 1u);
+    REQUIRE(s.unique());
+    CHECK(s->data.size() == 1000u);
+
+    eggs::variants::shared<Payload> c = s;
+
+    CHECK(Payload::copies == 0u);
+    CHECK(s.use_count() == 2u);
+    CHECK(&c.get() == &s.get());
+    CHECK(c == s);
+
+    SECTION("mutate shared")
+    {
+        c.mutate().data[0] = 43;
+
+        CHECK(Payload::copies == 1u);
+        CHECK(c.unique());
+        CHECK(s.unique());
+        CHECK(s->data[0] == 42);
+        CHECK(c->data[0] == 43);
+        CHECK(c != s);
+        CHECK(s < c);
+    }
+
+    SECTION("mutate unique")
+    {
+        c = eggs::variants::shared<Payload>(Payload(10));
+        std::size_t const copies = Payload::copies;
+
+        c.mutate().data[0] = 43;
+
+        CHECK(Payload::copies == copies);
+        CHECK(s.unique());
+    }
+
+    SECTION("move")
+    {
+        eggs::variants::shared<Payload> m = std::move(c);
+
+        CHECK(Payload::copies == 0u);
+        CHECK(m.use_count() == 3u);
+        CHECK(&c.get() == &m.get());
+        CHECK(c == m);
+
+        c = std::move(m);
+        CHECK(c.use_count() == 3u);
+        CHECK(m->data.size() == 1000u);
+    }
+}
+
+TEST_CASE("variant<shared<T>>", "[shared]")
+{
+    using variant = eggs::variant<int, eggs::variants::shared<std::string>>;
+    using shared = eggs::variants::shared<std::string>;
+
+    variant v(shared(std::string(1000, 'a')));
+    variant const c = v;
+
+    shared const* cs = c.target<shared>();
+    REQUIRE(cs != nullptr);
+    CHECK(cs->use_count() == 2u);
+    CHECK(&cs->get() == &v.target<shared>()->get());
+    CHECK(v == c);
+
+    v.target<shared>()->mutate() += 'b';
+
+    CHECK(cs->unique());
+    CHECK(v != c);
+    CHECK(c < v);
+    CHECK(std::hash<variant>{}(c) == std::hash<std::string>{}(std::string(1000, 'a')));
+}
+
+TEST_CASE("variant<shared<T>> moved-from", "[shared]")
+{
+    using variant = eggs::variant<int, eggs::variants::shared<std::string>>;
+    using shared = eggs::variants::shared<std::string>;
+
+    variant v(shared(std::string(1000, 'a')));
+    variant const m = std::move(v);
+
+    // the moved-from variant still holds a valid shared<T>
+    REQUIRE(v.which() == 1u);
+    shared const* vs = v.target<shared>();
+    REQUIRE(vs != nullptr);
+    CHECK(vs->get() == std::string(1000, 'a'));
+    CHECK(vs->use_count() == 2u);
+    CHECK(v == m);
+    CHECK_FALSE(v < m);
+    CHECK(v != variant(shared(std::string("b"))));
+    CHECK(std::hash<variant>{}(v) == std::hash<variant>{}(m));
+
+    variant w(42);
+    w = std::move(v);
+    CHECK(w == m);
+    CHECK(v == m);
+    CHECK(v.target<shared>()->use_count() == 3u);
+}
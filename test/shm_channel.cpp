@@ -0,0 +1,163 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/shm_channel.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_POSIX_HAS_SHARED_MEMORY
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#if EGGS_POSIX_HAS_SHARED_MEMORY
+struct point { int x; int y; };
+
+using channel = eggs::variants::shm_channel<int, double, point>;
+
+static std::string unique_name(char const* tag)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name),
+        "/eggs_variant_%s_%ld", tag, static_cast<long>(::getpid()));
+    return name;
+}
+
+// records the messages it sees, as their alternative and a value
+struct recorder
+{
+    std::vector<int>* log;
+
+    void operator()(int const& i) const { log->push_back(i); }
+    void operator()(double const& d) const { log->push_back(-int(d)); }
+    void operator()(point const& p) const { log->push_back(p.x + p.y); }
+};
+
+TEST_CASE("shm_channel<Ts...>::create", "[shm_channel]")
+{
+    std::string const name = unique_name("create");
+    channel sender = channel::create(name.c_str(), 3);
+    REQUIRE(sender.capacity() == 4u);
+    CHECK(sender.empty());
+
+    channel receiver = channel::open(name.c_str());
+    CHECK(receiver.capacity() == 4u);
+
+    CHECK(sender.try_emplace<0>(1) == true);
+    CHECK(sender.try_send(channel::value_type(2.0)) == true);
+    CHECK(sender.try_emplace<point>(point{1, 2}) == true);
+    CHECK(sender.try_emplace<int>(4) == true);
+    CHECK(sender.try_emplace<int>(5) == false);
+    CHECK(receiver.size_approx() == 4u);
+
+    std::vector<int> log;
+    recorder const r = {&log};
+    CHECK(receiver.consume(r) == true);
+    CHECK(receiver.consume(r, 8) == 3u);
+    CHECK(receiver.consume(r) == false);
+    REQUIRE(log.size() == 4u);
+    CHECK(log[0] == 1);
+    CHECK(log[1] == -2);
+    CHECK(log[2] == 3);
+    CHECK(log[3] == 4);
+
+    // a moved-to channel takes over the mapping
+    channel moved = std::move(receiver);
+    CHECK(moved.empty());
+    CHECK(moved.wait_for(std::chrono::milliseconds(1)) == false);
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(
+        sender.try_send(channel::value_type()),
+        eggs::variants::bad_variant_access);
+    CHECK_THROWS_AS(channel::create(name.c_str(), 4), std::system_error);
+#endif
+}
+
+TEST_CASE("shm_channel<Ts...>::open", "[shm_channel]")
+{
+    std::string const name = unique_name("open");
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(channel::open(name.c_str()), std::system_error);
+
+    channel const owner = channel::create(name.c_str(), 4);
+    using reordered = eggs::variants::shm_channel<double, int, point>;
+    CHECK_THROWS_AS(reordered::open(name.c_str()), std::runtime_error);
+    using narrower = eggs::variants::shm_channel<int, float, point>;
+    CHECK_THROWS_AS(narrower::open(name.c_str()), std::runtime_error);
+#endif
+
+    // the object is removed with the channel that created it
+    {
+        channel const scoped = channel::create((name + "_2").c_str(), 4);
+    }
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(channel::open((name + "_2").c_str()), std::system_error);
+#endif
+}
+
+TEST_CASE("shm_channel<Ts...> between processes", "[shm_channel]")
+{
+    std::string const name = unique_name("processes");
+    channel receiver = channel::create(name.c_str(), 16);
+
+    // the child sends many more messages than fit, so both sides block
+    int const count = 100000;
+    ::pid_t const pid = ::fork();
+    REQUIRE(pid != -1);
+    if (pid == 0)
+    {
+        // the child reports failure by dying, not through the test runner
+        ::alarm(30);
+        channel sender = channel::open(name.c_str());
+        for (int i = 0; i < count; ++i)
+        {
+            if (i % 3 == 0)
+                sender.send(channel::value_type(i));
+            else if (i % 3 == 1)
+                sender.emplace<double>(double(i));
+            else
+                sender.emplace<point>(point{i, 0});
+        }
+        ::_exit(0);
+    }
+
+    std::vector<int> log;
+    log.reserve(count);
+    recorder const r = {&log};
+    while (log.size() < std::size_t(count)
+        && receiver.wait_for(std::chrono::seconds(30)))
+    {
+        receiver.consume(r, 7);
+    }
+    REQUIRE(log.size() == std::size_t(count));
+
+    int status = -1;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+
+    bool in_order = true;
+    for (int i = 0; i < count; ++i)
+        in_order = in_order && log[std::size_t(i)] == (i % 3 == 1 ? -i : i);
+    CHECK(in_order);
+    CHECK(receiver.empty());
+}
+#endif
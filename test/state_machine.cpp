@@ -0,0 +1,198 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/state_machine.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using eggs::variants::transition;
+using eggs::variants::transition_to;
+
+struct idle
+{
+    int visits;
+
+    explicit idle(int visits = 0)
+      : visits(visits)
+    {}
+};
+
+struct connecting
+{
+    std::string host;
+    int attempts;
+
+    connecting(std::string host, int attempts)
+      : host(std::move(host)), attempts(attempts)
+    {}
+};
+
+struct connected
+{
+    std::string host;
+
+    explicit connected(std::string host)
+      : host(std::move(host))
+    {
+        if (this->host == "unreachable")
+            throw std::runtime_error("unreachable");
+    }
+};
+
+struct connect { std::string host; };
+struct retry {};
+struct established {};
+struct drop {};
+
+struct protocol
+{
+    transition<connecting, std::string, int>
+    operator()(idle&, connect const& e) const
+    {
+        return transition_to<connecting>(e.host, 1);
+    }
+
+    void operator()(connecting& s, retry const&) const
+    {
+        ++s.attempts;
+    }
+
+    transition<connected, std::string>
+    operator()(connecting& s, established const&) const
+    {
+        // the current state is destroyed first, so its members are copied
+        return transition_to<connected>(s.host);
+    }
+
+    transition<idle, int>
+    operator()(connected&, drop const&) const
+    {
+        return transition_to<idle>(1);
+    }
+};
+
+struct logger
+{
+    std::vector<std::string>* log;
+
+    template <typename S, typename E>
+    void on_exit(S const&, E const&) const { log->push_back("exit"); }
+
+    template <typename S, typename E>
+    void on_enter(S const&, E const&) const { log->push_back("enter"); }
+
+    void on_enter(connecting const& s, connect const&) const
+    {
+        log->push_back("enter " + s.host);
+    }
+
+    template <typename S, typename E>
+    void on_internal(S const&, E const&) const { log->push_back("internal"); }
+
+    template <typename S, typename E>
+    void on_unhandled(S const&, E const&) const
+    {
+        log->push_back("unhandled");
+    }
+};
+
+using states = eggs::variant<idle, connecting, connected>;
+using events = eggs::variant<connect, retry, established, drop>;
+using machine = eggs::variants::state_machine<states, events, protocol>;
+using traced_machine =
+    eggs::variants::state_machine<states, events, protocol, logger>;
+
+TEST_CASE("state_machine<variant<Ss...>, variant<Es...>, Table>"
+    , "[state_machine]")
+{
+    machine m;
+    REQUIRE(m.state().which() == 0u);
+    CHECK(eggs::variants::get<idle>(m.state()).visits == 0);
+
+    void const* const storage = m.state().target();
+
+    CHECK(m.process(events(connect{"example.com"})) == true);
+    REQUIRE(m.state().which() == 1u);
+    CHECK(eggs::variants::get<connecting>(m.state()).host == "example.com");
+    CHECK(eggs::variants::get<connecting>(m.state()).attempts == 1);
+
+    // internal transitions update the current state
+    CHECK(m.process(events(retry{})) == true);
+    CHECK(m.process(retry{}) == true);
+    CHECK(eggs::variants::get<connecting>(m.state()).attempts == 3);
+
+    CHECK(m.process(established{}) == true);
+    REQUIRE(m.state().which() == 2u);
+    CHECK(eggs::variants::get<connected>(m.state()).host == "example.com");
+
+    CHECK(m.process(events(drop{})) == true);
+    REQUIRE(m.state().which() == 0u);
+    CHECK(eggs::variants::get<idle>(m.state()).visits == 1);
+
+    // every state is constructed in the same storage
+    CHECK(m.state().target() == storage);
+
+    // pairs with no entry leave the state untouched
+    CHECK(m.process(events(drop{})) == false);
+    CHECK(m.process(retry{}) == false);
+    CHECK(m.state().which() == 0u);
+
+    CHECK((machine::handles<idle, connect>()));
+    CHECK((machine::handles<connecting, retry>()));
+    CHECK_FALSE((machine::handles<idle, retry>()));
+    CHECK_FALSE((machine::handles<connected, connect>()));
+
+    m.reset<connecting>("reset", 5);
+    CHECK(eggs::variants::get<connecting>(m.state()).attempts == 5);
+    m.reset<0>();
+    CHECK(m.state().which() == 0u);
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(
+        m.process(events()), eggs::variants::bad_variant_access);
+    CHECK(m.state().which() == 0u);
+
+    // a throwing constructor leaves the machine with no state
+    m.process(connect{"unreachable"});
+    CHECK_THROWS_AS(m.process(established{}), std::runtime_error);
+    CHECK(m.state().which() == states::npos);
+    CHECK_THROWS_AS(
+        m.process(drop{}), eggs::variants::bad_variant_access);
+    CHECK_THROWS_AS(
+        m.process(events(drop{})), eggs::variants::bad_variant_access);
+
+    m.reset<idle>();
+    CHECK(m.process(connect{"example.com"}) == true);
+#endif
+}
+
+TEST_CASE("state_machine<variant<Ss...>, variant<Es...>, Table, Tracer>"
+    , "[state_machine]")
+{
+    std::vector<std::string> log;
+    traced_machine m(protocol(), logger{&log});
+
+    m.process(events(connect{"example.com"}));
+    m.process(retry{});
+    m.process(events(connect{"example.com"}));
+    m.process(established{});
+
+    std::vector<std::string> const expected = {
+        "exit", "enter example.com",
+        "internal",
+        "unhandled",
+        "exit", "enter"};
+    CHECK(log == expected);
+    CHECK(m.tracer().log == &log);
+}
@@ -0,0 +1,161 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/tag_scan.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+EGGS_CXX11_STATIC_CONSTEXPR std::size_t npos = eggs::variant<>::npos;
+
+using variant = eggs::variant<int, std::string, double>;
+using column = eggs::variants::variant_column<int, std::string, double>;
+
+// sizes straddling the 16, 32 and 64 element vector blocks, and the 255
+// block flush of the byte counters
+static std::size_t const sizes[] = {0, 1, 15, 16, 17, 63, 64, 65, 1000, 9000};
+
+static column make_column(std::size_t n)
+{
+    column c;
+    std::uint32_t x = 12345;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x = x * 1664525u + 1013904223u;
+        switch ((x >> 24) % 5)
+        {
+        case 0: case 1: c.push_back(variant(int(i))); break;
+        case 2: c.push_back(variant(std::string("s"))); break;
+        case 3: c.push_back(variant(double(i))); break;
+        case 4: c.push_back(variant()); break;
+        }
+    }
+    return c;
+}
+
+TEST_CASE("count_by_alternative(variant_column<Ts...> const&)", "[tag_scan]")
+{
+    for (std::size_t n : sizes)
+    {
+        column const c = make_column(n);
+
+        std::array<std::size_t, 3> expected = {{0, 0, 0}};
+        for (std::size_t i = 0; i < n; ++i)
+            if (c.which(i) != npos)
+                ++expected[c.which(i)];
+
+        std::array<std::size_t, 3> const counts =
+            eggs::variants::count_by_alternative(c);
+        CHECK(counts == expected);
+        CHECK(c.count<int>() == expected[0]);
+        CHECK(c.count<double>() == expected[2]);
+    }
+
+    SECTION("many alternatives")
+    {
+        using wide = eggs::variants::variant_column<
+            char, short, int, long, float, double, long double,
+            unsigned char, unsigned short, unsigned int, unsigned long>;
+        using wide_variant = wide::value_type;
+
+        wide c;
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (i % 3 == 0)
+                c.push_back(wide_variant(i));
+            else if (i % 3 == 1)
+                c.push_back(wide_variant(float(i)));
+            else
+                c.push_back(wide_variant(0ul));
+        }
+
+        std::array<std::size_t, 11> const counts =
+            eggs::variants::count_by_alternative(c);
+        CHECK(counts[2] == 334u);
+        CHECK(counts[4] == 333u);
+        CHECK(counts[10] == 333u);
+        CHECK(counts[0] == 0u);
+    }
+}
+
+TEST_CASE("find_first<T>(variant_column<Ts...> const&, std::size_t)", "[tag_scan]")
+{
+    for (std::size_t n : sizes)
+    {
+        column const c = make_column(n);
+
+        std::size_t expected = npos;
+        for (std::size_t i = 0; i < n && expected == npos; ++i)
+            if (c.which(i) == 2u)
+                expected = i;
+        CHECK(eggs::variants::find_first<double>(c) == expected);
+    }
+
+    column c;
+    for (int i = 0; i < 100; ++i)
+        c.push_back(variant(i));
+    c.push_back(variant(1.0));
+    c.push_back(variant(2));
+    c.push_back(variant(2.0));
+
+    CHECK(eggs::variants::find_first<double>(c) == 100u);
+    CHECK(eggs::variants::find_first<double>(c, 100) == 100u);
+    CHECK(eggs::variants::find_first<double>(c, 101) == 102u);
+    CHECK(eggs::variants::find_first<double>(c, 103) == npos);
+    CHECK(eggs::variants::find_first<std::string>(c) == npos);
+    CHECK(eggs::variants::find_first<int>(c, 1000) == npos);
+}
+
+TEST_CASE("mask_of<T>(variant_column<Ts...> const&, std::uint64_t*)", "[tag_scan]")
+{
+    for (std::size_t n : sizes)
+    {
+        column const c = make_column(n);
+
+        std::vector<std::uint64_t> words((n + 63) / 64 + 1, ~std::uint64_t(0));
+        eggs::variants::mask_of<int>(c, words.data());
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            bool const bit = ((words[i / 64] >> (i % 64)) & 1u) != 0;
+            CHECK(bit == (c.which(i) == 0u));
+        }
+        if (n % 64 != 0)
+            CHECK((words[n / 64] >> (n % 64)) == 0u);
+        CHECK(words.back() == ~std::uint64_t(0));
+    }
+}
+
+TEST_CASE("compress_indices<T>(variant_column<Ts...> const&, Index*)", "[tag_scan]")
+{
+    for (std::size_t n : sizes)
+    {
+        column const c = make_column(n);
+
+        std::vector<std::uint32_t> expected;
+        for (std::size_t i = 0; i < n; ++i)
+            if (c.which(i) == 1u)
+                expected.push_back(static_cast<std::uint32_t>(i));
+
+        std::vector<std::uint32_t> indices(expected.size() + 1, 0xFFFFFFFFu);
+        std::size_t const count =
+            eggs::variants::compress_indices<std::string>(c, indices.data());
+
+        REQUIRE(count == expected.size());
+        CHECK(std::vector<std::uint32_t>(
+            indices.begin(), indices.begin() + count) == expected);
+        CHECK(indices[count] == 0xFFFFFFFFu);
+    }
+}
@@ -0,0 +1,106 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant/thread_pool.hpp>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+TEST_CASE("thread_pool::thread_pool(std::size_t)", "[thread_pool]")
+{
+    eggs::variants::thread_pool pool(3);
+    CHECK(pool.size() == 3u);
+    CHECK(pool.this_worker() == pool.size());
+
+    eggs::variants::thread_pool single(0);
+    CHECK(single.size() == 1u);
+
+    CHECK(eggs::variants::thread_pool::default_concurrency() >= 1u);
+}
+
+TEST_CASE("task_group::run(F&&)", "[thread_pool]")
+{
+    eggs::variants::thread_pool pool(4);
+
+    std::atomic<int> count(0);
+    std::atomic<bool> on_workers(true);
+    {
+        eggs::variants::task_group group(pool);
+        for (int i = 0; i < 100; ++i)
+        {
+            group.run([&]
+            {
+                count.fetch_add(1);
+                if (pool.this_worker() >= pool.size())
+                    on_workers.store(false);
+            });
+        }
+        group.wait();
+        CHECK(count.load() == 100);
+        CHECK(on_workers.load());
+
+        // groups can be reused after waiting
+        group.run([&] { count.fetch_add(1); });
+        group.wait();
+        CHECK(count.load() == 101);
+    }
+}
+
+static long fib(eggs::variants::thread_pool& pool, int n)
+{
+    if (n < 12)
+        return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2);
+
+    long a = 0;
+    eggs::variants::task_group group(pool);
+    group.run([&] { a = fib(pool, n - 1); });
+    long const b = fib(pool, n - 2);
+    group.wait();
+    return a + b;
+}
+
+TEST_CASE("task_group nested wait", "[thread_pool]")
+{
+    eggs::variants::thread_pool pool(2);
+
+    long result = 0;
+    eggs::variants::task_group group(pool);
+    group.run([&] { result = fib(pool, 24); });
+    group.wait();
+    CHECK(result == 46368);
+}
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+TEST_CASE("task_group::wait() throws", "[thread_pool]")
+{
+    eggs::variants::thread_pool pool(2);
+
+    std::atomic<int> count(0);
+    eggs::variants::task_group group(pool);
+    for (int i = 0; i < 10; ++i)
+    {
+        group.run([&, i]
+        {
+            count.fetch_add(1);
+            if (i % 3 == 0)
+                throw std::runtime_error("task");
+        });
+    }
+    CHECK_THROWS_AS(group.wait(), std::runtime_error);
+    CHECK(count.load() == 10);
+
+    // the exception is cleared
+    group.run([&] { count.fetch_add(1); });
+    group.wait();
+    CHECK(count.load() == 11);
+}
+#endif
@@ -0,0 +1,152 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/transform_runs.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using variant = eggs::variant<int, std::string, double>;
+
+struct describe
+{
+    std::string operator()(int i) const { return "i" + std::to_string(i); }
+    std::string operator()(std::string const& s) const { return "s" + s; }
+    std::string operator()(double d) const { return "d" + std::to_string(int(d)); }
+};
+
+static std::vector<variant> make_variants()
+{
+    std::vector<variant> vs;
+    vs.push_back(1);
+    vs.push_back(2);
+    vs.push_back(3);
+    vs.push_back(std::string("a"));
+    vs.push_back(4.0);
+    vs.push_back(5.0);
+    vs.push_back(6);
+    vs.push_back(std::string("b"));
+    vs.push_back(std::string("c"));
+    return vs;
+}
+
+TEST_CASE("transform_runs(RandomIt, RandomIt, OutputIt, F&&)", "[transform_runs]")
+{
+    std::vector<variant> const vs = make_variants();
+
+    std::vector<std::string> out;
+    auto it = eggs::variants::transform_runs(
+        vs.begin(), vs.end(), std::back_inserter(out), describe{});
+    (void)it;
+
+    std::vector<std::string> const expected = {
+        "i1", "i2", "i3", "sa", "d4", "d5", "i6", "sb", "sc"};
+    CHECK(out == expected);
+
+    std::vector<std::string> prefix(3);
+    std::vector<std::string>::iterator const last =
+        eggs::variants::transform_runs(
+            vs.begin() + 2, vs.begin() + 5, prefix.begin(), describe{});
+    CHECK(last == prefix.end());
+    CHECK(prefix[0] == "i3");
+    CHECK(prefix[2] == "d4");
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    SECTION("throws")
+    {
+        std::vector<variant> es = vs;
+        es[4] = variant();
+
+        std::vector<std::string> partial;
+        CHECK_THROWS_AS(
+            eggs::variants::transform_runs(
+                es.begin(), es.end(), std::back_inserter(partial),
+                describe{}),
+            eggs::variants::bad_variant_access);
+        CHECK(partial.size() == 4u);
+    }
+#endif
+}
+
+struct run_recorder
+{
+    std::vector<std::string> runs;
+
+    void operator()(
+        eggs::variants::run_view<int const,
+            std::vector<variant>::const_iterator> run)
+    {
+        CHECK((std::is_same<decltype(*run.begin()), int const&>::value));
+        int const sum = std::accumulate(run.begin(), run.end(), 0);
+        runs.push_back("int@" + std::to_string(run.offset())
+          + "x" + std::to_string(run.size()) + "=" + std::to_string(sum));
+    }
+
+    void operator()(
+        eggs::variants::run_view<std::string const,
+            std::vector<variant>::const_iterator> run)
+    {
+        std::string joined;
+        for (std::string const& s : run)
+            joined += s;
+        runs.push_back("string@" + std::to_string(run.offset()) + "=" + joined);
+    }
+
+    void operator()(
+        eggs::variants::run_view<double const,
+            std::vector<variant>::const_iterator> run)
+    {
+        CHECK(run.front() <= run.back());
+        CHECK(run.end() - run.begin() == std::ptrdiff_t(run.size()));
+        runs.push_back("double@" + std::to_string(run.offset())
+          + "x" + std::to_string(run.size()));
+    }
+};
+
+struct zero_ints
+{
+    void operator()(
+        eggs::variants::run_view<int, std::vector<variant>::iterator> run) const
+    {
+        std::fill(run.begin(), run.end(), 0);
+    }
+
+    template <typename Run>
+    void operator()(Run) const {}
+};
+
+TEST_CASE("for_each_run(RandomIt, RandomIt, F&&)", "[transform_runs]")
+{
+    std::vector<variant> const vs = make_variants();
+
+    run_recorder r;
+    eggs::variants::for_each_run(vs.begin(), vs.end(), r);
+
+    std::vector<std::string> const expected = {
+        "int@0x3=6", "string@3=a", "double@4x2", "int@6x1=6", "string@7=bc"};
+    CHECK(r.runs == expected);
+
+    SECTION("mutable")
+    {
+        std::vector<variant> ms = vs;
+        eggs::variants::for_each_run(ms.begin(), ms.end(), zero_ints{});
+        CHECK(ms[0] == variant(0));
+        CHECK(ms[2] == variant(0));
+        CHECK(ms[6] == variant(0));
+        CHECK(ms[3] == vs[3]);
+    }
+}
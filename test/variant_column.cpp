@@ -0,0 +1,105 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_column.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+EGGS_CXX11_STATIC_CONSTEXPR std::size_t npos = eggs::variant<>::npos;
+
+using variant = eggs::variant<int, std::string, double>;
+using column = eggs::variants::variant_column<int, std::string, double>;
+
+TEST_CASE("variant_column<Ts...>", "[variant_column]")
+{
+    CHECK((std::is_same<column::tag_type, std::uint8_t>::value));
+
+    column c;
+    REQUIRE(c.empty());
+
+    for (int i = 0; i < 100; ++i)
+    {
+        switch (i % 4)
+        {
+        case 0: c.push_back(variant(i)); break;
+        case 1: c.push_back(variant(std::to_string(i))); break;
+        case 2: c.push_back(variant(i * 0.5)); break;
+        case 3: c.push_back(variant()); break;
+        }
+    }
+
+    REQUIRE(c.size() == 100u);
+    CHECK(c.count<int>() == 25u);
+    CHECK(c.count<std::string>() == 25u);
+    CHECK(c.count(npos) == 25u);
+
+    CHECK(c.tags()[0] == 1u);
+    CHECK(c.tags()[3] == 0u);
+    CHECK(c.which(1) == 1u);
+    CHECK(c.which(3) == npos);
+
+    CHECK(c[0].which() == 0u);
+    CHECK(*c[0].target<int>() == 0);
+    CHECK(c[0].target<std::string>() == nullptr);
+    CHECK(*c[5].target<std::string>() == "5");
+    CHECK(bool(c[7]) == false);
+    CHECK(c[6] == variant(3.0));
+
+    int sum = 0;
+    c.for_each<int>([&sum](int i) { sum += i; });
+    CHECK(sum == 1200);
+
+    SECTION("assign through proxy")
+    {
+        c[0] = variant(std::string{"zero"});
+        c[3] = variant(3);
+
+        CHECK(*c[0].target<std::string>() == "zero");
+        CHECK(*c[3].target<int>() == 3);
+        CHECK(c.count<int>() == 25u);
+        CHECK(c.count<std::string>() == 26u);
+
+        c.for_each<std::string>([](std::string& s) { s += '!'; });
+        CHECK(static_cast<variant>(c[1]) == variant(std::string{"1!"}));
+    }
+
+    SECTION("copy")
+    {
+        column const d = c;
+
+        REQUIRE(d.size() == c.size());
+        for (std::size_t i = 0; i < c.size(); ++i)
+            CHECK(static_cast<variant>(d[i]) == static_cast<variant>(c[i]));
+    }
+
+    SECTION("move")
+    {
+        column d = std::move(c);
+
+        CHECK(c.empty());
+        CHECK(d.size() == 100u);
+        CHECK(*d[9].target<std::string>() == "9");
+    }
+
+    SECTION("pop_back")
+    {
+        c.pop_back();
+        c.pop_back();
+
+        CHECK(c.size() == 98u);
+        CHECK(c.count<double>() == 24u);
+    }
+}
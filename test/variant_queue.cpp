@@ -0,0 +1,289 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_queue.hpp>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+static int alive = 0;
+static int copies = 0;
+
+// a message that counts its instances and copies, and may throw on demand
+struct tracked
+{
+    int value;
+
+    explicit tracked(int value, bool fail = false) : value(value)
+    {
+        if (fail)
+            throw value;
+        ++alive;
+    }
+    tracked(tracked const& other) : value(other.value) { ++alive; ++copies; }
+    tracked(tracked&& other) : value(other.value) { ++alive; }
+    ~tracked() { --alive; }
+};
+
+struct record
+{
+    std::vector<int>* ints;
+    std::vector<std::string>* strings;
+
+    void operator()(int i) const { ints->push_back(i); }
+    void operator()(std::string&& s) const { strings->push_back(std::move(s)); }
+    void operator()(tracked&& t) const { ints->push_back(-t.value); }
+};
+
+struct throwing
+{
+    template <typename T>
+    void operator()(T&&) const { throw 0; }
+};
+
+TEST_CASE("spsc_queue<Ts...>::try_emplace", "[variant_queue]")
+{
+    eggs::variants::spsc_queue<int, std::string> q(3);
+    CHECK(q.capacity() == 4u);
+    CHECK(q.empty());
+
+    CHECK(q.try_emplace<0>(1) == true);
+    CHECK(q.try_emplace<std::string>(3u, 'a') == true);
+    CHECK(q.try_push(eggs::variant<int, std::string>(2)) == true);
+    CHECK(q.try_emplace<int>(4) == true);
+    CHECK(q.size_approx() == 4u);
+
+    CHECK(q.try_emplace<int>(5) == false);
+    CHECK(q.size_approx() == 4u);
+
+    std::vector<int> ints;
+    std::vector<std::string> strings;
+    record const r = {&ints, &strings};
+
+    CHECK(q.consume(r) == true);
+    REQUIRE(ints.size() == 1u);
+    CHECK(ints[0] == 1);
+
+    CHECK(q.try_emplace<int>(5) == true);
+
+    CHECK(q.consume_all(r) == 4u);
+    CHECK(q.empty());
+    CHECK(q.consume(r) == false);
+
+    REQUIRE(ints.size() == 4u);
+    CHECK(ints[1] == 2);
+    CHECK(ints[2] == 4);
+    CHECK(ints[3] == 5);
+    REQUIRE(strings.size() == 1u);
+    CHECK(strings[0] == "aaa");
+}
+
+TEST_CASE("spsc_queue<Ts...>::consume", "[variant_queue]")
+{
+    alive = copies = 0;
+    {
+        eggs::variants::spsc_queue<int, tracked> q(8);
+        for (int i = 0; i < 6; ++i)
+            q.emplace<tracked>(i);
+        CHECK(alive == 6);
+        CHECK(copies == 0);
+
+        std::vector<int> ints;
+        record const r = {&ints, nullptr};
+
+        // messages are destroyed as they are consumed
+        CHECK(q.consume(r, 2) == 2u);
+        CHECK(alive == 4);
+        CHECK(copies == 0);
+        CHECK(q.size_approx() == 4u);
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+        // a message is dequeued even if the visitor throws
+        CHECK_THROWS(q.consume(throwing{}, 2));
+        CHECK(alive == 3);
+        CHECK(q.size_approx() == 3u);
+
+        // a message whose construction throws is not enqueued
+        CHECK_THROWS(q.try_emplace<tracked>(42, true));
+        CHECK(q.size_approx() == 3u);
+#endif
+    }
+    CHECK(alive == 0);
+}
+
+TEST_CASE("mpsc_queue<Ts...>::try_emplace", "[variant_queue]")
+{
+    eggs::variants::mpsc_queue<int, std::string> q(4);
+    CHECK(q.capacity() == 4u);
+    CHECK(q.empty());
+
+    CHECK(q.try_emplace<0>(1) == true);
+    CHECK(q.try_emplace<std::string>(3u, 'a') == true);
+    CHECK(q.try_push(eggs::variant<int, std::string>(2)) == true);
+    CHECK(q.try_emplace<int>(4) == true);
+    CHECK(q.size_approx() == 4u);
+
+    CHECK(q.try_emplace<int>(5) == false);
+
+    std::vector<int> ints;
+    std::vector<std::string> strings;
+    record const r = {&ints, &strings};
+
+    CHECK(q.consume(r) == true);
+    CHECK(q.try_emplace<int>(5) == true);
+    CHECK(q.consume_all(r) == 4u);
+    CHECK(q.empty());
+    CHECK(q.consume(r) == false);
+
+    REQUIRE(ints.size() == 4u);
+    CHECK(ints[0] == 1);
+    CHECK(ints[1] == 2);
+    CHECK(ints[2] == 4);
+    CHECK(ints[3] == 5);
+    REQUIRE(strings.size() == 1u);
+    CHECK(strings[0] == "aaa");
+}
+
+TEST_CASE("mpsc_queue<Ts...>::consume", "[variant_queue]")
+{
+    alive = copies = 0;
+    {
+        eggs::variants::mpsc_queue<int, tracked> q(8);
+        for (int i = 0; i < 6; ++i)
+            q.emplace<tracked>(i);
+        CHECK(alive == 6);
+        CHECK(copies == 0);
+
+        std::vector<int> ints;
+        record const r = {&ints, nullptr};
+
+        CHECK(q.consume(r, 2) == 2u);
+        CHECK(alive == 4);
+        CHECK(copies == 0);
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+        CHECK_THROWS(q.consume(throwing{}, 2));
+        CHECK(alive == 3);
+
+        // a slot whose construction throws is skipped
+        CHECK_THROWS(q.try_emplace<tracked>(42, true));
+        CHECK(q.try_emplace<int>(7) == true);
+        CHECK(q.consume_all(r) == 4u);
+        REQUIRE(ints.size() == 6u);
+        CHECK(ints[5] == 7);
+        CHECK(q.empty());
+#endif
+    }
+    CHECK(alive == 0);
+}
+
+TEST_CASE("spsc_queue<Ts...> contention", "[variant_queue]")
+{
+    std::size_t const messages = 100000;
+    eggs::variants::spsc_queue<std::size_t, std::string> q(64);
+
+    std::thread producer([&q, messages]
+    {
+        for (std::size_t i = 0; i < messages; ++i)
+        {
+            if (i % 2 == 0)
+                q.emplace<std::size_t>(i);
+            else
+                q.emplace<std::string>(i % 32, 'x');
+        }
+    });
+
+    // the visitor only records whether messages arrive in order
+    struct check
+    {
+        std::size_t next;
+        bool ordered;
+
+        void operator()(std::size_t i)
+        {
+            ordered = ordered && i == next;
+            ++next;
+        }
+        void operator()(std::string const& s)
+        {
+            ordered = ordered && s.size() == next % 32;
+            ++next;
+        }
+    } c = {0, true};
+
+    std::size_t received = 0;
+    while (received < messages)
+        received += q.consume(c, 16);
+    producer.join();
+
+    CHECK(received == messages);
+    CHECK(c.ordered);
+    CHECK(q.empty());
+}
+
+TEST_CASE("mpsc_queue<Ts...> contention", "[variant_queue]")
+{
+    std::size_t const producers = 4;
+    std::size_t const messages = 20000;
+    eggs::variants::mpsc_queue<std::size_t, std::string> q(64);
+
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&q, p, messages]
+        {
+            for (std::size_t i = 0; i < messages; ++i)
+            {
+                if (i % 2 == 0)
+                    q.emplace<std::size_t>(p * messages + i);
+                else
+                    q.emplace<std::string>(p + 1, 'x');
+            }
+        });
+    }
+
+    // the messages of each producer arrive in the order they were sent
+    struct check
+    {
+        std::vector<std::size_t> next;
+        std::vector<std::size_t> strings;
+        bool ordered;
+
+        void operator()(std::size_t i)
+        {
+            std::size_t const p = i / 20000;
+            ordered = ordered && i % 20000 == next[p];
+            next[p] += 2;
+        }
+        void operator()(std::string const& s)
+        {
+            ++strings[s.size() - 1];
+        }
+    } c = {
+        std::vector<std::size_t>(producers, 0),
+        std::vector<std::size_t>(producers, 0), true};
+
+    std::size_t received = 0;
+    while (received < producers * messages)
+        received += q.consume_all(c);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    CHECK(received == producers * messages);
+    CHECK(c.ordered);
+    for (std::size_t p = 0; p < producers; ++p)
+        CHECK(c.strings[p] == messages / 2);
+    CHECK(q.empty());
+}
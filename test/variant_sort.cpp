@@ -0,0 +1,94 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_sort.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+template <typename Variant, typename Make>
+static std::vector<Variant> make_range(std::size_t n, Make make)
+{
+    std::vector<Variant> vs;
+    std::uint32_t x = 2463534242u;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        vs.push_back(make(x));
+    }
+    return vs;
+}
+
+TEST_CASE("variant_sort(RandomIt, RandomIt)", "[variant_sort]")
+{
+    using variant = eggs::variant<int, std::string, double>;
+    auto const make = [](std::uint32_t x) -> variant
+    {
+        switch (x % 4)
+        {
+        case 0: return int(x >> 2) - (1 << 28);
+        case 1: return std::to_string(x >> 20);
+        case 2: return (double(x >> 2) - double(1 << 29)) / 1024.0;
+        default: return variant();
+        }
+    };
+
+    // small sizes exercise std::sort on the keys, large ones the radix sort
+    for (std::size_t n : {0u, 1u, 2u, 10u, 100u, 1000u, 20000u})
+    {
+        std::vector<variant> vs = make_range<variant>(n, make);
+        std::vector<variant> expected = vs;
+        std::sort(expected.begin(), expected.end());
+
+        eggs::variants::variant_sort(vs.begin(), vs.end());
+        CHECK(std::is_sorted(vs.begin(), vs.end()));
+        CHECK(vs == expected);
+    }
+}
+
+TEST_CASE("variant_sort(RandomIt, RandomIt) radix keys", "[variant_sort]")
+{
+    using variant = eggs::variant<
+        std::int8_t, std::uint16_t, std::int64_t, float, bool>;
+    auto const make = [](std::uint32_t x) -> variant
+    {
+        switch (x % 5)
+        {
+        case 0: return std::int8_t(x >> 8);
+        case 1: return std::uint16_t(x >> 8);
+        case 2: return std::int64_t(x) * -std::int64_t(x >> 3);
+        case 3: return float(std::int32_t(x)) * 1e-3f;
+        default: return (x & 256) != 0;
+        }
+    };
+
+    std::vector<variant> vs = make_range<variant>(5000, make);
+    vs.push_back(-std::numeric_limits<float>::infinity());
+    vs.push_back(std::numeric_limits<float>::infinity());
+    vs.push_back(std::numeric_limits<float>::lowest());
+    vs.push_back(-0.f);
+    vs.push_back(std::numeric_limits<std::int64_t>::min());
+    vs.push_back(std::numeric_limits<std::int64_t>::max());
+
+    std::vector<variant> expected = vs;
+    std::sort(expected.begin(), expected.end());
+
+    eggs::variants::variant_sort(vs.begin(), vs.end());
+    CHECK(std::is_sorted(vs.begin(), vs.end()));
+    CHECK(vs == expected);
+    CHECK(vs[0].which() == 0u);
+    CHECK(*vs.back().target<bool>() == true);
+}
@@ -0,0 +1,133 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/variant_vector.hpp>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+using vector = eggs::variants::variant_vector<int, std::string>;
+
+struct Record
+{
+    std::vector<std::string> seen;
+
+    void operator()(int i) { seen.push_back("i" + std::to_string(i)); }
+    void operator()(std::string const& s) { seen.push_back("s" + s); }
+};
+
+TEST_CASE("variant_vector<Ts...>::push_back(variant<Ts...> const&)", "[variant_vector]")
+{
+    vector vv;
+    REQUIRE(vv.empty());
+
+    eggs::variant<int, std::string> const v1(42);
+    eggs::variant<int, std::string> const v2(std::string{"42"});
+
+    vector::handle const h1 = vv.push_back(v1);
+    vector::handle const h2 = vv.push_back(v2);
+    vector::handle const h3 = vv.push_back(eggs::variant<int, std::string>(43));
+
+    CHECK(vv.size() == 3u);
+    CHECK(vv.size<int>() == 2u);
+    CHECK(vv.size<std::string>() == 1u);
+    CHECK(h1.which() == 0u);
+    CHECK(h2.which() == 1u);
+    CHECK(h1 != h3);
+    CHECK(vv.get<int>(h1) == 42);
+    CHECK(vv.get<std::string>(h2) == "42");
+    CHECK(vv.get<int>(h3) == 43);
+
+    CHECK(vv.end<int>() - vv.begin<int>() == 2);
+    CHECK(vv.data<std::string>()[0] == "42");
+
+    Record r;
+    vv.for_each(r);
+    CHECK((r.seen == std::vector<std::string>{"i42", "s42", "i43"}));
+
+#if EGGS_CXX98_HAS_EXCEPTIONS
+    CHECK_THROWS_AS(
+        vv.push_back(eggs::variant<int, std::string>()),
+        eggs::variants::bad_variant_access);
+    CHECK(vv.size() == 3u);
+#endif
+}
+
+TEST_CASE("variant_vector<Ts...>::erase(handle)", "[variant_vector]")
+{
+    vector vv;
+    std::vector<vector::handle> hs;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 3 == 0)
+            hs.push_back(vv.emplace_back<std::string>(std::to_string(i)));
+        else
+            hs.push_back(vv.emplace_back<int>(i));
+    }
+
+    std::vector<vector::handle> kept;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 4 == 0)
+            vv.erase(hs[i]);
+        else
+            kept.push_back(hs[i]);
+    }
+
+    CHECK(vv.size() == 75u);
+    CHECK(vv.size<int>() + vv.size<std::string>() == 75u);
+
+    Record r;
+    vv.for_each(r);
+    REQUIRE(r.seen.size() == 75u);
+
+    std::size_t k = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 4 == 0)
+            continue;
+
+        vector::handle const h = kept[k];
+        if (i % 3 == 0)
+        {
+            CHECK(vv.get<std::string>(h) == std::to_string(i));
+            CHECK(r.seen[k] == "s" + std::to_string(i));
+        } else {
+            CHECK(vv.get<int>(h) == i);
+            CHECK(r.seen[k] == "i" + std::to_string(i));
+        }
+        ++k;
+    }
+
+    SECTION("reuse slots")
+    {
+        for (vector::handle h : kept)
+            vv.erase(h);
+
+        CHECK(vv.empty());
+
+        vector::handle const h = vv.emplace_back<int>(7);
+        CHECK(vv.get<int>(h) == 7);
+        CHECK(vv.size() == 1u);
+    }
+
+    SECTION("move")
+    {
+        vector mv = std::move(vv);
+
+        CHECK(vv.empty());
+        CHECK(mv.size() == 75u);
+        CHECK(mv.get<int>(kept[0]) == 1);
+    }
+}
@@ -0,0 +1,209 @@
+// Eggs.Variant
+//
+// Copyright Agustin K-ballo Berge, Fusion Fenix 2014-2015
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <eggs/variant.hpp>
+#include <eggs/variant/views.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <eggs/variant/detail/config/prefix.hpp>
+
+#if EGGS_CXX20_HAS_RANGES
+#  include <ranges>
+#endif
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+struct Quote { double price; };
+struct Trade { double price; int size; };
+
+using message = eggs::variant<Quote, Trade, std::string>;
+
+static std::vector<message> make_messages()
+{
+    std::vector<message> ms;
+    ms.push_back(Quote{1.0});
+    ms.push_back(Trade{2.0, 10});
+    ms.push_back(std::string("halt"));
+    ms.push_back(Quote{3.0});
+    ms.push_back(message());
+    ms.push_back(Quote{5.0});
+    ms.push_back(Trade{6.0, 20});
+    return ms;
+}
+
+TEST_CASE("range | only<T>()", "[views]")
+{
+    std::vector<message> ms = make_messages();
+
+    auto quotes = ms | eggs::variants::only<Quote>();
+    CHECK((std::is_same<decltype(*quotes.begin()), Quote&>::value));
+    CHECK(std::distance(quotes.begin(), quotes.end()) == 3);
+
+    double sum = 0;
+    for (Quote const& q : quotes)
+        sum += q.price;
+    CHECK(sum == 9.0);
+
+    for (Quote& q : ms | eggs::variants::only<Quote>())
+        q.price *= 2;
+    CHECK(ms[3].target<Quote>()->price == 6.0);
+    CHECK(ms[5].target<Quote>()->price == 10.0);
+
+    auto it = quotes.begin();
+    ++it;
+    CHECK(it.base() == ms.begin() + 3);
+
+    std::vector<message> const& cms = ms;
+    auto trades = cms | eggs::variants::only<Trade>();
+    CHECK((std::is_same<decltype(*trades.begin()), Trade const&>::value));
+    CHECK(std::count_if(trades.begin(), trades.end(),
+        [](Trade const& t) { return t.size > 15; }) == 1);
+
+    std::vector<message> none;
+    auto empty = none | eggs::variants::only<Quote>();
+    CHECK(empty.begin() == empty.end());
+}
+
+TEST_CASE("range | where_alternative<I>()", "[views]")
+{
+    std::vector<message> const ms = make_messages();
+
+    std::vector<std::string> strings;
+    for (std::string const& s : ms | eggs::variants::where_alternative<2>())
+        strings.push_back(s);
+    REQUIRE(strings.size() == 1u);
+    CHECK(strings[0] == "halt");
+
+    message raw[] = {Trade{1.0, 1}, Quote{2.0}, Trade{3.0, 3}};
+    int size = 0;
+    for (Trade const& t : raw | eggs::variants::where_alternative<1>())
+        size += t.size;
+    CHECK(size == 4);
+}
+
+struct price_of
+{
+    double operator()(Quote const& q) const { return q.price; }
+    double operator()(Trade const& t) const { return t.price * t.size; }
+    double operator()(std::string const&) const { return 0.0; }
+};
+
+TEST_CASE("range | visit_each(f)", "[views]")
+{
+    std::vector<message> ms = make_messages();
+    ms.erase(ms.begin() + 4);
+
+    auto prices = ms | eggs::variants::visit_each(price_of{});
+    CHECK((std::is_same<decltype(*prices.begin()), double>::value));
+
+    std::vector<double> out(prices.begin(), prices.end());
+    std::vector<double> const expected = {1.0, 20.0, 0.0, 3.0, 5.0, 120.0};
+    CHECK(out == expected);
+
+    CHECK(std::accumulate(prices.begin(), prices.end(), 0.0) == 149.0);
+}
+
+// neither default constructible nor assignable, like a capturing lambda
+struct scaled_size
+{
+    double const scale;
+
+    double operator()(Quote const&) const { return 0.0; }
+    double operator()(Trade const& t) const { return t.size * scale; }
+    double operator()(std::string const&) const { return 0.0; }
+};
+
+TEST_CASE("range | visit_each(f) with a non-assignable f", "[views]")
+{
+    std::vector<message> ms = make_messages();
+    ms.erase(ms.begin() + 4);
+
+    auto sizes = ms | eggs::variants::visit_each(scaled_size{2.0});
+
+    // iterators hold their own copy of the function, and remain valid when
+    // the view is moved from
+    auto it = sizes.begin();
+    auto moved = std::move(sizes);
+    CHECK(*++it == 20.0);
+
+    // the view and its iterators are assignable even though f is not
+    auto other = ms | eggs::variants::visit_each(scaled_size{3.0});
+    decltype(it) first;
+    first = moved.begin();
+    moved = other;
+    CHECK(*++first == 20.0);
+    CHECK(*++moved.begin() == 30.0);
+}
+
+#if EGGS_CXX20_HAS_RANGES
+TEST_CASE("range | views | std::views", "[views]")
+{
+    using quotes_view = decltype(
+        std::declval<std::vector<message>&>() | eggs::variants::only<Quote>());
+    using prices_view = decltype(
+        std::declval<std::vector<message>&>()
+          | eggs::variants::visit_each(price_of{}));
+    static_assert(std::ranges::view<quotes_view>);
+    static_assert(std::ranges::forward_range<quotes_view>);
+    static_assert(std::ranges::borrowed_range<quotes_view>);
+    static_assert(std::ranges::view<prices_view>);
+    static_assert(std::ranges::input_range<prices_view>);
+
+    std::vector<message> ms = make_messages();
+    ms.erase(ms.begin() + 4);
+
+    std::vector<double> out;
+    for (double p : ms
+      | eggs::variants::visit_each(price_of{})
+      | std::views::drop(1)
+      | std::views::take(2))
+    {
+        out.push_back(p);
+    }
+    std::vector<double> const expected = {20.0, 0.0};
+    CHECK(out == expected);
+
+    auto first = ms
+      | eggs::variants::visit_each(scaled_size{10.0})
+      | std::views::drop(1)
+      | std::views::take(1);
+    CHECK(std::ranges::distance(first) == 1);
+    CHECK(*first.begin() == 100.0);
+
+    int const one = 1;
+    auto counted = ms
+      | eggs::variants::visit_each([one](auto const&) { return one; })
+      | std::views::take(3);
+    CHECK(std::ranges::distance(counted) == 3);
+
+    // rvalue ranges of variants whose iterators do not refer to them
+    double sum = 0;
+    for (Quote const& q : ms
+      | std::views::drop(1)
+      | eggs::variants::only<Quote>()
+      | std::views::filter([](Quote const& q) { return q.price > 3.0; }))
+    {
+        sum += q.price;
+    }
+    CHECK(sum == 5.0);
+
+    int trades = 0;
+    for (Trade const& t : std::views::all(ms) | std::views::reverse
+      | eggs::variants::where_alternative<1>())
+    {
+        trades += t.size;
+    }
+    CHECK(trades == 30);
+}
+#endif